@@ -26,9 +26,11 @@
  */
 
 #include "tidy/tidy-sub-texture.h"
+#include "tidy/tidy-batch-group.h"
 
 #include "hd-clutter-cache.h"
 #include "hd-render-manager.h"
+#include "hd-theme-atlas.h"
 
 struct _HdClutterCachePrivate
 {
@@ -45,6 +47,7 @@ G_DEFINE_TYPE (HdClutterCache, hd_clutter_cache, CLUTTER_TYPE_GROUP);
 /* ------------------------------------------------------------------------- */
 
 static HdClutterCache *the_clutter_cache = 0;
+static HdThemeAtlas *the_theme_atlas = 0;
 
 #define HD_CLUTTER_CACHE_THEME_PATH "/etc/hildon/theme/images/"
 #define HD_CLUTTER_CACHE_FALLBACK_THEME_PATH "/usr/share/themes/default/images/"
@@ -174,6 +177,84 @@ hd_clutter_cache_get_real_texture(const char *filename, gboolean from_theme)
   return texture;
 }
 
+/* Returns the atlas page and the area in it where the theme image
+ * @filename is, if it's in the atlas.  Images of the fallback theme
+ * are not atlased, they're only used when the real one is broken. */
+static gboolean
+hd_clutter_cache_get_atlas_image(const char *filename, gboolean from_theme,
+                                 ClutterTexture **page, ClutterGeometry *area)
+{
+  HdClutterCache *cache;
+
+  if (!from_theme || mb_wm_theme_is_broken())
+    return FALSE;
+  if (!(cache = hd_get_clutter_cache()))
+    return FALSE;
+
+  if (!the_theme_atlas)
+    the_theme_atlas = hd_theme_atlas_new(HD_CLUTTER_CACHE_THEME_PATH,
+                                         CLUTTER_CONTAINER(cache));
+  return hd_theme_atlas_lookup(the_theme_atlas, filename, page, area);
+}
+
+/* Turns @geo, a region of the atlased image at @area, into a region of
+ * its atlas page.  It's clamped to the image, so it doesn't show the
+ * neighbouring images, and 0x0 means all of it. */
+static void
+hd_clutter_cache_clamp_to_image(ClutterGeometry *geo,
+                                const ClutterGeometry *area)
+{
+  gint x1, y1, x2, y2;
+
+  x1 = CLAMP(geo->x, 0, (gint)area->width);
+  y1 = CLAMP(geo->y, 0, (gint)area->height);
+  x2 = CLAMP(geo->x + (gint)geo->width, x1, (gint)area->width);
+  y2 = CLAMP(geo->y + (gint)geo->height, y1, (gint)area->height);
+  if (x2 == x1 || y2 == y1)
+    {
+      *geo = *area;
+      return;
+    }
+
+  geo->x = area->x + x1;
+  geo->y = area->y + y1;
+  geo->width = x2 - x1;
+  geo->height = y2 - y1;
+}
+
+static ClutterActor *
+hd_clutter_cache_new_sub_texture(ClutterTexture *texture,
+                                 const char *filename,
+                                 ClutterGeometry *geo,
+                                 guint width, guint height)
+{
+  TidySubTexture *tex;
+
+  tex = tidy_sub_texture_new(texture);
+  tidy_sub_texture_set_region(tex, geo);
+  clutter_actor_set_name(CLUTTER_ACTOR(tex), filename);
+  clutter_actor_set_position(CLUTTER_ACTOR(tex), 0, 0);
+  clutter_actor_set_size(CLUTTER_ACTOR(tex), width, height);
+
+  return CLUTTER_ACTOR(tex);
+}
+
+/* Like hd_clutter_cache_new_sub_texture(), for a region of the atlased
+ * image @filename.  It's kept showing the image if the theme moves it. */
+static ClutterActor *
+hd_clutter_cache_new_atlas_sub_texture(ClutterTexture *page,
+                                       const char *filename,
+                                       ClutterGeometry *geo,
+                                       guint width, guint height)
+{
+  ClutterActor *tex;
+
+  tex = hd_clutter_cache_new_sub_texture(page, filename, geo, width, height);
+  hd_theme_atlas_track(the_theme_atlas, filename, TIDY_SUB_TEXTURE(tex));
+
+  return tex;
+}
+
 /* Returns an actor representing a broken texture.
  * ...Maybe make this Firefox-style broken picture symbol? */
 static ClutterActor *
@@ -184,11 +265,31 @@ hd_clutter_cache_get_broken_texture()
   return actor;
 }
 
+void
+hd_clutter_cache_preload(const char *filename, gboolean from_theme)
+{
+  ClutterTexture *page;
+  ClutterGeometry area;
+
+  /* Don't load it twice if it's served from the atlas. */
+  if (hd_clutter_cache_get_atlas_image(filename, from_theme, &page, &area))
+    return;
+  if (!hd_clutter_cache_get_real_texture(filename, from_theme))
+    g_warning("%s: couldn't load %s", __FUNCTION__, filename);
+}
+
 ClutterActor *
 hd_clutter_cache_get_texture(const char *filename, gboolean from_theme)
 {
-  ClutterActor *texture = hd_clutter_cache_get_real_texture(filename,
-                                                            from_theme);
+  ClutterActor *texture;
+  ClutterTexture *page;
+  ClutterGeometry area;
+
+  if (hd_clutter_cache_get_atlas_image(filename, from_theme, &page, &area))
+    return hd_clutter_cache_new_atlas_sub_texture(page, filename, &area,
+                                                  area.width, area.height);
+
+  texture = hd_clutter_cache_get_real_texture(filename, from_theme);
   if (!texture)
     texture = hd_clutter_cache_get_broken_texture();
   else
@@ -203,11 +304,21 @@ hd_clutter_cache_get_sub_texture(const char *filename,
                                  ClutterGeometry *geo)
 {
   ClutterActor *texture;
-  TidySubTexture *tex;
+  ClutterTexture *page;
+  ClutterGeometry area;
   HdClutterCache *cache = hd_get_clutter_cache();
   if (!cache)
     return 0;
 
+  if (hd_clutter_cache_get_atlas_image(filename, from_theme, &page, &area))
+    {
+      ClutterGeometry region = *geo;
+
+      hd_clutter_cache_clamp_to_image(&region, &area);
+      return hd_clutter_cache_new_atlas_sub_texture(page, filename, &region,
+                                                    geo->width, geo->height);
+    }
+
   texture = hd_clutter_cache_get_real_texture(filename, from_theme);
   if (!texture)
     {
@@ -217,13 +328,9 @@ hd_clutter_cache_get_sub_texture(const char *filename,
       return texture;
     }
 
-  tex = tidy_sub_texture_new(CLUTTER_TEXTURE(texture));
-  tidy_sub_texture_set_region(tex, geo);
-  clutter_actor_set_name(CLUTTER_ACTOR(tex), filename);
-  clutter_actor_set_position(CLUTTER_ACTOR(tex), 0, 0);
-  clutter_actor_set_size(CLUTTER_ACTOR(tex), geo->width, geo->height);
-
-  return CLUTTER_ACTOR(tex);
+  return hd_clutter_cache_new_sub_texture(CLUTTER_TEXTURE(texture),
+                                          filename, geo,
+                                          geo->width, geo->height);
 }
 
 /* like hd_clutter_cache_get_texture, but divides up the texture
@@ -253,11 +360,18 @@ hd_clutter_cache_get_sub_texture_for_area(const char *filename,
   gint low_x, low_y, high_x, high_y;
   ClutterTexture *texture = 0;
   ClutterGroup *group = 0;
-  ClutterGeometry geo = *geo_;
+  ClutterGeometry geo = *geo_, atlas_area;
+  gboolean atlased;
   gint x,y;
 
-  texture = CLUTTER_TEXTURE(hd_clutter_cache_get_real_texture(filename,
-                                                              from_theme));
+  atlased = hd_clutter_cache_get_atlas_image(filename, from_theme,
+                                             &texture, &atlas_area);
+  if (atlased)
+    /* Work in the coordinates of the atlas page. */
+    hd_clutter_cache_clamp_to_image(&geo, &atlas_area);
+  else
+    texture = CLUTTER_TEXTURE(hd_clutter_cache_get_real_texture(filename,
+                                                                from_theme));
   if (!texture)
     {
       ClutterActor *actor = hd_clutter_cache_get_broken_texture();
@@ -280,14 +394,16 @@ hd_clutter_cache_get_sub_texture_for_area(const char *filename,
   /* no need to extend */
   if (!extend_x && !extend_y)
     {
-      /* ignore the contents of 'texture' as it will be in our cache */
-      ClutterActor *actor =
-          hd_clutter_cache_get_sub_texture(filename, from_theme, &geo);
+      ClutterActor *actor = atlased
+        ? hd_clutter_cache_new_atlas_sub_texture(texture, filename, &geo,
+                                                 geo.width, geo.height)
+        : hd_clutter_cache_new_sub_texture(texture, filename, &geo,
+                                           geo.width, geo.height);
       clutter_actor_set_position(actor, area->x, area->y);
       return actor;
     }
 
-  group = CLUTTER_GROUP(clutter_group_new());
+  group = CLUTTER_GROUP(tidy_batch_group_new());
   clutter_actor_set_name(CLUTTER_ACTOR(group), filename);
   if (extend_x)
     {
@@ -366,6 +482,8 @@ hd_clutter_cache_get_sub_texture_for_area(const char *filename,
               tidy_sub_texture_set_tiled(tex, TRUE);
             clutter_actor_set_position(CLUTTER_ACTOR(tex), pos.x, pos.y);
             clutter_actor_set_size(CLUTTER_ACTOR(tex), pos.width, pos.height);
+            if (atlased)
+              hd_theme_atlas_track(the_theme_atlas, filename, tex);
             clutter_container_add_actor(
                       CLUTTER_CONTAINER(group),
                       CLUTTER_ACTOR(tex));
@@ -399,4 +517,6 @@ void hd_clutter_cache_theme_changed(void) {
 
   clutter_container_foreach (CLUTTER_CONTAINER(the_clutter_cache),
                              reload_texture_cb, 0);
+  if (the_theme_atlas)
+    hd_theme_atlas_theme_changed (the_theme_atlas);
 }
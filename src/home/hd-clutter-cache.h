@@ -55,6 +55,10 @@ GType hd_clutter_cache_get_type (void) G_GNUC_CONST;
 void
 hd_clutter_cache_theme_changed(void);
 
+/* Load a texture into the cache ahead of its first use. */
+void
+hd_clutter_cache_preload(const char *filename, gboolean from_theme);
+
 /* Create a clutter clone texture from a texture in our cache.
  * This is created specially and is not owned by the cache.
  * If from_theme is true, the filename will be appended to the current
@@ -75,6 +75,8 @@ struct _HdHomeViewContainerPrivate
   gboolean animation_overshoot;
 
   gboolean in_move;
+  /* Whether the views are painted from their snapshots */
+  gboolean views_cached;
 
   /* GConf */
   GConfClient *gconf_client;
@@ -95,6 +97,9 @@ enum
 
 G_DEFINE_TYPE (HdHomeViewContainer, hd_home_view_container, CLUTTER_TYPE_GROUP);
 
+static void hd_home_view_container_set_views_cached (HdHomeViewContainer *container,
+                                                     gboolean             cached);
+
 static void
 hd_home_view_container_update_previous_and_next_view (HdHomeViewContainer *self)
 {
@@ -918,10 +923,43 @@ hd_home_view_container_set_offset (HdHomeViewContainer *container,
   priv = container->priv;
 
   priv->offset = CLUTTER_UNITS_TO_INT(offset);
+  if (priv->offset)
+    hd_home_view_container_set_views_cached (container, TRUE);
 
   clutter_actor_queue_relayout (CLUTTER_ACTOR (container));
 }
 
+/* Only the views which are actually painted make a snapshot.  When we
+ * settle, the snapshots of the views which can't be scrolled in next
+ * time are freed. */
+static void
+hd_home_view_container_set_views_cached (HdHomeViewContainer *container,
+                                         gboolean             cached)
+{
+  HdHomeViewContainerPrivate *priv = container->priv;
+  guint i;
+
+  /* Snapshotting inside the blurred or cached render manager is not
+   * supported by tidy_util_cogl_push_offscreen_buffer(). */
+  if (!STATE_IS_HOME (hd_render_manager_get_state ()))
+    cached = FALSE;
+
+  if (priv->views_cached == cached)
+    return;
+  priv->views_cached = cached;
+
+  for (i = 0; i < MAX_HOME_VIEWS; i++)
+    {
+      if (!priv->views[i])
+        continue;
+
+      hd_home_view_set_cached (HD_HOME_VIEW (priv->views[i]), cached);
+      if (!cached && i != priv->current_view
+          && i != priv->previous_view && i != priv->next_view)
+        tidy_cached_group_free_cache (priv->views[i]);
+    }
+}
+
 static void
 scroll_back_new_frame_cb (ClutterTimeline     *timeline,
                           gint                 frame_num,
@@ -963,6 +1001,9 @@ scroll_back_completed_cb (ClutterTimeline     *timeline,
     }
 
   priv->in_move = FALSE;
+  /* Unless the user is already panning again. */
+  if (!priv->offset)
+    hd_home_view_container_set_views_cached (container, FALSE);
 }
 
 /* Velocity is the speed in pixels/second, and we attempt to set the scroll
@@ -1030,6 +1071,7 @@ hd_home_view_container_scroll_back (HdHomeViewContainer *container, gint velocit
   scroll_back_new_frame_cb(priv->timeline, 0, container);
 
   priv->in_move = TRUE;
+  hd_home_view_container_set_views_cached (container, TRUE);
   clutter_timeline_start (priv->timeline);
 }
 
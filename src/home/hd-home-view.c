@@ -35,6 +35,7 @@
 #include "hd-render-manager.h"
 #include "hd-clutter-cache.h"
 #include "hd-transition.h"
+#include "hd-texture-loader.h"
 
 #include "hildon-desktop.h"
 #include "../tidy/tidy-sub-texture.h"
@@ -111,6 +112,8 @@ struct _HdHomeViewPrivate
   guint                     id;
 
   guint load_background_source;
+  /* The PVR backgrounds being loaded, landscape and portrait. */
+  HdTextureLoad *background_load[2];
 
   GConfClient *gconf_client;
 
@@ -121,6 +124,7 @@ static void hd_home_view_class_init (HdHomeViewClass *klass);
 static void hd_home_view_init       (HdHomeView *self);
 static void hd_home_view_dispose    (GObject *object);
 static void hd_home_view_finalize   (GObject *object);
+static void cancel_background_loads (HdHomeView *self);
 
 static void hd_home_view_set_property (GObject      *object,
 				       guint         prop_id,
@@ -169,7 +173,7 @@ struct _HdHomeViewAppletData
 static HdHomeViewAppletData *applet_data_new  (ClutterActor *actor);
 static void                  applet_data_free (HdHomeViewAppletData *data);
 
-G_DEFINE_TYPE (HdHomeView, hd_home_view, CLUTTER_TYPE_GROUP);
+G_DEFINE_TYPE (HdHomeView, hd_home_view, TIDY_TYPE_CACHED_GROUP);
 
 static void
 hd_home_view_allocate (ClutterActor          *actor,
@@ -423,6 +427,8 @@ hd_home_view_init (HdHomeView *self)
   /* Explicitly enable maemo-specific visibility detection to cut down
    * spurious paints */
   clutter_actor_set_visibility_detect(CLUTTER_ACTOR(self), TRUE);
+  /* When cached we're scrolled as a whole, don't lose any quality. */
+  tidy_cached_group_set_downsampling_factor(CLUTTER_ACTOR(self), 1);
 
   self->priv->gconf_client = gconf_client_get_default ();
 
@@ -438,6 +444,7 @@ hd_home_view_dispose (GObject *object)
   /* Remove idle/timeout handlers */
   if (priv->load_background_source)
     priv->load_background_source = (g_source_remove (priv->load_background_source), 0);
+  cancel_background_loads (self);
 
   if (priv->gconf_client)
     priv->gconf_client = (g_object_unref (priv->gconf_client), NULL);
@@ -554,6 +561,50 @@ set_background_common (HdHomeView *hview, ClutterActor *new_bg)
     
 }
 
+static void
+cancel_background_loads (HdHomeView *self)
+{
+  HdHomeViewPrivate *priv = self->priv;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (priv->background_load); i++)
+    if (priv->background_load[i])
+      {
+        hd_texture_loader_cancel (priv->background_load[i]);
+        priv->background_load[i] = NULL;
+      }
+}
+
+static void
+background_loaded_common (HdHomeView *self, ClutterActor *new_bg,
+                          const GError *error, gboolean is_portrait)
+{
+  HdHomeViewPrivate *priv = self->priv;
+
+  priv->background_load[is_portrait] = NULL;
+  if (!new_bg)
+    g_warning ("Error loading cached %sbackground image. %s",
+               is_portrait ? "portrait " : "",
+               error ? error->message : "");
+
+  priv->is_portrait = is_portrait;
+  set_background_common (self, new_bg);
+  priv->is_portrait = FALSE;
+}
+
+static void
+background_loaded (ClutterActor *new_bg, const GError *error, gpointer view)
+{
+  background_loaded_common (HD_HOME_VIEW (view), new_bg, error, FALSE);
+}
+
+static void
+portrait_background_loaded (ClutterActor *new_bg, const GError *error,
+                            gpointer view)
+{
+  background_loaded_common (HD_HOME_VIEW (view), new_bg, error, TRUE);
+}
+
 static gboolean
 load_background_idle (gpointer data)
 {
@@ -599,19 +650,23 @@ load_background_idle (gpointer data)
             cached_background_image_file = g_strdup_printf (CACHED_BACKGROUND_IMAGE_FILE_PVR,
                                                             g_get_home_dir (),
                                                             priv->id + 1);
-
-            new_bg = clutter_texture_new_from_file (cached_background_image_file,
-                                                      &error);
           }
         else 
           {
             cached_background_image_file = g_strdup_printf (CACHED_BACKGROUND_IMAGE_FILE_PVR_PORTRAIT,
                                                             g_get_home_dir (),
                                                             priv->id + 1);
-
-            new_bg = clutter_texture_new_from_file (cached_background_image_file,
-                                                    &error_portrait);
           }
+
+        /* Map the file and fault it in in the background, then upload
+         * it straight from the mapping in background_loaded(). */
+        priv->background_load[i] = hd_texture_loader_load_async (
+                                        cached_background_image_file,
+                                        i ? portrait_background_loaded
+                                          : background_loaded,
+                                        self);
+        g_free (cached_background_image_file);
+        continue;
       }
     else
       {
@@ -722,9 +777,9 @@ load_background_idle (gpointer data)
     g_free (cached_background_image_file);
 
     set_background_common (self, new_bg);  
-    priv->load_background_source = 0;
   }
 
+  priv->load_background_source = 0;
   priv->is_portrait = FALSE;
 
   return FALSE;
@@ -749,6 +804,8 @@ hd_home_view_set_live_bg (HdHomeView *view,
       g_source_remove (priv->load_background_source);
       priv->load_background_source = 0;
     }
+  if (!above_applets)
+    cancel_background_loads (view);
 
   if (client) 
     {
@@ -807,6 +864,9 @@ hd_home_view_load_background (HdHomeView *view)
   if (hd_home_view_container_get_current_view (priv->view_container) == priv->id)
     priority = G_PRIORITY_HIGH_IDLE;
 
+  /* What's being loaded now is stale. */
+  cancel_background_loads (view);
+
   priv->load_background_source = g_idle_add_full (priority,
                                                   load_background_idle,
                                                   view,
@@ -1933,3 +1993,16 @@ hd_home_view_change_wallpaper(HdHomeView *view)
   priv->background = new_bg;
   priv->background_sub = new_bg_sub;
 }
+
+/* While the views are swiped they are painted from a snapshot instead
+ * of their backgrounds and applets, and are live again when settled. */
+void
+hd_home_view_set_cached (HdHomeView *view, gboolean cached)
+{
+  ClutterActor *actor = CLUTTER_ACTOR (view);
+
+  if (cached)
+    /* Take a new snapshot the next time we're painted. */
+    tidy_cached_group_changed (actor);
+  tidy_cached_group_set_render_cache (actor, cached ? 1 : 0);
+}
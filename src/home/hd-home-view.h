@@ -29,6 +29,7 @@
 #include <X11/Xlib.h>
 
 #include <clutter/clutter-group.h>
+#include "../tidy/tidy-cached-group.h"
 #include <matchbox/core/mb-wm.h>
 #include <matchbox/core/mb-wm-client.h>
 
@@ -47,12 +48,12 @@ typedef struct _HdHomeViewPrivate HdHomeViewPrivate;
 
 struct _HdHomeViewClass
 {
-  ClutterGroupClass parent_class;
+  TidyCachedGroupClass parent_class;
 };
 
 struct _HdHomeView
 {
-  ClutterGroup          parent;
+  TidyCachedGroup       parent;
 
   HdHomeViewPrivate    *priv;
 };
@@ -92,6 +93,8 @@ void hd_home_view_update_state (HdHomeView *view);
 void hd_home_view_change_applets_position (HdHomeView *view);
 void hd_home_view_change_wallpaper(HdHomeView *view);
 
+void hd_home_view_set_cached (HdHomeView *view, gboolean cached);
+
 G_END_DECLS
 
 #endif
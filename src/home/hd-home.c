@@ -42,6 +42,7 @@
 #include "hd-launcher-app.h"
 #include "hd-dbus.h"
 #include "hd-title-bar.h"
+#include "hd-frame-governor.h"
 
 #include <clutter/clutter.h>
 #include <clutter/x11/clutter-x11.h>
@@ -835,6 +836,23 @@ hd_home_desktop_key_press (XKeyEvent *xev, void *userdata)
                           d=23;
                           break;
           }
+          /* Type-to-search only starts with keys which aren't accelerators,
+           * but once started it gets all of them. */
+          if (conf_enable_launcher_search
+              && (hd_launcher_is_searching ()
+                  || !(d && conf_enable_launcher_navigator_accel))) {
+                gdk_keymap_translate_keyboard_state (keymap,
+                                       xev->keycode,
+                                       xev->state,
+                                       0,
+                                       &keyval,
+                                       NULL, NULL, NULL);
+                if (hd_launcher_key_typed (keyval == GDK_BackSpace
+                                           ? '\b'
+                                           : gdk_keyval_to_unicode (keyval)))
+                      /* Still report it on D-Bus as before. */
+                      d = 0;
+          }
           if (d && conf_enable_launcher_navigator_accel) {
                 hd_launcher_activate(xev->keycode-d);
           } else if(conf_enable_dbus_launcher_navigator) {
@@ -1224,6 +1242,11 @@ hd_home_set_live_background (HdHome *home, MBWindowManagerClient *client)
   HdHomePrivate *priv = home->priv;
   hd_home_view_container_set_live_bg (HD_HOME_VIEW_CONTAINER (
                                            priv->view_container), client);
+
+  if (client->window->live_background)
+    hd_frame_governor_add_client (client);
+  else
+    hd_frame_governor_remove_client (client);
 }
 
 /* Called when a client message is sent to the root window. */
@@ -1340,7 +1363,9 @@ hd_home_constructed (GObject *object)
 
   clutter_actor_set_name (CLUTTER_ACTOR(object), "HdHome");
 
-  priv->front = CLUTTER_GROUP(clutter_group_new());
+  /* A cached group so the render manager can flatten it, see
+   * hd_render_manager_add_flattened(). */
+  priv->front = CLUTTER_GROUP(tidy_cached_group_new());
   clutter_actor_set_name (CLUTTER_ACTOR(priv->front), "HdHome:front");
   clutter_container_add_actor (CLUTTER_CONTAINER (object),
                                CLUTTER_ACTOR(priv->front));
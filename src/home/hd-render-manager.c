@@ -46,11 +46,13 @@
 #include "hd-app.h"
 #include "hd-dialog.h"
 #include "hd-app-menu.h"
+#include "hd-frame-governor.h"
 
 #include <matchbox/core/mb-wm.h>
 #include <matchbox/theme-engines/mb-wm-theme.h>
 
 #include <sys/time.h>
+#include <string.h>
 
 #define ZOOM_INCREMENT 0.1
 
@@ -69,6 +71,13 @@
 #else
 # define VISIBILITY(...)  /* NOP */
 #endif
+
+/* Number of actors moved by each hd_render_manager_restack(). */
+#if 0
+# define RESTACK          g_debug
+#else
+# define RESTACK(...)     /* NOP */
+#endif
 /* ------------------------------------------------------------------------- */
 #define I_(str) (g_intern_static_string ((str)))
 
@@ -130,6 +139,9 @@ G_DEFINE_TYPE (HdRenderManager, hd_render_manager, TIDY_TYPE_CACHED_GROUP);
 /* The HdRenderManager singleton */
 static HdRenderManager *render_manager = NULL;
 
+/* Per-frame and per-restack temporaries, see hd_render_manager_get_scratch(). */
+static HdArena *scratch = NULL;
+
 /* HdRenderManager properties */
 enum
 {
@@ -246,6 +258,14 @@ struct _HdRenderManagerPrivate {
   GdkRegion           *current_input_viewport;
   GdkRegion           *new_input_viewport;
   guint                input_viewport_callback;
+
+  /* How many restacks there were and how many actors they moved. */
+  guint                restacks, restack_moves, restack_max_moves;
+
+  /* Cached groups painted from their cache while @timeline_blur is
+   * playing, see hd_render_manager_add_flattened(). */
+  GPtrArray           *flattened;
+  gboolean             is_flattened;
 };
 
 /* ------------------------------------------------------------------------- */
@@ -262,6 +282,8 @@ on_timeline_blur_new_frame(ClutterTimeline *timeline,
                            gint frame_num, gpointer data);
 static void
 on_timeline_blur_completed(ClutterTimeline *timeline, gpointer data);
+static void
+hd_render_manager_set_flattened(gboolean flat);
 
 static void
 hd_render_manager_sync_clutter_before(void);
@@ -402,6 +424,8 @@ hd_render_manager_create (HdCompMgr *hdcompmgr,
                            G_CALLBACK(stage_allocation_changed), priv->home);
   clutter_container_add_actor(CLUTTER_CONTAINER(priv->home_blur),
                               CLUTTER_ACTOR(priv->home));
+  /* The applets are faded and zoomed with the background. */
+  hd_render_manager_add_flattened(hd_home_get_front(priv->home));
 
   /* Edit button */
   clutter_container_add_actor(CLUTTER_CONTAINER(priv->blur_front),
@@ -427,6 +451,32 @@ hd_render_manager_get (void)
   return render_manager;
 }
 
+static void
+hd_render_manager_reset_scratch (ClutterActor *stage, gpointer unused)
+{
+  hd_arena_reset (scratch);
+}
+
+/*
+ * Returns the arena for temporaries which don't need to outlive the
+ * current frame.  It is reset after the stage is painted, so it must
+ * not be used for anything kept across a return to the main loop.
+ * Code which might run many times a frame should hd_arena_mark() and
+ * hd_arena_release() it as well.
+ */
+HdArena *
+hd_render_manager_get_scratch (void)
+{
+  if (G_UNLIKELY (!scratch))
+    {
+      scratch = hd_arena_new ("render manager scratch", 4096);
+      g_signal_connect_after (clutter_stage_get_default (), "paint",
+                              G_CALLBACK (hd_render_manager_reset_scratch),
+                              NULL);
+    }
+  return scratch;
+}
+
 static void
 hd_render_manager_finalize (GObject *gobject)
 {
@@ -505,6 +555,7 @@ hd_render_manager_init (HdRenderManager *self)
   priv->state = HDRM_STATE_UNDEFINED;
   priv->previous_state = HDRM_STATE_UNDEFINED;
   priv->current_blur = HDRM_BLUR_NONE;
+  priv->flattened = g_ptr_array_new ();
 
   priv->home_blur = TIDY_BLUR_GROUP(tidy_blur_group_new());
   clutter_actor_set_name(CLUTTER_ACTOR(priv->home_blur),
@@ -672,6 +723,7 @@ on_timeline_blur_completed (ClutterTimeline *timeline, gpointer data)
 
   priv->timeline_playing = FALSE;
   hd_comp_mgr_set_effect_running(priv->comp_mgr, FALSE);
+  hd_render_manager_set_flattened(FALSE);
 
   g_signal_emit (render_manager, signals[TRANSITION_COMPLETE], 0);
 
@@ -686,6 +738,40 @@ on_timeline_blur_completed (ClutterTimeline *timeline, gpointer data)
 /* -------------------------------------------------------------    PRIVATE  */
 /* ------------------------------------------------------------------------- */
 
+/* Switch the caching of the @flattened subtrees on or off. */
+static void
+hd_render_manager_set_flattened (gboolean flat)
+{
+  HdRenderManagerPrivate *priv = render_manager->priv;
+  guint i;
+
+  if (flat && !hd_transition_get_int ("blur", "flatten", 1))
+    flat = FALSE;
+  if (priv->is_flattened == flat)
+    return;
+
+  priv->is_flattened = flat;
+  for (i = 0; i < priv->flattened->len; i++)
+    {
+      ClutterActor *actor = priv->flattened->pdata[i];
+
+      if (flat)
+        /* Whatever we had cached since the last time is stale. */
+        tidy_cached_group_changed (actor);
+      tidy_cached_group_set_render_cache (actor, flat ? 1 : 0);
+      if (!flat)
+        /* Don't keep the texture around until the next transition. */
+        tidy_cached_group_free_cache (actor);
+    }
+}
+
+static void
+hd_render_manager_flattened_gone (gpointer unused, GObject *where)
+{
+  if (render_manager)
+    g_ptr_array_remove_fast (render_manager->priv->flattened, where);
+}
+
 static
 void hd_render_manager_set_blur (HDRMBlurEnum blur)
 {
@@ -778,6 +864,10 @@ void hd_render_manager_set_blur (HDRMBlurEnum blur)
       priv->applets_opacity.b = 1;
     }
 
+  /* Let it choose the resolution for where we're going. */
+  tidy_blur_group_set_target_blur(CLUTTER_ACTOR(priv->home_blur),
+                                  priv->home_radius.b);
+
   /* Just make sure that we set everything up correctly - even if the
    * ranges are the same, we may have changed 'a' and 'b' together
    * (see applets_opacity). Otherwise it is possible to get a frame
@@ -793,11 +883,13 @@ void hd_render_manager_set_blur (HDRMBlurEnum blur)
       range_equal(&priv->task_nav_zoom) &&
       range_equal(&priv->applets_opacity))
     {
+      hd_render_manager_set_flattened(FALSE);
       hd_render_manager_sync_clutter_after();
       return;
     }
 
   hd_comp_mgr_set_effect_running(priv->comp_mgr, TRUE);
+  hd_render_manager_set_flattened(TRUE);
   /* Set duration here so we reload from the file every time */
   clutter_timeline_set_duration(priv->timeline_blur,
       hd_transition_get_int("blur", "duration", 250));
@@ -1132,6 +1224,9 @@ void hd_render_manager_sync_clutter_after ()
                              CLUTTER_ACTOR(priv->home_blur));
       hd_render_manager_blurred_changed();
     }
+
+  /* Blurring has settled, live clients may need to slow down. */
+  hd_frame_governor_update();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -2120,6 +2215,151 @@ hd_render_manager_get_geo_for_current_screen(ClutterActor *actor,
     *geo = rgeo;
 }
 
+/*
+ * Have @cached_group painted from a snapshot of its children during
+ * the transitions between states, where it would be painted in full
+ * in every frame otherwise.  Meant for expensive subtrees which hardly
+ * change meanwhile.  The snapshot is updated whenever the children
+ * are redrawn anyway, and is thrown away after the transition.
+ */
+void hd_render_manager_add_flattened(ClutterActor *cached_group)
+{
+  HdRenderManagerPrivate *priv = render_manager->priv;
+
+  g_return_if_fail(TIDY_IS_CACHED_GROUP(cached_group));
+
+  tidy_cached_group_set_auto_update(cached_group, TRUE);
+  tidy_cached_group_set_use_alpha(cached_group, TRUE);
+  tidy_cached_group_set_downsampling_factor(cached_group, 1);
+  if (priv->is_flattened)
+    tidy_cached_group_set_render_cache(cached_group, 1);
+
+  g_ptr_array_add(priv->flattened, cached_group);
+  g_object_weak_ref(G_OBJECT(cached_group),
+                    hd_render_manager_flattened_gone, NULL);
+}
+
+void hd_render_manager_dump_flatten_stats()
+{
+  HdRenderManagerPrivate *priv = render_manager->priv;
+  guint i, hits, misses;
+
+  for (i = 0; i < priv->flattened->len; i++)
+    {
+      ClutterActor *actor = priv->flattened->pdata[i];
+
+      tidy_cached_group_get_stats(actor, &hits, &misses);
+      g_debug("flattened %s: %u paints from cache, %u updates",
+              clutter_actor_get_name(actor) ?: "(unnamed)", hits, misses);
+    }
+}
+
+void hd_render_manager_dump_restack_stats()
+{
+  HdRenderManagerPrivate *priv = render_manager->priv;
+
+  g_debug("restacks: %u, actors moved: %u, at most %u at once",
+          priv->restacks, priv->restack_moves, priv->restack_max_moves);
+}
+
+/* Prepends @actor to the list at @data in the scratch arena
+ * if it's visible. */
+static void
+hd_render_manager_prepend_visible_cb(ClutterActor *actor, gpointer data)
+{
+  GList **list = data;
+
+  if (CLUTTER_ACTOR_IS_VISIBLE(actor))
+    *list = hd_arena_list_prepend(scratch, *list, actor);
+}
+
+/*
+ * Reorders the children of @group so that the ones in @top come last,
+ * in the order of @top, while the others keep their relative order
+ * below them.  Only the actors which are out of the longest run of
+ * children already in the right order are moved.  Returns how many.
+ */
+static guint
+hd_render_manager_sync_group_order(ClutterGroup *group, GPtrArray *top)
+{
+  static GHashTable *top_index;
+  HdArena *arena;
+  HdArenaMark mark;
+  ClutterActor **current, **wanted;
+  guint *position, *tails, *prev;
+  gboolean *keep;
+  guint n, nbelow, ntails, i, moves;
+  GList *children, *li;
+
+  if (!top_index)
+    top_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+  for (i = 0; i < top->len; i++)
+    g_hash_table_insert(top_index, top->pdata[i], GUINT_TO_POINTER(i+1));
+
+  children = clutter_container_get_children(CLUTTER_CONTAINER(group));
+  n = g_list_length(children);
+  g_assert(n >= top->len);
+
+  arena = hd_render_manager_get_scratch();
+  hd_arena_mark(arena, &mark);
+  current  = hd_arena_alloc(arena, n * sizeof(*current));
+  wanted   = hd_arena_alloc(arena, n * sizeof(*wanted));
+  position = hd_arena_alloc(arena, n * sizeof(*position));
+  tails    = hd_arena_alloc(arena, n * sizeof(*tails));
+  prev     = hd_arena_alloc(arena, n * sizeof(*prev));
+  keep     = hd_arena_alloc(arena, n * sizeof(*keep));
+
+  /* @position[i] := where the i-th child from the bottom should be */
+  for (li = children, i = nbelow = 0; li; li = li->next, i++)
+    {
+      guint t = GPOINTER_TO_UINT(g_hash_table_lookup(top_index, li->data));
+
+      current[i] = li->data;
+      position[i] = t ? n - top->len + t-1 : nbelow++;
+      wanted[position[i]] = current[i];
+      keep[i] = FALSE;
+    }
+  g_list_free(children);
+  g_hash_table_remove_all(top_index);
+
+  /* Find the longest increasing subsequence of @position.
+   * @tails[l] is the index of the smallest possible last element
+   * of a subsequence of length l+1, @prev links the subsequences. */
+  for (i = ntails = 0; i < n; i++)
+    {
+      guint lo = 0, hi = ntails;
+
+      while (lo < hi)
+        {
+          guint mid = (lo + hi) / 2;
+          if (position[tails[mid]] < position[i])
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+      prev[i] = lo > 0 ? tails[lo-1] : G_MAXUINT;
+      tails[lo] = i;
+      if (lo == ntails)
+        ntails++;
+    }
+  for (i = ntails ? tails[ntails-1] : G_MAXUINT; i != G_MAXUINT; i = prev[i])
+    keep[position[i]] = TRUE;
+
+  /* Put everything else right above its predecessor, in order. */
+  for (i = moves = 0; i < n; i++)
+    if (!keep[i])
+      {
+        if (i == 0)
+          clutter_actor_lower_bottom(wanted[i]);
+        else
+          clutter_actor_raise(wanted[i], wanted[i-1]);
+        moves++;
+      }
+
+  hd_arena_release(arena, &mark);
+  return moves;
+}
+
 /* Called to restack the windows in the way we use for rendering... */
 void hd_render_manager_restack()
 {
@@ -2128,22 +2368,31 @@ void hd_render_manager_restack()
   MBWindowManagerClient *c;
   gboolean past_desktop = FALSE;
   gboolean blur_changed = FALSE;
+#if STACKING_DEBUG || BLUR_DEBUG
   gint i;
+#endif
   GList *previous_home_blur = 0;
   unsigned int screenw, screenh;
   int curr_view;
   ClutterActor *live_bg_actor = NULL;
-  ClutterActor *child;
+  gint live_bg_pos = -1;
+  static GPtrArray *blurred;
+  guint moves;
+  HdArena *arena;
+  HdArenaMark mark;
 
   wm = MB_WM_COMP_MGR(priv->comp_mgr)->wm;
+  arena = hd_render_manager_get_scratch();
+  hd_arena_mark(arena, &mark);
   /* Add all actors currently in the home_blur group */
+  clutter_container_foreach(CLUTTER_CONTAINER(priv->home_blur),
+                            hd_render_manager_prepend_visible_cb,
+                            &previous_home_blur);
 
-  for (i = 0,
-       child = clutter_group_get_nth_child(CLUTTER_GROUP(priv->home_blur), 0);
-       child;
-       child = clutter_group_get_nth_child(CLUTTER_GROUP(priv->home_blur), ++i))
-    if (CLUTTER_ACTOR_IS_VISIBLE(child))
-      previous_home_blur = g_list_prepend(previous_home_blur, child);
+  /* The actors to be stacked at the top of home_blur, bottom first. */
+  if (!blurred)
+    blurred = g_ptr_array_new();
+  g_ptr_array_set_size(blurred, 0);
 
   screenw = hd_comp_mgr_get_current_screen_width ();
   screenh = hd_comp_mgr_get_current_screen_height ();
@@ -2230,6 +2479,7 @@ void hd_render_manager_restack()
                         {
                           clutter_actor_reparent(actor,
                                                  CLUTTER_ACTOR(priv->home_blur));
+                          parent = CLUTTER_ACTOR(priv->home_blur);
                         }
 #if STACKING_DEBUG
                       else
@@ -2237,11 +2487,21 @@ void hd_render_manager_restack()
                             clutter_actor_get_name(actor)?clutter_actor_get_name(actor):"?",
                             clutter_actor_get_name(parent)?clutter_actor_get_name(parent):"?");
 #endif /*STACKING_DEBUG*/
-                     clutter_actor_raise_top(actor);
+                     /* home_blur is put in order at once afterwards. */
+                     if (parent == CLUTTER_ACTOR(priv->home_blur))
+                       g_ptr_array_add(blurred, actor);
+                     else
+                       clutter_actor_raise_top(actor);
                      if (live_bg_actor && c->desktop == curr_view
                          && MB_WM_CLIENT_CLIENT_TYPE (c)
                                              == HdWmClientTypeHomeApplet)
-                       clutter_actor_raise_top (live_bg_actor);
+                       {
+                         if (clutter_actor_get_parent(live_bg_actor)
+                             == CLUTTER_ACTOR(priv->home_blur))
+                           live_bg_pos = blurred->len;
+                         else
+                           clutter_actor_raise_top (live_bg_actor);
+                       }
                     }
 #if STACKING_DEBUG
                   else
@@ -2260,19 +2520,36 @@ void hd_render_manager_restack()
         }
     }
 
+  /* Put the live background right above the last applet and move
+   * only what is out of order. */
+  if (live_bg_pos >= 0)
+    {
+      g_ptr_array_add(blurred, NULL);
+      memmove(&blurred->pdata[live_bg_pos+1], &blurred->pdata[live_bg_pos],
+              (blurred->len-1 - live_bg_pos) * sizeof(blurred->pdata[0]));
+      blurred->pdata[live_bg_pos] = live_bg_actor;
+    }
+  moves = hd_render_manager_sync_group_order(CLUTTER_GROUP(priv->home_blur),
+                                             blurred);
+  priv->restacks++;
+  priv->restack_moves += moves;
+  if (priv->restack_max_moves < moves)
+    priv->restack_max_moves = moves;
+  RESTACK ("%u of %u actors moved", moves, blurred->len);
+
   /* Now start at the top and put actors in the non-blurred group
    * until we find one that fills the screen. If we didn't find
    * any that filled the screen then add the window that does. */
   {
-    gint i, n_elements;
+    GList *children, *li;
     gboolean move_to_front = TRUE;
     ClutterActor *highest_maximized = 0;
 
-    n_elements = clutter_group_get_n_children(CLUTTER_GROUP(priv->home_blur));
-    for (i = n_elements-1; i >= 0; i--)
+    children = clutter_container_get_children(
+                                      CLUTTER_CONTAINER(priv->home_blur));
+    for (li = g_list_last(children); li; li = li->prev)
       {
-        ClutterActor *child =
-          clutter_group_get_nth_child(CLUTTER_GROUP(priv->home_blur), i);
+        ClutterActor *child = li->data;
 
 	/* If the client decides its own visibility, skip it */
 	if (hd_render_manager_should_ignore_actor(child))
@@ -2320,6 +2597,7 @@ void hd_render_manager_restack()
               }
           }
       }
+    g_list_free(children);
 
     /* Put blur_front in the correct place, assuming it is in home_blur.
      * We want it above apps, but below anything non-fullscreen like
@@ -2350,25 +2628,21 @@ void hd_render_manager_restack()
   /* now compare the contents of home_blur to see if the blur group has
    * actually changed... We only look at *visible* children, which is
    * why it is a little complicated. */
-  GList *it;
-  for (i = 0, it = g_list_last(previous_home_blur),
-       child = clutter_group_get_nth_child(CLUTTER_GROUP(priv->home_blur), 0);
-       child && it;
-       child = clutter_group_get_nth_child(CLUTTER_GROUP(priv->home_blur), ++i),
-       it=it->prev)
+  GList *it, *current_home_blur = 0;
+  clutter_container_foreach(CLUTTER_CONTAINER(priv->home_blur),
+                            hd_render_manager_prepend_visible_cb,
+                            &current_home_blur);
+  for (it = previous_home_blur; it && current_home_blur;
+       it = it->next, current_home_blur = current_home_blur->next)
     {
-      /* search for next visible child */
-      while (child && !CLUTTER_ACTOR_IS_VISIBLE(child))
-        child=clutter_group_get_nth_child(CLUTTER_GROUP(priv->home_blur), ++i);
-
       /* now compare children */
-      if (CLUTTER_ACTOR(it->data) != child)
+      if (CLUTTER_ACTOR(it->data) != current_home_blur->data)
         {
           blur_changed = TRUE;
           break;
         }
     }
-  if (it || child)
+  if (it || current_home_blur)
     {
       blur_changed = TRUE;
     }
@@ -2400,7 +2674,7 @@ void hd_render_manager_restack()
           }
     }
 #endif
-  g_list_free(previous_home_blur);
+  hd_arena_release(arena, &mark);
 
   /* ----------------------------- DEBUG PRINTING */
 #if STACKING_DEBUG
@@ -2760,7 +3034,8 @@ void hd_render_manager_append_geo_cb(ClutterActor *actor, gpointer data)
       hd_render_manager_get_geo_for_current_screen(actor, &geo);
       if (!hd_render_manager_clip_geo (&geo))
         return;
-      *list = g_list_prepend(*list, g_memdup(&geo, sizeof(geo)));
+      *list = hd_arena_list_prepend(scratch, *list,
+                                    hd_arena_memdup(scratch, &geo, sizeof(geo)));
       VISIBILITY ("BLOCKER %dx%d%+d%+d", MBWM_GEOMETRY(&geo));
     }
 }
@@ -2769,7 +3044,7 @@ void hd_render_manager_set_visibilities()
 { VISIBILITY ("SET VISIBILITIES");
   HdRenderManagerPrivate *priv;
   GList *blockers = 0;
-  GList *it;
+  HdArenaMark mark;
   gint i, n_elements;
   ClutterGeometry fullscreen_geo = {0, 0,
           hd_comp_mgr_get_current_screen_width (),
@@ -2784,9 +3059,13 @@ void hd_render_manager_set_visibilities()
   if (STATE_IS_NON_COMP (priv->state))
     {
       hd_render_manager_set_input_viewport();
+      hd_frame_governor_update();
       return;
     }
 
+  /* The blockers only live until the end of this function. */
+  hd_arena_mark(hd_render_manager_get_scratch(), &mark);
+
   /* first append all the top elements... */
   clutter_container_foreach(CLUTTER_CONTAINER(priv->app_top),
                             hd_render_manager_append_geo_cb,
@@ -2828,7 +3107,8 @@ void hd_render_manager_set_visibilities()
               /* Add the geometry to our list of blockers and go to next... */
               if (hd_render_manager_actor_opaque(child))
                 {
-                  blockers = g_list_prepend(blockers, g_memdup(&geo, sizeof(geo)));
+                  blockers = hd_arena_list_prepend(scratch, blockers,
+                                   hd_arena_memdup(scratch, &geo, sizeof(geo)));
                   VISIBILITY ("MORE BLOCKER %dx%d%+d%+d", MBWM_GEOMETRY(&geo));
                 }
             }
@@ -2851,13 +3131,7 @@ void hd_render_manager_set_visibilities()
    * valid. See NB#117092 */
 
   /* now free blockers */
-  it = g_list_first(blockers);
-  while (it)
-    {
-      g_free(it->data);
-      it = it->next;
-    }
-  g_list_free(blockers);
+  hd_arena_release(scratch, &mark);
   blockers = 0;
 
   /* Do we have a fullscreen client totally filling the screen? */
@@ -2894,6 +3168,9 @@ void hd_render_manager_set_visibilities()
 
   hd_render_manager_update_status_area(has_fullscreen);
   hd_render_manager_set_input_viewport();
+
+  /* Occluded live clients needn't render at all. */
+  hd_frame_governor_update();
 }
 
 /* Called by hd-task-navigator when its state changes, as when notifications
@@ -35,6 +35,7 @@
 #include "hd-home.h"
 #include "../launcher/hd-launcher.h"
 #include "../tidy/tidy-cached-group.h"
+#include "hd-arena.h"
 
 G_BEGIN_DECLS
 
@@ -228,6 +229,9 @@ HdRenderManager *hd_render_manager_create (HdCompMgr *hdcompmgr,
 					   HdTaskNavigator *task_nav);
 HdRenderManager *hd_render_manager_get (void);
 
+/* Scratch memory which is reset after every frame. */
+HdArena *hd_render_manager_get_scratch (void);
+
 void hd_render_manager_set_status_area (ClutterActor *item);
 void hd_render_manager_set_status_menu (ClutterActor *item);
 void hd_render_manager_set_operator (ClutterActor *item);
@@ -258,6 +262,9 @@ void hd_render_manager_return_app (ClutterActor *actor);
 void hd_render_manager_return_dialog (ClutterActor *actor);
 
 void hd_render_manager_restack(void);
+void hd_render_manager_dump_restack_stats(void);
+void hd_render_manager_add_flattened(ClutterActor *cached_group);
+void hd_render_manager_dump_flatten_stats(void);
 void hd_render_manager_place_titlebar_elements(void);
 
 /* This stops any current transition that render manager is doing */
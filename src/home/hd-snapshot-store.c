@@ -0,0 +1,354 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <glib/gstdio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <libhildondesktop/hd-pvr-texture.h>
+
+#include "tidy/tidy-util.h"
+#include "tidy/tidy-sub-texture.h"
+
+#include "hd-snapshot-store.h"
+#include "hd-transition.h"
+#include "hd-texture-loader.h"
+
+/* Where the snapshots that don't fit in memory go. */
+#define SNAPSHOT_DIR      ".cache/hibernation"
+
+typedef struct
+{
+  guint       key;
+
+  /*
+   * -- @tex:     The snapshot if it's in memory, otherwise %NULL.
+   * -- @fname:   Where the snapshot is on disk if it's not in memory.
+   * -- @width, @height: The size of the window it was taken of.
+   * -- @size:    How many bytes of the budget it takes.
+   * -- @link:    Our link in @Store.lru.
+   */
+  CoglHandle  tex;
+  gchar      *fname;
+  guint       width, height;
+  gsize       size;
+  GList      *link;
+} Snapshot;
+
+static struct
+{
+  /* guint key -> Snapshot */
+  GHashTable *snapshots;
+
+  /* Of Snapshot:s, the most recently used first. */
+  GQueue      lru;
+
+  /* How much of the budgets are used, in bytes. */
+  gsize       mem_used, disk_used;
+
+  /* Writes snapshots to disk when we're over the memory budget. */
+  guint       spill_id;
+} Store;
+
+static gchar *
+snapshot_dir (void)
+{
+  return g_build_filename (g_get_home_dir (), SNAPSHOT_DIR, NULL);
+}
+
+/* Set up @Store and remove the snapshots of the previous session,
+ * whose applications can't be woken up anymore. */
+static void
+store_init (void)
+{
+  const gchar *fname;
+  gchar *dname;
+  GDir *dir;
+
+  if (Store.snapshots)
+    return;
+
+  Store.snapshots = g_hash_table_new (g_direct_hash, g_direct_equal);
+  g_queue_init (&Store.lru);
+
+  dname = snapshot_dir ();
+  if ((dir = g_dir_open (dname, 0, NULL)) != NULL)
+    {
+      while ((fname = g_dir_read_name (dir)) != NULL)
+        {
+          gchar *path = g_build_filename (dname, fname, NULL);
+          g_unlink (path);
+          g_free (path);
+        }
+      g_dir_close (dir);
+    }
+  g_free (dname);
+}
+
+static void
+drop_snapshot (Snapshot *snapshot)
+{
+  g_hash_table_remove (Store.snapshots, GUINT_TO_POINTER (snapshot->key));
+  g_queue_delete_link (&Store.lru, snapshot->link);
+
+  if (snapshot->tex)
+    {
+      cogl_texture_unref (snapshot->tex);
+      Store.mem_used -= snapshot->size;
+    }
+  else
+    {
+      g_unlink (snapshot->fname);
+      g_free (snapshot->fname);
+      Store.disk_used -= snapshot->size;
+    }
+
+  g_slice_free (Snapshot, snapshot);
+}
+
+/* Move @snapshot from memory to disk.  If we can't, just forget it. */
+static void
+write_snapshot (Snapshot *snapshot)
+{
+  GdkPixbuf *pixbuf;
+  GError *error;
+  gchar *dname;
+  struct stat sbuf;
+
+  /* Download the texture. */
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8,
+                           snapshot->width, snapshot->height);
+  if (!pixbuf)
+    goto out;
+  if (!cogl_texture_get_data (snapshot->tex, COGL_PIXEL_FORMAT_RGB_888,
+                              gdk_pixbuf_get_rowstride (pixbuf),
+                              gdk_pixbuf_get_pixels (pixbuf)))
+    {
+      g_warning ("%s: couldn't read back snapshot %08x", __FUNCTION__,
+                 snapshot->key);
+      goto out;
+    }
+
+  /* Compress it to disk. */
+  dname = snapshot_dir ();
+  g_mkdir_with_parents (dname, 0770);
+  snapshot->fname = g_strdup_printf ("%s/%08x.pvr", dname, snapshot->key);
+  g_free (dname);
+
+  error = NULL;
+  if (!hd_pvr_texture_save (snapshot->fname, pixbuf, &error))
+    {
+      g_warning ("%s: %s: %s", __FUNCTION__, snapshot->fname,
+                 error ? error->message : "unknown error");
+      if (error)
+        g_error_free (error);
+      goto out;
+    }
+  g_object_unref (pixbuf);
+
+  /* Move it to the disk budget. */
+  cogl_texture_unref (snapshot->tex);
+  snapshot->tex = NULL;
+  Store.mem_used -= snapshot->size;
+  snapshot->size = stat (snapshot->fname, &sbuf) == 0 ? sbuf.st_size : 0;
+  Store.disk_used += snapshot->size;
+  return;
+
+out:
+  if (pixbuf)
+    g_object_unref (pixbuf);
+  if (snapshot->fname)
+    {
+      g_unlink (snapshot->fname);
+      g_free (snapshot->fname);
+      snapshot->fname = NULL;
+    }
+  drop_snapshot (snapshot);
+}
+
+/*
+ * Writes the least recently used snapshot in memory to disk if we're
+ * over the memory budget, and forgets the least recently used ones on
+ * disk if we're over that budget.  Compressing takes time, so do one
+ * snapshot per call and keep being called while necessary.
+ */
+static gboolean
+spill (gpointer unused)
+{
+  gsize mem_budget, disk_budget;
+  GList *li, *prev;
+
+  mem_budget  = hd_transition_get_int ("snapshots", "memory_budget", 4096);
+  disk_budget = hd_transition_get_int ("snapshots", "disk_budget", 4096);
+  mem_budget *= 1024;
+  disk_budget *= 1024;
+
+  if (Store.mem_used > mem_budget)
+    for (li = Store.lru.tail; li; li = li->prev)
+      if (((Snapshot *)li->data)->tex)
+        {
+          write_snapshot (li->data);
+          break;
+        }
+
+  for (li = Store.lru.tail; li && Store.disk_used > disk_budget; li = prev)
+    {
+      prev = li->prev;
+      if (!((Snapshot *)li->data)->tex)
+        drop_snapshot (li->data);
+    }
+
+  if (Store.mem_used > mem_budget)
+    return TRUE;
+  Store.spill_id = 0;
+  return FALSE;
+}
+
+/* Render @actor into a new snapshot identified by @key,
+ * replacing the previous one if any. */
+void
+hd_snapshot_store_take (guint key, ClutterActor *actor)
+{
+  static const ClutterColor black = { 0x00, 0x00, 0x00, 0xff };
+  Snapshot *snapshot;
+  CoglHandle tex, fbo;
+  guint width, height;
+  gint x, y;
+
+  if (!hd_transition_get_int ("snapshots", "enabled", 1))
+    return;
+
+  clutter_actor_get_size (actor, &width, &height);
+  if (!width || !height)
+    return;
+
+  /* The snapshots are opaque, so they can be 16 bits deep. */
+  tex = cogl_texture_new_with_size (width, height, 0, FALSE,
+                                    COGL_PIXEL_FORMAT_RGB_565);
+  if (tex == COGL_INVALID_HANDLE)
+    return;
+  if ((fbo = cogl_offscreen_new_to_texture (tex)) == COGL_INVALID_HANDLE)
+    {
+      cogl_texture_unref (tex);
+      return;
+    }
+
+  /* Paint @actor at the origin of the texture. */
+  clutter_actor_get_position (actor, &x, &y);
+  cogl_push_matrix ();
+  tidy_util_cogl_push_offscreen_buffer (fbo);
+  cogl_paint_init (&black);
+  cogl_translate (-x, -y, 0);
+  clutter_actor_paint (actor);
+  tidy_util_cogl_pop_offscreen_buffer ();
+  cogl_pop_matrix ();
+  cogl_offscreen_unref (fbo);
+
+  store_init ();
+  hd_snapshot_store_forget (key);
+
+  snapshot = g_slice_new0 (Snapshot);
+  snapshot->key = key;
+  snapshot->tex = tex;
+  snapshot->width = width;
+  snapshot->height = height;
+  snapshot->size = width * height * 2;
+  g_queue_push_head (&Store.lru, snapshot);
+  snapshot->link = Store.lru.head;
+  g_hash_table_insert (Store.snapshots, GUINT_TO_POINTER (key), snapshot);
+  Store.mem_used += snapshot->size;
+
+  if (!Store.spill_id)
+    Store.spill_id = g_idle_add_full (G_PRIORITY_LOW, spill, NULL, NULL);
+}
+
+gboolean
+hd_snapshot_store_has (guint key)
+{
+  return Store.snapshots
+    && g_hash_table_lookup (Store.snapshots, GUINT_TO_POINTER (key));
+}
+
+/* Returns a new floating actor showing the snapshot identified by @key
+ * or %NULL if we don't have it.  Its natural size is that of the window
+ * it was taken of. */
+ClutterActor *
+hd_snapshot_store_get (guint key)
+{
+  Snapshot *snapshot;
+  ClutterActor *actor;
+  guint w, h;
+
+  if (!Store.snapshots
+      || !(snapshot = g_hash_table_lookup (Store.snapshots,
+                                           GUINT_TO_POINTER (key))))
+    return NULL;
+
+  /* Make it the most recently used. */
+  g_queue_unlink (&Store.lru, snapshot->link);
+  g_queue_push_head_link (&Store.lru, snapshot->link);
+
+  if (snapshot->tex)
+    {
+      actor = clutter_texture_new ();
+      clutter_texture_set_cogl_texture (CLUTTER_TEXTURE (actor),
+                                        snapshot->tex);
+      return actor;
+    }
+
+  if (!(actor = hd_texture_loader_load (snapshot->fname, NULL)))
+    {
+      g_warning ("%s: couldn't load %s", __FUNCTION__, snapshot->fname);
+      drop_snapshot (snapshot);
+      return NULL;
+    }
+
+  /* PVR textures are 2^n wide and high, crop them like the launcher
+   * does its loading screens. */
+  clutter_actor_get_size (actor, &w, &h);
+  if (w > snapshot->width || h > snapshot->height)
+    {
+      ClutterGeometry region = { 0, 0, snapshot->width, snapshot->height };
+      TidySubTexture *sub;
+
+      sub = tidy_sub_texture_new (CLUTTER_TEXTURE (actor));
+      tidy_sub_texture_set_region (sub, &region);
+      clutter_actor_set_size (CLUTTER_ACTOR (sub),
+                              region.width, region.height);
+      clutter_actor_hide (actor);
+      actor = CLUTTER_ACTOR (sub);
+    }
+
+  return actor;
+}
+
+void
+hd_snapshot_store_forget (guint key)
+{
+  Snapshot *snapshot;
+
+  if (Store.snapshots
+      && (snapshot = g_hash_table_lookup (Store.snapshots,
+                                          GUINT_TO_POINTER (key))))
+    drop_snapshot (snapshot);
+}
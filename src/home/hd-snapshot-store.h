@@ -0,0 +1,45 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Keeps the last frame of the windows of hibernated applications, so
+ * that the switcher can show them in the thumbnails and while the
+ * application is woken up.  The most recently used snapshots are kept
+ * in textures, the rest are PVR-compressed to disk until they fit in
+ * the budgets set in the [snapshots] section of transitions.ini.
+ * Snapshots are identified by the hibernation key of the window.
+ */
+
+#ifndef __HD_SNAPSHOT_STORE_H__
+#define __HD_SNAPSHOT_STORE_H__
+
+#include <clutter/clutter.h>
+
+G_BEGIN_DECLS
+
+void          hd_snapshot_store_take   (guint key, ClutterActor *actor);
+gboolean      hd_snapshot_store_has    (guint key);
+ClutterActor *hd_snapshot_store_get    (guint key);
+void          hd_snapshot_store_forget (guint key);
+
+G_END_DECLS
+
+#endif /* __HD_SNAPSHOT_STORE_H__ */
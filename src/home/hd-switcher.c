@@ -791,11 +791,21 @@ hd_switcher_zoom_in_complete (ClutterActor *actor, HdSwitcher *switcher)
   else
     {
       HdTitleBar *tbar = HD_TITLE_BAR (hd_render_manager_get_title_bar());
+      ClutterActor *snapshot;
       gchar *text =
         g_strdup_printf (dgettext("maemo-af-desktop",
                                   "ckct_ib_application_resuming"),
                          hd_comp_mgr_client_get_app_local_name (hclient));
-      hd_render_manager_set_loading (actor);
+
+      /* Show the last frame of the client until it's back. */
+      if ((snapshot = hd_comp_mgr_client_get_snapshot (hclient)) != NULL)
+        {
+          g_object_ref_sink (snapshot);
+          hd_render_manager_set_loading (snapshot);
+          g_object_unref (snapshot);
+        }
+      else
+        hd_render_manager_set_loading (actor);
       hd_render_manager_set_state (HDRM_STATE_LOADING);
       hd_render_manager_stop_transition ();
       hd_title_bar_set_loading_title (tbar, text);
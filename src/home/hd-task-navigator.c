@@ -17,6 +17,7 @@
  *     .windows                 #ClutterGroup
  *       .apwin                 #ClutterActor
  *       .dialogs               #ClutterActor
+ *     .snapshot                #ClutterTexture
  *     .video                   #ClutterTexture
  *   .notwin                    #ClutterGroup         notifications
  *     .background              #ClutterCloneTexture  or apps w/notifs
@@ -24,11 +25,11 @@
  *     .icon                    #ClutterTexture
  *     .count, .time, .message  #ClutterLabel
  *   .plate                     #ClutterGroup
- *     .frame.all               #ClutterGroup         applications
- *       .frame.nw, .nm, .ne    #ClutterCloneTexture  applications
- *       .frame.mw,      .mw    #ClutterCloneTexture  applications
- *       .frame.sw, .sm, .sw    #ClutterCloneTexture  applications
- *     .title                   #ClutterLabel
+ *     .frame.all               #TidyBatchGroup       applications
+ *       .frame.nw, .nm, .ne    #TidySubTexture       applications
+ *       .frame.mw,      .mw    #TidySubTexture       applications
+ *       .frame.sw, .sm, .sw    #TidySubTexture       applications
+ *     .title                   hd_text_cache_label_new()
  *     .close                   #ClutterGroup
  *       .icon_app, .icon_notif #ClutterCloneTexture
  *
@@ -48,6 +49,7 @@
 #include <clutter/clutter.h>
 #include <tidy/tidy-finger-scroll.h>
 #include <tidy/tidy-desaturation-group.h>
+#include <tidy/tidy-batch-group.h>
 
 #include <matchbox/core/mb-wm.h>
 #include <matchbox/comp-mgr/mb-wm-comp-mgr.h>
@@ -62,6 +64,7 @@
 #include "hd-render-manager.h"
 #include "hd-title-bar.h"
 #include "hd-clutter-cache.h"
+#include "hd-text-cache.h"
 #include "hd-transition.h"
 #include "hd-theme.h"
 #include "hd-util.h"
@@ -313,6 +316,9 @@ typedef struct
    *                          with a little padding and scaled horizontally.
    */
   ClutterActor                *background, *separator;
+
+  /* Whether it's in @Intake.changed. */
+  gboolean                     changed;
 } TNote; /* }}} */
 
 /* Our central object, the thumbnail. {{{ */
@@ -439,6 +445,14 @@ typedef struct
       gchar               *saved_title;
       gboolean             title_had_markup;
 
+      /*
+       * -- @snapshot:    The last frame of the client before it went to
+       *                  hibernation, shown in place of @windows until
+       *                  the window actor is replaced.  %NULL if the
+       *                  client is awake or we don't have a snapshot.
+       */
+      ClutterActor        *snapshot;
+
       /*
        * -- @nodest:      What notifications this thumbnails is destination for.
        *                  Taken from the _HILDON_NOTIFICATION_THREAD property
@@ -484,6 +498,12 @@ typedef struct
    */
   gboolean portrait_supported;
 
+  /* -- @cell_x, @cell_y: Where layout_thumbs() last placed @thwin,
+   *                      so it can leave alone those whose cell hasn't
+   *                      changed.
+   */
+  guint cell_x, cell_y;
+
 } Thumbnail; /* }}} */
 /* Thumbnail data structures }}} */
 
@@ -709,6 +729,38 @@ static const GtkRequisition *Thumbsize;
 /* Do we have notifications since we were last in task navigator? */
 static gboolean UnseenNotifications = FALSE;
 
+/*
+ * -- @Layouts:           The %Layout:s built by calc_layout() so far,
+ *                        one table per orientation indexed by the number
+ *                        of thumbnails.  Unbuilt entries are zeroed.
+ */
+static GArray *Layouts[G_N_ELEMENTS (Thumbsizes)];
+
+/*
+ * What has happened to notifications since the @Grid was last layed out.
+ * Notifications often come in storms (an IM client catching up), so
+ * their arrival, changes and removal are only reflected in the @Grid
+ * by flush_intake() before the next frame, with a single layout and
+ * render manager update for all of them.
+ * -- @newborns:      Thumbnails to be layed out without flying in.
+ * -- @newborn_notes: The notification thumbnails among @newborns,
+ *                    to be faded in.
+ * -- @changed:       %TNote:s whose %HdNote has changed.
+ * -- @threads:       The latest notification thread of application
+ *                    windows, #ClutterActor -> XFree()able string,
+ *                    or %NULL to clear it.
+ * -- @relayout:      Whether layout_thumbs() is due.
+ * -- @update_hdrm:   Whether hd_render_manager_update() is due.
+ * -- @flush_cb:      GSource id of flush_intake_idle().
+ */
+static struct
+{
+  GList *newborns, *newborn_notes, *changed;
+  GHashTable *threads;
+  gboolean relayout, update_hdrm;
+  guint flush_cb;
+} Intake;
+
 /*
  * Effect templates and their corresponding timelines.
  * -- @Fly_effect:  For moving thumbnails and notification windows around
@@ -926,6 +978,8 @@ get_icon (const gchar * iname, guint isize)
 {
   static GHashTable *cache;
   ClutterActor *icon;
+  HdArena *arena;
+  HdArenaMark mark;
   gchar *ikey;
   guint w, h;
 
@@ -934,22 +988,25 @@ get_icon (const gchar * iname, guint isize)
 
   /* Is it cached?  We can't use %HdClutterCache because that doesn't
    * handle icons and we may need to load the same icon with different
-   * sizes. */
-  ikey = g_strdup_printf ("%s-%u", iname, isize);
+   * sizes.  The key only goes to the heap if it's inserted. */
+  arena = hd_render_manager_get_scratch ();
+  hd_arena_mark (arena, &mark);
+  ikey = hd_arena_strdup_printf (arena, "%s-%u", iname, isize);
   if (cache && (icon = g_hash_table_lookup (cache, ikey)) != NULL)
     { /* Yeah */
-      g_free (ikey);
+      hd_arena_release (arena, &mark);
     }
   else if ((icon = load_icon (iname, isize)) != NULL)
     { /* No, but we could load it. */
       if (!cache)
         cache = g_hash_table_new_full (g_str_hash, g_str_equal,
                                        g_free, g_object_unref);
-      g_hash_table_insert (cache, ikey, icon);
+      g_hash_table_insert (cache, g_strdup (ikey), icon);
+      hd_arena_release (arena, &mark);
     }
   else
     { /* Couldn't load it. */
-      g_free (ikey);
+      hd_arena_release (arena, &mark);
       g_critical ("%s: failed to load icon", iname);
       goto out;
     }
@@ -1895,14 +1952,12 @@ layout_fun (gint total, gint term1, gint term2, gint factor)
   return (total - (term1*factor + term2*(factor - 1))) / 2;
 }
 
-/* Calculates the layout of the thumbnails and fills in @lout.
- * The layout depends on the number of thumbnails. */
+/* Fills in @lout with the layout of @nthumbs thumbnails in the current
+ * orientation, using the %taskswitcher tweak @tweak_taskswitcher. */
 static void
-calc_layout (Layout * lout)
+build_layout (Layout * lout, guint nthumbs, gint tweak_taskswitcher)
 {
   guint nrows_per_page;
-  int tweak_taskswitcher = hd_transition_get_int("thp_tweaks",
-                                                 "taskswitcher", 0);
 
   /* Figure out how many thumbnails to squeeze into one row
    * (not the last one, which may be different) and the maximum
@@ -1919,30 +1974,30 @@ calc_layout (Layout * lout)
     {
       /* Two-column layout */
       lout->thumbsize = &Thumbsizes[IS_PORTRAIT].twocol;
-      lout->cells_per_row = NThumbnails < 2 ? 1 : 2;
-      nrows_per_page = NThumbnails <= 2 ? 1 : 2;
+      lout->cells_per_row = nthumbs < 2 ? 1 : 2;
+      nrows_per_page = nthumbs <= 2 ? 1 : 2;
     }
   else
     {
       /* The original Maemo 5 layout method */
-      if (NThumbnails <= 3)
+      if (nthumbs <= 3)
         {
-          lout->thumbsize = NThumbnails <= 2
+          lout->thumbsize = nthumbs <= 2
 	    ? &Thumbsizes[IS_PORTRAIT].large : &Thumbsizes[IS_PORTRAIT].medium;
-          lout->cells_per_row = NThumbnails;
+          lout->cells_per_row = nthumbs;
 	  nrows_per_page = 1;
         }
-      else if (NThumbnails <= (IS_PORTRAIT?9:6))
+      else if (nthumbs <= (IS_PORTRAIT?9:6))
         {
 	  lout->thumbsize = &Thumbsizes[IS_PORTRAIT].medium;
           lout->cells_per_row = 3;
-	  nrows_per_page = IS_PORTRAIT?(NThumbnails>6?3:2):2;
+	  nrows_per_page = IS_PORTRAIT?(nthumbs>6?3:2):2;
         }
       else
         {
 	  lout->thumbsize = &Thumbsizes[IS_PORTRAIT].small;
           lout->cells_per_row = 4;
-	  nrows_per_page= ((NThumbnails-1) / 4)+1;
+	  nrows_per_page= ((nthumbs-1) / 4)+1;
         }
     }
 
@@ -1959,7 +2014,7 @@ calc_layout (Layout * lout)
                            lout->cells_per_row);
 
   lout->last_row_xpos = lout->xpos;
-  if (NThumbnails <= (IS_PORTRAIT?20:12))
+  if (nthumbs <= (IS_PORTRAIT?20:12))
     lout->ypos = GRID_TOP_MARGIN + layout_fun (DESKTOP_HEIGHT - GRID_TOP_MARGIN,
                              lout->thumbsize->height,
                              GRID_VERTICAL_GAP,
@@ -1970,6 +2025,44 @@ calc_layout (Layout * lout)
   lout->vspace = lout->thumbsize->height + GRID_VERTICAL_GAP;
 }
 
+/* Calculates the layout of the thumbnails and fills in @lout.
+ * The layout depends on the number of thumbnails and the orientation.
+ * It is looked up in @Layouts, and only built the first time it's
+ * needed after transitions.ini was (re)loaded. */
+static void
+calc_layout (Layout * lout)
+{
+  static guint generation;
+  static gint tweak_taskswitcher;
+  GArray *table;
+  Layout *entry;
+
+  if (!Layouts[IS_PORTRAIT] || generation != hd_transition_get_generation ())
+    {
+      guint i;
+
+      /* The tweak may have changed, start over. */
+      for (i = 0; i < G_N_ELEMENTS (Layouts); i++)
+        if (Layouts[i])
+          g_array_set_size (Layouts[i], 0);
+        else
+          Layouts[i] = g_array_new (FALSE, TRUE, sizeof (Layout));
+      generation = hd_transition_get_generation ();
+      tweak_taskswitcher = hd_transition_get_int ("thp_tweaks",
+                                                  "taskswitcher", 0);
+    }
+
+  table = Layouts[IS_PORTRAIT];
+  if (table->len <= NThumbnails)
+    g_array_set_size (table, NThumbnails + 1);
+
+  /* Unbuilt entries are all zero, built ones have at least one cell. */
+  entry = &g_array_index (table, Layout, NThumbnails);
+  if (!entry->cells_per_row)
+    build_layout (entry, NThumbnails, tweak_taskswitcher);
+  *lout = *entry;
+}
+
 /* Depending on the current @Thumbsize places the frame graphics
  * elements of @thumb where they should be. */
 static void
@@ -2213,8 +2306,9 @@ layout_notwin (Thumbnail * thumb, const GtkRequisition * oldthsize,
 /*
  * Lays out @Thumbnails on @Grid, and their inner portions.  Makes actors fly
  * if it's appropriate.  @newborn is either a new thumbnail or notification
- * to be displayed; it won't be animated.  Returns the position of the bottom
- * of the lowest thumbnail.  Also sets @Thumbsize.
+ * to be displayed; it won't be animated, and neither will be the
+ * @Intake.newborns.  Returns the position of the bottom of the lowest
+ * thumbnail.  Also sets @Thumbsize.
  */
 static guint
 layout_thumbs (ClutterActor * newborn)
@@ -2252,6 +2346,7 @@ layout_thumbs (ClutterActor * newborn)
   for (li = Thumbnails, i = 0; li && (thumb = li->data); li = li->next, i++)
     {
       const Flyops *ops;
+      gboolean is_newborn;
 
       /* If it's a new row re/set @ythumb and @xthumb. */
       g_assert (lout.cells_per_row > 0);
@@ -2270,14 +2365,23 @@ layout_thumbs (ClutterActor * newborn)
 
       /* If @thwin's been there, animate as it's moving.  Otherwise if it's
        * a new one to enter the navigator, don't, it's hidden anyway. */
-      ops = thumb->thwin == newborn ? &Fly_at_once : &Fly_smoothly;
+      is_newborn = thumb->thwin == newborn
+        || g_list_find (Intake.newborns, thumb->thwin);
+      ops = is_newborn ? &Fly_at_once : &Fly_smoothly;
+
+      /* If @Thumbnails are not changing size and this is not a newborn
+       * the inners of @thumb are already setup, and if its cell hasn't
+       * changed either it's already there or on its way. */
+      if (oldthsize == Thumbsize && !is_newborn
+          && thumb->cell_x == xthumb && thumb->cell_y == ythumb)
+        goto skip_the_circus;
 
       /* Place @thwin in any case. */
       ops->move (thumb->thwin, xthumb, ythumb);
+      thumb->cell_x = xthumb;
+      thumb->cell_y = ythumb;
 
-      /* If @Thumbnails are not changing size and this is not a newborn
-       * the inners of @thumb are already setup. */
-      if (oldthsize == Thumbsize && thumb->thwin != newborn)
+      if (oldthsize == Thumbsize && !is_newborn)
           goto skip_the_circus;
 
       /* Set thumbnail's reaction area. */
@@ -2287,8 +2391,7 @@ layout_thumbs (ClutterActor * newborn)
       ops->move (thumb->close, Thumbsize->width, 0);
 
       /* Make sure @thumb->title remains inside its confines. */
-      ops->resize (thumb->title, maxwtitle,
-                   clutter_actor_get_height (thumb->title));
+      hd_text_cache_label_set_width (thumb->title, maxwtitle);
 
       if (thumb_has_notification (thumb))
         /* nothumb or apthumb with a notification,
@@ -2344,23 +2447,136 @@ skip_the_circus:
   return ythumb + Thumbsize->height+(/* No idea why */ IS_PORTRAIT?(SCREEN_HEIGHT-SCREEN_WIDTH):0);
 }
 
-/* Lays out the @Thumbnails in the @Grid. */
+/* Notification intake {{{ */
+static void refresh_tnote (TNote * tnote);
+static void apply_thread_change (ClutterActor * win, char * nothread);
+
+/* Record that @newborn is to be layed out without flying in. */
 static void
-layout (ClutterActor * newborn, gboolean newborn_is_notification)
+intake_newborn (ClutterActor * newborn, gboolean is_notification)
+{
+  Intake.newborns = g_list_prepend (Intake.newborns, newborn);
+  if (is_notification)
+    Intake.newborn_notes = g_list_prepend (Intake.newborn_notes, newborn);
+}
+
+/* Forget about @thwin if it's going away before it's been layed out. */
+static void
+intake_forget (ClutterActor * thwin)
+{
+  Intake.newborns = g_list_remove (Intake.newborns, thwin);
+  Intake.newborn_notes = g_list_remove (Intake.newborn_notes, thwin);
+}
+
+/*
+ * Put everything waiting in the @Intake on the @Grid.  Thread changes
+ * go first because they can move notifications between thumbnails,
+ * then the changed notifications are updated, then everything is
+ * layed out at once.
+ */
+static void
+flush_intake (void)
 {
-  /* This layout machinery is based on invariants, which basically
-   * means we don't pay much attention to what caused the layout
-   * update, but we rely on the current state of matters. */
-  set_navigator_height (layout_thumbs (newborn));
+  if (Intake.flush_cb)
+    {
+      g_source_remove (Intake.flush_cb);
+      Intake.flush_cb = 0;
+    }
+
+  if (Intake.threads && g_hash_table_size (Intake.threads))
+    {
+      GHashTableIter iter;
+      gpointer win, nothread;
+
+      g_hash_table_iter_init (&iter, Intake.threads);
+      while (g_hash_table_iter_next (&iter, &win, &nothread))
+        {
+          /* apply_thread_change() takes @nothread over. */
+          g_hash_table_iter_steal (&iter);
+          apply_thread_change (win, nothread);
+        }
+    }
+
+  while (Intake.changed)
+    {
+      TNote *tnote = Intake.changed->data;
+
+      Intake.changed = g_list_delete_link (Intake.changed, Intake.changed);
+      tnote->changed = FALSE;
+      refresh_tnote (tnote);
+    }
+
+  if (Intake.relayout)
+    {
+      GList *li;
+
+      /* This layout machinery is based on invariants, which basically
+       * means we don't pay much attention to what caused the layout
+       * update, but we rely on the current state of matters. */
+      Intake.relayout = FALSE;
+      set_navigator_height (layout_thumbs (NULL));
+
+      if (animation_in_progress (Fly_effect_timeline))
+        for (li = Intake.newborns; li; li = li->next)
+          {
+            show_when_complete (li->data);
+            if (g_list_find (Intake.newborn_notes, li->data))
+              add_effect_closure (Fly_effect_timeline, fade_in_when_complete,
+                                  li->data,
+                                  GINT_TO_POINTER (NOTIFADE_IN_DURATION));
+          }
+    }
+  g_list_free (Intake.newborns);
+  g_list_free (Intake.newborn_notes);
+  Intake.newborns = Intake.newborn_notes = NULL;
 
-  if (newborn && animation_in_progress (Fly_effect_timeline))
+  if (Intake.update_hdrm)
     {
-      show_when_complete (newborn);
-      if (newborn_is_notification)
-        add_effect_closure (Fly_effect_timeline, fade_in_when_complete,
-                            newborn, GINT_TO_POINTER (NOTIFADE_IN_DURATION));
+      Intake.update_hdrm = FALSE;
+      hd_render_manager_update ();
     }
 }
+
+static gboolean
+flush_intake_idle (gpointer unused)
+{
+  Intake.flush_cb = 0;
+  flush_intake ();
+  return FALSE;
+}
+
+/* Have flush_intake() called before the next frame is drawn. */
+static void
+schedule_intake (void)
+{
+  if (!Intake.flush_cb)
+    Intake.flush_cb = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                       flush_intake_idle, NULL, NULL);
+}
+
+/* Lay out the @Thumbnails in the @Grid with @newborn before the next
+ * frame, together with whatever else arrives until then. */
+static void
+queue_layout (ClutterActor * newborn, gboolean update_hdrm)
+{
+  if (newborn)
+    intake_newborn (newborn, TRUE);
+  Intake.relayout = TRUE;
+  Intake.update_hdrm |= update_hdrm;
+  schedule_intake ();
+}
+/* Notification intake }}} */
+
+/* Lays out the @Thumbnails in the @Grid now, including what's waiting
+ * in the @Intake. */
+static void
+layout (ClutterActor * newborn, gboolean newborn_is_notification)
+{
+  if (newborn)
+    intake_newborn (newborn, newborn_is_notification);
+  Intake.relayout = TRUE;
+  flush_intake ();
+}
 /* Layout engine }}} */
 
 /* %Thumbnail:s {{{ */
@@ -2398,10 +2614,12 @@ reset_thumb_title (Thumbnail * thumb)
     }
 
   g_assert (thumb->title != NULL);
-  set_label_text_and_color (thumb->title, new_title,
-                            thumb_has_notification (thumb)
-                              ? &NotificationTextColor : &DefaultTextColor);
-  clutter_label_set_use_markup (CLUTTER_LABEL(thumb->title), use_markup);
+  hd_text_cache_label_set (thumb->title, new_title, use_markup,
+                           thumb_has_notification (thumb)
+                             ? &NotificationTextColor : &DefaultTextColor,
+                           -1);
+  clutter_actor_set_anchor_point_from_gravity (thumb->title,
+                                               CLUTTER_GRAVITY_WEST);
 }
 
 /* Creates @thumb->thwin.  The exact position of the inner actors is decided
@@ -2411,10 +2629,7 @@ static void
 create_thwin (Thumbnail * thumb, ClutterActor * prison)
 {
   /* .title */
-  thumb->title = clutter_label_new ();
-  clutter_label_set_font_name (CLUTTER_LABEL (thumb->title), SmallSystemFont);
-  clutter_label_set_use_markup(CLUTTER_LABEL(thumb->title), TRUE);
-  clutter_label_set_ellipsize(CLUTTER_LABEL(thumb->title), PANGO_ELLIPSIZE_END);
+  thumb->title = hd_text_cache_label_new (SmallSystemFont);
   clutter_actor_set_anchor_point_from_gravity (thumb->title, CLUTTER_GRAVITY_WEST);
   clutter_actor_set_position (thumb->title,
                               TITLE_LEFT_MARGIN, TITLE_HEIGHT / 2);
@@ -2471,6 +2686,8 @@ create_thwin (Thumbnail * thumb, ClutterActor * prison)
 static void
 free_thumb (Thumbnail * thumb, gboolean animate)
 {
+  intake_forget (thumb->thwin);
+
   /* This will kill the entire actor hierarchy. */
   if (animate && CLUTTER_ACTOR_IS_VISIBLE (thumb->thwin))
     { /* We may be adding it, no point of animation then. */
@@ -2636,12 +2853,12 @@ claim_win (Thumbnail * apthumb)
         }
     }
 
-  if (!apthumb->video)
+  if (!apthumb->video && !apthumb->snapshot)
     /* Needn't bother with show_all() the contents of .windows,
      * they are shown anyway because of reparent(). */
     clutter_actor_show (apthumb->windows);
   else
-    /* Only show @apthumb->video. */
+    /* Only show @apthumb->video or .snapshot. */
     clutter_actor_hide (apthumb->windows);
 
   /* Restore the opacity/visibility of the actors that have been faded out
@@ -2901,6 +3118,7 @@ hd_task_navigator_zoom_in (HdTaskNavigator * self, ClutterActor * win,
   const Thumbnail *apthumb;
 
   g_assert (hd_task_navigator_is_active ());
+  flush_intake ();
   if (!(apthumb = find_by_apwin (win)))
     goto damage_control;
 
@@ -2969,6 +3187,7 @@ hd_task_navigator_zoom_out (HdTaskNavigator * self, ClutterActor * win,
 
   /* Our "show" callback will grab the butts of @win. */
   clutter_actor_show (Navigator);
+  flush_intake ();
   if (!(apthumb = find_by_apwin (win)))
     goto damage_control;
 
@@ -3136,39 +3355,40 @@ win_title_changed (MBWMClientWindow * win, int unused1, Thumbnail * apthumb)
   return True;
 }
 
+/* The pieces of the frame of application thumbnails. */
+static const struct
+{
+  const gchar *fname;
+  ClutterGravity gravity;
+} Frames[] =
+{
+  { "TaskSwitcherThumbnailTitleLeft.png",    CLUTTER_GRAVITY_NORTH_WEST },
+  { "TaskSwitcherThumbnailTitleCenter.png",  CLUTTER_GRAVITY_NORTH_WEST },
+  { "TaskSwitcherThumbnailTitleRight.png",   CLUTTER_GRAVITY_NORTH_EAST },
+  { "TaskSwitcherThumbnailBorderLeft.png",   CLUTTER_GRAVITY_NORTH_WEST },
+  { "TaskSwitcherThumbnailTitleCenter.png",  CLUTTER_GRAVITY_NORTH_EAST },
+  { "TaskSwitcherThumbnailBorderRight.png",  CLUTTER_GRAVITY_NORTH_EAST },
+  { "TaskSwitcherThumbnailBottomLeft.png",   CLUTTER_GRAVITY_SOUTH_WEST },
+  { "TaskSwitcherThumbnailBottomCenter.png", CLUTTER_GRAVITY_SOUTH_WEST },
+  { "TaskSwitcherThumbnailBottomRight.png",  CLUTTER_GRAVITY_SOUTH_EAST },
+};
+
 /* Dress a %Thumbnail: create @thumb->frame.all and populate it
  * with frame graphics. */
 static void
 create_apthumb_frame (Thumbnail * apthumb)
 {
-  static struct
-  {
-    const gchar *fname;
-    ClutterGravity gravity;
-  } frames[] =
-  {
-    { "TaskSwitcherThumbnailTitleLeft.png",    CLUTTER_GRAVITY_NORTH_WEST },
-    { "TaskSwitcherThumbnailTitleCenter.png",  CLUTTER_GRAVITY_NORTH_WEST },
-    { "TaskSwitcherThumbnailTitleRight.png",   CLUTTER_GRAVITY_NORTH_EAST },
-    { "TaskSwitcherThumbnailBorderLeft.png",   CLUTTER_GRAVITY_NORTH_WEST },
-    { "TaskSwitcherThumbnailTitleCenter.png",  CLUTTER_GRAVITY_NORTH_EAST },
-    { "TaskSwitcherThumbnailBorderRight.png",  CLUTTER_GRAVITY_NORTH_EAST },
-    { "TaskSwitcherThumbnailBottomLeft.png",   CLUTTER_GRAVITY_SOUTH_WEST },
-    { "TaskSwitcherThumbnailBottomCenter.png", CLUTTER_GRAVITY_SOUTH_WEST },
-    { "TaskSwitcherThumbnailBottomRight.png",  CLUTTER_GRAVITY_SOUTH_EAST },
-  };
-
   guint i;
 
-  apthumb->frame.all = clutter_group_new ();
+  apthumb->frame.all = tidy_batch_group_new ();
   clutter_actor_set_name (apthumb->frame.all, "apthumb frame");
 
-  for (i = 0; i < G_N_ELEMENTS (frames); i++)
+  for (i = 0; i < G_N_ELEMENTS (Frames); i++)
     {
       apthumb->frame.pieces[i] = hd_clutter_cache_get_texture (
-                                                 frames[i].fname, TRUE);
+                                                 Frames[i].fname, TRUE);
       clutter_actor_set_anchor_point_from_gravity (apthumb->frame.pieces[i],
-                                                   frames[i].gravity);
+                                                   Frames[i].gravity);
       clutter_container_add_actor (CLUTTER_CONTAINER (apthumb->frame.all),
                                    apthumb->frame.pieces[i]);
     }
@@ -3342,6 +3562,9 @@ hd_task_navigator_remove_window (HdTaskNavigator * self,
       return;
     }
 
+  /* Don't let a pending thread change outlive @win. */
+  flush_intake ();
+
   /* Find @apthumb for @win.  We cannot use find_by_apiwin() because
    * we need @li to be able to remove @apthumb from @Thumbnails. */
   apthumb = NULL;
@@ -3518,7 +3741,10 @@ hd_task_navigator_hibernate_window (HdTaskNavigator * self,
                                     ClutterActor * win)
 {
   Thumbnail *apthumb;
+  HdCompMgrClient *hclient;
 
+  /* Let pending thread changes find @win. */
+  flush_intake ();
   if (!(apthumb = find_by_apwin (win)))
     return;
 
@@ -3534,6 +3760,23 @@ hd_task_navigator_hibernate_window (HdTaskNavigator * self,
   mb_wm_object_signal_disconnect (MB_WM_OBJECT (apthumb->win),
                                   apthumb->win_changed_cb_id);
   apthumb->win = NULL;
+
+  /* Show the client's last frame in place of @win, which won't be
+   * updated anymore. */
+  hclient = g_object_get_data (G_OBJECT (win), "HD-MBWMCompMgrClutterClient");
+  if (hclient && !apthumb->snapshot
+      && (apthumb->snapshot = hd_comp_mgr_client_get_snapshot (hclient)))
+    {
+      gint x, y;
+
+      clutter_actor_get_position (win, &x, &y);
+      clutter_actor_set_name (apthumb->snapshot, "snapshot");
+      clutter_actor_set_position (apthumb->snapshot, x, y);
+      clutter_container_add_actor (CLUTTER_CONTAINER (apthumb->prison),
+                                   apthumb->snapshot);
+      if (hd_task_navigator_is_active ())
+        clutter_actor_hide (apthumb->windows);
+    }
 }
 
 /* Tells us to show @new_win in place of @old_win, and forget about
@@ -3547,6 +3790,7 @@ hd_task_navigator_replace_window (HdTaskNavigator * self,
   Thumbnail *apthumb;
   gboolean showing;
 
+  flush_intake ();
   if (old_win == new_win || !(apthumb = find_by_apwin (old_win)))
     return;
 
@@ -3582,6 +3826,16 @@ hd_task_navigator_replace_window (HdTaskNavigator * self,
   if (showing)
     clutter_actor_reparent (apthumb->apwin, apthumb->windows);
 
+  /* The client is awake, show it instead of its .snapshot. */
+  if (apthumb->snapshot)
+    {
+      clutter_container_remove_actor (CLUTTER_CONTAINER (apthumb->prison),
+                                      apthumb->snapshot);
+      apthumb->snapshot = NULL;
+      if (showing && !apthumb->video)
+        clutter_actor_show (apthumb->windows);
+    }
+
   /* Replace the client window structure with @new_win's. */
   if (apthumb->win)
     mb_wm_object_signal_disconnect (MB_WM_OBJECT (apthumb->win),
@@ -3601,6 +3855,14 @@ hd_task_navigator_replace_window (HdTaskNavigator * self,
     }
 }
 
+/* Frees a notification thread name we got from the caller. */
+static void
+free_nothread (char * nothread)
+{
+  if (nothread)
+    XFree (nothread);
+}
+
 /*
  * Sets the @win's %Thumbnail's @nodest.  @nodest == %NULL clears it.
  * It is an error if the associated %Thumbnail cannot be found, but
@@ -3618,6 +3880,20 @@ void
 hd_task_navigator_notification_thread_changed (HdTaskNavigator * self,
                                                ClutterActor * win,
                                                char * nothread)
+{
+  /* Only the last change of each window matters, merge them
+   * in the @Intake until the next frame. */
+  if (!Intake.threads)
+    Intake.threads = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                            NULL, (GDestroyNotify)free_nothread);
+  g_hash_table_insert (Intake.threads, win, nothread);
+  schedule_intake ();
+}
+
+/* Does what hd_task_navigator_notification_thread_changed() promises,
+ * from flush_intake(). */
+static void
+apply_thread_change (ClutterActor * win, char * nothread)
 {
   GList *li;
   gboolean relayout;
@@ -3683,8 +3959,10 @@ hd_task_navigator_notification_thread_changed (HdTaskNavigator * self,
       }
 
 finito:
+  if (newborn)
+    intake_newborn (newborn, TRUE);
   if (newborn || relayout)
-    layout (newborn, TRUE);
+    Intake.relayout = TRUE;
 }
 /* Misc window commands }}} */
 /* }}} */
@@ -3718,9 +3996,23 @@ numstrcmp(const gchar * a, const gchar * b)
     }
 }
 
-/* HdNote::HdNoteSignalChanged signal handler. */
+/* HdNote::HdNoteSignalChanged signal handler.  Notifications may
+ * change many times a frame, so only refresh_tnote() later. */
 static Bool
 tnote_changed (HdNote * hdnote, int unused1, TNote * tnote)
+{
+  if (!tnote->changed)
+    {
+      tnote->changed = TRUE;
+      Intake.changed = g_list_prepend (Intake.changed, tnote);
+      schedule_intake ();
+    }
+  return False;
+}
+
+/* Update @tnote's thumbnail from its %HdNote. */
+static void
+refresh_tnote (TNote * tnote)
 { g_debug(__FUNCTION__);
   GList *li;
   Thumbnail *thumb;
@@ -3765,8 +4057,6 @@ tnote_changed (HdNote * hdnote, int unused1, TNote * tnote)
     hd_title_bar_set_switcher_pulse (
                       HD_TITLE_BAR (hd_render_manager_get_title_bar ()),
                       TRUE);
-
-  return False;
 }
 
 /* Returns a %TNote prepared for @hdnote. */
@@ -3842,6 +4132,8 @@ create_tnote (HdNote * hdnote)
 static void
 free_tnote (TNote * tnote)
 {
+  if (tnote->changed)
+    Intake.changed = g_list_remove (Intake.changed, tnote);
   mb_wm_object_signal_disconnect (MB_WM_OBJECT (tnote->hdnote),
                                   tnote->hdnote_changed_cb_id);
   mb_wm_object_unref (MB_WM_OBJECT (tnote->hdnote));
@@ -3998,10 +4290,9 @@ hd_task_navigator_add_notification (HdTaskNavigator * self,
         }
     }
 
-  layout (add_nothumb (tnote)->thwin, TRUE);
-
-  /* Make sure the Tasks button points to the switcher now. */
-  hd_render_manager_update();
+  /* Lay it out and make sure the Tasks button points to the switcher
+   * with the rest of the notifications arriving in this frame. */
+  queue_layout (add_nothumb (tnote)->thwin, TRUE);
 }
 
 /* Remove a notification from the navigator, either if
@@ -4026,10 +4317,9 @@ hd_task_navigator_remove_notification (HdTaskNavigator * self,
   if (thumb_is_notification (thumb))
     { /* @hdinfo is displayed in a thumbnail on its own. */
       remove_nothumb (li, TRUE);
-      layout (NULL, FALSE);
 
       /* Sync the Tasks button, we might have just become empty. */
-      hd_render_manager_update ();
+      queue_layout (NULL, TRUE);
     }
   else /* @hdnote is in an application's title area. */
     free_tnote (orphan_notification (thumb, TRUE));
@@ -4432,6 +4722,27 @@ hd_task_navigator_new (void)
 {
   return g_object_new (HD_TYPE_TASK_NAVIGATOR, NULL);
 }
+
+/* Load the theme images of the thumbnails into the cache, so the first
+ * thumbnails don't have to wait for them. */
+void
+hd_task_navigator_preload_theme (void)
+{
+  static const char *const images[] =
+  {
+    "TaskSwitcherThumbnailTitleCloseIcon.png",
+    "TaskSwitcherNotificationThumbnailCloseIcon.png",
+    "TaskSwitcherNotificationThumbnail.png",
+    "TaskSwitcherNotificationThumbnailSeparator.png",
+    HD_THEME_IMG_CLOSING_PARTICLE,
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (images); i++)
+    hd_clutter_cache_preload (images[i], TRUE);
+  for (i = 0; i < G_N_ELEMENTS (Frames); i++)
+    hd_clutter_cache_preload (Frames[i].fname, TRUE);
+}
 /* %HdTaskNavigator }}} */
 
 static int
@@ -4498,6 +4809,8 @@ hd_task_navigator_activate (int x, int y, int close)
   int n;
   GList *t;
 
+  /* Activate what the user sees. */
+  flush_intake ();
   if (y == -2)
     {
       GList *s;
@@ -89,4 +89,5 @@ void hd_task_navigator_rotate(int mode);
 void hd_task_navigator_update_orientation(gboolean portrait);
 void hd_task_navigator_update_win_orientation(Window xwindow,gboolean portrait);
 gboolean hd_task_navigator_get_disable_portrait(MBWindowManagerClient *c);
+void hd_task_navigator_preload_theme (void);
 #endif /* ! __HD_TASK_NAVIGATOR_H__ */
@@ -0,0 +1,478 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include <string.h>
+
+#include <pango/pangocairo.h>
+
+#include "hd-text-cache.h"
+#include "hd-transition.h"
+
+/* How many textures no label shows to keep around in case the
+ * strings come back, like the two states of a blinking counter. */
+#define UNUSED_TEXTURES_MAX   32
+
+/* A rendered string, shared by the labels showing it. */
+typedef struct
+{
+  /*
+   * -- @key:         What it was rendered with, see make_key().
+   * -- @tex:         The string, in straight (not premultiplied) RGBA.
+   * -- @text_width:  The logical width of the laid out text.
+   * -- @refs:        The number of labels showing it.
+   * -- @link:        Our link in @Cache.unused if @refs is 0.
+   */
+  gchar      *key;
+  CoglHandle  tex;
+  gint        text_width;
+  guint       refs;
+  GList      *link;
+} TextTexture;
+
+typedef struct
+{
+  ClutterActor      *actor;
+
+  /* What the label should show. */
+  gchar             *font, *text;
+  gboolean           use_markup;
+  ClutterColor       color;
+  gint               width;
+
+  /* @layout_font is what @layout's font description was made from. */
+  PangoLayout       *layout;
+  gchar             *layout_font;
+
+  /*
+   * -- @shown:         What the label shows now.
+   * -- @rebuild_cb:    The GSource id of rebuild_timeout() if the label
+   *                    is waiting to render a new string.
+   * -- @last_rebuild:  When it rendered the last one.
+   */
+  TextTexture       *shown;
+  guint              rebuild_cb;
+  GTimeVal           last_rebuild;
+
+  HdTextCacheNotify  notify;
+  gpointer           notify_data;
+} Label;
+
+static struct
+{
+  /* key -> TextTexture */
+  GHashTable   *textures;
+  /* The TextTexture:s no label shows, the most recently used first. */
+  GQueue        unused;
+  PangoContext *context;
+  GQuark        quark;
+} Cache;
+
+/* Texture management */
+static void
+texture_free (TextTexture *tt)
+{
+  cogl_texture_unref (tt->tex);
+  g_free (tt->key);
+  g_slice_free (TextTexture, tt);
+}
+
+static void
+texture_ref (TextTexture *tt)
+{
+  if (!tt->refs++ && tt->link)
+    {
+      g_queue_delete_link (&Cache.unused, tt->link);
+      tt->link = NULL;
+    }
+}
+
+static void
+texture_unref (TextTexture *tt)
+{
+  g_assert (tt->refs > 0);
+  if (--tt->refs)
+    return;
+
+  g_queue_push_head (&Cache.unused, tt);
+  tt->link = Cache.unused.head;
+  while (Cache.unused.length > UNUSED_TEXTURES_MAX)
+    {
+      TextTexture *lru = g_queue_pop_tail (&Cache.unused);
+
+      g_hash_table_remove (Cache.textures, lru->key);
+      texture_free (lru);
+    }
+}
+
+/* Returns what identifies the texture @label would be rendered to. */
+static gchar *
+make_key (const Label *label)
+{
+  return g_strdup_printf ("%s|%02x%02x%02x%02x|%d|%d|%s",
+                          label->font,
+                          label->color.red, label->color.green,
+                          label->color.blue, label->color.alpha,
+                          label->use_markup, label->width,
+                          label->text ? label->text : "");
+}
+
+/* Draws @layout in @color and returns it as a texture. */
+static CoglHandle
+render_layout (PangoLayout *layout, const ClutterColor *color,
+               gint *text_width)
+{
+  PangoRectangle logical;
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  guchar *pixels;
+  guint x, y, w, h, stride;
+  CoglHandle tex;
+
+  pango_layout_get_pixel_extents (layout, NULL, &logical);
+  w = MAX (logical.width, 1);
+  h = MAX (logical.height, 1);
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, w, h);
+  cr = cairo_create (surface);
+  cairo_set_source_rgba (cr,
+                         color->red   / 255.0, color->green / 255.0,
+                         color->blue  / 255.0, color->alpha / 255.0);
+  cairo_move_to (cr, -logical.x, -logical.y);
+  pango_cairo_show_layout (cr, layout);
+  cairo_destroy (cr);
+  cairo_surface_flush (surface);
+
+  /* Cairo gives us premultiplied native-endian ARGB, turn it into
+   * the straight RGBA Clutter blends textures with in place. */
+  pixels = cairo_image_surface_get_data (surface);
+  stride = cairo_image_surface_get_stride (surface);
+  for (y = 0; y < h; y++)
+    {
+      guint32 *src = (guint32 *)(pixels + y * stride);
+      guchar  *dst = pixels + y * stride;
+
+      for (x = 0; x < w; x++, dst += 4)
+        {
+          guint32 argb = src[x];
+          guint a = argb >> 24;
+
+          if (a)
+            {
+              dst[0] = (((argb >> 16) & 0xff) * 255 + a / 2) / a;
+              dst[1] = (((argb >>  8) & 0xff) * 255 + a / 2) / a;
+              dst[2] = (((argb      ) & 0xff) * 255 + a / 2) / a;
+            }
+          else
+            dst[0] = dst[1] = dst[2] = 0;
+          dst[3] = a;
+        }
+    }
+
+  tex = cogl_texture_new_from_data (w, h, -1, FALSE,
+                                    COGL_PIXEL_FORMAT_RGBA_8888,
+                                    COGL_PIXEL_FORMAT_RGBA_8888,
+                                    stride, pixels);
+  cairo_surface_destroy (surface);
+
+  *text_width = logical.width;
+  return tex;
+}
+
+/* Label management */
+static void
+label_show (Label *label, TextTexture *tt)
+{
+  TextTexture *old;
+
+  texture_ref (tt);
+  old = label->shown;
+  label->shown = tt;
+  clutter_texture_set_cogl_texture (CLUTTER_TEXTURE (label->actor), tt->tex);
+  if (old)
+    texture_unref (old);
+}
+
+/* Lay out and render what @label should show under @key, which is
+ * not in the cache yet. */
+static void
+label_rebuild (Label *label, gchar *key)
+{
+  TextTexture *tt;
+  const gchar *text;
+
+  if (!label->layout_font || strcmp (label->layout_font, label->font))
+    {
+      PangoFontDescription *desc;
+
+      desc = pango_font_description_from_string (label->font);
+      pango_layout_set_font_description (label->layout, desc);
+      pango_font_description_free (desc);
+      g_free (label->layout_font);
+      label->layout_font = g_strdup (label->font);
+    }
+
+  text = label->text ? label->text : "";
+  if (label->use_markup)
+    pango_layout_set_markup (label->layout, text, -1);
+  else
+    pango_layout_set_text (label->layout, text, -1);
+  pango_layout_set_width (label->layout,
+                          label->width > 0 ? label->width * PANGO_SCALE : -1);
+
+  tt = g_slice_new0 (TextTexture);
+  tt->key = key;
+  tt->tex = render_layout (label->layout, &label->color, &tt->text_width);
+  g_hash_table_insert (Cache.textures, tt->key, tt);
+
+  label_show (label, tt);
+  g_get_current_time (&label->last_rebuild);
+}
+
+static gboolean
+rebuild_timeout (Label *label)
+{
+  TextTexture *tt;
+  gchar *key;
+
+  label->rebuild_cb = 0;
+
+  key = make_key (label);
+  if ((tt = g_hash_table_lookup (Cache.textures, key)) != NULL)
+    {
+      label_show (label, tt);
+      g_free (key);
+    }
+  else
+    label_rebuild (label, key);
+
+  if (label->notify)
+    label->notify (label->actor, label->notify_data);
+  return FALSE;
+}
+
+/* Make @label show what it should, from the cache if we can. */
+static void
+label_update (Label *label)
+{
+  TextTexture *tt;
+  GTimeVal now;
+  gint interval, elapsed;
+  gchar *key;
+
+  key = make_key (label);
+  if (label->shown && !strcmp (label->shown->key, key))
+    { /* Changed back to what's shown before the rebuild. */
+      if (label->rebuild_cb)
+        {
+          g_source_remove (label->rebuild_cb);
+          label->rebuild_cb = 0;
+        }
+      g_free (key);
+      return;
+    }
+
+  if ((tt = g_hash_table_lookup (Cache.textures, key)) != NULL)
+    {
+      if (label->rebuild_cb)
+        {
+          g_source_remove (label->rebuild_cb);
+          label->rebuild_cb = 0;
+        }
+      label_show (label, tt);
+      g_free (key);
+      return;
+    }
+
+  /* A new string.  If we've just rendered one wait a bit in case
+   * this one is just as short-lived, rebuild_timeout() will render
+   * whatever is the latest by then. */
+  if (label->rebuild_cb)
+    {
+      g_free (key);
+      return;
+    }
+
+  interval = hd_transition_get_int ("titles", "rebuild_interval", 200);
+  g_get_current_time (&now);
+  elapsed = (now.tv_sec  - label->last_rebuild.tv_sec)  * 1000
+          + (now.tv_usec - label->last_rebuild.tv_usec) / 1000;
+  if (label->shown && 0 <= elapsed && elapsed < interval)
+    {
+      label->rebuild_cb = g_timeout_add (interval - elapsed,
+                                         (GSourceFunc)rebuild_timeout,
+                                         label);
+      g_free (key);
+      return;
+    }
+
+  label_rebuild (label, key);
+}
+
+static void
+label_free (Label *label)
+{
+  if (label->rebuild_cb)
+    g_source_remove (label->rebuild_cb);
+  if (label->shown)
+    texture_unref (label->shown);
+  g_object_unref (label->layout);
+  g_free (label->layout_font);
+  g_free (label->font);
+  g_free (label->text);
+  g_slice_free (Label, label);
+}
+
+static Label *
+get_label (ClutterActor *actor)
+{
+  Label *label;
+
+  label = g_object_get_qdata (G_OBJECT (actor), Cache.quark);
+  g_return_val_if_fail (label != NULL, NULL);
+  return label;
+}
+
+/* Public functions */
+/* Returns a new, empty label, drawn in @font_name in white. */
+ClutterActor *
+hd_text_cache_label_new (const gchar *font_name)
+{
+  static const ClutterColor white = { 0xff, 0xff, 0xff, 0xff };
+  Label *label;
+
+  if (!Cache.textures)
+    {
+      ClutterBackend *backend;
+      PangoFontMap *fontmap;
+      const cairo_font_options_t *options;
+
+      Cache.textures = g_hash_table_new (g_str_hash, g_str_equal);
+      Cache.quark = g_quark_from_static_string ("hd-text-cache-label");
+
+      /* Render with the same resolution and hinting as Clutter. */
+      backend = clutter_get_default_backend ();
+      fontmap = pango_cairo_font_map_get_default ();
+      Cache.context = pango_cairo_font_map_create_context (
+                                          PANGO_CAIRO_FONT_MAP (fontmap));
+      pango_cairo_context_set_resolution (Cache.context,
+                                  clutter_backend_get_resolution (backend));
+      if ((options = clutter_backend_get_font_options (backend)) != NULL)
+        pango_cairo_context_set_font_options (Cache.context, options);
+    }
+
+  label = g_slice_new0 (Label);
+  label->actor = clutter_texture_new ();
+  label->font = g_strdup (font_name);
+  label->color = white;
+  label->width = -1;
+
+  label->layout = pango_layout_new (Cache.context);
+  pango_layout_set_single_paragraph_mode (label->layout, TRUE);
+  pango_layout_set_ellipsize (label->layout, PANGO_ELLIPSIZE_END);
+
+  g_object_set_qdata_full (G_OBJECT (label->actor), Cache.quark, label,
+                           (GDestroyNotify)label_free);
+  label_update (label);
+
+  return label->actor;
+}
+
+void
+hd_text_cache_label_set_font (ClutterActor *actor, const gchar *font_name)
+{
+  Label *label;
+
+  if (!(label = get_label (actor)))
+    return;
+  if (!strcmp (label->font, font_name))
+    return;
+
+  g_free (label->font);
+  label->font = g_strdup (font_name);
+  label_update (label);
+}
+
+/*
+ * Makes the label show @text, which is Pango markup if @use_markup.
+ * If @color is not %NULL it changes the color of the text, and if
+ * @width is not negative the text is ellipsized to that many pixels
+ * (0 means no limit).
+ */
+void
+hd_text_cache_label_set (ClutterActor *actor, const gchar *text,
+                         gboolean use_markup, const ClutterColor *color,
+                         gint width)
+{
+  Label *label;
+
+  if (!(label = get_label (actor)))
+    return;
+
+  if (g_strcmp0 (label->text, text))
+    {
+      g_free (label->text);
+      label->text = g_strdup (text);
+    }
+  label->use_markup = use_markup;
+  if (color)
+    label->color = *color;
+  if (width >= 0)
+    label->width = width;
+  label_update (label);
+}
+
+void
+hd_text_cache_label_set_width (ClutterActor *actor, gint width)
+{
+  Label *label;
+
+  if (!(label = get_label (actor)) || label->width == width)
+    return;
+
+  label->width = width;
+  label_update (label);
+}
+
+/* Returns the width of the text the label shows, which may be less
+ * than the width of the label itself. */
+gint
+hd_text_cache_label_get_text_width (ClutterActor *actor)
+{
+  Label *label;
+
+  if (!(label = get_label (actor)) || !label->shown)
+    return 0;
+  return label->shown->text_width;
+}
+
+/* Sets the function to call when the label shows a string it was
+ * asked to show earlier, see the top of hd-text-cache.h. */
+void
+hd_text_cache_label_set_notify (ClutterActor *actor, HdTextCacheNotify func,
+                                gpointer data)
+{
+  Label *label;
+
+  if (!(label = get_label (actor)))
+    return;
+  label->notify = func;
+  label->notify_data = data;
+}
@@ -0,0 +1,61 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Single-line, end-ellipsized labels for titles which change often.
+ * Unlike a #ClutterLabel, which lays out and renders its glyphs again
+ * whenever its text is set, these are textures rendered once per
+ * string and shared between the labels showing the same string.
+ * Each label keeps its own #PangoLayout, which is only laid out again
+ * when the text or the width change, and the textures of strings not
+ * seen before are rebuilt at most once per [titles] rebuild_interval.
+ * Until then the label keeps showing the previous one.
+ */
+
+#ifndef __HD_TEXT_CACHE_H__
+#define __HD_TEXT_CACHE_H__
+
+#include <clutter/clutter.h>
+
+G_BEGIN_DECLS
+
+/* Called when a label finally shows a string it was asked to
+ * show earlier, and it may have changed size. */
+typedef void (*HdTextCacheNotify) (ClutterActor *label, gpointer data);
+
+ClutterActor *hd_text_cache_label_new            (const gchar *font_name);
+void          hd_text_cache_label_set_font       (ClutterActor *label,
+                                                  const gchar *font_name);
+void          hd_text_cache_label_set            (ClutterActor *label,
+                                                  const gchar *text,
+                                                  gboolean use_markup,
+                                                  const ClutterColor *color,
+                                                  gint width);
+void          hd_text_cache_label_set_width      (ClutterActor *label,
+                                                  gint width);
+gint          hd_text_cache_label_get_text_width (ClutterActor *label);
+void          hd_text_cache_label_set_notify     (ClutterActor *label,
+                                                  HdTextCacheNotify func,
+                                                  gpointer data);
+
+G_END_DECLS
+
+#endif /* __HD_TEXT_CACHE_H__ */
@@ -0,0 +1,730 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <glib/gstdio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <cogl/cogl.h>
+
+#include "hd-theme-atlas.h"
+
+/* The size of the pages, and how many of them we're willing to have. */
+#define PAGE_SIZE         1024
+#define MAX_PAGES         4
+
+/* Images larger than this in either direction are left alone, they
+ * would waste too much of a page. */
+#define MAX_IMAGE_SIZE    256
+
+/* Each image is surrounded by a copy of its edges this wide, so that
+ * bilinear filtering doesn't bleed the neighbours in. */
+#define PADDING           1
+
+/* Where the layout is kept between runs, relative to $HOME. */
+#define LAYOUT_DIR        ".cache/hildon-desktop"
+#define LAYOUT_FILE       "theme-atlas"
+#define LAYOUT_MAGIC      "hildon-desktop theme atlas 1"
+
+/* Images are packed on shelves: rows of images stacked on each other,
+ * filled left to right. */
+typedef struct
+{
+  guint y, height;
+  guint used;
+} Shelf;
+
+typedef struct
+{
+  ClutterActor *texture;
+  GArray       *shelves;
+  guint         top; /* where the next shelf goes */
+} Page;
+
+typedef struct
+{
+  guint           page;
+  ClutterGeometry area;
+
+  /* Set if the image has its own texture because it no longer fits in
+   * the atlas, then @area is all of it. */
+  ClutterActor   *texture;
+
+  /* The #TidySubTexture:s showing it, to be kept current when the
+   * image moves. */
+  GSList         *actors;
+} Image;
+
+struct _HdThemeAtlas
+{
+  gchar        *theme_path;
+  glong         mtime;
+
+  /* Holds the pages of the atlas, hidden. */
+  ClutterActor *group;
+  GPtrArray    *pages;
+
+  /* File name -> Image, or %NULL if it's not in the atlas. */
+  GHashTable   *images;
+
+  guint         save_id;
+};
+
+/* A line of the layout file. */
+typedef struct
+{
+  gchar *fname;
+  guint  page, x, y, width, height;
+} Placement;
+
+static glong
+theme_mtime (const gchar *theme_path)
+{
+  struct stat sbuf;
+
+  return stat (theme_path, &sbuf) == 0 ? sbuf.st_mtime : 0;
+}
+
+static gchar *
+layout_file_name (void)
+{
+  return g_build_filename (g_get_home_dir (), LAYOUT_DIR, LAYOUT_FILE, NULL);
+}
+
+static Page *
+hd_theme_atlas_new_page (HdThemeAtlas *atlas)
+{
+  CoglHandle tex;
+  Page *page;
+
+  if (atlas->pages->len >= MAX_PAGES)
+    return NULL;
+
+  tex = cogl_texture_new_with_size (PAGE_SIZE, PAGE_SIZE, -1, FALSE,
+                                    COGL_PIXEL_FORMAT_RGBA_8888);
+  if (tex == COGL_INVALID_HANDLE)
+    return NULL;
+
+  page = g_slice_new (Page);
+  page->texture = clutter_texture_new ();
+  clutter_texture_set_cogl_texture (CLUTTER_TEXTURE (page->texture), tex);
+  cogl_texture_unref (tex);
+  clutter_container_add_actor (CLUTTER_CONTAINER (atlas->group),
+                               page->texture);
+  page->shelves = g_array_new (FALSE, FALSE, sizeof (Shelf));
+  page->top = 0;
+  g_ptr_array_add (atlas->pages, page);
+
+  return page;
+}
+
+/* Find room for a @width x @height image on the shelf it fits the most
+ * snugly.  Returns the position of the image itself, inside the padding. */
+static gboolean
+hd_theme_atlas_alloc (HdThemeAtlas *atlas, guint width, guint height,
+                      guint *pagep, guint *xp, guint *yp)
+{
+  guint pw = width + 2*PADDING, ph = height + 2*PADDING;
+  guint i, j;
+
+  for (i = 0; ; i++)
+    {
+      Page *page;
+      Shelf *best = NULL;
+
+      if (i < atlas->pages->len)
+        page = g_ptr_array_index (atlas->pages, i);
+      else if (!(page = hd_theme_atlas_new_page (atlas)))
+        return FALSE;
+
+      for (j = 0; j < page->shelves->len; j++)
+        {
+          Shelf *shelf = &g_array_index (page->shelves, Shelf, j);
+          if (shelf->height >= ph && shelf->used + pw <= PAGE_SIZE
+              && (!best || shelf->height < best->height))
+            best = shelf;
+        }
+
+      if (!best && page->top + ph <= PAGE_SIZE)
+        {
+          Shelf shelf = { page->top, ph, 0 };
+
+          g_array_append_val (page->shelves, shelf);
+          page->top += ph;
+          best = &g_array_index (page->shelves, Shelf,
+                                 page->shelves->len-1);
+        }
+
+      if (best)
+        {
+          *pagep = i;
+          *xp = best->used + PADDING;
+          *yp = best->y + PADDING;
+          best->used += pw;
+          return TRUE;
+        }
+    }
+}
+
+/* Claim the place an image had in the saved layout.  Shelves are
+ * rebuilt from the images on them: every image on a shelf is at its
+ * top, so the images with the same page and y make up one shelf. */
+static gboolean
+hd_theme_atlas_reserve (HdThemeAtlas *atlas, const Placement *place)
+{
+  guint y = place->y - PADDING;
+  guint right = place->x + place->width + PADDING;
+  guint bottom = place->y + place->height + PADDING;
+  Shelf *shelf = NULL;
+  Page *page;
+  guint i;
+
+  if (place->page >= MAX_PAGES || place->x < PADDING || place->y < PADDING
+      || right > PAGE_SIZE || bottom > PAGE_SIZE)
+    return FALSE;
+  while (atlas->pages->len <= place->page)
+    if (!hd_theme_atlas_new_page (atlas))
+      return FALSE;
+  page = g_ptr_array_index (atlas->pages, place->page);
+
+  for (i = 0; i < page->shelves->len; i++)
+    if (g_array_index (page->shelves, Shelf, i).y == y)
+      {
+        shelf = &g_array_index (page->shelves, Shelf, i);
+        break;
+      }
+  if (!shelf)
+    {
+      Shelf new_shelf = { y, 0, 0 };
+
+      g_array_append_val (page->shelves, new_shelf);
+      shelf = &g_array_index (page->shelves, Shelf, page->shelves->len-1);
+    }
+
+  shelf->height = MAX (shelf->height, bottom - y);
+  shelf->used   = MAX (shelf->used, right);
+  page->top     = MAX (page->top, shelf->y + shelf->height);
+
+  return TRUE;
+}
+
+/* Copy @pixbuf and the padding around it to @image's place. */
+static void
+hd_theme_atlas_upload (HdThemeAtlas *atlas, const Image *image,
+                       GdkPixbuf *pixbuf)
+{
+  GdkPixbuf *rgba, *padded;
+  guint w = image->area.width, h = image->area.height;
+  Page *page;
+  guint i;
+
+  rgba = gdk_pixbuf_get_has_alpha (pixbuf)
+    ? g_object_ref (pixbuf)
+    : gdk_pixbuf_add_alpha (pixbuf, FALSE, 0, 0, 0);
+  padded = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8,
+                           w + 2*PADDING, h + 2*PADDING);
+  gdk_pixbuf_copy_area (rgba, 0, 0, w, h, padded, PADDING, PADDING);
+  g_object_unref (rgba);
+
+  /* Rows first, then the columns with the corners. */
+  for (i = 0; i < PADDING; i++)
+    {
+      gdk_pixbuf_copy_area (padded, PADDING, PADDING, w, 1,
+                            padded, PADDING, i);
+      gdk_pixbuf_copy_area (padded, PADDING, PADDING+h-1, w, 1,
+                            padded, PADDING, PADDING+h+i);
+    }
+  for (i = 0; i < PADDING; i++)
+    {
+      gdk_pixbuf_copy_area (padded, PADDING, 0, 1, h + 2*PADDING,
+                            padded, i, 0);
+      gdk_pixbuf_copy_area (padded, PADDING+w-1, 0, 1, h + 2*PADDING,
+                            padded, PADDING+w+i, 0);
+    }
+
+  page = g_ptr_array_index (atlas->pages, image->page);
+  cogl_texture_set_region (
+      clutter_texture_get_cogl_texture (CLUTTER_TEXTURE (page->texture)),
+      0, 0,
+      image->area.x - PADDING, image->area.y - PADDING,
+      w + 2*PADDING, h + 2*PADDING,
+      w + 2*PADDING, h + 2*PADDING,
+      COGL_PIXEL_FORMAT_RGBA_8888,
+      gdk_pixbuf_get_rowstride (padded),
+      gdk_pixbuf_get_pixels (padded));
+  g_object_unref (padded);
+}
+
+static GdkPixbuf *
+hd_theme_atlas_load_image (HdThemeAtlas *atlas, const gchar *fname)
+{
+  GdkPixbuf *pixbuf;
+  gchar *path;
+
+  path = g_build_filename (atlas->theme_path, fname, NULL);
+  pixbuf = gdk_pixbuf_new_from_file (path, NULL);
+  g_free (path);
+
+  if (pixbuf && (gdk_pixbuf_get_width (pixbuf) > MAX_IMAGE_SIZE
+                 || gdk_pixbuf_get_height (pixbuf) > MAX_IMAGE_SIZE
+                 || gdk_pixbuf_get_bits_per_sample (pixbuf) != 8))
+    {
+      g_object_unref (pixbuf);
+      pixbuf = NULL;
+    }
+
+  return pixbuf;
+}
+
+static gboolean
+hd_theme_atlas_save_idle (HdThemeAtlas *atlas)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  GString *layout;
+  gchar *fname, *dname;
+
+  atlas->save_id = 0;
+
+  layout = g_string_new (LAYOUT_MAGIC "\n");
+  g_string_append_printf (layout, "%s %ld\n",
+                          atlas->theme_path, atlas->mtime);
+  g_hash_table_iter_init (&iter, atlas->images);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      const Image *image = value;
+
+      if (image && !image->texture)
+        g_string_append_printf (layout, "%u %d %d %u %u %s\n",
+                                image->page, image->area.x, image->area.y,
+                                image->area.width, image->area.height,
+                                (const gchar *)key);
+    }
+
+  dname = g_build_filename (g_get_home_dir (), LAYOUT_DIR, NULL);
+  g_mkdir_with_parents (dname, 0770);
+  g_free (dname);
+
+  fname = layout_file_name ();
+  g_file_set_contents (fname, layout->str, layout->len, NULL);
+  g_free (fname);
+  g_string_free (layout, TRUE);
+
+  return FALSE;
+}
+
+static void
+hd_theme_atlas_changed (HdThemeAtlas *atlas)
+{
+  if (!atlas->save_id)
+    atlas->save_id = g_idle_add_full (G_PRIORITY_LOW,
+                                      (GSourceFunc)hd_theme_atlas_save_idle,
+                                      atlas, NULL);
+}
+
+/* Put @fname in the atlas if it's small enough and there's room.
+ * Either way remember the answer. */
+static Image *
+hd_theme_atlas_add (HdThemeAtlas *atlas, const gchar *fname,
+                    GdkPixbuf *pixbuf)
+{
+  Image *image = NULL;
+  guint page, x, y;
+
+  if (pixbuf && hd_theme_atlas_alloc (atlas,
+                                      gdk_pixbuf_get_width (pixbuf),
+                                      gdk_pixbuf_get_height (pixbuf),
+                                      &page, &x, &y))
+    {
+      image = g_slice_new0 (Image);
+      image->page = page;
+      image->area.x = x;
+      image->area.y = y;
+      image->area.width  = gdk_pixbuf_get_width (pixbuf);
+      image->area.height = gdk_pixbuf_get_height (pixbuf);
+      hd_theme_atlas_upload (atlas, image, pixbuf);
+      hd_theme_atlas_changed (atlas);
+    }
+
+  g_hash_table_insert (atlas->images, g_strdup (fname), image);
+  return image;
+}
+
+static void
+hd_theme_atlas_untrack (gpointer image, GObject *actor)
+{
+  ((Image *)image)->actors = g_slist_remove (((Image *)image)->actors,
+                                             actor);
+}
+
+static void
+free_image (gpointer data)
+{
+  Image *image = data;
+  GSList *li;
+
+  if (!image)
+    return;
+
+  for (li = image->actors; li; li = li->next)
+    g_object_weak_unref (li->data, hd_theme_atlas_untrack, image);
+  g_slist_free (image->actors);
+  g_slice_free (Image, image);
+}
+
+/* Read the saved layout.  Returns whether it was made of the same theme
+ * as we have now, and its placements in @places either way. */
+static gboolean
+hd_theme_atlas_read_layout (HdThemeAtlas *atlas, GArray *places)
+{
+  gchar *fname, *contents, **lines, theme_path[256];
+  glong mtime;
+  gboolean same;
+  guint i;
+
+  fname = layout_file_name ();
+  if (!g_file_get_contents (fname, &contents, NULL, NULL))
+    {
+      g_free (fname);
+      return FALSE;
+    }
+  g_free (fname);
+
+  lines = g_strsplit (contents, "\n", 0);
+  g_free (contents);
+  if (!lines[0] || strcmp (lines[0], LAYOUT_MAGIC) || !lines[1]
+      || sscanf (lines[1], "%255s %ld", theme_path, &mtime) != 2)
+    {
+      g_strfreev (lines);
+      return FALSE;
+    }
+  same = !strcmp (theme_path, atlas->theme_path) && mtime == atlas->mtime;
+
+  for (i = 2; lines[i]; i++)
+    {
+      Placement place;
+      gint name_at;
+
+      if (sscanf (lines[i], "%u %u %u %u %u %n", &place.page,
+                  &place.x, &place.y, &place.width, &place.height,
+                  &name_at) == 5 && lines[i][name_at])
+        {
+          place.fname = g_strdup (&lines[i][name_at]);
+          g_array_append_val (places, place);
+        }
+    }
+
+  g_strfreev (lines);
+  return same;
+}
+
+static gint
+placement_cmp_height (gconstpointer a, gconstpointer b)
+{
+  return (gint)((const Placement *)b)->height
+    - (gint)((const Placement *)a)->height;
+}
+
+/* Pack the images the atlas had the last time.  If the theme hasn't
+ * changed since then they go where they were, otherwise they are packed
+ * anew, the tallest first, which wastes the least room on the shelves. */
+static void
+hd_theme_atlas_load (HdThemeAtlas *atlas)
+{
+  GArray *places;
+  gboolean same;
+  guint i;
+
+  places = g_array_new (FALSE, FALSE, sizeof (Placement));
+  same = hd_theme_atlas_read_layout (atlas, places);
+  if (!same)
+    g_array_sort (places, placement_cmp_height);
+
+  for (i = 0; i < places->len; i++)
+    {
+      Placement *place = &g_array_index (places, Placement, i);
+      GdkPixbuf *pixbuf;
+
+      if (g_hash_table_lookup_extended (atlas->images, place->fname,
+                                        NULL, NULL))
+        goto next;
+      if (!(pixbuf = hd_theme_atlas_load_image (atlas, place->fname)))
+        goto next;
+
+      if (same
+          && gdk_pixbuf_get_width (pixbuf) == place->width
+          && gdk_pixbuf_get_height (pixbuf) == place->height
+          && hd_theme_atlas_reserve (atlas, place))
+        {
+          Image *image = g_slice_new0 (Image);
+
+          image->page = place->page;
+          image->area.x = place->x;
+          image->area.y = place->y;
+          image->area.width  = place->width;
+          image->area.height = place->height;
+          hd_theme_atlas_upload (atlas, image, pixbuf);
+          g_hash_table_insert (atlas->images, place->fname, image);
+          place->fname = NULL;
+        }
+      else
+        hd_theme_atlas_add (atlas, place->fname, pixbuf);
+      g_object_unref (pixbuf);
+
+next:
+      g_free (place->fname);
+    }
+
+  g_array_free (places, TRUE);
+}
+
+/* Create an atlas of the images in @theme_path, with its textures
+ * in @parent. */
+HdThemeAtlas *
+hd_theme_atlas_new (const gchar *theme_path, ClutterContainer *parent)
+{
+  HdThemeAtlas *atlas;
+
+  atlas = g_slice_new0 (HdThemeAtlas);
+  atlas->theme_path = g_strdup (theme_path);
+  atlas->mtime = theme_mtime (theme_path);
+  atlas->pages = g_ptr_array_new ();
+  atlas->images = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         g_free, free_image);
+
+  atlas->group = clutter_group_new ();
+  clutter_actor_set_name (atlas->group, "HdThemeAtlas");
+  clutter_actor_hide (atlas->group);
+  clutter_container_add_actor (parent, atlas->group);
+
+  hd_theme_atlas_load (atlas);
+
+  return atlas;
+}
+
+static ClutterActor *
+hd_theme_atlas_image_texture (HdThemeAtlas *atlas, const Image *image)
+{
+  return image->texture
+    ? image->texture
+    : ((Page *)g_ptr_array_index (atlas->pages, image->page))->texture;
+}
+
+/* Make the actors of @image show the same part of it as they did when
+ * it was at @old_area. */
+static void
+hd_theme_atlas_move_actors (HdThemeAtlas *atlas, const Image *image,
+                            const ClutterGeometry *old_area)
+{
+  ClutterActor *texture;
+  GSList *li;
+
+  texture = hd_theme_atlas_image_texture (atlas, image);
+  for (li = image->actors; li; li = li->next)
+    {
+      TidySubTexture *actor = li->data;
+      ClutterGeometry region;
+      gint right, bottom;
+      gboolean visible;
+
+      tidy_sub_texture_get_region (actor, &region);
+      region.x += image->area.x - old_area->x;
+      region.y += image->area.y - old_area->y;
+
+      /* The image may have shrunk. */
+      right  = MIN (region.x + (gint)region.width,
+                    image->area.x + (gint)image->area.width);
+      bottom = MIN (region.y + (gint)region.height,
+                    image->area.y + (gint)image->area.height);
+      if (right <= region.x || bottom <= region.y)
+        region = image->area;
+      else
+        {
+          region.width  = right  - region.x;
+          region.height = bottom - region.y;
+        }
+
+      /* Setting the parent texture hides @actor unless the texture is
+       * visible, and ours never are. */
+      if (tidy_sub_texture_get_parent_texture (actor)
+          != CLUTTER_TEXTURE (texture))
+        {
+          visible = CLUTTER_ACTOR_IS_VISIBLE (actor);
+          tidy_sub_texture_set_parent_texture (actor,
+                                               CLUTTER_TEXTURE (texture));
+          if (visible)
+            clutter_actor_show (CLUTTER_ACTOR (actor));
+        }
+      tidy_sub_texture_set_region (actor, &region);
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (actor));
+    }
+}
+
+/* Give @image a texture of its own, if it no longer fits in the atlas. */
+static gboolean
+hd_theme_atlas_set_standalone (HdThemeAtlas *atlas, const gchar *fname,
+                               Image *image)
+{
+  ClutterGeometry old_area = image->area;
+  gint width, height;
+  gchar *path;
+
+  path = g_build_filename (atlas->theme_path, fname, NULL);
+  if (image->texture)
+    {
+      if (!clutter_texture_set_from_file (CLUTTER_TEXTURE (image->texture),
+                                          path, NULL))
+        {
+          g_free (path);
+          return FALSE;
+        }
+    }
+  else if ((image->texture = clutter_texture_new_from_file (path, NULL)))
+    clutter_container_add_actor (CLUTTER_CONTAINER (atlas->group),
+                                 image->texture);
+  g_free (path);
+  if (!image->texture)
+    return FALSE;
+
+  clutter_texture_get_base_size (CLUTTER_TEXTURE (image->texture),
+                                 &width, &height);
+  image->area.x = image->area.y = 0;
+  image->area.width = width;
+  image->area.height = height;
+  hd_theme_atlas_move_actors (atlas, image, &old_area);
+
+  return TRUE;
+}
+
+/* Returns where @fname is in the atlas, adding it if it's not there yet.
+ * %FALSE if it's not in the atlas and won't be. */
+gboolean
+hd_theme_atlas_lookup (HdThemeAtlas *atlas, const gchar *fname,
+                       ClutterTexture **page, ClutterGeometry *area)
+{
+  gpointer value;
+  Image *image;
+
+  if (g_hash_table_lookup_extended (atlas->images, fname, NULL, &value))
+    image = value;
+  else
+    {
+      GdkPixbuf *pixbuf = hd_theme_atlas_load_image (atlas, fname);
+      image = hd_theme_atlas_add (atlas, fname, pixbuf);
+      if (pixbuf)
+        g_object_unref (pixbuf);
+    }
+
+  if (!image)
+    return FALSE;
+
+  *page = CLUTTER_TEXTURE (hd_theme_atlas_image_texture (atlas, image));
+  *area = image->area;
+  return TRUE;
+}
+
+/* Keep @actor, which shows some of @fname, showing the same part of it
+ * if the image moves when the theme changes. */
+void
+hd_theme_atlas_track (HdThemeAtlas *atlas, const gchar *fname,
+                      TidySubTexture *actor)
+{
+  Image *image;
+
+  if (!(image = g_hash_table_lookup (atlas->images, fname)))
+    return;
+
+  image->actors = g_slist_prepend (image->actors, actor);
+  g_object_weak_ref (G_OBJECT (actor), hd_theme_atlas_untrack, image);
+}
+
+/*
+ * Reload the images after the theme has changed.  Those which are the
+ * same size as before are reloaded in place.  The others are moved to a
+ * new place in the atlas, or to a texture of their own if there's no
+ * room, and their actors are moved with them.  The places they leave
+ * are lost until the next restart, when everything is packed anew.
+ */
+void
+hd_theme_atlas_theme_changed (HdThemeAtlas *atlas)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+
+  g_hash_table_iter_init (&iter, atlas->images);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      Image *image = value;
+      ClutterGeometry old_area;
+      GdkPixbuf *pixbuf;
+      guint page, x, y;
+
+      /* The new theme may have it smaller. */
+      if (!image)
+        {
+          g_hash_table_iter_remove (&iter);
+          continue;
+        }
+
+      if (image->texture)
+        {
+          hd_theme_atlas_set_standalone (atlas, key, image);
+          continue;
+        }
+
+      /* If it's too big now it'll get its own texture. */
+      if (!(pixbuf = hd_theme_atlas_load_image (atlas, key)))
+        {
+          hd_theme_atlas_set_standalone (atlas, key, image);
+          continue;
+        }
+
+      if (gdk_pixbuf_get_width (pixbuf) == image->area.width
+          && gdk_pixbuf_get_height (pixbuf) == image->area.height)
+        {
+          hd_theme_atlas_upload (atlas, image, pixbuf);
+          hd_theme_atlas_move_actors (atlas, image, &image->area);
+        }
+      else if (hd_theme_atlas_alloc (atlas,
+                                     gdk_pixbuf_get_width (pixbuf),
+                                     gdk_pixbuf_get_height (pixbuf),
+                                     &page, &x, &y))
+        {
+          old_area = image->area;
+          image->page = page;
+          image->area.x = x;
+          image->area.y = y;
+          image->area.width  = gdk_pixbuf_get_width (pixbuf);
+          image->area.height = gdk_pixbuf_get_height (pixbuf);
+          hd_theme_atlas_upload (atlas, image, pixbuf);
+          hd_theme_atlas_move_actors (atlas, image, &old_area);
+        }
+      else
+        hd_theme_atlas_set_standalone (atlas, key, image);
+      g_object_unref (pixbuf);
+    }
+
+  atlas->mtime = theme_mtime (atlas->theme_path);
+  hd_theme_atlas_changed (atlas);
+}
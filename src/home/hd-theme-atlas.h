@@ -0,0 +1,52 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Packs the small images of a theme into a few large textures, so that
+ * the #TidySubTexture:s HdClutterCache makes of them all sample the same
+ * texture.  Images are added when they're first looked up; which ones
+ * were in the atlas and where is remembered on disk, and the next time
+ * the same theme is loaded they are all packed at once.  Actors made of
+ * the images should be hd_theme_atlas_track()ed, so that they can be
+ * moved along with them when the theme changes.
+ */
+
+#ifndef __HD_THEME_ATLAS_H__
+#define __HD_THEME_ATLAS_H__
+
+#include <clutter/clutter.h>
+
+#include "tidy/tidy-sub-texture.h"
+
+typedef struct _HdThemeAtlas HdThemeAtlas;
+
+HdThemeAtlas *hd_theme_atlas_new           (const gchar *theme_path,
+                                            ClutterContainer *parent);
+gboolean      hd_theme_atlas_lookup        (HdThemeAtlas *atlas,
+                                            const gchar *fname,
+                                            ClutterTexture **page,
+                                            ClutterGeometry *area);
+void          hd_theme_atlas_track         (HdThemeAtlas *atlas,
+                                            const gchar *fname,
+                                            TidySubTexture *actor);
+void          hd_theme_atlas_theme_changed (HdThemeAtlas *atlas);
+
+#endif /* __HD_THEME_ATLAS_H__ */
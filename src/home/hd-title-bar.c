@@ -29,6 +29,7 @@
 
 #include "hd-title-bar.h"
 #include "hd-clutter-cache.h"
+#include "hd-text-cache.h"
 #include "mb/hd-app.h"
 #include "mb/hd-comp-mgr.h"
 #include "mb/hd-decor.h"
@@ -172,9 +173,11 @@ struct _HdTitleBarPrivate
 
   /* Stretched image for the title background */
   ClutterActor          *title_bg;
-  ClutterLabel          *title;
+  ClutterActor          *title;
   /* The title to be used when in HDRM_STATE_LOADING */
   gchar                 *loading_title;
+  /* The title to be used in the launcher, if any */
+  gchar                 *launcher_title;
   /* Pulsing animation for switcher */
   ClutterTimeline       *switcher_timeline;
   /* progress indicator */
@@ -219,6 +222,8 @@ static void hd_title_bar_set_title (HdTitleBar *bar,
                                     const char *title,
                                     gboolean has_markup,
                                     gboolean waiting);
+static void hd_title_bar_title_changed (ClutterActor *title,
+                                        gpointer bar);
 /* ------------------------------------------------------------------------- */
 
 /* One pulse is breathe in or breathe out.  The animation takes two
@@ -358,16 +363,17 @@ hd_title_bar_init (HdTitleBar *bar)
   hd_title_bar_add_left_signals(bar, priv->buttons[BTN_MENU]);
   hd_title_bar_add_right_signals(bar, priv->buttons[BTN_DONE]);
 
-  /* Create the title */
-  priv->title = CLUTTER_LABEL(clutter_label_new());
+  /* Create the title.  Applications may change it often, so it's
+   * cached per string rather than laid out and drawn every time. */
+  priv->title = hd_text_cache_label_new(font_name);
   /* Explicitly enable maemo-specific visibility detection to cut down
    * spurious paints */
-  clutter_actor_set_visibility_detect(CLUTTER_ACTOR(priv->title), TRUE);
-  clutter_label_set_color(priv->title, &title_color);
-  /* do not call clutter_label_set_use_markup() until we know whether
-   * or not the text has markup */
-  clutter_container_add_actor(CLUTTER_CONTAINER(bar), CLUTTER_ACTOR(priv->title));
-  clutter_actor_hide(CLUTTER_ACTOR(priv->title));
+  clutter_actor_set_visibility_detect(priv->title, TRUE);
+  hd_text_cache_label_set(priv->title, NULL, FALSE, &title_color, -1);
+  hd_text_cache_label_set_notify(priv->title,
+                                 hd_title_bar_title_changed, bar);
+  clutter_container_add_actor(CLUTTER_CONTAINER(bar), priv->title);
+  clutter_actor_hide(priv->title);
 
   /* Make sure the 'foreground' is in the right place */
   clutter_actor_raise_top(CLUTTER_ACTOR(priv->foreground));
@@ -456,6 +462,11 @@ hd_title_bar_dispose (GObject *obj)
       g_free(priv->loading_title);
       priv->loading_title = 0;
     }
+  if (priv->launcher_title)
+    {
+      g_free(priv->launcher_title);
+      priv->launcher_title = 0;
+    }
   if (priv->progress_timeline)
     clutter_timeline_stop(priv->progress_timeline);
   for (i=0;i<BTN_COUNT;i++)
@@ -1063,14 +1074,9 @@ static gint hd_title_bar_get_end_of_title(HdTitleBar *bar,
   gint x = 0;
   gint max_x = hd_comp_mgr_get_current_screen_width () -
               (width + hd_title_bar_get_button_width(bar));
-  PangoRectangle logical_rect = { 0, };
-  PangoLayout *layout;
-
-  layout = clutter_label_get_layout (priv->title);
-  pango_layout_get_extents (layout, NULL, &logical_rect);
 
-  x = clutter_actor_get_x(CLUTTER_ACTOR(priv->title)) +
-      (int)pango_units_to_double(logical_rect.width) +
+  x = clutter_actor_get_x(priv->title) +
+      hd_text_cache_label_get_text_width(priv->title) +
       HD_TITLE_BAR_PROGRESS_MARGIN;
 
   if (x > max_x)
@@ -1116,24 +1122,20 @@ static void hd_title_bar_set_title (HdTitleBar *bar,
         x_start += clutter_actor_get_width(status_area);
 
       font_name = hd_gtk_style_resolve_logical_font(HD_TITLE_BAR_TITLE_FONT);
-      clutter_label_set_font_name(priv->title, font_name);
+      hd_text_cache_label_set_font(priv->title, font_name);
       g_free(font_name);
-      clutter_label_set_text(priv->title, title);
 
-      clutter_label_set_use_markup(priv->title, has_markup);
-
-      h = clutter_actor_get_height(CLUTTER_ACTOR(priv->title));
       w = x_end - (x_start + title_margin);
+      hd_text_cache_label_set(priv->title, title, has_markup, NULL, w);
 
-      clutter_actor_set_width(CLUTTER_ACTOR(priv->title), w);
-      clutter_actor_set_position(CLUTTER_ACTOR(priv->title),
+      h = clutter_actor_get_height(priv->title);
+      clutter_actor_set_position(priv->title,
                                  x_start+title_margin,
                                  (HD_COMP_MGR_TOP_MARGIN-h)/2);
-      clutter_label_set_ellipsize(priv->title, PANGO_ELLIPSIZE_END);
-      clutter_actor_show(CLUTTER_ACTOR(priv->title));
+      clutter_actor_show(priv->title);
     }
   else
-    clutter_actor_hide(CLUTTER_ACTOR(priv->title));
+    clutter_actor_hide(priv->title);
 
   if (waiting)
     {
@@ -1190,6 +1192,23 @@ void hd_title_bar_set_loading_title   (HdTitleBar *bar,
   hd_title_bar_update(bar);
 }
 
+/* Shows @title in the launcher, or nothing if it's %NULL. */
+void hd_title_bar_set_launcher_title  (HdTitleBar *bar,
+                                       const char *title)
+{
+  HdTitleBarPrivate *priv;
+  if (!HD_IS_TITLE_BAR(bar))
+    return;
+  priv = bar->priv;
+
+  if (!g_strcmp0(priv->launcher_title, title))
+    return;
+  g_free(priv->launcher_title);
+  priv->launcher_title = g_strdup(title);
+
+  hd_title_bar_update(bar);
+}
+
 static gboolean
 hd_title_bar_update_idle(HdTitleBar *bar)
 {
@@ -1224,6 +1243,9 @@ hd_title_bar_update_idle(HdTitleBar *bar)
         c = NULL;
 
       hd_title_bar_set_window(bar, c);
+      if (STATE_IS_LAUNCHER (hd_render_manager_get_state ())
+          && priv->launcher_title)
+        hd_title_bar_set_title (bar, priv->launcher_title, FALSE, FALSE);
       clutter_actor_set_reactive(bar->priv->title_bg, FALSE);
     }
 
@@ -1256,6 +1278,14 @@ hd_title_bar_update(HdTitleBar *bar)
                                   bar, NULL);
 }
 
+/* The title has been rendered late, so it may have grown or shrunk
+ * under the progress and menu indicators.  Place them again. */
+static void
+hd_title_bar_title_changed (ClutterActor *title, gpointer bar)
+{
+  hd_title_bar_update(HD_TITLE_BAR(bar));
+}
+
 void
 hd_title_bar_update_now(HdTitleBar *bar)
 {
@@ -1531,7 +1561,7 @@ hd_title_bar_get_xy (HdTitleBar *bar, int *x, int *y)
   if (!HD_IS_TITLE_BAR(bar) || !x || !y)
     return;
 
-  titlebar = CLUTTER_ACTOR(bar->priv->title);
+  titlebar = bar->priv->title;
 
   if (titlebar)
   {
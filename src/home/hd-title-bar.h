@@ -89,6 +89,8 @@ void hd_title_bar_update_now(HdTitleBar *bar);
 
 void hd_title_bar_set_loading_title   (HdTitleBar *bar,
                                        const char *title);
+void hd_title_bar_set_launcher_title  (HdTitleBar *bar,
+                                       const char *title);
 
 gboolean
 hd_title_bar_is_title_bar_decor(HdTitleBar *bar, MBWMDecor *decor);
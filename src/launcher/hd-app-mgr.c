@@ -46,11 +46,14 @@
 #include <mce/mode-names.h>
 #include "hd-launcher.h"
 #include "hd-launcher-tree.h"
+#include "hd-launch-helper.h"
+#include "hd-app-queue.h"
 #include "home/hd-render-manager.h"
 #include "home/hd-home-view-container.h"
 #include "hd-transition.h"
 #include "hd-wm.h"
 #include "hd-orientation-lock.h"
+#include "hd-startup.h"
 
 #undef  G_LOG_DOMAIN
 #define G_LOG_DOMAIN "hd-app-mgr"
@@ -105,8 +108,9 @@ struct _HdAppMgrPrivate
   /* All the running apps we know about. */
   GList *running_apps;
 
-  /* Each one of these lists contain different HdRunningApps. */
-  GQueue *queues[NUM_QUEUES];
+  /* Each one of these lists contain different HdRunningApps, which
+   * know their place in them through hd_running_app_get_queue_link(). */
+  HdAppQueue *queues[NUM_QUEUES];
 
   /* Is the state check already looping? */
   gboolean state_check_looping;
@@ -224,6 +228,7 @@ gboolean conf_enable_dbus_shift_ctrl;
 gboolean conf_enable_home_contacts_phone;
 gboolean conf_enable_launcher_navigator_accel;
 gboolean conf_enable_dbus_launcher_navigator;
+gboolean conf_enable_launcher_search;
 gboolean conf_default_launcher_positions;
 gboolean conf_dbus_shortcuts_use_fn;
 gboolean conf_dbus_ctrl_shortcuts;
@@ -245,6 +250,8 @@ gboolean hd_app_mgr_hibernate (HdRunningApp *app);
 
 static gboolean hd_app_mgr_service_top (const gchar *service,
                                         const gchar *param);
+static gboolean hd_app_mgr_spawn (gchar **argv, GPid *pid,
+                                  gboolean auto_reap, GError **error);
 
 void hd_app_mgr_prestartable     (HdRunningApp *app, gboolean prestartable);
 
@@ -255,6 +262,11 @@ static void hd_app_mgr_remove_from_queue (HdAppMgrQueue queue,
 static void hd_app_mgr_move_queue (HdAppMgrQueue queue_from,
                                    HdAppMgrQueue queue_to,
                                    HdRunningApp *app);
+typedef gboolean (*HdAppMgrServiceFunc) (HdRunningApp *app);
+static guint hd_app_mgr_service_queue (HdAppMgrQueue queue,
+                                       gboolean lowest,
+                                       guint max,
+                                       HdAppMgrServiceFunc func);
 
 static size_t   hd_app_mgr_read_lowmem (const gchar *filename);
 static HdAppMgrPrestartMode
@@ -294,6 +306,7 @@ static gboolean hd_app_mgr_show_callui_cb (gpointer data);
 static void     hd_app_mgr_request_app_pid (HdRunningApp *app);
 static gboolean hd_app_mgr_loading_timeout (HdRunningApp *app);
 static gboolean hd_app_mgr_init_done_timeout (HdAppMgr *self);
+static void     hd_app_mgr_start_init_done_timeout (gpointer self);
 
 static void hd_app_mgr_kill_all_prestarted (void);
 
@@ -416,15 +429,18 @@ hd_app_mgr_init (HdAppMgr *self)
   self->priv = priv = HD_APP_MGR_GET_PRIVATE (self);
 
   /* Initialize the queues. */
+  g_assert (NUM_QUEUES <= HD_RUNNING_APP_QUEUE_LINKS);
   for (int i = 0; i < NUM_QUEUES; i++)
-    priv->queues[i] = g_queue_new ();
+    priv->queues[i] = hd_app_queue_new ();
 
   priv->tree = hd_launcher_tree_new ();
   hd_launcher_tree_ensure_user_menu ();
   g_signal_connect (priv->tree, "finished",
                     G_CALLBACK (hd_app_mgr_populate_tree_finished),
                     self);
-  hd_launcher_tree_populate (priv->tree);
+  /* The launcher is not needed for the first frame. */
+  hd_startup_defer ("launcher tree", G_PRIORITY_HIGH_IDLE,
+                    (HdStartupTask)hd_launcher_tree_populate, priv->tree);
 
   /* NOTE: Can we assume this when we start up? */
   priv->unlocked = TRUE;
@@ -474,6 +490,8 @@ hd_app_mgr_init (HdAppMgr *self)
 			      GCONF_KEY_ACTIONS_DIR "/launcher_navigator_accel", NULL);
 	      conf_enable_dbus_launcher_navigator = gconf_client_get_bool(priv->gconf_client, 
 			      GCONF_KEY_ACTIONS_DIR "/dbus_launcher_navigator", NULL);
+	      conf_enable_launcher_search = gconf_client_get_bool(priv->gconf_client, 
+			      GCONF_KEY_ACTIONS_DIR "/launcher_search", NULL);
 	      conf_default_launcher_positions = gconf_client_get_bool(priv->gconf_client, 
 			      GCONF_KEY_ACTIONS_DIR "/default_launcher_positions", NULL);
 	      conf_ctrl_backspace_in_tasknav = gconf_client_get_int(priv->gconf_client, 
@@ -592,11 +610,11 @@ hd_app_mgr_init (HdAppMgr *self)
     g_warning ("%s: Failed to connect to system dbus.\n", __FUNCTION__);
 
   /* Add a timeout in case init_done is never received. That can happen
-   * when restarting, for example.
+   * when restarting, for example.  Count it from when we're up rather
+   * than from here, so a slow startup doesn't start prestarting early.
    */
-  g_timeout_add_seconds (INIT_DONE_TIMEOUT,
-                         (GSourceFunc)hd_app_mgr_init_done_timeout,
-                         self);
+  hd_startup_defer ("init_done timeout", G_PRIORITY_LOW,
+                    hd_app_mgr_start_init_done_timeout, self);
 }
 
 void
@@ -610,23 +628,19 @@ hd_app_mgr_set_render_manager (GObject *rendermgr)
                     priv);
 }
 
-static void
-_hd_app_mgr_kill_prestarted (HdRunningApp *app, gpointer user_data)
+static gboolean
+_hd_app_mgr_kill_prestarted (HdRunningApp *app)
 {
+  /* Don't get stuck at the ones we can't kill. */
   hd_app_mgr_kill (app);
+  return TRUE;
 }
 
 static void
 hd_app_mgr_kill_all_prestarted ()
 {
-  GQueue *prestarted;
-  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
-
-  prestarted = g_queue_copy (priv->queues[QUEUE_PRESTARTED]);
-  g_queue_foreach (prestarted,
-                   (GFunc)_hd_app_mgr_kill_prestarted,
-                   NULL);
-  g_queue_free (prestarted);
+  hd_app_mgr_service_queue (QUEUE_PRESTARTED, TRUE, G_MAXUINT,
+                            _hd_app_mgr_kill_prestarted);
 }
 
 /* Called when exiting main() to close all prestarted apps. */
@@ -668,9 +682,12 @@ hd_app_mgr_dispose (GObject *gobject)
     {
       if (priv->queues[i])
         {
-          g_queue_foreach (priv->queues[i], (GFunc)g_object_unref, NULL);
-          g_queue_free (priv->queues[i]);
+          GList *apps = hd_app_queue_to_list (priv->queues[i]);
+
+          hd_app_queue_free (priv->queues[i]);
           priv->queues[i] = NULL;
+          g_list_foreach (apps, (GFunc)g_object_unref, NULL);
+          g_list_free (apps);
         }
     }
 
@@ -684,27 +701,13 @@ hd_app_mgr_dispose (GObject *gobject)
   G_OBJECT_CLASS (hd_app_mgr_parent_class)->dispose (gobject);
 }
 
+/* Apps without a launcher come first, then the higher priorities. */
 static gint
-_hd_app_mgr_compare_app_priority (gconstpointer a,
-                                  gconstpointer b,
-                                  gpointer user_data)
+_hd_app_mgr_app_priority (HdRunningApp *app)
 {
-  HdRunningApp *a_rapp = HD_RUNNING_APP (a);
-  HdRunningApp *b_rapp = HD_RUNNING_APP (b);
-  HdLauncherApp *a_launcher = hd_running_app_get_launcher_app (a_rapp);
-  HdLauncherApp *b_launcher = hd_running_app_get_launcher_app (b_rapp);
-
-  if (!a_launcher && !b_launcher)
-    return 0;
-  if (!a_launcher)
-    return -1;
-  if (!b_launcher)
-    return 1;
-
-  gint a_priority = hd_launcher_app_get_priority (a_launcher);
-  gint b_priority = hd_launcher_app_get_priority (b_launcher);
+  HdLauncherApp *launcher = hd_running_app_get_launcher_app (app);
 
-  return b_priority - a_priority;
+  return launcher ? hd_launcher_app_get_priority (launcher) : G_MAXINT;
 }
 
 static void
@@ -715,27 +718,23 @@ hd_app_mgr_add_to_queue (HdAppMgrQueue queue, HdRunningApp *app)
 
   HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
 
-  /* Check if app's already there. */
-  GList *link = g_queue_find (priv->queues[queue], app);
-  if (link)
-    return;
-
-  g_queue_insert_sorted (priv->queues[queue],
-                         g_object_ref (app),
-                         _hd_app_mgr_compare_app_priority,
-                         NULL);
+  /* Returns FALSE if app's already there. */
+  if (hd_app_queue_insert (priv->queues[queue],
+                           hd_running_app_get_queue_link (app, queue),
+                           _hd_app_mgr_app_priority (app)))
+    g_object_ref (app);
 }
 
 static void
 hd_app_mgr_remove_from_queue (HdAppMgrQueue queue, HdRunningApp *app)
 {
   HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
-  GList *link = g_queue_find (priv->queues[queue], app);
+  HdAppQueueLink *link = hd_running_app_get_queue_link (app, queue);
 
-  if (link)
+  if (hd_app_queue_contains (priv->queues[queue], link))
     {
+      hd_app_queue_remove (link);
       g_object_unref (app);
-      g_queue_delete_link (priv->queues[queue], link);
     }
 }
 
@@ -748,21 +747,44 @@ hd_app_mgr_move_queue (HdAppMgrQueue queue_from,
     return;
 
   HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
-  GList *link = g_queue_find (priv->queues[queue_from], app);
+  HdAppQueueLink *link = hd_running_app_get_queue_link (app, queue_from);
 
-  if (link)
+  if (hd_app_queue_contains (priv->queues[queue_from], link))
     {
-      g_queue_delete_link (priv->queues[queue_from], link);
-      g_queue_insert_sorted (priv->queues[queue_to],
-                             app,
-                             _hd_app_mgr_compare_app_priority,
-                             NULL);
-
+      /* Pass our reference on to @queue_to unless it has one already. */
+      hd_app_queue_remove (link);
+      if (!hd_app_queue_insert (priv->queues[queue_to],
+                          hd_running_app_get_queue_link (app, queue_to),
+                          _hd_app_mgr_app_priority (app)))
+        g_object_unref (app);
     }
   else
     hd_app_mgr_add_to_queue (queue_to, app);
 }
 
+static gboolean
+hd_app_mgr_service_one (gpointer app, gpointer func)
+{
+  return (*(HdAppMgrServiceFunc *)func) (app);
+}
+
+/*
+ * Calls @func with the apps of @queue from the top, or the bottom if
+ * @lowest, while it returns TRUE, at most @max times.  Whether an app
+ * leaves @queue is up to @func: a killed prestarted app, for instance,
+ * stays in QUEUE_PRESTARTED until we see it exit.  Returns the number
+ * of apps serviced.
+ */
+static guint
+hd_app_mgr_service_queue (HdAppMgrQueue queue, gboolean lowest, guint max,
+                          HdAppMgrServiceFunc func)
+{
+  HdAppMgrPrivate *priv = HD_APP_MGR_GET_PRIVATE (hd_app_mgr_get ());
+
+  return hd_app_queue_service (priv->queues[queue], lowest, max,
+                               hd_app_mgr_service_one, &func);
+}
+
 void hd_app_mgr_prestartable (HdRunningApp *app, gboolean prestartable)
 {
   if (prestartable)
@@ -997,12 +1019,26 @@ hd_app_mgr_start (HdRunningApp *app)
       if (exec)
         {
           GPid pid = 0;
-          result = hd_app_mgr_execute (exec, &pid, FALSE);
+          GError *error = NULL;
+          gchar **argv;
+
+          argv = hd_launcher_app_get_argv (launcher);
+          result = argv && hd_app_mgr_spawn (argv, &pid, FALSE, &error);
+          if (!result && error && g_error_matches (error, G_SPAWN_ERROR,
+                                                   G_SPAWN_ERROR_NOENT))
+            { /* It has moved since we looked it up. */
+              hd_launcher_app_forget_argv (launcher);
+              argv = hd_launcher_app_get_argv (launcher);
+              result = argv && hd_app_mgr_spawn (argv, &pid, FALSE, NULL);
+            }
+          if (error)
+            g_error_free (error);
+
           if (result)
             {
               hd_running_app_set_pid (app, pid);
               /* Watch the child. */
-              g_child_watch_add (pid,
+              hd_launch_helper_child_watch_add (pid,
                                  (GChildWatchFunc)_hd_app_mgr_child_exit,
                                  g_object_ref (app));
             }
@@ -1343,6 +1379,10 @@ hd_app_mgr_hibernate (HdRunningApp *app)
     /* Can't hibernate a non-dbus app. */
     return FALSE;
 
+  /* Keep what it looks like to show it while it's hibernated. */
+  if (hd_running_app_is_executing (app))
+    hd_comp_mgr_snapshot_app (hd_comp_mgr_get (), app);
+
   if (hd_app_mgr_kill (app))
     {
       hd_running_app_set_state (app, HD_APP_STATE_HIBERNATED);
@@ -1417,48 +1457,41 @@ _hd_app_mgr_child_setup(gpointer user_data)
   }
 }
 
-gboolean
-hd_app_mgr_execute (const gchar *exec, GPid *pid, gboolean auto_reap)
+/* Spawns @argv through the launch helper if it's running, otherwise
+ * forks us. */
+static gboolean
+hd_app_mgr_spawn (gchar **argv, GPid *pid, gboolean auto_reap,
+                  GError **error)
 {
-  gboolean res = FALSE;
-  gchar *space = strchr (exec, ' ');
-  gchar *exec_cmd;
-  gint argc;
-  gchar **argv = NULL;
+  GError *err = NULL;
 
-  if (space)
-  {
-    gchar *cmd = g_strndup (exec, space - exec);
-    gchar *exc = g_find_program_in_path (cmd);
-
-    exec_cmd = g_strconcat (exc, space, NULL);
+  if (hd_launch_helper_spawn (argv, pid, &err))
+    return TRUE;
+  if (err)
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
 
-    g_free (cmd);
-    g_free (exc);
-  }
-  else
-    exec_cmd = g_find_program_in_path (exec);
+  return g_spawn_async (NULL,
+                        argv, NULL,
+                        auto_reap ? 0 : G_SPAWN_DO_NOT_REAP_CHILD,
+                        _hd_app_mgr_child_setup, NULL,
+                        pid,
+                        error);
+}
 
-  if (!exec_cmd ||
-      !g_shell_parse_argv (exec_cmd, &argc, &argv, NULL))
-  {
-    g_free (exec_cmd);
-    if (argv)
-      g_strfreev (argv);
+gboolean
+hd_app_mgr_execute (const gchar *exec, GPid *pid, gboolean auto_reap)
+{
+  gboolean res;
+  gchar **argv;
 
+  if (!(argv = hd_launch_helper_parse_exec (exec)))
     return FALSE;
-  }
-
-  res = g_spawn_async (NULL,
-                       argv, NULL,
-                       auto_reap ? 0 : G_SPAWN_DO_NOT_REAP_CHILD,
-                       _hd_app_mgr_child_setup, NULL,
-                       pid,
-                       NULL);
-  g_free (exec_cmd);
 
-  if (argv)
-    g_strfreev (argv);
+  res = hd_app_mgr_spawn (argv, pid, auto_reap, NULL);
+  g_strfreev (argv);
 
   return res;
 }
@@ -1662,6 +1695,15 @@ hd_app_mgr_state_check (void)
                          NULL);
 }
 
+static gboolean
+_hd_app_mgr_prestart_top (HdRunningApp *app)
+{
+  HdLauncherApp *launcher = hd_running_app_get_launcher_app (app);
+
+  return launcher && hd_app_mgr_can_prestart (launcher)
+    && hd_app_mgr_prestart (app);
+}
+
 /*
  * This function runs in a loop or whenever there's a change in memory
  * conditions. Depending on those conditions, it
@@ -1682,36 +1724,29 @@ hd_app_mgr_state_check_loop (gpointer data)
   if (priv->lowmem)
     {
       /* If there are prestarted apps, kill one of them. */
-      if (!g_queue_is_empty (priv->queues[QUEUE_PRESTARTED]))
-        {
-          HdRunningApp *app = g_queue_peek_tail (priv->queues[QUEUE_PRESTARTED]);
-          hd_app_mgr_kill (app);
-          if (!g_queue_is_empty (priv->queues[QUEUE_PRESTARTED]))
-            loop = TRUE;
-        }
+      hd_app_mgr_service_queue (QUEUE_PRESTARTED, TRUE, 1, hd_app_mgr_kill);
+      if (!hd_app_queue_is_empty (priv->queues[QUEUE_PRESTARTED]))
+        loop = TRUE;
     }
 
   /* If we're running low, hibernate an app. */
   else if (priv->bg_killing)
     {
       /* TODO: Hibernate an app and loop. */
-      if (!g_queue_is_empty (priv->queues[QUEUE_HIBERNATABLE]))
-        {
-          HdRunningApp *app = g_queue_peek_tail (priv->queues[QUEUE_HIBERNATABLE]);
-          hd_app_mgr_hibernate (app);
-          if (!g_queue_is_empty (priv->queues[QUEUE_HIBERNATABLE]))
-            loop = TRUE;
-        }
+      hd_app_mgr_service_queue (QUEUE_HIBERNATABLE, TRUE, 1,
+                                hd_app_mgr_hibernate);
+      if (!hd_app_queue_is_empty (priv->queues[QUEUE_HIBERNATABLE]))
+        loop = TRUE;
     }
   /* If there's enough memory and hibernated apps, try to awake them.
    * TODO: Add some way to avoid waking-up apps from being shown immediately
    * to the user as if launched anew.
-  else if (!g_queue_is_empty (priv->queues[QUEUE_HIBERNATED]) &&
+  else if (!hd_app_queue_is_empty (priv->queues[QUEUE_HIBERNATED]) &&
            hd_app_mgr_can_launch (NULL))
     {
-      HdLauncherApp *app = g_queue_peek_head (priv->queues[QUEUE_HIBERNATED]);
+      HdLauncherApp *app = hd_app_queue_peek_head (priv->queues[QUEUE_HIBERNATED]);
       hd_app_mgr_wakeup (app);
-      if (!g_queue_is_empty (priv->queues[QUEUE_HIBERNATED]))
+      if (!hd_app_queue_is_empty (priv->queues[QUEUE_HIBERNATED]))
         loop = TRUE;
     }
    */
@@ -1721,18 +1756,14 @@ hd_app_mgr_state_check_loop (gpointer data)
   else if (priv->init_done &&
            priv->prestart_mode != PRESTART_NEVER &&
            !priv->prestarting_stopped &&
-           !g_queue_is_empty (priv->queues[QUEUE_PRESTARTABLE])
+           !hd_app_queue_is_empty (priv->queues[QUEUE_PRESTARTABLE])
       )
     {
       /* We make this tests here to loop even if we can't prestart right now.*/
       if (!priv->prestarting)
-        {
-          HdRunningApp *app = g_queue_peek_head (priv->queues[QUEUE_PRESTARTABLE]);
-          HdLauncherApp *launcher = hd_running_app_get_launcher_app (app);
-          if (launcher && hd_app_mgr_can_prestart (launcher))
-            hd_app_mgr_prestart (app);
-        }
-      if (!g_queue_is_empty (priv->queues[QUEUE_PRESTARTABLE]))
+        hd_app_mgr_service_queue (QUEUE_PRESTARTABLE, FALSE, 1,
+                                  _hd_app_mgr_prestart_top);
+      if (!hd_app_queue_is_empty (priv->queues[QUEUE_PRESTARTABLE]))
         loop = TRUE;
     }
 
@@ -1987,6 +2018,14 @@ hd_app_mgr_check_show_callui (void)
   return FALSE;
 }
 
+static void
+hd_app_mgr_start_init_done_timeout (gpointer self)
+{
+  g_timeout_add_seconds (INIT_DONE_TIMEOUT,
+                         (GSourceFunc)hd_app_mgr_init_done_timeout,
+                         self);
+}
+
 static gboolean
 hd_app_mgr_init_done_timeout (HdAppMgr *self)
 {
@@ -2328,6 +2367,8 @@ hd_app_mgr_gconf_value_changed (GConfClient *client,
 			      GCONF_KEY_ACTIONS_DIR "/launcher_navigator_accel", NULL);
 	      conf_enable_dbus_launcher_navigator = gconf_client_get_bool(priv->gconf_client, 
 			      GCONF_KEY_ACTIONS_DIR "/dbus_launcher_navigator", NULL);
+	      conf_enable_launcher_search = gconf_client_get_bool(priv->gconf_client, 
+			      GCONF_KEY_ACTIONS_DIR "/launcher_search", NULL);
 	      conf_default_launcher_positions = gconf_client_get_bool(priv->gconf_client, 
 			      GCONF_KEY_ACTIONS_DIR "/default_launcher_positions", NULL);
 	      conf_ctrl_backspace_in_tasknav = gconf_client_get_int(priv->gconf_client, 
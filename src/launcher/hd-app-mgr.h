@@ -110,6 +110,7 @@ extern gboolean conf_enable_dbus_shift_ctrl;
 extern gboolean conf_enable_home_contacts_phone;
 extern gboolean conf_enable_launcher_navigator_accel;
 extern gboolean conf_enable_dbus_launcher_navigator;
+extern gboolean conf_enable_launcher_search;
 extern gboolean conf_default_launcher_positions;
 extern gboolean conf_dbus_shortcuts_use_fn;
 extern gboolean conf_dbus_ctrl_shortcuts;
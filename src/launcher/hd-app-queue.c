@@ -0,0 +1,252 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+
+#include "hd-app-queue.h"
+
+struct _HdAppQueue
+{
+  /* Of HdAppQueueLinks, in the order of _hd_app_queue_compare(). */
+  GSequence *links;
+
+  /* Incremented by every insertion to keep FIFO order among
+   * elements of equal priority. */
+  guint      serial;
+};
+
+static gint
+_hd_app_queue_compare (gconstpointer a, gconstpointer b, gpointer unused)
+{
+  const HdAppQueueLink *la = a, *lb = b;
+
+  if (la->priority != lb->priority)
+    return la->priority > lb->priority ? -1 : 1;
+  /* Wraps around only after 4G insertions to the same queue. */
+  return (gint)(la->serial - lb->serial);
+}
+
+void
+hd_app_queue_link_init (HdAppQueueLink *link, gpointer data)
+{
+  link->data = data;
+  link->queue = NULL;
+  link->iter = NULL;
+  link->priority = 0;
+  link->serial = 0;
+}
+
+HdAppQueue *
+hd_app_queue_new (void)
+{
+  HdAppQueue *queue = g_slice_new (HdAppQueue);
+
+  queue->links = g_sequence_new (NULL);
+  queue->serial = 0;
+
+  return queue;
+}
+
+/* Leaves the elements alone but unlinks them. */
+void
+hd_app_queue_free (HdAppQueue *queue)
+{
+  GSequenceIter *iter;
+
+  for (iter = g_sequence_get_begin_iter (queue->links);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      HdAppQueueLink *link = g_sequence_get (iter);
+      link->queue = NULL;
+      link->iter = NULL;
+    }
+
+  g_sequence_free (queue->links);
+  g_slice_free (HdAppQueue, queue);
+}
+
+/* Returns FALSE if @link is already in @queue. */
+gboolean
+hd_app_queue_insert (HdAppQueue *queue, HdAppQueueLink *link, gint priority)
+{
+  g_return_val_if_fail (queue && link, FALSE);
+
+  if (link->queue == queue)
+    return FALSE;
+  g_return_val_if_fail (!link->queue, FALSE);
+
+  link->queue = queue;
+  link->priority = priority;
+  link->serial = queue->serial++;
+  link->iter = g_sequence_insert_sorted (queue->links, link,
+                                         _hd_app_queue_compare, NULL);
+  return TRUE;
+}
+
+/* Takes @link out of whichever queue it is in.
+ * Returns FALSE if it wasn't in any. */
+gboolean
+hd_app_queue_remove (HdAppQueueLink *link)
+{
+  g_return_val_if_fail (link, FALSE);
+
+  if (!link->queue)
+    return FALSE;
+
+  g_sequence_remove (link->iter);
+  link->queue = NULL;
+  link->iter = NULL;
+  return TRUE;
+}
+
+/* Moves @link to @queue from where it was.  Returns whether it was
+ * in a queue before. */
+gboolean
+hd_app_queue_move (HdAppQueue *queue, HdAppQueueLink *link, gint priority)
+{
+  gboolean was_linked;
+
+  g_return_val_if_fail (queue && link, FALSE);
+
+  if (link->queue == queue && link->priority == priority)
+    return TRUE;
+
+  was_linked = hd_app_queue_remove (link);
+  hd_app_queue_insert (queue, link, priority);
+  return was_linked;
+}
+
+gboolean
+hd_app_queue_contains (HdAppQueue *queue, HdAppQueueLink *link)
+{
+  return link->queue == queue;
+}
+
+gboolean
+hd_app_queue_is_empty (HdAppQueue *queue)
+{
+  return g_sequence_iter_is_end (g_sequence_get_begin_iter (queue->links));
+}
+
+guint
+hd_app_queue_get_length (HdAppQueue *queue)
+{
+  return g_sequence_get_length (queue->links);
+}
+
+/* Returns the data of the highest priority element or NULL. */
+gpointer
+hd_app_queue_peek_head (HdAppQueue *queue)
+{
+  GSequenceIter *iter = g_sequence_get_begin_iter (queue->links);
+
+  return g_sequence_iter_is_end (iter)
+    ? NULL : ((HdAppQueueLink *)g_sequence_get (iter))->data;
+}
+
+/* Returns the data of the lowest priority element or NULL. */
+gpointer
+hd_app_queue_peek_tail (HdAppQueue *queue)
+{
+  GSequenceIter *iter = g_sequence_get_end_iter (queue->links);
+
+  return g_sequence_iter_is_begin (iter)
+    ? NULL
+    : ((HdAppQueueLink *)g_sequence_get (g_sequence_iter_prev (iter)))->data;
+}
+
+/* Returns the elements' data from head to tail.  Free the list
+ * with g_list_free(). */
+GList *
+hd_app_queue_to_list (HdAppQueue *queue)
+{
+  GSequenceIter *iter;
+  GList *list;
+
+  list = NULL;
+  for (iter = g_sequence_get_end_iter (queue->links);
+       !g_sequence_iter_is_begin (iter); )
+    {
+      iter = g_sequence_iter_prev (iter);
+      list = g_list_prepend (list,
+                   ((HdAppQueueLink *)g_sequence_get (iter))->data);
+    }
+
+  return list;
+}
+
+/* Returns the first element from the head or the tail, or NULL. */
+static GSequenceIter *
+_hd_app_queue_end (HdAppQueue *queue, gboolean tail)
+{
+  GSequenceIter *iter;
+
+  if (!tail)
+    {
+      iter = g_sequence_get_begin_iter (queue->links);
+      return g_sequence_iter_is_end (iter) ? NULL : iter;
+    }
+
+  iter = g_sequence_get_end_iter (queue->links);
+  return g_sequence_iter_is_begin (iter) ? NULL : g_sequence_iter_prev (iter);
+}
+
+/* Returns the element after @iter towards the tail, or towards the head
+ * if @backwards, or NULL. */
+static GSequenceIter *
+_hd_app_queue_step (GSequenceIter *iter, gboolean backwards)
+{
+  if (!backwards)
+    {
+      iter = g_sequence_iter_next (iter);
+      return g_sequence_iter_is_end (iter) ? NULL : iter;
+    }
+
+  return g_sequence_iter_is_begin (iter) ? NULL : g_sequence_iter_prev (iter);
+}
+
+/*
+ * Calls @func with the elements' data from the head, or the tail if
+ * @from_tail, while it returns TRUE, at most @max times.  @func may take
+ * its own element out of @queue, but must leave the others alone.
+ * Elements it leaves in @queue are not visited again, so it doesn't get
+ * stuck at one it can't do anything with yet.  Returns the number of
+ * elements @func accepted.
+ */
+guint
+hd_app_queue_service (HdAppQueue *queue, gboolean from_tail, guint max,
+                      HdAppQueueFunc func, gpointer user_data)
+{
+  GSequenceIter *iter, *next;
+  guint n;
+
+  iter = _hd_app_queue_end (queue, from_tail);
+  for (n = 0; iter && n < max; n++)
+    {
+      /* Step before @func, it may take @iter's element out. */
+      next = _hd_app_queue_step (iter, from_tail);
+      if (!func (((HdAppQueueLink *)g_sequence_get (iter))->data, user_data))
+        break;
+      iter = next;
+    }
+
+  return n;
+}
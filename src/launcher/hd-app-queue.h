@@ -0,0 +1,84 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+
+/*
+ * HdAppQueue is a priority queue whose elements carry their own
+ * HdAppQueueLink, so finding, removing or moving an element doesn't
+ * need to search the queue.  Higher priorities come first, and elements
+ * of equal priority are kept in the order they were inserted.
+ * Inserting and removing are O(log n), and peeking at either end
+ * is O(log n) too.
+ */
+
+#ifndef __HD_APP_QUEUE_H__
+#define __HD_APP_QUEUE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _HdAppQueue HdAppQueue;
+typedef struct _HdAppQueueLink HdAppQueueLink;
+
+typedef gboolean (*HdAppQueueFunc) (gpointer data, gpointer user_data);
+
+/* Embed one of these in the element for each queue it can be in.
+ * Initialize it with hd_app_queue_link_init(); the rest is private. */
+struct _HdAppQueueLink
+{
+  gpointer       data;
+
+  HdAppQueue    *queue;
+  GSequenceIter *iter;
+  gint           priority;
+  guint          serial;
+};
+
+void        hd_app_queue_link_init  (HdAppQueueLink *link, gpointer data);
+
+HdAppQueue *hd_app_queue_new        (void);
+void        hd_app_queue_free       (HdAppQueue *queue);
+
+gboolean    hd_app_queue_insert     (HdAppQueue *queue,
+                                     HdAppQueueLink *link,
+                                     gint priority);
+gboolean    hd_app_queue_remove     (HdAppQueueLink *link);
+gboolean    hd_app_queue_move       (HdAppQueue *queue,
+                                     HdAppQueueLink *link,
+                                     gint priority);
+gboolean    hd_app_queue_contains   (HdAppQueue *queue,
+                                     HdAppQueueLink *link);
+
+gboolean    hd_app_queue_is_empty   (HdAppQueue *queue);
+guint       hd_app_queue_get_length (HdAppQueue *queue);
+gpointer    hd_app_queue_peek_head  (HdAppQueue *queue);
+gpointer    hd_app_queue_peek_tail  (HdAppQueue *queue);
+GList      *hd_app_queue_to_list    (HdAppQueue *queue);
+guint       hd_app_queue_service    (HdAppQueue *queue,
+                                     gboolean from_tail,
+                                     guint max,
+                                     HdAppQueueFunc func,
+                                     gpointer user_data);
+
+G_END_DECLS
+
+#endif /* __HD_APP_QUEUE_H__ */
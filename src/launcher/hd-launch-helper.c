@@ -0,0 +1,527 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-launch-helper.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/* The largest request we send; longer command lines are spawned by
+ * ourselves. */
+#define HELPER_MAX_REQUEST      4096
+#define HELPER_MAX_ARGS         256
+/* How long to wait for the helper to spawn something, in ms. */
+#define HELPER_TIMEOUT          3000
+/* How often to look for the orphans of a dead helper, in seconds. */
+#define HELPER_ORPHAN_POLL      2
+
+#define OOM_DISABLE "0"
+
+/*
+ * The protocol.  A request is a single SOCK_SEQPACKET message holding
+ * the NUL-terminated arguments of the program to spawn, the first one
+ * being its absolute path.  The helper answers it with HELPER_SPAWNED,
+ * and sends HELPER_EXITED whenever one of its children exits.
+ */
+enum
+{
+  HELPER_SPAWNED,
+  HELPER_EXITED,
+};
+
+typedef struct
+{
+  gint32 type;
+  gint32 pid;      /* -errno if HELPER_SPAWNED failed */
+  gint32 status;   /* as returned by waitpid() */
+} HelperReply;
+
+typedef struct
+{
+  GChildWatchFunc func;
+  gpointer        data;
+} HelperWatch;
+
+static int helper_fd = -1;
+static guint helper_watch_id, helper_exits_idle, helper_orphans_timeout;
+
+/* Of the pids we got from the helper.  GINT_TO_POINTER (pid) ->
+ * HelperWatch, which is empty if nobody is watching the process. */
+static GHashTable *helper_children;
+/* HELPER_EXITED replies read while waiting for a HELPER_SPAWNED. */
+static GArray *helper_exits;
+
+/* The helper's side. */
+static int helper_sigchld_pipe[2];
+
+static void
+helper_sigchld (int unused)
+{
+  int saved_errno = errno;
+
+  write (helper_sigchld_pipe[1], "", 1);
+  errno = saved_errno;
+}
+
+static void
+helper_report_exits (int fd)
+{
+  HelperReply reply;
+  int status;
+  pid_t pid;
+
+  while ((pid = waitpid (-1, &status, WNOHANG)) > 0)
+    {
+      reply.type = HELPER_EXITED;
+      reply.pid = pid;
+      reply.status = status;
+      send (fd, &reply, sizeof (reply), MSG_NOSIGNAL);
+    }
+}
+
+static void
+helper_spawn (int fd, char *request, ssize_t len)
+{
+  char *argv[HELPER_MAX_ARGS + 1];
+  posix_spawnattr_t attr;
+  HelperReply reply;
+  char *p, *end;
+  int argc, ret;
+  pid_t pid = 0;
+
+  argc = 0;
+  end = request + len;
+  for (p = request; p < end && argc < HELPER_MAX_ARGS; p += strlen (p) + 1)
+    argv[argc++] = p;
+  argv[argc] = NULL;
+
+  if (argc > 0 && argv[0][0] == '/')
+    {
+      posix_spawnattr_init (&attr);
+#ifdef POSIX_SPAWN_USEVFORK
+      posix_spawnattr_setflags (&attr, POSIX_SPAWN_USEVFORK);
+#endif
+      ret = posix_spawn (&pid, argv[0], NULL, &attr, argv, environ);
+      posix_spawnattr_destroy (&attr);
+    }
+  else
+    ret = EINVAL;
+
+  reply.type = HELPER_SPAWNED;
+  reply.pid = ret ? -ret : pid;
+  reply.status = 0;
+  send (fd, &reply, sizeof (reply), MSG_NOSIGNAL);
+}
+
+static void
+helper_main (int fd)
+{
+  char request[HELPER_MAX_REQUEST];
+  struct sigaction sa;
+  struct pollfd fds[2];
+  ssize_t len;
+  int oom_fd;
+  char c;
+
+  signal (SIGHUP,  SIG_DFL);
+  signal (SIGTERM, SIG_DFL);
+  signal (SIGUSR1, SIG_DFL);
+
+  /* What _hd_app_mgr_child_setup() did for every child, once and for
+   * all: don't pass on our priority and OOM protection. */
+  errno = 0;
+  if (getpriority (PRIO_PROCESS, 0) < 0 && !errno)
+    setpriority (PRIO_PROCESS, 0, 0);
+  if ((oom_fd = open ("/proc/self/oom_adj", O_WRONLY)) >= 0)
+    {
+      write (oom_fd, OOM_DISABLE, sizeof (OOM_DISABLE));
+      close (oom_fd);
+    }
+
+  if (pipe (helper_sigchld_pipe) < 0)
+    _exit (1);
+  fcntl (helper_sigchld_pipe[0], F_SETFL, O_NONBLOCK);
+  fcntl (helper_sigchld_pipe[1], F_SETFL, O_NONBLOCK);
+  fcntl (helper_sigchld_pipe[0], F_SETFD, FD_CLOEXEC);
+  fcntl (helper_sigchld_pipe[1], F_SETFD, FD_CLOEXEC);
+  fcntl (fd, F_SETFD, FD_CLOEXEC);
+
+  memset (&sa, 0, sizeof (sa));
+  sa.sa_handler = helper_sigchld;
+  sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+  sigaction (SIGCHLD, &sa, NULL);
+
+  fds[0].fd = fd;
+  fds[0].events = POLLIN;
+  fds[1].fd = helper_sigchld_pipe[0];
+  fds[1].events = POLLIN;
+  for (;;)
+    {
+      if (poll (fds, 2, -1) < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          _exit (1);
+        }
+
+      if (fds[1].revents & POLLIN)
+        {
+          while (read (helper_sigchld_pipe[0], &c, 1) > 0)
+            ;
+          helper_report_exits (fd);
+        }
+
+      if (fds[0].revents & (POLLIN | POLLHUP | POLLERR))
+        {
+          len = recv (fd, request, sizeof (request), 0);
+          if (len <= 0)
+            /* The compositor is gone; leave the applications alone. */
+            _exit (0);
+          if (request[len - 1] == '\0')
+            helper_spawn (fd, request, len);
+        }
+    }
+}
+
+/* The compositor's side. */
+static void
+helper_dispatch_exit (const HelperReply *reply)
+{
+  HelperWatch *watch;
+
+  watch = g_hash_table_lookup (helper_children, GINT_TO_POINTER (reply->pid));
+  if (!watch)
+    return;
+
+  if (watch->func)
+    watch->func (reply->pid, reply->status, watch->data);
+  g_hash_table_remove (helper_children, GINT_TO_POINTER (reply->pid));
+}
+
+static gboolean
+helper_exits_idle_cb (gpointer unused)
+{
+  HelperReply reply;
+
+  helper_exits_idle = 0;
+  while (helper_exits->len > 0)
+    {
+      reply = g_array_index (helper_exits, HelperReply, 0);
+      g_array_remove_index (helper_exits, 0);
+      helper_dispatch_exit (&reply);
+    }
+
+  return FALSE;
+}
+
+/* Processes whose exit we can't learn from the helper anymore. */
+static gboolean
+helper_orphans_cb (gpointer unused)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  GArray *gone;
+  HelperReply reply;
+  guint i;
+
+  gone = g_array_new (FALSE, FALSE, sizeof (HelperReply));
+  g_hash_table_iter_init (&iter, helper_children);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    if (kill (GPOINTER_TO_INT (key), 0) < 0 && errno == ESRCH)
+      {
+        reply.type = HELPER_EXITED;
+        reply.pid = GPOINTER_TO_INT (key);
+        reply.status = 0;
+        g_array_append_val (gone, reply);
+      }
+
+  for (i = 0; i < gone->len; i++)
+    helper_dispatch_exit (&g_array_index (gone, HelperReply, i));
+  g_array_free (gone, TRUE);
+
+  if (g_hash_table_size (helper_children) > 0)
+    return TRUE;
+  helper_orphans_timeout = 0;
+  return FALSE;
+}
+
+static void
+helper_lost (void)
+{
+  g_warning ("launch helper is gone, spawning applications ourselves");
+
+  if (helper_watch_id)
+    {
+      g_source_remove (helper_watch_id);
+      helper_watch_id = 0;
+    }
+  close (helper_fd);
+  helper_fd = -1;
+
+  if (g_hash_table_size (helper_children) > 0 && !helper_orphans_timeout)
+    helper_orphans_timeout = g_timeout_add_seconds (HELPER_ORPHAN_POLL,
+                                                    helper_orphans_cb, NULL);
+}
+
+static gboolean
+helper_readable_cb (GIOChannel *source, GIOCondition condition,
+                    gpointer unused)
+{
+  HelperReply reply;
+  ssize_t len;
+
+  while ((len = recv (helper_fd, &reply, sizeof (reply), MSG_DONTWAIT))
+         == sizeof (reply))
+    if (reply.type == HELPER_EXITED)
+      helper_dispatch_exit (&reply);
+
+  if (len == 0 || (len < 0 && errno != EAGAIN && errno != EINTR))
+    {
+      helper_watch_id = 0;
+      helper_lost ();
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Fork the helper.  Call it early, while we're small. */
+gboolean
+hd_launch_helper_start (void)
+{
+  GIOChannel *channel;
+  int fds[2], status;
+  pid_t pid;
+
+  if (socketpair (AF_UNIX, SOCK_SEQPACKET, 0, fds) < 0)
+    {
+      g_warning ("%s: socketpair: %s", __FUNCTION__, g_strerror (errno));
+      return FALSE;
+    }
+
+  /* Fork twice so that init reaps the helper and we don't need to. */
+  if ((pid = fork ()) < 0)
+    {
+      g_warning ("%s: fork: %s", __FUNCTION__, g_strerror (errno));
+      close (fds[0]);
+      close (fds[1]);
+      return FALSE;
+    }
+  else if (!pid)
+    {
+      close (fds[0]);
+      if (fork ())
+        _exit (0);
+      helper_main (fds[1]);
+    }
+
+  close (fds[1]);
+  while (waitpid (pid, &status, 0) < 0 && errno == EINTR)
+    ;
+
+  helper_fd = fds[0];
+  fcntl (helper_fd, F_SETFD, FD_CLOEXEC);
+
+  helper_children = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                           NULL, g_free);
+  helper_exits = g_array_new (FALSE, FALSE, sizeof (HelperReply));
+
+  channel = g_io_channel_unix_new (helper_fd);
+  helper_watch_id = g_io_add_watch (channel, G_IO_IN | G_IO_HUP | G_IO_ERR,
+                                    helper_readable_cb, NULL);
+  g_io_channel_unref (channel);
+
+  return TRUE;
+}
+
+gboolean
+hd_launch_helper_is_running (void)
+{
+  return helper_fd >= 0;
+}
+
+/*
+ * Turns a desktop file's Exec line into an argument vector with the
+ * program's absolute path in front, or returns %NULL if the program
+ * is not in $PATH.
+ */
+gchar **
+hd_launch_helper_parse_exec (const gchar *exec)
+{
+  const gchar *space = strchr (exec, ' ');
+  gchar *exec_cmd;
+  gchar **argv = NULL;
+  gint argc;
+
+  if (space)
+  {
+    gchar *cmd = g_strndup (exec, space - exec);
+    gchar *exc = g_find_program_in_path (cmd);
+
+    exec_cmd = exc ? g_strconcat (exc, space, NULL) : NULL;
+
+    g_free (cmd);
+    g_free (exc);
+  }
+  else
+    exec_cmd = g_find_program_in_path (exec);
+
+  if (!exec_cmd || !g_shell_parse_argv (exec_cmd, &argc, &argv, NULL))
+    argv = NULL;
+  g_free (exec_cmd);
+
+  return argv;
+}
+
+/*
+ * Has the helper spawn @argv, whose first element must be an absolute
+ * path.  Returns %FALSE and leaves @error unset if the helper cannot
+ * do it for us, in which case the caller should spawn @argv itself.
+ */
+gboolean
+hd_launch_helper_spawn (gchar **argv, GPid *pid, GError **error)
+{
+  gchar request[HELPER_MAX_REQUEST];
+  HelperReply reply;
+  struct pollfd pfd;
+  gsize len, arglen;
+  ssize_t ret;
+  guint i;
+
+  if (helper_fd < 0 || !argv || !argv[0])
+    return FALSE;
+
+  len = 0;
+  for (i = 0; argv[i]; i++)
+    {
+      arglen = strlen (argv[i]) + 1;
+      if (i >= HELPER_MAX_ARGS || len + arglen > sizeof (request))
+        return FALSE;
+      memcpy (&request[len], argv[i], arglen);
+      len += arglen;
+    }
+
+  if (send (helper_fd, request, len, MSG_NOSIGNAL) != (ssize_t) len)
+    {
+      helper_lost ();
+      return FALSE;
+    }
+
+  /* It's only a posix_spawn() away, wait for the answer. */
+  pfd.fd = helper_fd;
+  pfd.events = POLLIN;
+  for (;;)
+    {
+      ret = poll (&pfd, 1, HELPER_TIMEOUT);
+      if (ret < 0 && errno == EINTR)
+        continue;
+      if (ret <= 0)
+        {
+          g_warning ("%s: no answer from the launch helper", __FUNCTION__);
+          g_set_error (error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED,
+                       "launch helper timed out");
+          helper_lost ();
+          return FALSE;
+        }
+
+      ret = recv (helper_fd, &reply, sizeof (reply), 0);
+      if (ret < 0 && errno == EINTR)
+        continue;
+      if (ret != sizeof (reply))
+        {
+          helper_lost ();
+          return FALSE;
+        }
+
+      if (reply.type == HELPER_SPAWNED)
+        break;
+
+      /* Don't call back from the middle of a launch. */
+      g_array_append_val (helper_exits, reply);
+      if (!helper_exits_idle)
+        helper_exits_idle = g_idle_add (helper_exits_idle_cb, NULL);
+    }
+
+  if (reply.pid < 0)
+    {
+      gint code;
+
+      switch (-reply.pid)
+        {
+        case ENOENT:
+        case ENOTDIR:
+          code = G_SPAWN_ERROR_NOENT;
+          break;
+        case EACCES:
+          code = G_SPAWN_ERROR_ACCES;
+          break;
+        case ENOMEM:
+          code = G_SPAWN_ERROR_NOMEM;
+          break;
+        default:
+          code = G_SPAWN_ERROR_FAILED;
+          break;
+        }
+      g_set_error (error, G_SPAWN_ERROR, code, "Failed to execute %s: %s",
+                   argv[0], g_strerror (-reply.pid));
+      return FALSE;
+    }
+
+  g_hash_table_insert (helper_children, GINT_TO_POINTER (reply.pid),
+                       g_new0 (HelperWatch, 1));
+  if (pid)
+    *pid = reply.pid;
+  return TRUE;
+}
+
+/*
+ * Like g_child_watch_add() but for the processes spawned either by the
+ * helper or by ourselves.
+ */
+void
+hd_launch_helper_child_watch_add (GPid pid, GChildWatchFunc func,
+                                  gpointer data)
+{
+  HelperWatch *watch;
+
+  if (helper_children
+      && (watch = g_hash_table_lookup (helper_children,
+                                       GINT_TO_POINTER (pid))))
+    {
+      watch->func = func;
+      watch->data = data;
+    }
+  else
+    g_child_watch_add (pid, func, data);
+}
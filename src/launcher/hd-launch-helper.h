@@ -0,0 +1,53 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * The launch helper is a small process forked off at startup, before
+ * we map any graphics, which starts the applications for us.  Forking
+ * the compositor itself would copy the page tables of all of Clutter,
+ * GL and our textures every time the user launches something.
+ *
+ * The applications are children of the helper, so their exit is
+ * reported through the helper too; use hd_launch_helper_child_watch_add()
+ * instead of g_child_watch_add() for the pids it gives you.
+ */
+
+#ifndef __HD_LAUNCH_HELPER_H__
+#define __HD_LAUNCH_HELPER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+gboolean   hd_launch_helper_start           (void);
+gboolean   hd_launch_helper_is_running      (void);
+
+gchar    **hd_launch_helper_parse_exec      (const gchar *exec);
+gboolean   hd_launch_helper_spawn           (gchar **argv,
+                                             GPid *pid,
+                                             GError **error);
+void       hd_launch_helper_child_watch_add (GPid pid,
+                                             GChildWatchFunc func,
+                                             gpointer data);
+
+G_END_DECLS
+
+#endif /* __HD_LAUNCH_HELPER_H__ */
@@ -29,6 +29,7 @@
 
 #include "hildon-desktop.h"
 #include "hd-launcher-app.h"
+#include "hd-launch-helper.h"
 
 #include <string.h>
 
@@ -52,6 +53,8 @@
 struct _HdLauncherAppPrivate
 {
   gchar *exec;
+  /* @exec resolved and parsed, see hd_launcher_app_get_argv() */
+  gchar **argv;
   gchar *service;
   gchar *loading_image;
   gchar *switcher_icon;
@@ -76,6 +79,7 @@ hd_launcher_app_finalize (GObject *gobject)
   HdLauncherAppPrivate *priv = HD_LAUNCHER_APP (gobject)->priv;
 
   g_free (priv->exec);
+  g_strfreev (priv->argv);
   g_free (priv->service);
   g_free (priv->loading_image);
   g_free (priv->switcher_icon);
@@ -213,6 +217,34 @@ hd_launcher_app_get_exec (HdLauncherApp *item)
   return item->priv->exec;
 }
 
+/*
+ * Returns the command line of the application with the absolute path of
+ * the program, or %NULL if it can't be found.  It's looked up in $PATH
+ * only once; call hd_launcher_app_forget_argv() if it has moved since.
+ */
+gchar **
+hd_launcher_app_get_argv (HdLauncherApp *item)
+{
+  HdLauncherAppPrivate *priv;
+
+  g_return_val_if_fail (HD_IS_LAUNCHER_APP (item), NULL);
+
+  priv = item->priv;
+  if (!priv->argv && priv->exec)
+    priv->argv = hd_launch_helper_parse_exec (priv->exec);
+
+  return priv->argv;
+}
+
+void
+hd_launcher_app_forget_argv (HdLauncherApp *item)
+{
+  g_return_if_fail (HD_IS_LAUNCHER_APP (item));
+
+  g_strfreev (item->priv->argv);
+  item->priv->argv = NULL;
+}
+
 G_CONST_RETURN gchar *
 hd_launcher_app_get_service (HdLauncherApp *item)
 {
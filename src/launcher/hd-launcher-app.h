@@ -65,6 +65,9 @@ G_CONST_RETURN gchar *hd_launcher_app_get_loading_image (HdLauncherApp *item);
 G_CONST_RETURN gchar *hd_launcher_app_get_switcher_icon (HdLauncherApp *item);
 G_CONST_RETURN gchar *hd_launcher_app_get_wm_class (HdLauncherApp *item);
 
+gchar **hd_launcher_app_get_argv    (HdLauncherApp *item);
+void    hd_launcher_app_forget_argv (HdLauncherApp *item);
+
 #define HD_APP_PRESTART_NONE_STRING     "none"
 #define HD_APP_PRESTART_USAGE_STRING    "usage"
 #define HD_APP_PRESTART_ALWAYS_STRING   "always"
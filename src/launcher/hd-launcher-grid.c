@@ -65,11 +65,21 @@
 
 struct _HdLauncherGridPrivate
 {
-  /* list of actors */
+  /* HdLauncherItems of the grid, in display order.  Only the rows
+   * around the visible area have tiles bound to them. */
+  GPtrArray *items;
+  /* the HdLauncherTile showing each of @items or %NULL */
+  GPtrArray *slots;
+  /* list of bound tile actors */
   GList *tiles;
-  /* list of 'blocker' actors that block presses
+  /* unbound tiles kept for recycling */
+  GList *spare_tiles;
+  /* The range of rows we have tiles for, or -1 if none. */
+  gint first_row, last_row;
+
+  /* 'blocker' actor that blocks presses
    * on the empty rows of pixels between the icons */
-  GList *blockers;
+  ClutterActor *blocker;
 
   guint h_spacing;
   guint v_spacing;
@@ -99,14 +109,15 @@ enum
   PROP_V_ADJUSTMENT
 };
 
-/* FIXME: Do we need signals here?
 enum
 {
+  TILE_CLICKED,
+  TILE_LONG_CLICKED,
+
   LAST_SIGNAL
 };
 
-static guint task_signals[LAST_SIGNAL] = {};
-*/
+static guint launcher_grid_signals[LAST_SIGNAL] = { 0, };
 
 static void tidy_scrollable_iface_init   (TidyScrollableInterface *iface);
 
@@ -115,6 +126,9 @@ static gboolean _hd_launcher_grid_blocker_release_cb (ClutterActor *actor,
                                         gpointer *data);
 
 static gboolean      hd_launcher_grid_is_portrait (HdLauncherGrid *self);
+static void hd_launcher_grid_update_tiles (HdLauncherGrid *grid,
+                                           gboolean force);
+
 #define HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE 5
 #define HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT 3
 
@@ -123,6 +137,11 @@ static gboolean      hd_launcher_grid_is_portrait (HdLauncherGrid *self);
 #define HD_LAUNCHER_GRID_LEFT_DISMISSAL_AREA_PORTRAIT (64)
 #define HD_LAUNCHER_GRID_RIGHT_DISMISSAL_AREA_PORTRAIT (64)
 
+/* How many rows of tiles to keep above and below the visible area. */
+#define HD_LAUNCHER_GRID_ROW_MARGIN (1)
+/* How many unbound tiles to keep around for recycling. */
+#define HD_LAUNCHER_GRID_MAX_SPARE_TILES (HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE*2)
+
 
 G_DEFINE_TYPE_WITH_CODE (HdLauncherGrid,
                          hd_launcher_grid,
@@ -239,6 +258,7 @@ adjustment_value_notify (GObject    *gobject,
   clutter_actor_set_anchor_point(grid,
                              0,
                              tidy_adjustment_get_value(priv->v_adjustment));
+  hd_launcher_grid_update_tiles (HD_LAUNCHER_GRID (grid), FALSE);
 }
 
 static void
@@ -342,131 +362,221 @@ tidy_scrollable_iface_init (TidyScrollableInterface *iface)
   iface->get_adjustments = hd_launcher_grid_get_adjustments;
 }
 
-static void
-hd_launcher_grid_actor_added (ClutterContainer *container,
-                              ClutterActor     *actor)
+static guint
+hd_launcher_grid_get_columns (HdLauncherGrid *grid)
 {
-  HdLauncherGridPrivate *priv = HD_LAUNCHER_GRID (container)->priv;
-
-  g_object_ref (actor);
+  return hd_launcher_grid_is_portrait (grid)
+    ? HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT
+    : HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE;
+}
 
-  if (HD_IS_LAUNCHER_TILE(actor))
-    {
-      priv->tiles = g_list_append (priv->tiles, g_object_ref(actor));
+static guint
+hd_launcher_grid_get_top_margin (HdLauncherGrid *grid)
+{
+  return hd_launcher_grid_is_portrait (grid)
+    ? HD_LAUNCHER_PAGE_XMARGIN
+    : HD_LAUNCHER_PAGE_YMARGIN;
+}
 
-      /* relayout moved to the traversal code */
-    }
+static guint
+hd_launcher_grid_count_rows (HdLauncherGrid *grid)
+{
+  HdLauncherGridPrivate *priv = grid->priv;
+  guint columns = hd_launcher_grid_get_columns (grid);
 
-  g_object_unref (actor);
+  return (priv->items->len + columns - 1) / columns;
 }
 
+/* Returns where the tile of the @i-th item goes in the grid. */
 static void
-hd_launcher_grid_actor_removed (ClutterContainer *container,
-                                ClutterActor     *actor)
+hd_launcher_grid_get_cell_position (HdLauncherGrid *grid, guint i,
+                                    guint *x, guint *y)
 {
-  HdLauncherGridPrivate *priv = HD_LAUNCHER_GRID (container)->priv;
-
-  g_object_ref (actor);
-
-  if (HD_IS_LAUNCHER_TILE(actor))
-    {
-      priv->tiles = g_list_remove (priv->tiles, actor);
-      g_object_unref(actor);
+  HdLauncherGridPrivate *priv = grid->priv;
+  guint columns, page_width, icons_width;
 
-      /* relayout moved to the traversal code */
-    }
+  /* Figure out the starting X position needed to centre the icons */
+  columns = hd_launcher_grid_get_columns (grid);
+  page_width = hd_launcher_grid_is_portrait (grid)
+    ? HD_LAUNCHER_PAGE_HEIGHT : HD_LAUNCHER_PAGE_WIDTH;
+  icons_width = HD_LAUNCHER_TILE_WIDTH * columns
+    + priv->h_spacing * (columns-1);
+
+  *x = (page_width - icons_width) / 2
+    + (i % columns) * (HD_LAUNCHER_TILE_WIDTH + priv->h_spacing);
+  *y = hd_launcher_grid_get_top_margin (grid)
+    + (i / columns) * (HD_LAUNCHER_TILE_HEIGHT + priv->v_spacing);
+}
 
-  g_object_unref (actor);
+static void
+hd_launcher_grid_tile_clicked (HdLauncherTile *tile, HdLauncherGrid *grid)
+{
+  g_signal_emit (grid, launcher_grid_signals[TILE_CLICKED], 0, tile);
 }
 
 static void
-_hd_launcher_grid_count_children_and_rows (HdLauncherGrid *grid,
-                                           guint *children,
-                                           guint *rows)
+hd_launcher_grid_tile_long_clicked (HdLauncherTile *tile,
+                                    HdLauncherGrid *grid)
 {
-  HdLauncherGridPrivate *priv = HD_LAUNCHER_GRID_GET_PRIVATE (grid);
-  GList *l;
+  g_signal_emit (grid, launcher_grid_signals[TILE_LONG_CLICKED], 0, tile);
+}
 
-  *children = 0;
-  for (l = priv->tiles; l != NULL; l = l->next)
-    {
-      ClutterActor *child = l->data;
+/* Makes sure the @i-th item has a tile, recycling a spare one if we have
+ * any, and returns it. */
+static HdLauncherTile *
+hd_launcher_grid_bind_tile (HdLauncherGrid *grid, guint i)
+{
+  HdLauncherGridPrivate *priv = grid->priv;
+  HdLauncherTile *tile;
+  guint x, y;
 
-      if (CLUTTER_ACTOR_IS_VISIBLE (child))
-        {
-          ++(*children);
-        }
-    }
+  if ((tile = g_ptr_array_index (priv->slots, i)) != NULL)
+    return tile;
 
-  if (*children > 0)
+  if (priv->spare_tiles)
     {
-      if (hd_launcher_grid_is_portrait (grid))
-        *rows = (*children / HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT) +
-          (*children % HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT ? 1 : 0);
-      else
-        *rows = (*children / HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE) +
-          (*children % HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE ? 1 : 0);
+      tile = priv->spare_tiles->data;
+      priv->spare_tiles = g_list_delete_link (priv->spare_tiles,
+                                              priv->spare_tiles);
     }
   else
     {
-      *rows = 0;
+      tile = hd_launcher_tile_new (NULL, NULL);
+      g_signal_connect (tile, "clicked",
+                        G_CALLBACK (hd_launcher_grid_tile_clicked), grid);
+      g_signal_connect (tile, "long-clicked",
+                        G_CALLBACK (hd_launcher_grid_tile_long_clicked), grid);
+      clutter_container_add_actor (CLUTTER_CONTAINER (grid),
+                                   CLUTTER_ACTOR (tile));
     }
-}
 
+  hd_launcher_tile_set_item (tile, g_ptr_array_index (priv->items, i));
+  g_object_set_data (G_OBJECT (tile), "HdLauncherGrid::index",
+                     GUINT_TO_POINTER (i));
+  hd_launcher_grid_get_cell_position (grid, i, &x, &y);
+  clutter_actor_set_position (CLUTTER_ACTOR (tile), x, y);
+  clutter_actor_set_depthu (CLUTTER_ACTOR (tile), 0);
+  clutter_actor_set_opacity (CLUTTER_ACTOR (tile), 255);
+  clutter_actor_show (CLUTTER_ACTOR (tile));
 
-/**
- * Allocates a number of tiles in a row, starting at cur_y.
- * Returns the remaining children list (ie still to allocate).
- *
- * @grid: the HdLauncherGrid instance
- * @l: list of tiles still to be inserted in the layout
- * @remaining is a memory address containing a pointer to the number of
- * children still to insert into the grid.
- * @cur_y: the current y position of the grid, from where to begin placing
- * tiles
- * @h_spacing is the icon horizonal spacing.
- */
-static GList *
-_hd_launcher_grid_layout_row   (HdLauncherGrid *grid,
-                                GList *l,
-                                guint *remaining,
-                                guint cur_y,
-                                guint h_spacing)
+  g_ptr_array_index (priv->slots, i) = tile;
+  priv->tiles = g_list_prepend (priv->tiles, tile);
+
+  return tile;
+}
+
+/* Takes the tile from the @i-th item and keeps it for recycling. */
+static void
+hd_launcher_grid_unbind_tile (HdLauncherGrid *grid, guint i)
 {
-  ClutterActor *child;
-  guint allocated;
-  guint cur_x;
+  HdLauncherGridPrivate *priv = grid->priv;
+  HdLauncherTile *tile;
 
-  /* Figure out the starting X position needed to centre the icons */
-  if (hd_launcher_grid_is_portrait (grid))
-    {
-      guint icons_width = HD_LAUNCHER_TILE_WIDTH * HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT +
-                            h_spacing * (HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT-1);
+  if (!(tile = g_ptr_array_index (priv->slots, i)))
+    return;
+
+  g_ptr_array_index (priv->slots, i) = NULL;
+  priv->tiles = g_list_remove (priv->tiles, tile);
+  hd_launcher_tile_set_item (tile, NULL);
 
-      cur_x = (HD_LAUNCHER_PAGE_HEIGHT - icons_width) / 2;
-      allocated = MIN (HD_LAUNCHER_GRID_MAX_COLUMNS_PORTRAIT, *remaining);
+  if (g_list_length (priv->spare_tiles) < HD_LAUNCHER_GRID_MAX_SPARE_TILES)
+    {
+      clutter_actor_hide (CLUTTER_ACTOR (tile));
+      priv->spare_tiles = g_list_prepend (priv->spare_tiles, tile);
     }
   else
+    clutter_actor_destroy (CLUTTER_ACTOR (tile));
+}
+
+/* Binds tiles to the rows in and around the visible area and releases
+ * the ones which scrolled out of it.  Unless @force, it does nothing
+ * if the range of rows hasn't changed. */
+static void
+hd_launcher_grid_update_tiles (HdLauncherGrid *grid, gboolean force)
+{
+  HdLauncherGridPrivate *priv = grid->priv;
+  gdouble value, page_size;
+  gint row_height, top, first_row, last_row, n_rows;
+  guint columns, i;
+  GList *l;
+
+  n_rows = hd_launcher_grid_count_rows (grid);
+  columns = hd_launcher_grid_get_columns (grid);
+  row_height = HD_LAUNCHER_TILE_HEIGHT + priv->v_spacing;
+  top = hd_launcher_grid_get_top_margin (grid);
+
+  value = 0;
+  page_size = 0;
+  if (priv->v_adjustment)
+    tidy_adjustment_get_values (priv->v_adjustment, &value,
+                                NULL, NULL, NULL, NULL, &page_size);
+  if (page_size <= 0)
+    page_size = hd_launcher_grid_is_portrait (grid)
+      ? HD_COMP_MGR_PORTRAIT_HEIGHT : HD_COMP_MGR_LANDSCAPE_HEIGHT;
+
+  first_row = floor ((value - top) / row_height) - HD_LAUNCHER_GRID_ROW_MARGIN;
+  last_row  = floor ((value + page_size - top) / row_height)
+    + HD_LAUNCHER_GRID_ROW_MARGIN;
+  first_row = MAX (first_row, 0);
+  last_row  = MIN (last_row, n_rows - 1);
+  if (last_row < first_row)
+    first_row = last_row = -1;
+
+  if (!force && first_row == priv->first_row && last_row == priv->last_row)
+    return;
+  priv->first_row = first_row;
+  priv->last_row  = last_row;
+
+  /* Release the tiles out of the range first so they can be reused. */
+  for (l = priv->tiles; l; )
     {
-      guint icons_width = HD_LAUNCHER_TILE_WIDTH * HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE +
-                            h_spacing * (HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE-1);
+      guint idx = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (l->data),
+                                                "HdLauncherGrid::index"));
+      gint row = idx / columns;
 
-      cur_x = (HD_LAUNCHER_PAGE_WIDTH - icons_width) / 2;
-      allocated = MIN (HD_LAUNCHER_GRID_MAX_COLUMNS_LANDSCAPE, *remaining);
+      l = l->next;
+      if (row < first_row || row > last_row)
+        hd_launcher_grid_unbind_tile (grid, idx);
     }
 
-  /* for each icon in the row... */
-  for (int i = 0; i < allocated; i++)
+  if (first_row < 0)
+    return;
+
+  for (i = first_row * columns;
+       i < priv->items->len && i < (last_row+1) * columns; i++)
     {
-      child = l->data;
+      HdLauncherTile *tile = g_ptr_array_index (priv->slots, i);
 
-      clutter_actor_set_position(child, cur_x, cur_y);
-      cur_x += HD_LAUNCHER_TILE_WIDTH + h_spacing;
+      if (!tile)
+        hd_launcher_grid_bind_tile (grid, i);
+      else if (force)
+        { /* The layout may have changed. */
+          guint x, y;
 
-      l = l->next;
+          hd_launcher_grid_get_cell_position (grid, i, &x, &y);
+          clutter_actor_set_position (CLUTTER_ACTOR (tile), x, y);
+        }
     }
-  *remaining -= allocated;
-  return l;
+}
+
+/* hd_launcher_grid_add_item:
+ * @grid: launcher's grid
+ * @item: the #HdLauncherItem to append
+ *
+ * Appends @item to @grid.  No actor is created for it until it
+ * is scrolled into view.  Call %hd_launcher_grid_layout() when
+ * you've finished adding items.
+ */
+void
+hd_launcher_grid_add_item (HdLauncherGrid *grid, HdLauncherItem *item)
+{
+  HdLauncherGridPrivate *priv;
+
+  g_return_if_fail (HD_IS_LAUNCHER_GRID (grid));
+
+  priv = grid->priv;
+  g_ptr_array_add (priv->items, g_object_ref (item));
+  g_ptr_array_add (priv->slots, NULL);
 }
 
 /* hd_launcher_grid_layout:
@@ -486,71 +596,56 @@ _hd_launcher_grid_layout_row   (HdLauncherGrid *grid,
 void hd_launcher_grid_layout (HdLauncherGrid *grid)
 {
   HdLauncherGridPrivate *priv = grid->priv;
-  GList *l;
-  guint cur_height, n_visible_launchers, n_rows;
-
-  /* Free our list of 'blocker' actors that we use to block mouse clicks.
-   * TODO: just check we have 'nrows' worth */
-  g_list_foreach(priv->blockers,
-                 (GFunc)clutter_actor_destroy,
-                 NULL);
-  g_list_free(priv->blockers);
-  priv->blockers = NULL;
+  guint cur_height, n_rows, row_height;
 
-  _hd_launcher_grid_count_children_and_rows (grid,
-      &n_visible_launchers, &n_rows);
+  n_rows = hd_launcher_grid_count_rows (grid);
+  row_height = HD_LAUNCHER_TILE_HEIGHT + priv->v_spacing;
+  cur_height = hd_launcher_grid_get_top_margin (grid) + n_rows * row_height;
 
-  if (hd_launcher_grid_is_portrait (grid))
-    cur_height = HD_LAUNCHER_PAGE_XMARGIN;
-  else
-    cur_height = HD_LAUNCHER_PAGE_YMARGIN;
-
-  l = priv->tiles;
-  while (l) {
-    /* Allocate all icons on this row */
-    l = _hd_launcher_grid_layout_row(grid, l, &n_visible_launchers,
-                                       cur_height, priv->h_spacing);
-    if (l)
-      {
-        /* If there is another row, we must create an actor that
-         * goes between the two rows that will grab the clicks that
-         * would have gone between them and dismissed the launcher  */
-        ClutterActor *blocker = clutter_group_new();
-        clutter_actor_set_name(blocker, "HdLauncherGrid::blocker");
-        clutter_actor_show(blocker);
-        clutter_container_add_actor(CLUTTER_CONTAINER(grid), blocker);
-        clutter_actor_set_reactive(blocker, TRUE);
-        g_signal_connect (blocker, "button-release-event",
-                          G_CALLBACK (_hd_launcher_grid_blocker_release_cb),
-                          NULL);
-
-        if (hd_launcher_grid_is_portrait (grid))
-          {
-            clutter_actor_set_position(blocker,
-                HD_LAUNCHER_BOTTOM_MARGIN,
-                cur_height + HD_LAUNCHER_TILE_HEIGHT);
-            clutter_actor_set_size(blocker,
-                HD_LAUNCHER_GRID_WIDTH_PORTRAIT -
-                (HD_LAUNCHER_GRID_LEFT_DISMISSAL_AREA_PORTRAIT +
-                 HD_LAUNCHER_GRID_RIGHT_DISMISSAL_AREA_PORTRAIT),
-                priv->v_spacing);
-          }
-        else
-          {
-            clutter_actor_set_position(blocker,
-                HD_LAUNCHER_LEFT_MARGIN,
-                cur_height + HD_LAUNCHER_TILE_HEIGHT);
-            clutter_actor_set_size(blocker,
-                HD_LAUNCHER_GRID_WIDTH_LANDSCAPE -
-                (HD_LAUNCHER_GRID_LEFT_DISMISSAL_AREA_LANDSCAPE +
-                 HD_LAUNCHER_GRID_RIGHT_DISMISSAL_AREA_LANDSCAPE),
-                priv->v_spacing);
-          }
-        priv->blockers = g_list_prepend(priv->blockers, blocker);
-      }
+  /* If there is more than one row, we must have an actor that goes
+   * between the rows that will grab the clicks that would have gone
+   * between them and dismissed the launcher.  It's beneath the tiles,
+   * so a single one covering all rows does the job. */
+  if (n_rows > 1)
+    {
+      if (!priv->blocker)
+        {
+          priv->blocker = clutter_group_new();
+          clutter_actor_set_name(priv->blocker, "HdLauncherGrid::blocker");
+          clutter_container_add_actor(CLUTTER_CONTAINER(grid), priv->blocker);
+          clutter_actor_lower_bottom(priv->blocker);
+          clutter_actor_set_reactive(priv->blocker, TRUE);
+          g_signal_connect (priv->blocker, "button-release-event",
+                            G_CALLBACK (_hd_launcher_grid_blocker_release_cb),
+                            NULL);
+        }
 
-    cur_height += HD_LAUNCHER_TILE_HEIGHT + priv->v_spacing;
-  }
+      if (hd_launcher_grid_is_portrait (grid))
+        {
+          clutter_actor_set_position(priv->blocker,
+              HD_LAUNCHER_BOTTOM_MARGIN,
+              HD_LAUNCHER_PAGE_XMARGIN + HD_LAUNCHER_TILE_HEIGHT);
+          clutter_actor_set_size(priv->blocker,
+              HD_LAUNCHER_GRID_WIDTH_PORTRAIT -
+              (HD_LAUNCHER_GRID_LEFT_DISMISSAL_AREA_PORTRAIT +
+               HD_LAUNCHER_GRID_RIGHT_DISMISSAL_AREA_PORTRAIT),
+              (n_rows-1) * row_height - HD_LAUNCHER_TILE_HEIGHT);
+        }
+      else
+        {
+          clutter_actor_set_position(priv->blocker,
+              HD_LAUNCHER_LEFT_MARGIN,
+              HD_LAUNCHER_PAGE_YMARGIN + HD_LAUNCHER_TILE_HEIGHT);
+          clutter_actor_set_size(priv->blocker,
+              HD_LAUNCHER_GRID_WIDTH_LANDSCAPE -
+              (HD_LAUNCHER_GRID_LEFT_DISMISSAL_AREA_LANDSCAPE +
+               HD_LAUNCHER_GRID_RIGHT_DISMISSAL_AREA_LANDSCAPE),
+              (n_rows-1) * row_height - HD_LAUNCHER_TILE_HEIGHT);
+        }
+      clutter_actor_show(priv->blocker);
+    }
+  else if (priv->blocker)
+    clutter_actor_hide(priv->blocker);
 
   if (hd_launcher_grid_is_portrait (grid))
     clutter_actor_set_size(CLUTTER_ACTOR(grid),
@@ -567,6 +662,8 @@ void hd_launcher_grid_layout (HdLauncherGrid *grid)
 
   if (priv->v_adjustment)
     hd_launcher_grid_refresh_v_adjustment (grid);
+
+  hd_launcher_grid_update_tiles (grid, TRUE);
 }
 
 static void
@@ -579,9 +676,22 @@ hd_launcher_grid_dispose (GObject *gobject)
                   NULL);
   g_list_free (priv->tiles);
   priv->tiles = NULL;
+  g_list_foreach (priv->spare_tiles,
+                  (GFunc) clutter_actor_destroy,
+                  NULL);
+  g_list_free (priv->spare_tiles);
+  priv->spare_tiles = NULL;
+
+  if (priv->items)
+    {
+      g_ptr_array_foreach (priv->items, (GFunc) g_object_unref, NULL);
+      g_ptr_array_free (priv->items, TRUE);
+      priv->items = NULL;
+      g_ptr_array_free (priv->slots, TRUE);
+      priv->slots = NULL;
+    }
 
-  g_list_free(priv->blockers);
-  priv->blockers = NULL;
+  priv->blocker = NULL;
 
   G_OBJECT_CLASS (hd_launcher_grid_parent_class)->dispose (gobject);
 }
@@ -668,6 +778,25 @@ hd_launcher_grid_class_init (HdLauncherGridClass *klass)
   g_object_class_override_property (gobject_class,
                                     PROP_V_ADJUSTMENT,
                                     "vadjustment");
+
+  launcher_grid_signals[TILE_CLICKED] =
+    g_signal_new (I_("tile-clicked"),
+                  G_TYPE_FROM_CLASS (gobject_class),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__OBJECT,
+                  G_TYPE_NONE, 1,
+                  HD_TYPE_LAUNCHER_TILE);
+  launcher_grid_signals[TILE_LONG_CLICKED] =
+    g_signal_new (I_("tile-long-clicked"),
+                  G_TYPE_FROM_CLASS (gobject_class),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__OBJECT,
+                  G_TYPE_NONE, 1,
+                  HD_TYPE_LAUNCHER_TILE);
 }
 
 static gboolean
@@ -726,15 +855,14 @@ hd_launcher_grid_init (HdLauncherGrid *launcher)
 
   launcher->priv = priv = HD_LAUNCHER_GRID_GET_PRIVATE (launcher);
 
+  priv->items = g_ptr_array_new ();
+  priv->slots = g_ptr_array_new ();
+  priv->first_row = priv->last_row = -1;
+
   /* set grid's orientation and h/v_spacing values to landscape by default */
   hd_launcher_grid_set_portrait (launcher, FALSE);
 
   clutter_actor_set_reactive (CLUTTER_ACTOR (launcher), FALSE);
-
-  g_signal_connect(
-      launcher, "actor-added", G_CALLBACK(hd_launcher_grid_actor_added), 0);
-  g_signal_connect(
-      launcher, "actor-removed", G_CALLBACK(hd_launcher_grid_actor_removed), 0);
 }
 
 ClutterActor *
@@ -747,21 +875,19 @@ void
 hd_launcher_grid_clear (HdLauncherGrid *grid)
 {
   HdLauncherGridPrivate *priv;
-  GList *l;
+  guint i;
 
   g_return_if_fail (HD_IS_LAUNCHER_GRID (grid));
 
   priv = grid->priv;
 
-  l = priv->tiles;
-  while (l)
-    {
-      ClutterActor *child = l->data;
-
-      l = l->next;
+  for (i = 0; i < priv->items->len; i++)
+    hd_launcher_grid_unbind_tile (grid, i);
+  priv->first_row = priv->last_row = -1;
 
-      clutter_container_remove_actor (CLUTTER_CONTAINER (grid), child);
-    }
+  g_ptr_array_foreach (priv->items, (GFunc) g_object_unref, NULL);
+  g_ptr_array_set_size (priv->items, 0);
+  g_ptr_array_set_size (priv->slots, 0);
 }
 
 /* Reset the grid before it is shown */
@@ -1002,14 +1128,11 @@ _hd_launcher_grid_blocker_release_cb (ClutterActor *actor,
 void hd_launcher_grid_activate(ClutterActor *actor, int p)
 {
   HdLauncherGridPrivate *priv = HD_LAUNCHER_GRID_GET_PRIVATE (actor);
-  GList *l = priv->tiles;
 
-  while ((p > 0) && l)
-    {
-      l=l->next;
-      p--;
-    }
+  if (p < 0 || p >= priv->items->len)
+    return;
 
-  if (l && !p)
-    hd_launcher_tile_activate (l->data);
+  /* The tile is bound on demand if it's out of view. */
+  hd_launcher_tile_activate (CLUTTER_ACTOR (
+                 hd_launcher_grid_bind_tile (HD_LAUNCHER_GRID (actor), p)));
 }
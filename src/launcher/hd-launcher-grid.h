@@ -27,6 +27,11 @@
  * HdLauncherItems. It implements the interfaces ClutterContainer and
  * TidyScrollable.
  *
+ * HdLauncherTiles are only created for the rows in and around the
+ * visible area and they are recycled as the grid is scrolled.
+ * Clicks on them are reported by the ::tile-clicked and
+ * ::tile-long-clicked signals.
+ *
  */
 
 #ifndef __HD_LAUNCHER_GRID_H__
@@ -65,6 +70,8 @@ GType         hd_launcher_grid_get_type (void) G_GNUC_CONST;
 ClutterActor *hd_launcher_grid_new      (void);
 
 void          hd_launcher_grid_clear    (HdLauncherGrid *grid);
+void          hd_launcher_grid_add_item (HdLauncherGrid *grid,
+                                         HdLauncherItem *item);
 void          hd_launcher_grid_reset_v_adjustment (HdLauncherGrid *grid);
 
 void          hd_launcher_grid_transition_begin(HdLauncherGrid *grid,
@@ -92,7 +92,8 @@ static void hd_launcher_page_constructed (GObject *object);
 static void hd_launcher_page_dispose (GObject *gobject);
 static void hd_launcher_page_show (ClutterActor *actor);
 
-static void hd_launcher_page_tile_clicked (HdLauncherTile *tile,
+static void hd_launcher_page_tile_clicked (HdLauncherGrid *grid,
+                                           HdLauncherTile *tile,
                                            gpointer data);
 static void hd_launcher_page_new_frame(ClutterTimeline *timeline,
                                        gint frame_num, gpointer data);
@@ -243,6 +244,9 @@ hd_launcher_page_constructed (GObject *object)
   priv->grid = hd_launcher_grid_new ();
   clutter_container_add_actor (CLUTTER_CONTAINER (priv->scroller),
                                priv->grid);
+  g_signal_connect (priv->grid, "tile-clicked",
+                    G_CALLBACK (hd_launcher_page_tile_clicked),
+                    page);
   priv->transition = 0;
 
   /* Add callbacks for de-selecting an icon after the user has moved
@@ -299,7 +303,7 @@ hd_launcher_page_get_grid (HdLauncherPage *page)
 }
 
 void
-hd_launcher_page_add_tile (HdLauncherPage *page, HdLauncherTile* tile)
+hd_launcher_page_add_item (HdLauncherPage *page, HdLauncherItem *item)
 {
   HdLauncherPagePrivate *priv = HD_LAUNCHER_PAGE_GET_PRIVATE (page);
   g_return_if_fail(HD_IS_LAUNCHER_PAGE(page));
@@ -310,16 +314,12 @@ hd_launcher_page_add_tile (HdLauncherPage *page, HdLauncherTile* tile)
       priv->empty_label = NULL;
     }
 
-  clutter_container_add_actor (CLUTTER_CONTAINER (priv->grid),
-                               CLUTTER_ACTOR (tile));
-
-  g_signal_connect (tile, "clicked",
-                    G_CALLBACK (hd_launcher_page_tile_clicked),
-                    page);
+  hd_launcher_grid_add_item (HD_LAUNCHER_GRID (priv->grid), item);
 }
 
 static void
-hd_launcher_page_tile_clicked (HdLauncherTile *tile, gpointer data)
+hd_launcher_page_tile_clicked (HdLauncherGrid *grid, HdLauncherTile *tile,
+                               gpointer data)
 {
   g_signal_emit (HD_LAUNCHER_PAGE(data),
                  launcher_page_signals[TILE_CLICKED],
@@ -72,7 +72,7 @@ GType            hd_launcher_page_get_type (void) G_GNUC_CONST;
 ClutterActor    *hd_launcher_page_new      (void);
 ClutterActor    *hd_launcher_page_get_grid      (HdLauncherPage *page);
 
-void hd_launcher_page_add_tile (HdLauncherPage *page, HdLauncherTile* tile);
+void hd_launcher_page_add_item (HdLauncherPage *page, HdLauncherItem *item);
 void hd_launcher_page_transition(HdLauncherPage *page,
                                  HdLauncherPageTransition trans_type);
 void hd_launcher_page_transition_stop(HdLauncherPage *page);
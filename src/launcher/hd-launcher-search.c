@@ -0,0 +1,584 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-launcher-search.h"
+#include "hd-launcher-app.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* Weights of the fields; a prefix match counts thrice, a match at the
+ * beginning of a word twice as much as a match anywhere else. */
+#define NAME_WEIGHT     10
+#define EXEC_WEIGHT      6
+#define COMMENT_WEIGHT   2
+/* Multiplied by log2(1 + number of launches). */
+#define LAUNCH_WEIGHT    4
+
+/* Where the number of launches is kept between restarts,
+ * in lines of "<launches> <item id>". */
+#define LAUNCHES_DIR     ".cache/hildon-desktop"
+#define LAUNCHES_FILE    "launches"
+
+typedef struct
+{
+  /* %NULL if the item has been removed from the index */
+  HdLauncherItem *item;
+
+  /* The searchable fields, normalised and case folded. */
+  gchar *name, *exec, *comment;
+
+  /* The last hd_launcher_search_update() which has seen @item. */
+  guint generation;
+} HdLauncherSearchEntry;
+
+typedef struct
+{
+  HdLauncherItem *item;
+  const gchar *name;
+  gint score;
+} HdLauncherSearchMatch;
+
+struct _HdLauncherSearch
+{
+  /* HdLauncherSearchEntries.  They are only appended and never moved
+   * until the index is compacted, so the posting lists stay sorted. */
+  GPtrArray *entries;
+  guint n_removed;
+
+  /* item id -> entry index + 1 */
+  GHashTable *ids;
+
+  /* Posting lists (GArrays of entry indices) keyed by gram_key().
+   * @trigrams has all trigrams of all fields, @prefixes has the
+   * one and two characters long prefixes of all words. */
+  GHashTable *trigrams;
+  GHashTable *prefixes;
+
+  /* item id -> number of launches; kept across reindexing and saved
+   * in LAUNCHES_FILE when it changes */
+  GHashTable *launches;
+  guint save_id;
+
+  guint generation;
+};
+
+/* Private functions */
+static gchar *
+normalize (const gchar *str)
+{
+  gchar *norm, *folded;
+
+  if (!str || !(norm = g_utf8_normalize (str, -1, G_NORMALIZE_ALL)))
+    return g_strdup ("");
+
+  folded = g_utf8_casefold (norm, -1);
+  g_free (norm);
+  return folded;
+}
+
+/* Returns the normalised name of the program @item executes. */
+static gchar *
+get_exec_name (HdLauncherItem *item)
+{
+  const gchar *exec;
+  gchar *program, *base, *ret;
+
+  if (!HD_IS_LAUNCHER_APP (item)
+      || !(exec = hd_launcher_app_get_exec (HD_LAUNCHER_APP (item))))
+    return g_strdup ("");
+
+  /* We're not interested in the arguments. */
+  program = g_strndup (exec, strcspn (exec, " \t"));
+  base = g_path_get_basename (program);
+  ret = normalize (base);
+  g_free (base);
+  g_free (program);
+
+  return ret;
+}
+
+/* Hashes @n characters.  Collisions are harmless because candidates
+ * are verified against the query. */
+static guint32
+gram_key (const gunichar *chars, guint n)
+{
+  guint32 key;
+  guint i;
+
+  key = 2166136261U ^ n;
+  for (i = 0; i < n; i++)
+    key = (key ^ chars[i]) * 16777619U;
+  return key;
+}
+
+static void
+posting_free (GArray *list)
+{
+  g_array_free (list, TRUE);
+}
+
+static void
+posting_add (GHashTable *table, guint32 key, guint idx)
+{
+  GArray *list;
+
+  list = g_hash_table_lookup (table, GUINT_TO_POINTER (key));
+  if (!list)
+    {
+      list = g_array_new (FALSE, FALSE, sizeof (guint));
+      g_hash_table_insert (table, GUINT_TO_POINTER (key), list);
+    }
+
+  /* Entries are indexed one by one, so a duplicate can only be last. */
+  if (list->len && g_array_index (list, guint, list->len-1) == idx)
+    return;
+  g_array_append_val (list, idx);
+}
+
+static void
+index_string (HdLauncherSearch *search, const gchar *str, guint idx)
+{
+  gunichar *chars;
+  glong i, n;
+
+  chars = g_utf8_to_ucs4_fast (str, -1, &n);
+
+  for (i = 0; i + 3 <= n; i++)
+    posting_add (search->trigrams, gram_key (&chars[i], 3), idx);
+
+  /* Queries too short for trigrams are matched against word prefixes. */
+  for (i = 0; i < n; i++)
+    {
+      if (!g_unichar_isalnum (chars[i])
+          || (i > 0 && g_unichar_isalnum (chars[i-1])))
+        continue;
+      posting_add (search->prefixes, gram_key (&chars[i], 1), idx);
+      if (i + 1 < n)
+        posting_add (search->prefixes, gram_key (&chars[i], 2), idx);
+    }
+
+  g_free (chars);
+}
+
+static void
+entry_free (HdLauncherSearchEntry *entry)
+{
+  if (entry->item)
+    g_object_unref (entry->item);
+  g_free (entry->name);
+  g_free (entry->exec);
+  g_free (entry->comment);
+  g_slice_free (HdLauncherSearchEntry, entry);
+}
+
+static void
+add_entry (HdLauncherSearch *search, HdLauncherItem *item)
+{
+  HdLauncherSearchEntry *entry;
+  guint idx;
+
+  idx = search->entries->len;
+  entry = g_slice_new0 (HdLauncherSearchEntry);
+  entry->item = g_object_ref (item);
+  entry->name = normalize (hd_launcher_item_get_local_name (item));
+  entry->exec = get_exec_name (item);
+  entry->comment = normalize (hd_launcher_item_get_comment (item));
+  entry->generation = search->generation;
+  g_ptr_array_add (search->entries, entry);
+
+  index_string (search, entry->name, idx);
+  index_string (search, entry->exec, idx);
+  index_string (search, entry->comment, idx);
+
+  g_hash_table_replace (search->ids,
+                        g_strdup (hd_launcher_item_get_id (item)),
+                        GUINT_TO_POINTER (idx + 1));
+}
+
+/* Removes the entry from the lookups, but leaves it in the posting lists
+ * until the index is compacted.  Queries skip removed entries. */
+static void
+remove_entry (HdLauncherSearch *search, guint idx)
+{
+  HdLauncherSearchEntry *entry = g_ptr_array_index (search->entries, idx);
+  const gchar *id = hd_launcher_item_get_id (entry->item);
+
+  if (GPOINTER_TO_UINT (g_hash_table_lookup (search->ids, id)) == idx + 1)
+    g_hash_table_remove (search->ids, id);
+
+  g_object_unref (entry->item);
+  entry->item = NULL;
+  search->n_removed++;
+}
+
+/* Reindexes the live entries to get rid of the removed ones. */
+static void
+compact (HdLauncherSearch *search)
+{
+  GPtrArray *old;
+  guint i;
+
+  old = search->entries;
+  search->entries = g_ptr_array_sized_new (old->len - search->n_removed);
+  search->n_removed = 0;
+  g_hash_table_remove_all (search->ids);
+  g_hash_table_remove_all (search->trigrams);
+  g_hash_table_remove_all (search->prefixes);
+
+  for (i = 0; i < old->len; i++)
+    {
+      HdLauncherSearchEntry *entry = g_ptr_array_index (old, i);
+
+      if (entry->item)
+        add_entry (search, entry->item);
+      entry_free (entry);
+    }
+  g_ptr_array_free (old, TRUE);
+}
+
+/* Does @entry still describe @item? */
+static gboolean
+entry_matches_item (HdLauncherSearchEntry *entry, HdLauncherItem *item)
+{
+  gchar *name, *exec, *comment;
+  gboolean same;
+
+  name = normalize (hd_launcher_item_get_local_name (item));
+  exec = get_exec_name (item);
+  comment = normalize (hd_launcher_item_get_comment (item));
+  same = !strcmp (name, entry->name) && !strcmp (exec, entry->exec)
+    && !strcmp (comment, entry->comment);
+  g_free (name);
+  g_free (exec);
+  g_free (comment);
+
+  return same;
+}
+
+static gint
+score_field (const gchar *field, const gchar *query,
+             gboolean prefix_only, gint weight)
+{
+  const gchar *p;
+
+  if (g_str_has_prefix (field, query))
+    return weight * 3;
+
+  /* A match at the beginning of a word? */
+  for (p = strstr (field, query); p; p = strstr (p + 1, query))
+    if (!g_unichar_isalnum (g_utf8_get_char (g_utf8_prev_char (p))))
+      return weight * 2;
+
+  if (!prefix_only && strstr (field, query))
+    return weight;
+  return 0;
+}
+
+static gint
+compare_matches (gconstpointer a, gconstpointer b)
+{
+  const HdLauncherSearchMatch *ma = a, *mb = b;
+
+  if (ma->score != mb->score)
+    return mb->score - ma->score;
+  return strcmp (ma->name, mb->name);
+}
+
+static gchar *
+launches_file_name (void)
+{
+  return g_build_filename (g_get_home_dir (), LAUNCHES_DIR, LAUNCHES_FILE,
+                           NULL);
+}
+
+static void
+load_launches (HdLauncherSearch *search)
+{
+  gchar *fname, *contents, **lines;
+  guint i;
+
+  fname = launches_file_name ();
+  if (!g_file_get_contents (fname, &contents, NULL, NULL))
+    {
+      g_free (fname);
+      return;
+    }
+  g_free (fname);
+
+  lines = g_strsplit (contents, "\n", -1);
+  g_free (contents);
+  for (i = 0; lines[i]; i++)
+    {
+      gchar *id;
+      gulong count;
+
+      count = strtoul (lines[i], &id, 10);
+      if (count && *id == ' ' && id[1])
+        g_hash_table_replace (search->launches, g_strdup (id+1),
+                              GUINT_TO_POINTER (count));
+    }
+  g_strfreev (lines);
+}
+
+static gboolean
+save_launches (HdLauncherSearch *search)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  GString *launches;
+  gchar *fname, *dname;
+
+  search->save_id = 0;
+
+  launches = g_string_new (NULL);
+  g_hash_table_iter_init (&iter, search->launches);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    g_string_append_printf (launches, "%u %s\n",
+                            GPOINTER_TO_UINT (value), (const gchar *)key);
+
+  dname = g_build_filename (g_get_home_dir (), LAUNCHES_DIR, NULL);
+  g_mkdir_with_parents (dname, 0770);
+  g_free (dname);
+
+  fname = launches_file_name ();
+  g_file_set_contents (fname, launches->str, launches->len, NULL);
+  g_free (fname);
+  g_string_free (launches, TRUE);
+
+  return FALSE;
+}
+
+/* Public functions */
+HdLauncherSearch *
+hd_launcher_search_new (void)
+{
+  HdLauncherSearch *search = g_new0 (HdLauncherSearch, 1);
+
+  search->entries = g_ptr_array_new ();
+  search->ids = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                       g_free, NULL);
+  search->trigrams = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                      NULL, (GDestroyNotify) posting_free);
+  search->prefixes = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                      NULL, (GDestroyNotify) posting_free);
+  search->launches = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                            g_free, NULL);
+  load_launches (search);
+
+  return search;
+}
+
+void
+hd_launcher_search_free (HdLauncherSearch *search)
+{
+  if (!search)
+    return;
+
+  if (search->save_id)
+    {
+      g_source_remove (search->save_id);
+      save_launches (search);
+    }
+
+  g_ptr_array_foreach (search->entries, (GFunc) entry_free, NULL);
+  g_ptr_array_free (search->entries, TRUE);
+  g_hash_table_destroy (search->ids);
+  g_hash_table_destroy (search->trigrams);
+  g_hash_table_destroy (search->prefixes);
+  g_hash_table_destroy (search->launches);
+  g_free (search);
+}
+
+/* hd_launcher_search_update:
+ * @search: the index
+ * @items: all the #HdLauncherItem<!-- -->s of the tree
+ *
+ * Brings @search in sync with @items.  Only the applications which
+ * are new or whose name, executable or comment changed are (re)indexed,
+ * the ones not in @items anymore are dropped.
+ */
+void
+hd_launcher_search_update (HdLauncherSearch *search, GList *items)
+{
+  GList *l;
+  guint i;
+
+  search->generation++;
+
+  for (l = items; l; l = l->next)
+    {
+      HdLauncherItem *item = l->data;
+      HdLauncherSearchEntry *entry;
+      guint idx;
+
+      if (hd_launcher_item_get_item_type (item) != HD_APPLICATION_LAUNCHER)
+        continue;
+
+      idx = GPOINTER_TO_UINT (g_hash_table_lookup (search->ids,
+                                        hd_launcher_item_get_id (item)));
+      if (!idx)
+        {
+          add_entry (search, item);
+          continue;
+        }
+
+      entry = g_ptr_array_index (search->entries, idx-1);
+      if (entry->item != item)
+        {
+          /* The tree was reloaded, the item may or may not have changed. */
+          if (!entry_matches_item (entry, item))
+            {
+              remove_entry (search, idx-1);
+              add_entry (search, item);
+              continue;
+            }
+          g_object_unref (entry->item);
+          entry->item = g_object_ref (item);
+        }
+      entry->generation = search->generation;
+    }
+
+  for (i = 0; i < search->entries->len; i++)
+    {
+      HdLauncherSearchEntry *entry = g_ptr_array_index (search->entries, i);
+
+      if (entry->item && entry->generation != search->generation)
+        remove_entry (search, i);
+    }
+
+  if (search->n_removed > search->entries->len / 2)
+    compact (search);
+}
+
+void
+hd_launcher_search_record_launch (HdLauncherSearch *search,
+                                  HdLauncherItem *item)
+{
+  const gchar *id = hd_launcher_item_get_id (item);
+  guint count;
+
+  count = GPOINTER_TO_UINT (g_hash_table_lookup (search->launches, id));
+  g_hash_table_replace (search->launches, g_strdup (id),
+                        GUINT_TO_POINTER (count + 1));
+
+  if (!search->save_id)
+    search->save_id = g_idle_add_full (G_PRIORITY_LOW,
+                                       (GSourceFunc) save_launches,
+                                       search, NULL);
+}
+
+/* hd_launcher_search_query:
+ * @search: the index
+ * @query: what the user has typed
+ * @max_results: how many items to return at most
+ *
+ * Returns a newly allocated #GPtrArray of the #HdLauncherItem<!-- -->s
+ * matching @query, best match first.  The items are not referenced,
+ * so the array should be used before the next hd_launcher_search_update().
+ * Queries shorter than three characters only match the beginning
+ * of words.
+ */
+GPtrArray *
+hd_launcher_search_query (HdLauncherSearch *search, const gchar *query,
+                          guint max_results)
+{
+  GPtrArray *results;
+  GArray *candidates, *matches;
+  gunichar *chars;
+  gchar *q;
+  glong i, n;
+
+  results = g_ptr_array_new ();
+  q = normalize (query);
+  chars = g_utf8_to_ucs4_fast (q, -1, &n);
+  candidates = NULL;
+
+  if (n == 0)
+    goto out;
+  else if (n < 3)
+    candidates = g_hash_table_lookup (search->prefixes,
+                                      GUINT_TO_POINTER (gram_key (chars, n)));
+  else
+    /* All trigrams of @q must be present; start from the rarest one. */
+    for (i = 0; i + 3 <= n; i++)
+      {
+        GArray *list;
+
+        list = g_hash_table_lookup (search->trigrams,
+                            GUINT_TO_POINTER (gram_key (&chars[i], 3)));
+        if (!list)
+          {
+            candidates = NULL;
+            break;
+          }
+        if (!candidates || list->len < candidates->len)
+          candidates = list;
+      }
+
+  if (!candidates)
+    goto out;
+
+  matches = g_array_new (FALSE, FALSE, sizeof (HdLauncherSearchMatch));
+  for (i = 0; i < candidates->len; i++)
+    {
+      HdLauncherSearchEntry *entry;
+      HdLauncherSearchMatch match;
+      guint launches;
+
+      entry = g_ptr_array_index (search->entries,
+                                 g_array_index (candidates, guint, i));
+      if (!entry->item)
+        continue;
+
+      match.score = MAX (MAX (
+            score_field (entry->name, q, n < 3, NAME_WEIGHT),
+            score_field (entry->exec, q, n < 3, EXEC_WEIGHT)),
+            score_field (entry->comment, q, n < 3, COMMENT_WEIGHT));
+      if (!match.score)
+        continue;
+
+      launches = GPOINTER_TO_UINT (g_hash_table_lookup (search->launches,
+                                      hd_launcher_item_get_id (entry->item)));
+      if (launches)
+        match.score += LAUNCH_WEIGHT * log2 (1 + launches);
+
+      match.item = entry->item;
+      match.name = entry->name;
+      g_array_append_val (matches, match);
+    }
+
+  g_array_sort (matches, compare_matches);
+  for (i = 0; i < matches->len && i < max_results; i++)
+    g_ptr_array_add (results,
+             g_array_index (matches, HdLauncherSearchMatch, i).item);
+  g_array_free (matches, TRUE);
+
+out:
+  g_free (chars);
+  g_free (q);
+  return results;
+}
@@ -0,0 +1,54 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * An HdLauncherSearch is an index over the applications of the
+ * HdLauncherTree for the launcher's type-to-search mode.  It matches
+ * the localised name, the executable and the comment of the items
+ * through trigrams and word prefixes, and ranks the matches by
+ * how well they match and by how often the application is launched.
+ * The number of launches is kept in ~/.cache/hildon-desktop/launches.
+ */
+
+#ifndef __HD_LAUNCHER_SEARCH_H__
+#define __HD_LAUNCHER_SEARCH_H__
+
+#include <glib.h>
+#include "hd-launcher-item.h"
+
+G_BEGIN_DECLS
+
+typedef struct _HdLauncherSearch HdLauncherSearch;
+
+HdLauncherSearch *hd_launcher_search_new          (void);
+void              hd_launcher_search_free         (HdLauncherSearch *search);
+
+void              hd_launcher_search_update       (HdLauncherSearch *search,
+                                                   GList *items);
+void              hd_launcher_search_record_launch (HdLauncherSearch *search,
+                                                    HdLauncherItem *item);
+GPtrArray        *hd_launcher_search_query        (HdLauncherSearch *search,
+                                                   const gchar *query,
+                                                   guint max_results);
+
+G_END_DECLS
+
+#endif /* __HD_LAUNCHER_SEARCH_H__ */
@@ -48,11 +48,20 @@
 
 #define HD_LAUNCHER_TILE_LONG_PRESS_DUR (1000)
 
+/* How many icons to load per idle iteration; see hd_launcher_tile_set_item(). */
+#define HD_LAUNCHER_TILE_ICONS_PER_IDLE (2)
+
+/* How many loaded icons to keep; see hd_launcher_tile_cached_icon(). */
+#define HD_LAUNCHER_TILE_ICON_CACHE_SIZE (64)
+
 struct _HdLauncherTilePrivate
 {
   gchar *icon_name;
   gchar *text;
 
+  /* The item this tile is showing if it is managed by a grid. */
+  HdLauncherItem *item;
+
   ClutterActor *icon;
   ClutterActor *label;
   TidyHighlight *icon_glow;
@@ -111,6 +120,28 @@ static void hd_launcher_tile_allocate (ClutterActor          *self,
 
 G_DEFINE_TYPE (HdLauncherTile, hd_launcher_tile, CLUTTER_TYPE_GROUP);
 
+/* Tiles whose real icon hasn't been loaded yet.  They're processed
+ * in an idle callback a few at a time, so scrolling a grid doesn't
+ * have to wait for the icons to be read from disk. */
+static GQueue hd_launcher_tile_icon_queue = G_QUEUE_INIT;
+static guint hd_launcher_tile_icon_idle;
+
+/* What we show until the real icon is loaded. */
+static GdkPixbuf *hd_launcher_tile_placeholder;
+
+/* The icons loaded most recently, so that tiles scrolled back into
+ * view needn't read them from disk again.  The cache maps "size:name"
+ * to HdLauncherTileIcon:s, which are in the LRU queue too, the least
+ * recently used first. */
+typedef struct
+{
+  gchar *key, *real_name;
+  GdkPixbuf *pixbuf;
+} HdLauncherTileIcon;
+
+static GHashTable *hd_launcher_tile_icon_cache;
+static GQueue hd_launcher_tile_icon_lru = G_QUEUE_INIT;
+
 static void
 hd_launcher_tile_class_init (HdLauncherTileClass *klass)
 {
@@ -274,46 +305,33 @@ hd_launcher_tile_get_label (HdLauncherTile *tile)
   return priv->label;
 }
 
-void
-hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
-                                const gchar *icon_name)
+/* Looks up @icon_name in the icon theme (or takes it as a file name)
+ * and returns a pixbuf of it with a 1 pixel transparent border.
+ * Falls back to the default icon if @icon_name is not found.
+ * Sets @real_name to the name of the icon actually loaded. */
+static GdkPixbuf *
+hd_launcher_tile_load_icon (const gchar *icon_name, gchar **real_name)
 {
-  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
   GtkIconTheme *icon_theme;
-  GdkPixbuf *pixbuf;
+  GdkPixbuf *pixbuf, *pixbufb;
   GtkIconInfo *info = NULL;
   const gchar *fname;
+  gchar *name;
 
-  if (priv->icon_name)
-    {
-      g_free (priv->icon_name);
-    }
-  if (icon_name)
-    priv->icon_name = g_strdup (icon_name);
-  else
-    /* Set the default if none was passed. */
-    priv->icon_name = g_strdup (HD_LAUNCHER_DEFAULT_ICON);
-
-  fname = priv->icon_name;
-
-  /* Recreate the icon actor */
-  if (priv->icon)
-    {
-      clutter_actor_destroy (priv->icon);
-      priv->icon = NULL;
-    }
+  name = g_strdup (icon_name ? icon_name : HD_LAUNCHER_DEFAULT_ICON);
+  *real_name = NULL;
 
   /* The desktop file contains path to the icon. */
-  if (g_file_test (fname, G_FILE_TEST_EXISTS)
-        && (g_strrstr (priv->icon_name, ".png") != NULL))
+  if (g_file_test (name, G_FILE_TEST_EXISTS)
+        && (g_strrstr (name, ".png") != NULL))
     {
-      fname = priv->icon_name;
+      fname = name;
     }
   else
     {
       /* Try to get the 64x64 icon. */
       icon_theme = gtk_icon_theme_get_default();
-      info = gtk_icon_theme_lookup_icon(icon_theme, priv->icon_name,
+      info = gtk_icon_theme_lookup_icon(icon_theme, name,
                                         HD_LAUNCHER_TILE_ICON_REAL_SIZE,
                                         GTK_ICON_LOOKUP_NO_SVG);
 
@@ -321,7 +339,7 @@ hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
         {
           /* Try to get the Harmattan (80x80) icon. The icon will be scaled 
            * down to 64x64. */
-          info = gtk_icon_theme_lookup_icon(icon_theme, priv->icon_name,
+          info = gtk_icon_theme_lookup_icon(icon_theme, name,
                                             HD_LAUNCHER_TILE_ICON_REAL_SIZE_HARMATTAN_COMP,
                                             GTK_ICON_LOOKUP_NO_SVG);
         }
@@ -329,28 +347,27 @@ hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
       if (info == NULL)
         {
           /* Try to get the default icon. */
-          g_free (priv->icon_name);
-          priv->icon_name = g_strdup (HD_LAUNCHER_DEFAULT_ICON);
-          info = gtk_icon_theme_lookup_icon(icon_theme, priv->icon_name,
+          g_free (name);
+          name = g_strdup (HD_LAUNCHER_DEFAULT_ICON);
+          info = gtk_icon_theme_lookup_icon(icon_theme, name,
                                             HD_LAUNCHER_TILE_ICON_REAL_SIZE,
                                             GTK_ICON_LOOKUP_NO_SVG);
         }
 
       if (info == NULL)
         {
-          g_warning ("%s: couldn't find icon %s\n", __FUNCTION__, priv->icon_name);
-          g_free (priv->icon_name); 
-          priv->icon_name = NULL;
-          return;
+          g_warning ("%s: couldn't find icon %s\n", __FUNCTION__, name);
+          g_free (name);
+          return NULL;
         }
 
       fname = gtk_icon_info_get_filename(info);
       if (fname == NULL)
         {
-          g_warning ("%s: couldn't get icon %s\n", __FUNCTION__, priv->icon_name);
-          g_free (priv->icon_name);
-          priv->icon_name = NULL;
-          return;
+          g_warning ("%s: couldn't get icon %s\n", __FUNCTION__, name);
+          gtk_icon_info_free(info);
+          g_free (name);
+          return NULL;
         }
     }
 
@@ -360,50 +377,139 @@ hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
    * isn't actually guaranteed to be the correct size.  */
   pixbuf = gdk_pixbuf_new_from_file_at_size(fname,
       HD_LAUNCHER_TILE_ICON_REAL_SIZE, HD_LAUNCHER_TILE_ICON_REAL_SIZE, 0);
+  pixbufb = NULL;
 
   if (pixbuf)
     {
       gint w = gdk_pixbuf_get_width(pixbuf);
       gint h = gdk_pixbuf_get_height(pixbuf);
-      GdkPixbuf *pixbufb = gdk_pixbuf_new(
-          GDK_COLORSPACE_RGB, TRUE, 8, w+2, h+2);
+      pixbufb = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, w+2, h+2);
 
       gdk_pixbuf_fill(pixbufb, 0);
       gdk_pixbuf_copy_area(pixbuf, 0, 0, w, h,
                            pixbufb, 1, 1);
+      g_object_unref(pixbuf);
+    }
+  else
+    g_warning ("%s: couldn't load %s\n", __FUNCTION__, fname);
 
-      priv->icon = clutter_texture_new();
-      clutter_texture_set_from_rgb_data(
-          CLUTTER_TEXTURE(priv->icon),
-          gdk_pixbuf_get_pixels(pixbufb),
-          gdk_pixbuf_get_has_alpha(pixbufb),
-          gdk_pixbuf_get_width(pixbufb),
-          gdk_pixbuf_get_height(pixbufb),
-          gdk_pixbuf_get_rowstride(pixbufb),
-          gdk_pixbuf_get_n_channels(pixbufb), 0, 0);
-      g_object_unref(pixbufb);
+  if (info)
+    gtk_icon_info_free(info);
+
+  if (pixbufb)
+    *real_name = name;
+  else
+    g_free (name);
+  return pixbufb;
+}
+
+static void
+hd_launcher_tile_icon_free (HdLauncherTileIcon *icon)
+{
+  g_free (icon->key);
+  g_free (icon->real_name);
+  g_object_unref (icon->pixbuf);
+  g_slice_free (HdLauncherTileIcon, icon);
+}
+
+static void
+hd_launcher_tile_icon_theme_changed (GtkIconTheme *theme, gpointer unused)
+{
+  g_queue_clear (&hd_launcher_tile_icon_lru);
+  g_hash_table_remove_all (hd_launcher_tile_icon_cache);
+}
+
+/* Returns a new reference to the pixbuf of @icon_name from the cache,
+ * or if it's not there and we may @load it, from the disk.  Sets
+ * @real_name like hd_launcher_tile_load_icon() does. */
+static GdkPixbuf *
+hd_launcher_tile_cached_icon (const gchar *icon_name, gboolean load,
+                              gchar **real_name)
+{
+  HdLauncherTileIcon *icon;
+  GdkPixbuf *pixbuf;
+  gchar *key;
+
+  if (!hd_launcher_tile_icon_cache)
+    {
+      hd_launcher_tile_icon_cache = g_hash_table_new_full (
+                          g_str_hash, g_str_equal, NULL,
+                          (GDestroyNotify)hd_launcher_tile_icon_free);
+      g_signal_connect (gtk_icon_theme_get_default (), "changed",
+                        G_CALLBACK (hd_launcher_tile_icon_theme_changed),
+                        NULL);
     }
-  if (pixbuf)
-    g_object_unref(pixbuf);
+
+  *real_name = NULL;
+  key = g_strdup_printf ("%d:%s", HD_LAUNCHER_TILE_ICON_REAL_SIZE,
+                         icon_name ? icon_name : HD_LAUNCHER_DEFAULT_ICON);
+  if ((icon = g_hash_table_lookup (hd_launcher_tile_icon_cache, key)))
+    {
+      g_free (key);
+      g_queue_remove (&hd_launcher_tile_icon_lru, icon);
+      g_queue_push_tail (&hd_launcher_tile_icon_lru, icon);
+      *real_name = g_strdup (icon->real_name);
+      return g_object_ref (icon->pixbuf);
+    }
+
+  if (!load || !(pixbuf = hd_launcher_tile_load_icon (icon_name, real_name)))
+    {
+      g_free (key);
+      return NULL;
+    }
+
+  if (g_queue_get_length (&hd_launcher_tile_icon_lru)
+      >= HD_LAUNCHER_TILE_ICON_CACHE_SIZE)
+    {
+      icon = g_queue_pop_head (&hd_launcher_tile_icon_lru);
+      g_hash_table_remove (hd_launcher_tile_icon_cache, icon->key);
+    }
+
+  icon = g_slice_new (HdLauncherTileIcon);
+  icon->key = key;
+  icon->real_name = g_strdup (*real_name);
+  icon->pixbuf = g_object_ref (pixbuf);
+  g_hash_table_insert (hd_launcher_tile_icon_cache, icon->key, icon);
+  g_queue_push_tail (&hd_launcher_tile_icon_lru, icon);
+
+  return pixbuf;
+}
+
+/* Uploads @pixbuf to the icon texture of @tile, creating the icon and
+ * its glow if they don't exist yet.  When a tile is recycled the same
+ * actors are reused, only their content changes. */
+static void
+hd_launcher_tile_set_icon_pixbuf (HdLauncherTile *tile, GdkPixbuf *pixbuf)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
 
   if (!priv->icon)
-  {
-    g_warning ("%s: couldn't create texture for %s\n", __FUNCTION__, fname);
-    g_free (priv->icon_name);
-    priv->icon_name = NULL;
-    return;
-  }
+    {
+      priv->icon = clutter_texture_new();
+      clutter_actor_set_size (priv->icon,
+          HD_LAUNCHER_TILE_ICON_SIZE,
+          HD_LAUNCHER_TILE_ICON_SIZE);
+      clutter_actor_set_position (priv->icon,
+          (HD_LAUNCHER_TILE_WIDTH - HD_LAUNCHER_TILE_ICON_SIZE) / 2, 0);
+      clutter_container_add_actor (CLUTTER_CONTAINER(tile), priv->icon);
+    }
 
+  clutter_texture_set_from_rgb_data(
+      CLUTTER_TEXTURE(priv->icon),
+      gdk_pixbuf_get_pixels(pixbuf),
+      gdk_pixbuf_get_has_alpha(pixbuf),
+      gdk_pixbuf_get_width(pixbuf),
+      gdk_pixbuf_get_height(pixbuf),
+      gdk_pixbuf_get_rowstride(pixbuf),
+      gdk_pixbuf_get_n_channels(pixbuf), 0, 0);
+  /* set_from_rgb_data() resets the size to the pixbuf's */
   clutter_actor_set_size (priv->icon,
       HD_LAUNCHER_TILE_ICON_SIZE,
       HD_LAUNCHER_TILE_ICON_SIZE);
-  clutter_actor_set_position (priv->icon,
-      (HD_LAUNCHER_TILE_WIDTH - HD_LAUNCHER_TILE_ICON_SIZE) / 2, 0);
-  clutter_container_add_actor (CLUTTER_CONTAINER(tile), priv->icon);
+  clutter_actor_show (priv->icon);
 
   if (priv->icon_glow)
-    /* free the old one */
-    clutter_actor_destroy (CLUTTER_ACTOR (priv->icon_glow));
+    return;
 
   priv->icon_glow = tidy_highlight_new(CLUTTER_TEXTURE(priv->icon));
   clutter_actor_set_size (CLUTTER_ACTOR(priv->icon_glow),
@@ -417,8 +523,150 @@ hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
   clutter_actor_lower_bottom(CLUTTER_ACTOR(priv->icon_glow));
 
   clutter_actor_hide(CLUTTER_ACTOR(priv->icon_glow));
+}
+
+void
+hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
+                                const gchar *icon_name)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+  GdkPixbuf *pixbuf;
 
-  gtk_icon_info_free(info);
+  /* Any pending asynchronous load is superseded. */
+  g_queue_remove (&hd_launcher_tile_icon_queue, tile);
+
+  g_free (priv->icon_name);
+  pixbuf = hd_launcher_tile_cached_icon (icon_name, TRUE, &priv->icon_name);
+
+  if (!pixbuf)
+    {
+      if (priv->icon)
+        clutter_actor_hide (priv->icon);
+      return;
+    }
+
+  hd_launcher_tile_set_icon_pixbuf (tile, pixbuf);
+  g_object_unref (pixbuf);
+}
+
+static gboolean
+hd_launcher_tile_load_icons_idle (gpointer unused)
+{
+  guint i;
+
+  for (i = 0; i < HD_LAUNCHER_TILE_ICONS_PER_IDLE; i++)
+    {
+      HdLauncherTile *tile;
+      HdLauncherTilePrivate *priv;
+
+      if (!(tile = g_queue_pop_head (&hd_launcher_tile_icon_queue)))
+        break;
+      priv = tile->priv;
+
+      /* The item may have been unbound meanwhile. */
+      if (priv->item)
+        hd_launcher_tile_set_icon_name (tile,
+                            hd_launcher_item_get_icon_name (priv->item));
+    }
+
+  if (g_queue_is_empty (&hd_launcher_tile_icon_queue))
+    {
+      hd_launcher_tile_icon_idle = 0;
+      return FALSE;
+    }
+  return TRUE;
+}
+
+/* hd_launcher_tile_set_item:
+ * @tile: a tile to (re)bind
+ * @item: the #HdLauncherItem to show or %NULL to unbind @tile
+ *
+ * Makes @tile show @item.  This is how #HdLauncherGrid recycles tiles
+ * which have been scrolled out of view.  The label is updated right
+ * away, and so is the icon if it's been loaded recently.  Otherwise
+ * it's replaced by a placeholder and loaded later in an idle callback.
+ * The glow and pressed state are reset.
+ */
+void
+hd_launcher_tile_set_item (HdLauncherTile *tile, HdLauncherItem *item)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+  GdkPixbuf *pixbuf;
+
+  hd_launcher_tile_reset (tile, TRUE);
+  g_queue_remove (&hd_launcher_tile_icon_queue, tile);
+
+  priv->item = item;
+  if (!item)
+    return;
+
+  hd_launcher_tile_set_text (tile, hd_launcher_item_get_local_name (item));
+
+  g_free (priv->icon_name);
+  pixbuf = hd_launcher_tile_cached_icon (hd_launcher_item_get_icon_name (item),
+                                         FALSE, &priv->icon_name);
+  if (pixbuf)
+    {
+      hd_launcher_tile_set_icon_pixbuf (tile, pixbuf);
+      g_object_unref (pixbuf);
+      return;
+    }
+
+  if (!hd_launcher_tile_placeholder)
+    {
+      gchar *name;
+
+      hd_launcher_tile_placeholder =
+        hd_launcher_tile_load_icon (HD_LAUNCHER_DEFAULT_ICON, &name);
+      g_free (name);
+    }
+  if (hd_launcher_tile_placeholder)
+    hd_launcher_tile_set_icon_pixbuf (tile, hd_launcher_tile_placeholder);
+  else if (priv->icon)
+    clutter_actor_hide (priv->icon);
+
+  priv->icon_name = g_strdup (hd_launcher_item_get_icon_name (item));
+
+  g_queue_push_tail (&hd_launcher_tile_icon_queue, tile);
+  if (!hd_launcher_tile_icon_idle)
+    hd_launcher_tile_icon_idle =
+      clutter_threads_add_idle_full (CLUTTER_PRIORITY_REDRAW + 10,
+                                     hd_launcher_tile_load_icons_idle,
+                                     NULL, NULL);
+}
+
+HdLauncherItem *
+hd_launcher_tile_get_item (HdLauncherTile *tile)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+
+  return priv->item;
+}
+
+/* Sizes and positions the label according to its current text. */
+static void
+hd_launcher_tile_size_label (HdLauncherTile *tile)
+{
+  HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
+  ClutterUnit label_width;
+  guint label_height, label_width_px;
+
+  label_height = HD_LAUNCHER_TILE_HEIGHT - (64 + HILDON_MARGIN_HALF);
+
+  clutter_actor_get_preferred_width (priv->label,
+    CLUTTER_UNITS_FROM_DEVICE(label_height),
+                              NULL, &label_width);
+  label_width_px = MIN (CLUTTER_UNITS_TO_DEVICE(label_width),
+                        HD_LAUNCHER_TILE_WIDTH);
+
+  clutter_actor_set_size(priv->label, label_width_px, label_height);
+  clutter_actor_set_position(priv->label,
+      (HD_LAUNCHER_TILE_WIDTH - label_width_px) / 2,
+      HD_LAUNCHER_TILE_HEIGHT - label_height);
+
+  if (CLUTTER_UNITS_TO_DEVICE(label_width) > HD_LAUNCHER_TILE_WIDTH)
+    clutter_actor_set_clip (priv->label, 0, 0,
+                  HD_LAUNCHER_TILE_WIDTH, label_height);
 }
 
 void
@@ -427,8 +675,6 @@ hd_launcher_tile_set_text (HdLauncherTile *tile,
 {
   ClutterColor text_color = {0xFF, 0xFF, 0xFF, 0xFF};
   HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (tile);
-  ClutterUnit label_width;
-  guint label_height, label_width_px;
   gchar *tile_font = NULL;
 
   if (!text)
@@ -440,10 +686,13 @@ hd_launcher_tile_set_text (HdLauncherTile *tile,
     }
   priv->text = g_strdup (text);
 
-  /* Recreate the label actor */
+  /* Reuse the label actor if the tile is being recycled. */
   if (priv->label)
     {
-      clutter_actor_destroy (priv->label);
+      clutter_label_set_text (CLUTTER_LABEL (priv->label), priv->text);
+      clutter_actor_remove_clip (priv->label);
+      hd_launcher_tile_size_label (tile);
+      return;
     }
 
   tile_font = hd_transition_get_string("task_nav", "tile_font", "Nokia Sans 15");
@@ -463,23 +712,8 @@ hd_launcher_tile_set_text (HdLauncherTile *tile,
   clutter_label_set_line_wrap_mode (CLUTTER_LABEL (priv->label),
                                     PANGO_WRAP_CHAR);
 
-  label_height = HD_LAUNCHER_TILE_HEIGHT - (64 + HILDON_MARGIN_HALF);
-
-  clutter_actor_get_preferred_width (priv->label,
-    CLUTTER_UNITS_FROM_DEVICE(label_height),
-                              NULL, &label_width);
-  label_width_px = MIN (CLUTTER_UNITS_TO_DEVICE(label_width),
-                        HD_LAUNCHER_TILE_WIDTH);
-
-  clutter_actor_set_size(priv->label, label_width_px, label_height);
-  clutter_actor_set_position(priv->label,
-      (HD_LAUNCHER_TILE_WIDTH - label_width_px) / 2,
-      HD_LAUNCHER_TILE_HEIGHT - label_height);
   clutter_container_add_actor (CLUTTER_CONTAINER(tile), priv->label);
-
-  if (CLUTTER_UNITS_TO_DEVICE(label_width) > HD_LAUNCHER_TILE_WIDTH)
-    clutter_actor_set_clip (priv->label, 0, 0,
-                  HD_LAUNCHER_TILE_WIDTH, label_height);
+  hd_launcher_tile_size_label (tile);
 }
 
 static void
@@ -649,6 +883,9 @@ hd_launcher_tile_dispose (GObject *gobject)
 {
   HdLauncherTilePrivate *priv = HD_LAUNCHER_TILE_GET_PRIVATE (gobject);
 
+  g_queue_remove (&hd_launcher_tile_icon_queue, gobject);
+  priv->item = NULL;
+
   if (priv->press_timeout)
     {
       g_source_remove (priv->press_timeout);
@@ -33,6 +33,7 @@
 #define __HD_LAUNCHER_TILE_H__
 
 #include <clutter/clutter.h>
+#include "hd-launcher-item.h"
 
 G_BEGIN_DECLS
 
@@ -71,6 +72,10 @@ void hd_launcher_tile_set_icon_name (HdLauncherTile *tile,
 void hd_launcher_tile_set_text      (HdLauncherTile *tile,
                                      const gchar *text);
 
+void            hd_launcher_tile_set_item (HdLauncherTile *tile,
+                                           HdLauncherItem *item);
+HdLauncherItem *hd_launcher_tile_get_item (HdLauncherTile *tile);
+
 ClutterActor *hd_launcher_tile_get_icon (HdLauncherTile *tile);
 ClutterActor *hd_launcher_tile_get_label (HdLauncherTile *tile);
 
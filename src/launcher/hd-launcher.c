@@ -43,6 +43,7 @@
 #include "hd-launcher-grid.h"
 #include "hd-launcher-page.h"
 #include "hd-launcher-editor.h"
+#include "hd-launcher-search.h"
 #include "hd-gtk-utils.h"
 #include "hd-render-manager.h"
 #include "hd-app-mgr.h"
@@ -51,6 +52,7 @@
 #include "hd-clutter-cache.h"
 #include "hd-title-bar.h"
 #include "hd-transition.h"
+#include "hd-texture-loader.h"
 #include "hd-util.h"
 #include "tidy/tidy-sub-texture.h"
 
@@ -69,6 +71,10 @@
 
 #define GCONF_KEY_DISABLE_MENU_EDIT "/apps/osso/hildon-desktop/menu_edit_disabled"
 
+/* The page showing the search results, in @pages. */
+#define HD_LAUNCHER_SEARCH_PAGE     "HdLauncher::search"
+#define HD_LAUNCHER_SEARCH_RESULTS  60
+
 typedef struct
 {
   GList *items;
@@ -98,6 +104,10 @@ struct _HdLauncherPrivate
 
   gboolean portraited;
   gboolean is_editor_in_landscape;
+
+  /* Type-to-search: the index and what has been typed so far. */
+  HdLauncherSearch *search;
+  GString *search_query;
 };
 
 #define HD_LAUNCHER_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
@@ -128,6 +138,12 @@ static void hd_launcher_application_tile_clicked (HdLauncherTile *tile,
                                                   gpointer data);
 static void hd_launcher_application_tile_long_clicked (HdLauncherTile *tile,
                                                        gpointer data);
+static void hd_launcher_grid_tile_clicked (HdLauncherGrid *grid,
+                                           HdLauncherTile *tile,
+                                           gpointer data);
+static void hd_launcher_grid_tile_long_clicked (HdLauncherGrid *grid,
+                                                HdLauncherTile *tile,
+                                                gpointer data);
 static gboolean hd_launcher_captured_event_cb (HdLauncher *launcher,
                                                ClutterEvent *event,
                                                gpointer data);
@@ -216,6 +232,8 @@ hd_launcher_init (HdLauncher *self)
   self->priv = priv = HD_LAUNCHER_GET_PRIVATE (self);
   priv->gconf_client = gconf_client_get_default ();
   g_datalist_init (&priv->pages);
+  priv->search = hd_launcher_search_new ();
+  priv->search_query = g_string_new (NULL);
 }
 
 static void hd_launcher_constructed (GObject *gobject)
@@ -277,6 +295,14 @@ hd_launcher_dispose (GObject *gobject)
 
   g_datalist_clear (&priv->pages);
 
+  if (priv->search)
+    {
+      hd_launcher_search_free (priv->search);
+      priv->search = NULL;
+      g_string_free (priv->search_query, TRUE);
+      priv->search_query = NULL;
+    }
+
   G_OBJECT_CLASS (hd_launcher_parent_class)->dispose (gobject);
 }
 
@@ -391,11 +417,30 @@ hd_launcher_show (gboolean is_top_page)
   clutter_actor_show (self);
 }
 
+/* Shows what has been typed in the title bar, so the user can see
+ * what's being searched for. */
+static void
+hd_launcher_show_search_query (HdLauncherPrivate *priv)
+{
+  hd_title_bar_set_launcher_title (
+                    HD_TITLE_BAR (hd_render_manager_get_title_bar ()),
+                    priv->search_query->len ? priv->search_query->str : NULL);
+}
+
+/* Forgets the query when leaving the search results. */
+static void
+hd_launcher_reset_search (HdLauncherPrivate *priv)
+{
+  g_string_truncate (priv->search_query, 0);
+  hd_launcher_show_search_query (priv);
+}
+
 void
 hd_launcher_hide (void)
 {
   HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
 
+  hd_launcher_reset_search (priv);
   if (priv->active_page)
     {
       ClutterActor *top_page = g_datalist_get_data (&priv->pages,
@@ -436,6 +481,7 @@ hd_launcher_back_button_clicked ()
   if (!STATE_IS_LAUNCHER (hd_render_manager_get_state()))
     return FALSE;
 
+  hd_launcher_reset_search (priv);
   if (priv->active_page == top_page)
     g_signal_emit (hd_launcher_get (), launcher_signals[HIDDEN], 0);
   else
@@ -490,6 +536,7 @@ hd_launcher_application_tile_clicked (HdLauncherTile *tile,
 
   if (!hd_app_mgr_launch (app))
     return;
+  hd_launcher_search_record_launch (priv->search, HD_LAUNCHER_ITEM (app));
 
   hd_launcher_page_transition(HD_LAUNCHER_PAGE(priv->active_page),
         HD_LAUNCHER_PAGE_TRANSITION_LAUNCH);
@@ -508,6 +555,38 @@ hd_launcher_application_tile_clicked (HdLauncherTile *tile,
                  0, data, NULL);
 }
 
+/* Tiles are recycled by the grids, so we find out what to do
+ * from the item the tile is currently showing. */
+static void
+hd_launcher_grid_tile_clicked (HdLauncherGrid *grid,
+                               HdLauncherTile *tile,
+                               gpointer data)
+{
+  HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
+  HdLauncherItem *item = hd_launcher_tile_get_item (tile);
+
+  if (!item)
+    return;
+
+  if (hd_launcher_item_get_item_type (item) == HD_CATEGORY_LAUNCHER)
+    hd_launcher_category_tile_clicked (tile,
+                              g_datalist_get_data (&priv->pages,
+                                           hd_launcher_item_get_id (item)));
+  else if (hd_launcher_item_get_item_type (item) == HD_APPLICATION_LAUNCHER)
+    hd_launcher_application_tile_clicked (tile, item);
+}
+
+static void
+hd_launcher_grid_tile_long_clicked (HdLauncherGrid *grid,
+                                    HdLauncherTile *tile,
+                                    gpointer data)
+{
+  HdLauncherItem *item = hd_launcher_tile_get_item (tile);
+
+  if (item)
+    hd_launcher_application_tile_long_clicked (tile, item);
+}
+
 /* This is a little complex, h-d needs to:
  * - Go back to the launcher when the user closes the editor window.
  * - Hide and destroy the editor window when the user is taken away from it,
@@ -698,6 +777,21 @@ hd_launcher_populate_tree_starting (HdLauncherTree *tree, gpointer data)
  * Creating the pages and tiles
  */
 
+static ClutterActor *
+hd_launcher_new_page (void)
+{
+  ClutterActor *page, *grid;
+
+  page = hd_launcher_page_new ();
+  grid = hd_launcher_page_get_grid (HD_LAUNCHER_PAGE (page));
+  g_signal_connect (grid, "tile-clicked",
+                    G_CALLBACK (hd_launcher_grid_tile_clicked), NULL);
+  g_signal_connect (grid, "tile-long-clicked",
+                    G_CALLBACK (hd_launcher_grid_tile_long_clicked), NULL);
+
+  return page;
+}
+
 static void
 hd_launcher_create_page (HdLauncherItem *item, gpointer data)
 {
@@ -708,7 +802,7 @@ hd_launcher_create_page (HdLauncherItem *item, gpointer data)
   if (hd_launcher_item_get_item_type (item) != HD_CATEGORY_LAUNCHER)
     return;
 
-  newpage = hd_launcher_page_new ();
+  newpage = hd_launcher_new_page ();
 
   clutter_actor_hide (newpage);
   clutter_container_add_actor (CLUTTER_CONTAINER (self), newpage);
@@ -721,7 +815,6 @@ hd_launcher_lazy_traverse_tree (gpointer data)
   HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
   HdLauncherTraverseData *tdata = data;
   HdLauncherItem *item;
-  HdLauncherTile *tile;
   HdLauncherPage *page = NULL;
   guint i;
 
@@ -732,24 +825,14 @@ hd_launcher_lazy_traverse_tree (gpointer data)
     return FALSE;
 
   /* We're called back with huge latency so let's batch the work
-   * to cut the overall population time. */
-  for (i = 0; i < 5; i++)
+   * to cut the overall population time.  Adding an item is cheap
+   * since the grids only create tiles for what's on the screen. */
+  for (i = 0; i < 50; i++)
     {
       if (!tdata->items || !tdata->items->data)
         return FALSE;
       item = tdata->items->data;
 
-      tile = hd_launcher_tile_new (
-          hd_launcher_item_get_icon_name (item),
-          hd_launcher_item_get_local_name (item));
-      /* Signals can be handled during construction, so check this hasn't
-       * been cancelled. */
-      if (tdata->cancelled)
-        {
-          g_object_unref (tile);
-          return FALSE;
-        }
-
       /* Find in which page it goes */
       page = g_datalist_get_data (&priv->pages,
                                   hd_launcher_item_get_category (item));
@@ -761,33 +844,11 @@ hd_launcher_lazy_traverse_tree (gpointer data)
        * check just in case.
        */
       if (!page)
-        {
-          g_warning ("%s: Couldn't find any page to accept entry %s",
-              __FUNCTION__, hd_launcher_item_get_id (item));
-          g_object_unref (tile);
-        }
+        g_warning ("%s: Couldn't find any page to accept entry %s",
+            __FUNCTION__, hd_launcher_item_get_id (item));
       else
-        {
-          hd_launcher_page_add_tile (page, tile);
-
-          if (hd_launcher_item_get_item_type(item) == HD_CATEGORY_LAUNCHER)
-            {
-              g_signal_connect (tile, "clicked",
-                                G_CALLBACK (hd_launcher_category_tile_clicked),
-                                g_datalist_get_data (&priv->pages,
-                                  hd_launcher_item_get_id (item)));
-            }
-          else if (hd_launcher_item_get_item_type(item) == HD_APPLICATION_LAUNCHER)
-            {
-              g_signal_connect (tile, "clicked",
-                                G_CALLBACK (hd_launcher_application_tile_clicked),
-                                item);
-            }
-
-          g_signal_connect (tile, "long-clicked",
-                        G_CALLBACK (hd_launcher_application_tile_long_clicked),
-                        item);
-        }
+        /* The grid creates the tile when it's scrolled into view. */
+        hd_launcher_page_add_item (page, item);
 
       g_object_unref (G_OBJECT (item));
       tdata->items = g_list_delete_link (tdata->items, tdata->items);
@@ -837,6 +898,7 @@ hd_launcher_populate_tree_finished (HdLauncherTree *tree, gpointer data)
   HdLauncher *launcher = HD_LAUNCHER (data);
   HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (launcher);
   HdLauncherTraverseData *tdata = g_new0 (HdLauncherTraverseData, 1);
+  ClutterActor *search_page;
 
   /* As we'll be adding these in an idle loop, we need to ensure that they
    * won't disappear while we do this, so we copy the list and ref all the
@@ -864,7 +926,7 @@ hd_launcher_populate_tree_finished (HdLauncherTree *tree, gpointer data)
   /* First we traverse the list and create all the categories,
    * so that apps can be correctly put into them.
    */
-  ClutterActor *top_page = hd_launcher_page_new ();
+  ClutterActor *top_page = hd_launcher_new_page ();
   clutter_container_add_actor (CLUTTER_CONTAINER (launcher),
                                top_page);
   clutter_actor_hide (top_page);
@@ -873,6 +935,16 @@ hd_launcher_populate_tree_finished (HdLauncherTree *tree, gpointer data)
 
   g_list_foreach (tdata->items, (GFunc) hd_launcher_create_page, NULL);
 
+  /* The search results have a page of their own, filled as the user types. */
+  search_page = hd_launcher_new_page ();
+  clutter_container_add_actor (CLUTTER_CONTAINER (launcher), search_page);
+  clutter_actor_hide (search_page);
+  g_datalist_set_data_full (&priv->pages, HD_LAUNCHER_SEARCH_PAGE,
+                            search_page,
+                            (GDestroyNotify) clutter_actor_destroy);
+  hd_launcher_reset_search (priv);
+  hd_launcher_search_update (priv->search, hd_launcher_tree_get_items (tree));
+
   /* Then we add the tiles to them in a idle callback. */
   clutter_threads_add_idle_full (CLUTTER_PRIORITY_REDRAW + 20,
                                  hd_launcher_lazy_traverse_tree,
@@ -991,7 +1063,10 @@ hd_launcher_transition_app_start (HdLauncherApp *item)
   /* App image - if we had one */
   if (loading_image)
     {
-      app_image = clutter_texture_new_from_file(loading_image, 0);
+      /* The transition starts right away, so this can't wait for
+       * the main loop, but most loading screens are PVRs which we can
+       * upload straight from a mapping. */
+      app_image = hd_texture_loader_load(loading_image, 0);
       if (!app_image)
         g_warning("%s: Preload image file '%s' specified for '%s'"
                     " couldn't be loaded",
@@ -1301,6 +1376,101 @@ hd_launcher_activate (int p)
   hd_launcher_page_activate(priv->active_page, p);
 }
 
+/* Fills the search page with the matches of the current query. */
+static void
+hd_launcher_update_search_results (ClutterActor *page)
+{
+  HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
+  HdLauncherGrid *grid;
+  GPtrArray *results;
+  guint i;
+
+  grid = HD_LAUNCHER_GRID (hd_launcher_page_get_grid (HD_LAUNCHER_PAGE (page)));
+  hd_launcher_grid_clear (grid);
+
+  results = hd_launcher_search_query (priv->search, priv->search_query->str,
+                                      HD_LAUNCHER_SEARCH_RESULTS);
+  for (i = 0; i < results->len; i++)
+    hd_launcher_grid_add_item (grid, g_ptr_array_index (results, i));
+  g_ptr_array_free (results, TRUE);
+
+  _hd_launcher_layout_page (0, page, NULL);
+  hd_launcher_grid_reset_v_adjustment (grid);
+}
+
+/* hd_launcher_key_typed:
+ * @c: the character typed or '\b' for backspace
+ *
+ * Type-to-search.  The first printable character switches to the search
+ * page, subsequent ones refine the query.  Erasing the whole query goes
+ * back to the top page.  Returns whether the key was consumed.
+ */
+gboolean
+hd_launcher_key_typed (gunichar c)
+{
+  HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
+  ClutterActor *top_page, *search_page;
+
+  if (hd_render_manager_get_state () != HDRM_STATE_LAUNCHER)
+    return FALSE;
+
+  top_page = g_datalist_get_data (&priv->pages, HD_LAUNCHER_ITEM_TOP_CATEGORY);
+  search_page = g_datalist_get_data (&priv->pages, HD_LAUNCHER_SEARCH_PAGE);
+  if (!top_page || !search_page || priv->current_traversal)
+    return FALSE;
+
+  if (c == '\b')
+    {
+      if (!priv->search_query->len)
+        return FALSE;
+      g_string_truncate (priv->search_query,
+          g_utf8_prev_char (priv->search_query->str
+                            + priv->search_query->len)
+          - priv->search_query->str);
+      if (!priv->search_query->len)
+        {
+          hd_launcher_back_button_clicked ();
+          return TRUE;
+        }
+    }
+  else if (g_unichar_isprint (c) && (priv->search_query->len
+                                     || !g_unichar_isspace (c)))
+    g_string_append_unichar (priv->search_query, c);
+  else
+    return FALSE;
+
+  hd_launcher_show_search_query (priv);
+  hd_launcher_update_search_results (search_page);
+
+  if (priv->active_page != search_page)
+    {
+      if (priv->active_page && priv->active_page != top_page)
+        /* Leave the category the same way as with the back button. */
+        hd_launcher_page_transition (HD_LAUNCHER_PAGE (priv->active_page),
+                                     HD_LAUNCHER_PAGE_TRANSITION_OUT_SUB);
+      else
+        hd_launcher_page_transition (HD_LAUNCHER_PAGE (top_page),
+                                     HD_LAUNCHER_PAGE_TRANSITION_BACK);
+      hd_launcher_page_transition (HD_LAUNCHER_PAGE (search_page),
+                                   HD_LAUNCHER_PAGE_TRANSITION_IN_SUB);
+      priv->active_page = search_page;
+      g_signal_emit (hd_launcher_get (), launcher_signals[CAT_LAUNCHED],
+                     0, NULL);
+    }
+
+  return TRUE;
+}
+
+/* Whether a type-to-search query is being typed, so the keys should go
+ * to hd_launcher_key_typed() before anything else. */
+gboolean
+hd_launcher_is_searching (void)
+{
+  HdLauncherPrivate *priv = HD_LAUNCHER_GET_PRIVATE (hd_launcher_get ());
+
+  return priv->search_query && priv->search_query->len > 0;
+}
+
 gboolean
 hd_launcher_is_editor_in_landscape (void)
 {
@@ -92,6 +92,8 @@ gboolean hd_launcher_transition_app_start (HdLauncherApp *item);
 void hd_launcher_stop_loading_transition (void);
 
 void hd_launcher_activate(int p);
+gboolean hd_launcher_key_typed (gunichar c);
+gboolean hd_launcher_is_searching (void);
 void hd_launcher_update_orientation (gboolean portraited);
 
 gboolean hd_launcher_is_editor_in_landscape (void);
@@ -40,6 +40,8 @@ struct _HdRunningAppPrivate
   HdRunningAppState state;
   GPid pid;
   time_t last_launch;
+
+  HdAppQueueLink queue_links[HD_RUNNING_APP_QUEUE_LINKS];
 };
 
 G_DEFINE_TYPE (HdRunningApp, hd_running_app, G_TYPE_OBJECT);
@@ -70,6 +72,8 @@ static void
 hd_running_app_init (HdRunningApp *app)
 {
   app->priv = HD_RUNNING_APP_GET_PRIVATE (app);
+  for (guint i = 0; i < HD_RUNNING_APP_QUEUE_LINKS; i++)
+    hd_app_queue_link_init (&app->priv->queue_links[i], app);
 }
 
 HdRunningApp *
@@ -144,6 +148,13 @@ hd_running_app_set_last_launch (HdRunningApp *app, time_t time)
   priv->last_launch = time;
 }
 
+HdAppQueueLink *
+hd_running_app_get_queue_link (HdRunningApp *app, guint queue)
+{
+  g_return_val_if_fail (queue < HD_RUNNING_APP_QUEUE_LINKS, NULL);
+  return &app->priv->queue_links[queue];
+}
+
 HdLauncherApp  *
 hd_running_app_get_launcher_app  (HdRunningApp *app)
 {
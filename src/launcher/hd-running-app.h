@@ -32,6 +32,7 @@
 #include <time.h>
 
 #include "hd-launcher-app.h"
+#include "hd-app-queue.h"
 
 G_BEGIN_DECLS
 
@@ -86,6 +87,11 @@ void hd_running_app_set_pid (HdRunningApp *app, GPid pid);
 time_t hd_running_app_get_last_launch (HdRunningApp *app);
 void   hd_running_app_set_last_launch (HdRunningApp *app, time_t time);
 
+/* The links for HdAppMgr's queues. */
+#define HD_RUNNING_APP_QUEUE_LINKS 4
+HdAppQueueLink *hd_running_app_get_queue_link (HdRunningApp *app,
+                                               guint queue);
+
 /* Some convenience functions. */
 const gchar *hd_running_app_get_service (HdRunningApp *app);
 const gchar *hd_running_app_get_id      (HdRunningApp *app);
@@ -49,8 +49,12 @@
 #include "hd-util.h"
 #include "hd-dbus.h"
 #include "hd-volume-profile.h"
+#include "hd-startup.h"
 #include "launcher/hd-app-mgr.h"
+#include "launcher/hd-launch-helper.h"
 #include "home/hd-render-manager.h"
+#include "tidy/tidy-highlight.h"
+#include "tidy/tidy-desaturation-group.h"
 #include "hd-transition.h"
 #include "hd-orientation-lock.h"
 #include "hd-home.h"
@@ -559,6 +563,27 @@ terminating (int unused)
   gtk_main_quit ();
 }
 
+/* HdStartupTask:s */
+#ifndef DISABLE_A11Y
+static void
+a11y_init (gpointer unused)
+{
+  hildon_desktop_a11y_init ();
+}
+#endif
+
+static void
+highlight_warm_up (gpointer unused)
+{
+  tidy_highlight_warm_up ();
+}
+
+static void
+desaturation_warm_up (gpointer unused)
+{
+  tidy_desaturation_group_warm_up ();
+}
+
 typedef enum
 {
   OSSO_FPU_IEEE,    /* Usual processor mode, slow and accurate */
@@ -602,6 +627,7 @@ main (int argc, char **argv)
   HdAppMgr *app_mgr;
   char keys1[32], c; 
 
+  hd_startup_mark ("main");
   signal (SIGUSR1, dump_debug_info_sighand);
   signal (SIGHUP,  relaunch);
   signal (SIGTERM, terminating);
@@ -621,6 +647,9 @@ main (int argc, char **argv)
 
   g_thread_init (NULL);
 
+  /* Before we grow big. */
+  hd_launch_helper_start ();
+
   gnome_vfs_init ();
 
   mb_wm_object_init();
@@ -631,6 +660,7 @@ main (int argc, char **argv)
   mb_wm_theme_set_custom_button_type_func (theme_button_type_func, NULL);
 
   hildon_gtk_init (&argc, &argv);
+  hd_startup_mark ("gtk");
   /* Initialise the async error handler. Do it after gtk is inited, or gtk
    * will grab the handler for itself */
   mb_wm_util_async_x_error_init();
@@ -653,9 +683,13 @@ main (int argc, char **argv)
   /* Use software-based selection, which is much faster on SGX than rendering
    * with 'GL and reading back */
   clutter_set_software_selection(TRUE);
+  hd_startup_mark ("clutter");
 
 #ifndef DISABLE_A11Y
-  hildon_desktop_a11y_init ();
+  /* Loading the modules takes a while and nobody needs them before
+   * there is something on the screen. */
+  hd_startup_defer ("a11y", G_PRIORITY_HIGH_IDLE,
+                    a11y_init, NULL);
 #endif
 
   dpy = clutter_x11_get_default_display ();
@@ -680,6 +714,7 @@ main (int argc, char **argv)
   mb_wm_rename_window (wm, wm->root_win->hidden_window, PACKAGE);
   mb_wm_init (wm);
   g_assert (mb_wm_comp_mgr_enabled (wm->comp_mgr));
+  hd_startup_mark ("window manager");
 
   if(conf_enable_ctrl_backspace) {
   mb_wm_keys_binding_add_with_spec (wm,
@@ -794,6 +829,7 @@ main (int argc, char **argv)
   app_mgr = hd_app_mgr_get ();
 
   hd_volume_profile_init ();
+  hd_startup_mark ("key bindings, volume profile");
 
   /* Check if orientation is locked to portrait or the device is in vertical position. */
   if (hd_orientation_lock_is_locked_to_portrait ()
@@ -809,7 +845,16 @@ main (int argc, char **argv)
       if (hd_util_change_screen_orientation (wm, FALSE));
         hd_util_root_window_configured (wm);
     }
+  hd_startup_mark ("orientation");
+
+  /* The launcher tiles and the task switcher thumbnails are only made
+   * later, compile their shaders while we're idle until then. */
+  hd_startup_defer ("highlight shader warm-up", G_PRIORITY_DEFAULT_IDLE,
+                    highlight_warm_up, NULL);
+  hd_startup_defer ("desaturation shader warm-up", G_PRIORITY_DEFAULT_IDLE,
+                    desaturation_warm_up, NULL);
 
+  hd_startup_run_after_paint (clutter_stage_get_default ());
 
   /* NB: we call gtk_main as opposed to clutter_main or mb_wm_main_loop
    * because it does the most extra magic, such as supporting quit functions
@@ -24,6 +24,7 @@
 #include "hd-animation-actor.h"
 #include "hd-comp-mgr.h"
 #include "hd-wm.h"
+#include "hd-frame-governor.h"
 
 #include <sys/time.h>
 #include <time.h>
@@ -318,6 +319,9 @@ hd_animation_actor_realize (MBWindowManagerClient *client)
 		   ready_atom,
 		   XA_ATOM, 32, PropModeReplace,
 		   (unsigned char *) &val, 1);
+
+  /* Tell the client how fast it may animate. */
+  hd_frame_governor_add_client (client);
 }
 
 static void
@@ -348,6 +352,7 @@ hd_animation_actor_destroy (MBWMObject *this)
     MBWindowManagerClient *client = MB_WM_CLIENT (this);
     MBWindowManager       *wm = client->wmref;
 
+    hd_frame_governor_remove_client (client);
     if (self->client_message_handler_id)
     {
         mb_wm_main_context_x_event_handler_remove (wm->main_ctx,
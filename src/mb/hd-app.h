@@ -51,6 +51,10 @@ struct HdApp
   Bool         non_composited_read;
   Bool         non_composited;
   Bool         force_composited;
+  /* _HILDON_NON_COMPOSITED_WINDOW is explicitly 0 */
+  Bool         composited_requested;
+  /* unredirected because of its damage rate */
+  Bool         auto_non_composited;
 
   Window       detransitised_from;  
 };
@@ -65,6 +65,9 @@ hd_atoms_init (Display * xdpy, Atom * atoms)
     "_HILDON_ANIMATION_CLIENT_MESSAGE_PARENT",
     "_HILDON_ANIMATION_CLIENT_READY",
 
+    /* The frame rate we're going to show of a live client */
+    "_HILDON_FRAME_RATE",
+
     "_HILDON_TEXTURE_CLIENT_MESSAGE_SHM",
     "_HILDON_TEXTURE_CLIENT_MESSAGE_DAMAGE",
     "_HILDON_TEXTURE_CLIENT_MESSAGE_SHOW",
@@ -60,6 +60,8 @@ typedef enum HdAtoms
   HD_ATOM_HILDON_ANIMATION_CLIENT_MESSAGE_PARENT,
   HD_ATOM_HILDON_ANIMATION_CLIENT_READY,
 
+  HD_ATOM_HILDON_FRAME_RATE,
+
   HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_SHM,
   HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_DAMAGE,
   HD_ATOM_HILDON_TEXTURE_CLIENT_MESSAGE_SHOW,
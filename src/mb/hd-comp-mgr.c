@@ -36,9 +36,12 @@
 #include "hd-gtk-style.h"
 #include "hd-note.h"
 #include "hd-animation-actor.h"
+#include "hd-frame-governor.h"
+#include "hd-snapshot-store.h"
 #include "hd-render-manager.h"
 #include "hd-title-bar.h"
 #include "hd-orientation-lock.h"
+#include "hd-startup.h"
 #include "launcher/hd-app-mgr.h"
 #include "launcher/hd-launcher-editor.h"
 
@@ -47,6 +50,7 @@
 #include <matchbox/core/mb-wm-client.h>
 #include <matchbox/theme-engines/mb-wm-theme.h>
 
+#include <X11/Xatom.h>
 #include <X11/extensions/Xcomposite.h>
 #include <X11/extensions/shape.h>
 
@@ -54,6 +58,8 @@
 #include <clutter/x11/clutter-x11.h>
 
 #include "../tidy/tidy-blur-group.h"
+#include "../tidy/tidy-shader-cache.h"
+#include "../tidy/tidy-quad-batch.h"
 
 #include <dbus/dbus-glib-bindings.h>
 #include <mce/dbus-names.h>
@@ -124,6 +130,23 @@ struct HdCompMgrPrivate
   GConfClient* gconf_client;
 };
 
+/*
+ * What decides whether a client can be rotated, apart from the
+ * portrait properties, which are cheap to look at.
+ * -- @has_name:        Whether the client has a WM_CLASS.
+ * -- @whitelisted:     Whether its name is on the [thp_tweaks] whitelist.
+ * -- @blacklisted:     Likewise for the blacklist.
+ * -- @force_landscape: Whether its .desktop file says
+ *                      X-CSSU-Force-Landscape.
+ */
+typedef struct
+{
+  gboolean has_name        : 1;
+  gboolean whitelisted     : 1;
+  gboolean blacklisted     : 1;
+  gboolean force_landscape : 1;
+} HdOrientationCaps;
+
 /*
  * A helper object to store manager's per-client data
  */
@@ -136,11 +159,27 @@ struct HdCompMgrClientPrivate
   gboolean              can_hibernate : 1;
 
   gboolean              has_video_overlay;
+
+  /* Damage rate tracking for automatic unredirection */
+  GTimer               *damage_timer;
+  gdouble               damage_pixels;
+  guint                 busy_periods, idle_periods;
+
+  /* What hd_comp_mgr_get_orientation_caps() found out, valid while
+   * @orientation_caps_generation is the generation of transitions.ini
+   * and @orientation_caps_tree is @launcher_tree_serial. */
+  HdOrientationCaps     orientation_caps;
+  guint                 orientation_caps_generation;
+  guint                 orientation_caps_tree;
+  gboolean              orientation_caps_valid : 1;
 };
 
 extern gboolean hd_dbus_display_is_off;
 static guint portrait_freshness_counter;
 
+/* Incremented whenever the launcher tree is reloaded. */
+static guint launcher_tree_serial;
+
 HdRunningApp *hd_comp_mgr_client_get_app_key (HdCompMgrClient *client,
                                                HdCompMgr *hmgr);
 
@@ -155,6 +194,18 @@ hd_comp_mgr_is_non_composited (MBWindowManagerClient *client,
 
 static MBWindowManagerClient *hd_comp_mgr_determine_current_app (void);
 
+static void hd_comp_mgr_launcher_tree_finished (HdLauncherTree *tree,
+                                                gpointer unused);
+
+/* Length of the damage sampling periods in seconds. */
+#define HD_COMP_MGR_DAMAGE_PERIOD 0.5
+
+static void hd_comp_mgr_track_damage (MBWindowManagerClient *c,
+                                      int width, int height);
+static MBWindowManagerClient *hd_comp_mgr_client_from_texture (
+                                                  ClutterActor *actor);
+static guint auto_unredirect_idle;
+
 static MBWMCompMgrClient *
 hd_comp_mgr_client_new (MBWindowManagerClient * client)
 {
@@ -348,6 +399,9 @@ hd_comp_mgr_client_destroy (MBWMObject* obj)
       priv->app = NULL;
     }
 
+  if (priv->damage_timer)
+    g_timer_destroy (priv->damage_timer);
+
   g_free (priv);
 }
 
@@ -408,6 +462,14 @@ hd_comp_mgr_client_get_app (HdCompMgrClient *hclient)
   return hclient->priv->app;
 }
 
+/* Returns a new actor showing the last frame of @hclient
+ * before it was hibernated or %NULL. */
+ClutterActor *
+hd_comp_mgr_client_get_snapshot (HdCompMgrClient *hclient)
+{
+  return hd_snapshot_store_get (hclient->priv->hibernation_key);
+}
+
 HdLauncherApp *
 hd_comp_mgr_client_get_launcher (HdCompMgrClient *hclient)
 {
@@ -490,6 +552,12 @@ hd_comp_mgr_class_init (MBWMObjectClass *klass)
 #endif
 }
 
+static void
+hd_comp_mgr_preload_task_navigator_theme (gpointer unused)
+{
+  hd_task_navigator_preload_theme ();
+}
+
 static int
 hd_comp_mgr_init (MBWMObject *obj, va_list vap)
 {
@@ -522,13 +590,17 @@ hd_comp_mgr_init (MBWMObject *obj, va_list vap)
    * Create the home group before the switcher, so the switcher can
    * connect it's signals to it.
    */
+  hd_startup_mark ("wm core, comp-mgr: dbus, gconf, style");
   priv->home = g_object_new (HD_TYPE_HOME, "comp-mgr", cmgr, NULL);
+  hd_startup_mark ("comp-mgr: home");
 
   clutter_actor_set_reactive (priv->home, TRUE);
 
   clutter_actor_show (priv->home);
 
   hd_task_navigator = hd_task_navigator_new ();
+  hd_startup_defer ("task navigator theme", G_PRIORITY_DEFAULT_IDLE,
+                    hd_comp_mgr_preload_task_navigator_theme, NULL);
 
   priv->render_manager = hd_render_manager_create(hmgr,
 		                                  hd_launcher_get(),
@@ -537,12 +609,18 @@ hd_comp_mgr_init (MBWMObject *obj, va_list vap)
   g_object_set(priv->home, "hdrm", priv->render_manager, NULL);
   clutter_container_add_actor(CLUTTER_CONTAINER (stage),
                               CLUTTER_ACTOR(priv->render_manager));
+  hd_startup_mark ("comp-mgr: render manager");
 
   /* Pass the render manager to the app mgr so it knows when it can't
    * prestart apps.
    */
   priv->app_mgr = g_object_ref (hd_app_mgr_get ());
   hd_app_mgr_set_render_manager (G_OBJECT (priv->render_manager));
+  hd_startup_mark ("comp-mgr: app manager");
+
+  /* The .desktop files may force applications to landscape. */
+  g_signal_connect (hd_app_mgr_get_tree (), "finished",
+                    G_CALLBACK (hd_comp_mgr_launcher_tree_finished), NULL);
 
   /* NB -- home must be constructed before constructing the switcher;
    */
@@ -683,6 +761,16 @@ hd_comp_mgr_client_property_changed (XPropertyEvent *event, HdCompMgr *hmgr)
 
   wm = MB_WM_COMP_MGR (hmgr)->wm;
 
+  if (event->atom == XA_WM_CLASS)
+    {
+      /* The client may be on a different list by its new name. */
+      c = mb_wm_managed_client_from_xwindow (wm, event->window);
+      if (c && c->cm_client)
+        HD_COMP_MGR_CLIENT (c->cm_client)->priv->orientation_caps_valid
+          = FALSE;
+      return False;
+    }
+
   if (event->atom == wm->atoms[MBWM_ATOM_HILDON_LIVE_DESKTOP_BACKGROUND])
     {
       HdCompMgrPrivate *priv = hmgr->priv;
@@ -1181,6 +1269,7 @@ hd_comp_mgr_unregister_client (MBWMCompMgr *mgr, MBWindowManagerClient *c)
 
   g_debug ("%s, c=%p ctype=%d", __FUNCTION__, c, MB_WM_CLIENT_CLIENT_TYPE (c));
   actor = mb_wm_comp_mgr_clutter_client_get_actor (cclient);
+  hd_frame_governor_remove_client (c);
 
   /* Check if it's the last window for the app. */
   if (hclient->priv->app)
@@ -1217,6 +1306,10 @@ hd_comp_mgr_unregister_client (MBWMCompMgr *mgr, MBWindowManagerClient *c)
                                 MBWMCompMgrClutterClientDontUpdate);
       mb_wm_object_ref (MB_WM_OBJECT (cclient));
 
+      /* Normally hd_comp_mgr_snapshot_app() has done it already. */
+      if (actor && !hd_snapshot_store_has (hclient->priv->hibernation_key))
+        hd_snapshot_store_take (hclient->priv->hibernation_key, actor);
+
       g_hash_table_insert (priv->hibernating_apps,
 			   (gpointer) hclient->priv->hibernation_key,
 			   hclient);
@@ -1419,6 +1512,7 @@ hd_comp_mgr_texture_update_area(HdCompMgr *hmgr,
   HdCompMgrPrivate * priv;
   gboolean blur_update = FALSE;
   ClutterActor *actors_stage;
+  MBWindowManagerClient *c;
 
   if (!actor || !CLUTTER_ACTOR_IS_VISIBLE(actor) || hmgr == 0)
     return;
@@ -1433,6 +1527,11 @@ hd_comp_mgr_texture_update_area(HdCompMgr *hmgr,
       return;
     }
 
+  /* Let the rotation know who has redrawn at the new size. */
+  if (hd_transition_is_rotating ()
+      && (c = hd_comp_mgr_client_from_texture (actor)))
+    hd_transition_rotate_client_damaged (c, width, height);
+
   /* If we are in the blanking period of the rotation transition
    * then we don't want to issue a redraw every time something changes.
    * This function also assumes that it is called because there was damage,
@@ -1476,6 +1575,13 @@ hd_comp_mgr_texture_update_area(HdCompMgr *hmgr,
   if (blur_update)
     return;
 
+  if ((c = hd_comp_mgr_client_from_texture (actor)))
+    hd_comp_mgr_track_damage (c, width, height);
+
+  /* Don't redraw live clients more often than we told them. */
+  if (!hd_frame_governor_allow_damage (actor))
+    return;
+
   /* Update the screen. This function checks for scaling/visibility and
    * chooses the area to update accordingly */
   {
@@ -1636,6 +1742,194 @@ hd_comp_mgr_unredirect_client (MBWindowManagerClient *c)
     g_printerr("%s: ain't no doing no unredirection\n", __func__);
 }
 
+/* Reads @c's WM_CLASS into @class_hint, which must be released with
+ * hd_comp_mgr_free_class_hint() whatever this returns. */
+static Status
+hd_comp_mgr_get_class_hint (MBWindowManagerClient *c, XClassHint *class_hint)
+{
+  MBWindowManager *wm = c->wmref;
+  Status ret;
+
+  memset (class_hint, 0, sizeof (*class_hint));
+  mb_wm_util_async_trap_x_errors (wm->xdpy);
+  ret = XGetClassHint (wm->xdpy, c->window->xwindow, class_hint);
+  mb_wm_util_async_untrap_x_errors ();
+
+  return ret;
+}
+
+static void
+hd_comp_mgr_free_class_hint (XClassHint *class_hint)
+{
+  if (class_hint->res_class)
+    XFree (class_hint->res_class);
+  if (class_hint->res_name)
+    XFree (class_hint->res_name);
+}
+
+/* Returns the [thp_tweaks] @key list as a set of window names. */
+static GHashTable *
+hd_comp_mgr_get_name_list (const gchar *key, GHashTable **cache,
+                           guint *generation)
+{
+  gchar *list, **names;
+  guint i;
+
+  if (*cache && *generation == hd_transition_get_generation ())
+    return *cache;
+
+  if (*cache)
+    g_hash_table_destroy (*cache);
+  *cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  *generation = hd_transition_get_generation ();
+
+  /* The names are separated by spaces, or commas. */
+  list = hd_transition_get_string ("thp_tweaks", key, "");
+  names = g_strsplit_set (list ? list : "", " \t,;", -1);
+  g_free (list);
+  for (i = 0; names[i]; i++)
+    if (names[i][0])
+      g_hash_table_insert (*cache, g_strdup (names[i]), GINT_TO_POINTER (1));
+  g_strfreev (names);
+
+  return *cache;
+}
+
+/* Whether @c's res_name is in the [thp_tweaks] @key list. */
+static gboolean
+hd_comp_mgr_client_is_listed (MBWindowManagerClient *c, const gchar *key,
+                              GHashTable **cache, guint *generation)
+{
+  XClassHint class_hint;
+  gboolean listed;
+
+  listed = hd_comp_mgr_get_class_hint (c, &class_hint)
+    && class_hint.res_name
+    && g_hash_table_lookup (hd_comp_mgr_get_name_list (key, cache,
+                                                       generation),
+                            class_hint.res_name);
+  hd_comp_mgr_free_class_hint (&class_hint);
+
+  return listed;
+}
+
+/* Can @c be unredirected automatically? */
+static gboolean
+hd_comp_mgr_may_auto_unredirect (MBWindowManagerClient *c)
+{
+  static GHashTable *composited_apps;
+  static guint composited_apps_generation;
+  HdApp *app = HD_APP (c);
+
+  if (app->force_composited || app->composited_requested)
+    return FALSE;
+  if (c->is_argb32
+      || !(c->window->ewmh_state & MBWMClientWindowEWMHStateFullscreen))
+    return FALSE;
+  if (c != hd_comp_mgr_determine_current_app ())
+    return FALSE;
+  /* Windows stacked above are checked by reconsider_compositing(). */
+  return !hd_comp_mgr_client_is_listed (c, "composited_apps",
+                                        &composited_apps,
+                                        &composited_apps_generation);
+}
+
+static gboolean
+hd_comp_mgr_auto_unredirect_idle (gpointer mgr)
+{
+  auto_unredirect_idle = 0;
+  hd_comp_mgr_reconsider_compositing (MB_WM_COMP_MGR (mgr));
+  return FALSE;
+}
+
+/* Returns the client whose window @actor, a texture given to
+ * hd_comp_mgr_texture_update_area(), shows. */
+static MBWindowManagerClient *
+hd_comp_mgr_client_from_texture (ClutterActor *actor)
+{
+  MBWMCompMgrClient *cc;
+  ClutterActor *parent;
+
+  /* @actor is the texture inside the client's actor. */
+  if (!(cc = g_object_get_data (G_OBJECT (actor),
+                                "HD-MBWMCompMgrClutterClient"))
+      && (!(parent = clutter_actor_get_parent (actor))
+          || !(cc = g_object_get_data (G_OBJECT (parent),
+                                       "HD-MBWMCompMgrClutterClient"))))
+    return NULL;
+  return cc->wm_client;
+}
+
+/*
+ * Automatic unredirection.  A fullscreen, opaque, topmost application
+ * which keeps repainting most of the screen is made non-composited as if
+ * it had set _HILDON_NON_COMPOSITED_WINDOW.  Its damage is sampled in
+ * periods of %HD_COMP_MGR_DAMAGE_PERIOD seconds and measured in screens
+ * per second.  It takes [unredirect] enter_periods busy periods in a row
+ * to be unredirected, and leave_periods idle ones while composited again
+ * (because of a note, for example) to lose the privilege.
+ */
+static void
+hd_comp_mgr_track_damage (MBWindowManagerClient *c, int width, int height)
+{
+  HDRMStateEnum state = hd_render_manager_get_state ();
+  HdCompMgrClientPrivate *cpriv;
+  gdouble elapsed, rate;
+
+  if (state != HDRM_STATE_APP && state != HDRM_STATE_APP_PORTRAIT)
+    return;
+  if (!HD_IS_APP (c) || !c->window
+      || !(c->window->ewmh_state & MBWMClientWindowEWMHStateFullscreen))
+    return;
+
+  cpriv = HD_COMP_MGR_CLIENT (c->cm_client)->priv;
+  if (!cpriv->damage_timer)
+    cpriv->damage_timer = g_timer_new ();
+  cpriv->damage_pixels += (gdouble) width * height;
+
+  elapsed = g_timer_elapsed (cpriv->damage_timer, NULL);
+  if (elapsed < HD_COMP_MGR_DAMAGE_PERIOD)
+    return;
+
+  rate = cpriv->damage_pixels / (elapsed
+                  * hd_comp_mgr_get_current_screen_width ()
+                  * hd_comp_mgr_get_current_screen_height ());
+  cpriv->damage_pixels = 0;
+  g_timer_start (cpriv->damage_timer);
+
+  if (rate >= hd_transition_get_double ("unredirect", "enter_rate", 9))
+    {
+      cpriv->busy_periods++;
+      cpriv->idle_periods = 0;
+    }
+  else if (rate < hd_transition_get_double ("unredirect", "leave_rate", 2))
+    {
+      cpriv->idle_periods++;
+      cpriv->busy_periods = 0;
+    }
+
+  if (HD_APP (c)->auto_non_composited)
+    {
+      if (cpriv->idle_periods
+          >= hd_transition_get_int ("unredirect", "leave_periods", 6))
+        HD_APP (c)->auto_non_composited = False;
+    }
+  else if (cpriv->busy_periods
+           >= hd_transition_get_int ("unredirect", "enter_periods", 4))
+    {
+      cpriv->busy_periods = 0;
+      if (!hd_transition_get_int ("unredirect", "enabled", 1)
+          || !hd_comp_mgr_may_auto_unredirect (c))
+        return;
+
+      HD_APP (c)->auto_non_composited = True;
+      /* Don't change the state from within a texture's signal handler. */
+      if (!auto_unredirect_idle)
+        auto_unredirect_idle = g_idle_add (hd_comp_mgr_auto_unredirect_idle,
+                                           c->wmref->comp_mgr);
+    }
+}
+
 /* returns TRUE if the client wants non-composited mode */
 static gboolean
 hd_comp_mgr_is_non_composited (MBWindowManagerClient *client,
@@ -1687,10 +1981,15 @@ hd_comp_mgr_is_non_composited (MBWindowManagerClient *client,
   if (HD_APP (client)->force_composited)
     return FALSE;
 
+  if (!(client->window->ewmh_state & MBWMClientWindowEWMHStateFullscreen))
+    /* It has to earn it again. */
+    HD_APP (client)->auto_non_composited = False;
+
   if (HD_APP (client)->non_composited_read && !force_re_read)
     {
       if ((client->window->ewmh_state & MBWMClientWindowEWMHStateFullscreen)
-          && HD_APP (client)->non_composited)
+          && (HD_APP (client)->non_composited
+              || HD_APP (client)->auto_non_composited))
         return TRUE;
       else
         return FALSE;
@@ -1719,6 +2018,10 @@ hd_comp_mgr_is_non_composited (MBWindowManagerClient *client,
       XFree (prop);
     }
 
+  HD_APP (client)->composited_requested = actual_type == XA_INTEGER && !value;
+  if (HD_APP (client)->composited_requested)
+    HD_APP (client)->auto_non_composited = False;
+
   if (actual_type == XA_INTEGER)
     {
       if (value)
@@ -1742,7 +2045,8 @@ hd_comp_mgr_is_non_composited (MBWindowManagerClient *client,
      else
        HD_APP (client)->non_composited = False;
    }
-  return FALSE;
+  return (client->window->ewmh_state & MBWMClientWindowEWMHStateFullscreen)
+    && HD_APP (client)->auto_non_composited;
 }
 
 /* returns HdApp of client that was replaced (because the stack_index
@@ -2403,6 +2707,7 @@ hd_comp_mgr_map_notify (MBWMCompMgr *mgr, MBWindowManagerClient *c)
                                         actor_h, actor);
       mb_wm_object_unref (MB_WM_OBJECT (hclient_h));
       g_hash_table_remove (priv->hibernating_apps, (gpointer)hkey);
+      hd_snapshot_store_forget (hkey);
     }
 
   int topmost;
@@ -3195,6 +3500,7 @@ hd_comp_mgr_close_app (HdCompMgr *hmgr, MBWMCompMgrClutterClient *cc,
 
       g_hash_table_remove (priv->hibernating_apps,
                            (gpointer)h_client->priv->hibernation_key);
+      hd_snapshot_store_forget (h_client->priv->hibernation_key);
 
       if (h_client->priv->app)
         {
@@ -3232,6 +3538,32 @@ hd_comp_mgr_wakeup_client (HdCompMgr *hmgr, HdCompMgrClient *hclient)
   hd_app_mgr_activate (hclient->priv->app);
 }
 
+/* Snapshot the windows of @app before it's killed for hibernation,
+ * while they still have their contents. */
+void
+hd_comp_mgr_snapshot_app (HdCompMgr *hmgr, HdRunningApp *app)
+{
+  MBWindowManagerClient *c;
+
+  mb_wm_stack_enumerate (MB_WM_COMP_MGR (hmgr)->wm, c)
+    {
+      HdCompMgrClient *hclient;
+      ClutterActor *actor;
+
+      if (MB_WM_CLIENT_CLIENT_TYPE (c) != MBWMClientTypeApp
+          || !c->cm_client)
+        continue;
+      hclient = HD_COMP_MGR_CLIENT (c->cm_client);
+      if (hclient->priv->app != app)
+        continue;
+
+      actor = mb_wm_comp_mgr_clutter_client_get_actor (
+                               MB_WM_COMP_MGR_CLUTTER_CLIENT (c->cm_client));
+      if (actor)
+        hd_snapshot_store_take (hclient->priv->hibernation_key, actor);
+    }
+}
+
 void
 hd_comp_mgr_kill_all_apps (HdCompMgr *hmgr)
 {
@@ -3791,8 +4123,18 @@ hd_comp_mgr_dump_debug_info (const gchar *tag)
     g_debug ("    %dx%d%+d%+d", MBWM_GEOMETRY(&inputshape[i]));
   XFree(inputshape);
 
+  g_debug ("last rotation took %u ms",
+           hd_transition_get_last_rotation_time ());
+
   dump_clutter_actor_tree (clutter_stage_get_default (), NULL);
   hd_app_mgr_dump_app_list (TRUE);
+  hd_dbus_dump_stats ();
+  hd_arena_dump_stats (hd_render_manager_get_scratch ());
+  hd_render_manager_dump_restack_stats ();
+  hd_render_manager_dump_flatten_stats ();
+  tidy_shader_cache_dump_stats ();
+  tidy_quad_batch_dump_stats ();
+  hd_startup_dump ();
 #endif
 }
 
@@ -3881,14 +4223,81 @@ hd_comp_mgr_update_applets_on_current_desktop_property (HdCompMgr *hmgr)
   mb_wm_util_async_untrap_x_errors ();
 }
 
-gboolean
-hd_comp_mgr_is_whitelisted(MBWindowManager *wm, MBWindowManagerClient *c)
+static void
+hd_comp_mgr_launcher_tree_finished (HdLauncherTree *tree, gpointer unused)
+{
+  launcher_tree_serial++;
+}
+
+/* Finds out @c's #HdOrientationCaps, which takes X and launcher tree
+ * roundtrips, into @caps. */
+static void
+hd_comp_mgr_find_orientation_caps (MBWindowManager *wm,
+                                   MBWindowManagerClient *c,
+                                   HdOrientationCaps *caps)
 {
-  gchar *whitelist;
+  static GHashTable *whitelist, *blacklist;
+  static guint whitelist_generation, blacklist_generation;
   XClassHint class_hint;
   Status ret;
-  gchar *wname = NULL;
-  gboolean is_on_whitelist = FALSE;
+  gchar *wname;
+
+  ret = hd_comp_mgr_get_class_hint (c, &class_hint);
+  wname = ret && class_hint.res_class ? class_hint.res_name : NULL;
+  caps->has_name = wname != NULL;
+  caps->whitelisted = wname && g_hash_table_lookup (
+                hd_comp_mgr_get_name_list ("whitelist", &whitelist,
+                                           &whitelist_generation), wname);
+  caps->blacklisted = wname && g_hash_table_lookup (
+                hd_comp_mgr_get_name_list ("blacklist", &blacklist,
+                                           &blacklist_generation), wname);
+
+  /* Check, if X-CSSU-Force-Landscape=true. */
+  caps->force_landscape = HD_IS_APP (c)
+    && hd_comp_mgr_is_blacklisted_parse_desktop_file (wname,
+                                                      class_hint.res_class,
+                                                      c->window->pid);
+
+  hd_comp_mgr_free_class_hint (&class_hint);
+}
+
+/*
+ * Returns the #HdOrientationCaps of @c.  They are found out the first
+ * time they're needed after the client is mapped and kept until its
+ * WM_CLASS changes, transitions.ini or the launcher tree is reloaded.
+ * Clients without a #HdCompMgrClient are looked at every time in @tmp.
+ */
+static const HdOrientationCaps *
+hd_comp_mgr_get_orientation_caps (MBWindowManager *wm,
+                                  MBWindowManagerClient *c,
+                                  HdOrientationCaps *tmp)
+{
+  HdCompMgrClientPrivate *cpriv;
+
+  if (!c->cm_client)
+    {
+      hd_comp_mgr_find_orientation_caps (wm, c, tmp);
+      return tmp;
+    }
+
+  cpriv = HD_COMP_MGR_CLIENT (c->cm_client)->priv;
+  if (!cpriv->orientation_caps_valid
+      || cpriv->orientation_caps_generation != hd_transition_get_generation ()
+      || cpriv->orientation_caps_tree != launcher_tree_serial)
+    {
+      hd_comp_mgr_find_orientation_caps (wm, c, &cpriv->orientation_caps);
+      cpriv->orientation_caps_generation = hd_transition_get_generation ();
+      cpriv->orientation_caps_tree = launcher_tree_serial;
+      cpriv->orientation_caps_valid = TRUE;
+    }
+
+  return &cpriv->orientation_caps;
+}
+
+gboolean
+hd_comp_mgr_is_whitelisted(MBWindowManager *wm, MBWindowManagerClient *c)
+{
+  HdOrientationCaps tmp;
 
   if ((!c) || !MB_WINDOW_MANAGER(wm) || c == wm->desktop)
     return FALSE;
@@ -3899,82 +4308,26 @@ hd_comp_mgr_is_whitelisted(MBWindowManager *wm, MBWindowManagerClient *c)
       return FALSE;
   }
 
-  whitelist = g_strdup(hd_transition_get_string("thp_tweaks", "whitelist", ""));
-  memset(&class_hint, 0, sizeof(XClassHint));
-  mb_wm_util_async_trap_x_errors (wm->xdpy);
-  ret = XGetClassHint (wm->xdpy, c->window->xwindow, &class_hint);
-  mb_wm_util_async_untrap_x_errors ();
-
-  if (ret && class_hint.res_class)
-    wname = g_strdup(class_hint.res_name);
-
-  if (class_hint.res_class)
-    XFree(class_hint.res_class);
-
-  if (class_hint.res_name)
-    XFree(class_hint.res_name);
-
-  if (g_strrstr(whitelist, wname))
-    is_on_whitelist = TRUE;
-
-  PORTRAIT ("Whitelist: WName %s; Supp: %d; Req: %d; SuppInh: %d, ReqInh: %d", wname, c->portrait_supported, c->portrait_requested, c->portrait_supported_inherited, c->portrait_requested_inherited);
+  PORTRAIT ("Whitelist: Supp: %d; Req: %d; SuppInh: %d, ReqInh: %d", c->portrait_supported, c->portrait_requested, c->portrait_supported_inherited, c->portrait_requested_inherited);
 #ifdef DEBUG_WINDOWS
   if (c->transient_for)
       PORTRAIT("Whitelist: Parent Sup: %d Req: %d", c->transient_for->portrait_supported, c->transient_for->portrait_requested);
 #endif
 
-  g_free(whitelist);
-  g_free(wname);
-
-  return is_on_whitelist;
+  return hd_comp_mgr_get_orientation_caps (wm, c, &tmp)->whitelisted;
 }
 
 gboolean
 hd_comp_mgr_is_blacklisted(MBWindowManager *wm, MBWindowManagerClient *c)
 {
-  gchar *blacklist;
-  XClassHint class_hint;
-  Status ret;
-  gchar *wname = NULL;
-  gboolean blacklisted = FALSE;
-  gboolean blacklisted_by_desktopfile = FALSE;
-  gboolean forcerotation = hd_transition_get_int("thp_tweaks", "forcerotation", 0);
+  const HdOrientationCaps *caps;
+  HdOrientationCaps tmp;
 
   if ((!c) || !HD_IS_APP (c) || !MB_WINDOW_MANAGER(wm) || c == wm->desktop)
     return FALSE;
 
-  blacklist = g_strdup (hd_transition_get_string ("thp_tweaks", "blacklist", ""));
-  memset (&class_hint, 0, sizeof (XClassHint));
-  mb_wm_util_async_trap_x_errors (wm->xdpy);
-  ret = XGetClassHint (wm->xdpy, c->window->xwindow, &class_hint);
-  mb_wm_util_async_untrap_x_errors ();
-
-  if (ret && class_hint.res_class)
-    wname = g_strdup (class_hint.res_name);
-
-  /* Check, if X-CSSU-Force-Landscape=true. */
-  blacklisted_by_desktopfile = hd_comp_mgr_is_blacklisted_parse_desktop_file (wname, class_hint.res_class, c->window->pid);
-
-  if (class_hint.res_class)
-    XFree(class_hint.res_class);
-
-  if (class_hint.res_name)
-    XFree(class_hint.res_name);
-
-  if (!blacklisted_by_desktopfile)
-    {
-      if (g_strrstr(blacklist, wname))
-        blacklisted = TRUE;
-
-      if (c->stacked_below && (wname == NULL))
-        if (hd_comp_mgr_is_blacklisted (wm, c->stacked_below))
-          blacklisted = TRUE;
-    }
-
-  g_free (blacklist);
-  g_free (wname);
-
-  if (blacklisted_by_desktopfile)
+  caps = hd_comp_mgr_get_orientation_caps (wm, c, &tmp);
+  if (caps->force_landscape)
     return TRUE;
 
   /* Do not lock to landscape a window which supports portrait mode. */
@@ -3982,10 +4335,15 @@ hd_comp_mgr_is_blacklisted(MBWindowManager *wm, MBWindowManagerClient *c)
       return FALSE;
 
   /* We don't want blacklisted windows when forcerotation == 0. */
-  if (!forcerotation)
+  if (!hd_transition_get_int("thp_tweaks", "forcerotation", 0))
     return FALSE;
 
-  return blacklisted;
+  if (caps->blacklisted)
+    return TRUE;
+
+  /* Nameless windows go with the one below. */
+  return !caps->has_name && c->stacked_below
+    && hd_comp_mgr_is_blacklisted (wm, c->stacked_below);
 }
 
 gboolean
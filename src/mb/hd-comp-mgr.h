@@ -91,6 +91,7 @@ gboolean hd_comp_mgr_client_has_video_overlay (HdCompMgrClient *hclient);
 HdRunningApp  *hd_comp_mgr_client_get_app (HdCompMgrClient *hclient);
 HdLauncherApp *hd_comp_mgr_client_get_launcher (HdCompMgrClient *hclient);
 const gchar   *hd_comp_mgr_client_get_app_local_name (HdCompMgrClient *hclient);
+ClutterActor  *hd_comp_mgr_client_get_snapshot (HdCompMgrClient *hclient);
 
 typedef struct HdCompMgrClass   HdCompMgrClass;
 typedef struct HdCompMgr        HdCompMgr;
@@ -129,6 +130,8 @@ void hd_comp_mgr_kill_all_apps       (HdCompMgr *hmgr);
 
 void hd_comp_mgr_wakeup_client       (HdCompMgr       *hmgr,
 				      HdCompMgrClient *hclient);
+void hd_comp_mgr_snapshot_app        (HdCompMgr    *hmgr,
+                                      HdRunningApp *app);
 
 void hd_comp_mgr_set_pip_flags (HdCompMgr *hmgr,
                                           gboolean enabled,
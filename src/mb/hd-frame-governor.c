@@ -0,0 +1,239 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Clients which render continuously -- live backgrounds and animation
+ * actors -- are told how many frames per second we are going to show
+ * of them through the _HILDON_FRAME_RATE CARDINAL property of their
+ * window.  It is 0 if the client can't be seen at all and reduced if
+ * it is blurred or the display is dimmed.  Damage arriving faster than
+ * that is not redrawn; the actor is redrawn when its next frame is due
+ * instead, so the latest contents are always shown eventually.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hd-frame-governor.h"
+#include "hd-comp-mgr.h"
+#include "hd-atoms.h"
+#include "hd-render-manager.h"
+#include "hd-transition.h"
+
+#include "../tidy/tidy-blur-group.h"
+
+#include <matchbox/core/mb-wm.h>
+
+#include <clutter/clutter.h>
+#include <X11/Xatom.h>
+
+/* The rate we haven't told the client yet. */
+#define HD_FRAME_GOVERNOR_UNKNOWN G_MAXUINT
+
+typedef struct
+{
+  MBWindowManagerClient *client;
+
+  /* What the client has been told. */
+  guint fps;
+
+  /* Since we last redrew the client. */
+  GTimer *since_frame;
+  /* Redraws the client when its next frame is due. */
+  guint redraw_cb;
+} HdFrameGovernorClient;
+
+extern gboolean hd_dbus_display_is_off;
+extern gboolean hd_dbus_display_is_dimmed;
+
+static GList *governed_clients;
+
+static ClutterActor *
+hd_frame_governor_get_actor (MBWindowManagerClient *client)
+{
+  if (!client->cm_client)
+    return NULL;
+  return mb_wm_comp_mgr_clutter_client_get_actor (
+                           MB_WM_COMP_MGR_CLUTTER_CLIENT (client->cm_client));
+}
+
+/* Is @actor under a blur group which is showing a blurred image? */
+static gboolean
+hd_frame_governor_is_blurred (ClutterActor *actor)
+{
+  for (actor = clutter_actor_get_parent (actor); actor;
+       actor = clutter_actor_get_parent (actor))
+    if (TIDY_IS_BLUR_GROUP (actor) && tidy_blur_group_source_buffered (actor))
+      return TRUE;
+  return FALSE;
+}
+
+static guint
+hd_frame_governor_get_budget (MBWindowManagerClient *client)
+{
+  ClutterActor *actor;
+
+  if (hd_dbus_display_is_off
+      || !(actor = hd_frame_governor_get_actor (client))
+      || !hd_render_manager_is_client_visible (client))
+    return 0;
+
+  /* We don't redraw blurred windows anyway. */
+  if (hd_frame_governor_is_blurred (actor))
+    return hd_transition_get_int ("frame_governor", "blurred_fps", 0);
+  if (hd_dbus_display_is_dimmed)
+    return hd_transition_get_int ("frame_governor", "dimmed_fps", 10);
+  return hd_transition_get_int ("frame_governor", "fps", 30);
+}
+
+static void
+hd_frame_governor_publish (HdFrameGovernorClient *gc, guint fps)
+{
+  MBWindowManager *wm = gc->client->wmref;
+  long val = fps;
+
+  if (gc->fps == fps)
+    return;
+  gc->fps = fps;
+
+  /* The window may be gone already. */
+  mb_wm_util_async_trap_x_errors (wm->xdpy);
+  XChangeProperty (wm->xdpy, gc->client->window->xwindow,
+                   hd_comp_mgr_get_atom (HD_COMP_MGR (wm->comp_mgr),
+                                         HD_ATOM_HILDON_FRAME_RATE),
+                   XA_CARDINAL, 32, PropModeReplace,
+                   (unsigned char *) &val, 1);
+  mb_wm_util_async_untrap_x_errors ();
+}
+
+static gboolean
+hd_frame_governor_redraw (HdFrameGovernorClient *gc)
+{
+  ClutterActor *actor;
+
+  gc->redraw_cb = 0;
+  if ((actor = hd_frame_governor_get_actor (gc->client)) != NULL)
+    {
+      g_timer_start (gc->since_frame);
+      clutter_actor_queue_redraw (actor);
+    }
+  return FALSE;
+}
+
+static HdFrameGovernorClient *
+hd_frame_governor_find (MBWindowManagerClient *client)
+{
+  GList *l;
+
+  for (l = governed_clients; l; l = l->next)
+    if (((HdFrameGovernorClient *) l->data)->client == client)
+      return l->data;
+  return NULL;
+}
+
+void
+hd_frame_governor_add_client (MBWindowManagerClient *client)
+{
+  HdFrameGovernorClient *gc;
+
+  if (hd_frame_governor_find (client))
+    return;
+
+  gc = g_slice_new0 (HdFrameGovernorClient);
+  gc->client = client;
+  gc->fps = HD_FRAME_GOVERNOR_UNKNOWN;
+  gc->since_frame = g_timer_new ();
+  governed_clients = g_list_prepend (governed_clients, gc);
+
+  hd_frame_governor_publish (gc, hd_frame_governor_get_budget (client));
+}
+
+void
+hd_frame_governor_remove_client (MBWindowManagerClient *client)
+{
+  HdFrameGovernorClient *gc;
+
+  if (!(gc = hd_frame_governor_find (client)))
+    return;
+
+  governed_clients = g_list_remove (governed_clients, gc);
+  if (gc->redraw_cb)
+    g_source_remove (gc->redraw_cb);
+  g_timer_destroy (gc->since_frame);
+  g_slice_free (HdFrameGovernorClient, gc);
+}
+
+void
+hd_frame_governor_update (void)
+{
+  GList *l;
+
+  for (l = governed_clients; l; l = l->next)
+    {
+      HdFrameGovernorClient *gc = l->data;
+      hd_frame_governor_publish (gc, hd_frame_governor_get_budget (gc->client));
+    }
+}
+
+gboolean
+hd_frame_governor_allow_damage (ClutterActor *actor)
+{
+  ClutterActor *parent;
+  GList *l;
+
+  if (!governed_clients)
+    return TRUE;
+
+  /* @actor is usually the texture inside the client's actor. */
+  parent = clutter_actor_get_parent (actor);
+  for (l = governed_clients; l; l = l->next)
+    {
+      HdFrameGovernorClient *gc = l->data;
+      ClutterActor *client_actor;
+      gdouble elapsed;
+
+      client_actor = hd_frame_governor_get_actor (gc->client);
+      if (!client_actor || (client_actor != actor && client_actor != parent))
+        continue;
+
+      if (gc->fps == HD_FRAME_GOVERNOR_UNKNOWN)
+        return TRUE;
+      if (!gc->fps)
+        return FALSE;
+
+      elapsed = g_timer_elapsed (gc->since_frame, NULL);
+      if (elapsed * gc->fps >= 1)
+        {
+          g_timer_start (gc->since_frame);
+          return TRUE;
+        }
+
+      /* Too early, but make sure the latest frame will be shown. */
+      if (!gc->redraw_cb)
+        gc->redraw_cb = g_timeout_add (
+                            MAX (1, (1.0 / gc->fps - elapsed) * 1000),
+                            (GSourceFunc) hd_frame_governor_redraw, gc);
+      return FALSE;
+    }
+
+  return TRUE;
+}
@@ -0,0 +1,44 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef _HAVE_HD_FRAME_GOVERNOR_H
+#define _HAVE_HD_FRAME_GOVERNOR_H
+
+#include <glib.h>
+#include <clutter/clutter-actor.h>
+#include <matchbox/core/mb-wm.h>
+
+G_BEGIN_DECLS
+
+/* Live backgrounds and animation actors are governed. */
+void     hd_frame_governor_add_client    (MBWindowManagerClient *client);
+void     hd_frame_governor_remove_client (MBWindowManagerClient *client);
+
+/* Recalculates the frame rates; call it when visibilities, blurring
+ * or the display state change. */
+void     hd_frame_governor_update        (void);
+
+/* Whether the damage of @actor should be shown. */
+gboolean hd_frame_governor_allow_damage  (ClutterActor *actor);
+
+G_END_DECLS
+
+#endif
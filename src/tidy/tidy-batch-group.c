@@ -0,0 +1,102 @@
+/*
+ * A ClutterGroup which draws its #TidySubTexture children together.
+ * Consecutive children using the same texture are drawn with a single
+ * call, which is what frames pieced together from theme images in the
+ * same atlas page are.  Children it can't batch - other kinds of actors,
+ * and sub-textures which are scaled, rotated or clipped - are painted as
+ * usual after drawing what's been batched before them, so the result is
+ * the same as ClutterGroup's.
+ */
+
+#include "tidy-batch-group.h"
+#include "tidy-quad-batch.h"
+#include "tidy-sub-texture.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <clutter/clutter-container.h>
+
+#include <cogl/cogl.h>
+
+G_DEFINE_TYPE (TidyBatchGroup,
+               tidy_batch_group,
+               CLUTTER_TYPE_GROUP);
+
+/* Returns where @child is in our coordinate space, if it's only
+ * translated. */
+static gboolean
+tidy_batch_group_child_origin (ClutterActor *child,
+                               ClutterFixed *x, ClutterFixed *y)
+{
+  ClutterActorBox box;
+  ClutterUnit anchor_x, anchor_y;
+  ClutterFixed scale_x, scale_y;
+
+  if (clutter_actor_has_clip (child) || clutter_actor_get_depthu (child))
+    return FALSE;
+
+  clutter_actor_get_scalex (child, &scale_x, &scale_y);
+  if (scale_x != CFX_ONE || scale_y != CFX_ONE)
+    return FALSE;
+
+  if (clutter_actor_get_rotationx (child, CLUTTER_X_AXIS, NULL, NULL, NULL)
+      || clutter_actor_get_rotationx (child, CLUTTER_Y_AXIS, NULL, NULL, NULL)
+      || clutter_actor_get_rotationx (child, CLUTTER_Z_AXIS, NULL, NULL, NULL))
+    return FALSE;
+
+  clutter_actor_get_allocation_box (child, &box);
+  clutter_actor_get_anchor_pointu (child, &anchor_x, &anchor_y);
+  *x = CLUTTER_UNITS_TO_FIXED (box.x1 - anchor_x);
+  *y = CLUTTER_UNITS_TO_FIXED (box.y1 - anchor_y);
+
+  return TRUE;
+}
+
+static void
+tidy_batch_group_paint_child (ClutterActor *child, gpointer unused)
+{
+  ClutterFixed x, y;
+
+  if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+    return;
+
+  if (TIDY_IS_SUB_TEXTURE (child)
+      && tidy_batch_group_child_origin (child, &x, &y))
+    tidy_sub_texture_paint_batched (TIDY_SUB_TEXTURE (child), x, y);
+  else
+    {
+      tidy_quad_batch_flush ();
+      clutter_actor_paint (child);
+    }
+}
+
+static void
+tidy_batch_group_paint (ClutterActor *actor)
+{
+  clutter_container_foreach (CLUTTER_CONTAINER (actor),
+                             tidy_batch_group_paint_child, NULL);
+  tidy_quad_batch_flush ();
+}
+
+static void
+tidy_batch_group_class_init (TidyBatchGroupClass *klass)
+{
+  ClutterActorClass *actor_class = CLUTTER_ACTOR_CLASS (klass);
+
+  /* ClutterGroup picks its children by calling its own paint directly,
+   * so picking is not affected. */
+  actor_class->paint = tidy_batch_group_paint;
+}
+
+static void
+tidy_batch_group_init (TidyBatchGroup *self)
+{
+}
+
+ClutterActor *
+tidy_batch_group_new (void)
+{
+  return g_object_new (TIDY_TYPE_BATCH_GROUP, NULL);
+}
@@ -0,0 +1,38 @@
+#ifndef TIDYBATCHGROUP_H_
+#define TIDYBATCHGROUP_H_
+
+#include <clutter/clutter-group.h>
+#include <clutter/clutter-types.h>
+
+G_BEGIN_DECLS
+
+#define TIDY_TYPE_BATCH_GROUP                  (tidy_batch_group_get_type ())
+#define TIDY_BATCH_GROUP(obj)                (G_TYPE_CHECK_INSTANCE_CAST ((obj), TIDY_TYPE_BATCH_GROUP, TidyBatchGroup))
+#define TIDY_IS_BATCH_GROUP(obj)             (G_TYPE_CHECK_INSTANCE_TYPE ((obj), TIDY_TYPE_BATCH_GROUP))
+#define TIDY_BATCH_GROUP_CLASS(klass)        (G_TYPE_CHECK_CLASS_CAST ((klass), TIDY_TYPE_BATCH_GROUP, TidyBatchGroupClass))
+#define TIDY_IS_BATCH_GROUP_CLASS(klass)     (G_TYPE_CHECK_CLASS_TYPE ((klass), TIDY_TYPE_BATCH_GROUP))
+#define TIDY_BATCH_GROUP_GET_CLASS(obj)      (G_TYPE_INSTANCE_GET_CLASS ((obj), TIDY_TYPE_BATCH_GROUP, TidyBatchGroupClass))
+
+
+typedef struct _TidyBatchGroup         TidyBatchGroup;
+typedef struct _TidyBatchGroupClass    TidyBatchGroupClass;
+
+struct _TidyBatchGroup
+{
+  ClutterGroup          parent;
+};
+
+struct _TidyBatchGroupClass
+{
+  ClutterGroupClass parent_class;
+};
+
+
+GType tidy_batch_group_get_type (void) G_GNUC_CONST;
+ClutterActor *tidy_batch_group_new (void);
+
+
+G_END_DECLS
+
+
+#endif /*TIDYBATCHGROUP_H_*/
@@ -4,10 +4,15 @@
  * It renders its children into a half-size texture first, then blurs this into
  * another texture, finally rendering that to the screen. Because of this, when
  * the blurring doesn't change from frame to frame, children and NOT rendered,
- * making this pretty quick. */
+ * making this pretty quick.
+ *
+ * If it's told it will be blurred heavily it renders into a quarter-size
+ * texture instead, and blurs it with fewer steps.  The textures are kept
+ * for each resolution and orientation once they're made. */
 
 #include "tidy-blur-group.h"
 #include "tidy-util.h"
+#include "tidy-shader-cache.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -18,23 +23,17 @@
 #include <cogl/cogl.h>
 
 #include <string.h>
-#include <locale.h>
 
 #include "util/hd-transition.h"
 
 /* #define it something sane */
 #define TIDY_IS_SANE_BLUR_GROUP(obj)    ((obj) != NULL)
 
-/* This destroys and re-allocates the texture if the actor size changes
- * (eg. screen rotation). We may not want to do this as it takes some time. */
-#define RESIZE_TEXTURE 0
-
-/* This fixes the bug where the SGX GLSL compiler uses the current locale for
- * numbers - so '1.0' in a shader will not work when the locale says that ','
- * is a decimal separator.
- */
-#define GLSL_LOCALE_FIX 1
-
+/* The factors we may downsample the children by, see
+ * tidy_blur_group_set_target_blur().  The number of blur steps is
+ * calibrated for %TIDY_BLUR_GROUP_DEFAULT_DOWNSAMPLE. */
+static const guint Downsamples[] = { 1, 2, 4 };
+#define TIDY_BLUR_GROUP_DEFAULT_DOWNSAMPLE 1 /* index in Downsamples */
 
 #define VIGNETTE_TILES 7
 #define VIGNETTE_COLOURS ((VIGNETTE_TILES)/2 + 1)
@@ -139,10 +138,20 @@ struct _TidyBlurGroupPrivate
   /* Internal TidyBlurGroup stuff */
   ClutterShader *shader_blur;
   ClutterShader *shader_saturate;
+  /* The textures we're blurring with now, from @targets. */
   CoglHandle tex_a;
   CoglHandle fbo_a;
   CoglHandle tex_b;
   CoglHandle fbo_b;
+  /* Textures for each downsampling factor and landscape/portrait,
+   * made when they are first needed. */
+  struct
+  {
+    CoglHandle tex_a, fbo_a, tex_b, fbo_b;
+  } targets[G_N_ELEMENTS (Downsamples)][2];
+  /* Index of the current downsampling factor in @Downsamples and of
+   * the one to switch to the next time we're not blurred. */
+  guint downsample, next_downsample;
   CoglHandle tex_chequer; /* chequer texture used for dimming video overlays */
   gboolean current_is_a;
   gboolean current_is_rotated;
@@ -156,6 +165,8 @@ struct _TidyBlurGroupPrivate
   gboolean chequer; /* whether to chequer pattern the contents -
                        for dimming video overlays */
 
+  /* What tidy_blur_group_set_blur() was last called with. */
+  float blur;
   int blur_step;
   int current_blur_step;
   int max_blur_step;
@@ -212,42 +223,40 @@ static void tidy_blur_group_check_shader(TidyBlurGroup *group,
   TidyBlurGroupPrivate *priv = group->priv;
 
   if (priv->use_shader && !*shader)
-   {
-     GError *error = NULL;
-     char   *old_locale;
-
-#if GLSL_LOCALE_FIX
-      old_locale = g_strdup (setlocale (LC_ALL, NULL));
-      setlocale (LC_NUMERIC, "C");
-#endif
-
-      *shader = clutter_shader_new();
-      if (fragment_source)
-        clutter_shader_set_fragment_source (*shader, fragment_source, -1);
-      if (vertex_source)
-        clutter_shader_set_vertex_source (*shader, vertex_source, -1);
-      clutter_shader_compile (*shader, &error);
-
-      if (error)
-      {
-        g_warning ("unable to load shader: %s\n", error->message);
-        g_error_free (error);
+    {
+      *shader = tidy_shader_cache_get (fragment_source, vertex_source);
+      if (!*shader)
         priv->use_shader = FALSE;
-      }
+    }
+}
 
-#if GLSL_LOCALE_FIX
-      setlocale (LC_ALL, old_locale);
-      g_free (old_locale);
-#endif
-   }
+/* Free all @priv->targets. */
+static void
+tidy_blur_group_free_textures (TidyBlurGroup *self)
+{
+  TidyBlurGroupPrivate *priv = self->priv;
+  guint i, portrait;
+
+  for (i = 0; i < G_N_ELEMENTS (priv->targets); i++)
+    for (portrait = 0; portrait < 2; portrait++)
+      if (priv->targets[i][portrait].fbo_a)
+        {
+          cogl_offscreen_unref(priv->targets[i][portrait].fbo_a);
+          cogl_texture_unref(priv->targets[i][portrait].tex_a);
+          cogl_offscreen_unref(priv->targets[i][portrait].fbo_b);
+          cogl_texture_unref(priv->targets[i][portrait].tex_b);
+        }
+  memset (priv->targets, 0, sizeof (priv->targets));
+  priv->tex_a = priv->fbo_a = priv->tex_b = priv->fbo_b = 0;
 }
 
-/* Allocate @priv->fbo_[ab]. */
+/* Make @priv->fbo_[ab] those of the current downsampling factor
+ * and orientation, allocating them if we haven't had them yet. */
 static void
 tidy_blur_group_allocate_textures (TidyBlurGroup *self)
 {
   TidyBlurGroupPrivate *priv = self->priv;
-  guint tex_width, tex_height;
+  guint tex_width, tex_height, portrait;
 
 #ifdef __i386__
   if (!cogl_features_available(COGL_FEATURE_OFFSCREEN))
@@ -255,58 +264,88 @@ tidy_blur_group_allocate_textures (TidyBlurGroup *self)
     return;
 #endif
 
-#if !RESIZE_TEXTURE
-  if (priv->fbo_a && priv->fbo_b)
-    /* Rotate in _paint() rather than resize. */
-    return;
-#endif
-
-  /* Free the textures. */
-  if (priv->fbo_a)
-    {
-      cogl_offscreen_unref(priv->fbo_a);
-      cogl_texture_unref(priv->tex_a);
-      priv->fbo_a = 0;
-      priv->tex_a = 0;
-    }
-  if (priv->fbo_b)
-    {
-      cogl_offscreen_unref(priv->fbo_b);
-      cogl_texture_unref(priv->tex_b);
-      priv->fbo_b = 0;
-      priv->tex_b = 0;
-    }
-
-  /* (Re)create the textures + offscreen buffers.  Downsample by 2.
-   * We can specify mipmapping here, but we don't need it. */
   clutter_actor_get_size(CLUTTER_ACTOR(self), &tex_width, &tex_height);
+  if (!tex_width || !tex_height)
+    return;
+  portrait = tex_width < tex_height;
 
-  /* if we want blurless desaturation, don't downsample (downsampling
-   * makes the image look a bit blurry even with blurring disabled) */
-  if (!priv->tweaks_blurless)
+  if (!priv->targets[priv->downsample][portrait].fbo_a)
     {
-      tex_width  /= 2;
-      tex_height /= 2;
-    }
+      /* Create the textures + offscreen buffers.
+       * We can specify mipmapping here, but we don't need it. */
+      tex_width  /= Downsamples[priv->downsample];
+      tex_height /= Downsamples[priv->downsample];
 
-  priv->tex_a = cogl_texture_new_with_size(
+      priv->targets[priv->downsample][portrait].tex_a =
+        cogl_texture_new_with_size(
             tex_width, tex_height, 0, FALSE /* mipmap */,
             priv->use_alpha ? COGL_PIXEL_FORMAT_RGBA_8888 :
                               COGL_PIXEL_FORMAT_RGB_565);
-  cogl_texture_set_filters(priv->tex_a, CGL_NEAREST, CGL_NEAREST);
-  priv->fbo_a = cogl_offscreen_new_to_texture(priv->tex_a);
-
-  priv->tex_b = cogl_texture_new_with_size(
+      priv->targets[priv->downsample][portrait].tex_b =
+        cogl_texture_new_with_size(
             tex_width, tex_height, 0, FALSE /* mipmap */,
             priv->use_alpha ? COGL_PIXEL_FORMAT_RGBA_8888 :
                               COGL_PIXEL_FORMAT_RGB_565);
-  cogl_texture_set_filters(priv->tex_b, CGL_NEAREST, CGL_NEAREST);
-  priv->fbo_b = cogl_offscreen_new_to_texture(priv->tex_b);
+      cogl_texture_set_filters(priv->targets[priv->downsample][portrait].tex_a,
+                               CGL_NEAREST, CGL_NEAREST);
+      cogl_texture_set_filters(priv->targets[priv->downsample][portrait].tex_b,
+                               CGL_NEAREST, CGL_NEAREST);
+      priv->targets[priv->downsample][portrait].fbo_a =
+        cogl_offscreen_new_to_texture(
+                          priv->targets[priv->downsample][portrait].tex_a);
+      priv->targets[priv->downsample][portrait].fbo_b =
+        cogl_offscreen_new_to_texture(
+                          priv->targets[priv->downsample][portrait].tex_b);
+    }
+
+  if (priv->fbo_a == priv->targets[priv->downsample][portrait].fbo_a)
+    return;
+
+  priv->tex_a = priv->targets[priv->downsample][portrait].tex_a;
+  priv->fbo_a = priv->targets[priv->downsample][portrait].fbo_a;
+  priv->tex_b = priv->targets[priv->downsample][portrait].tex_b;
+  priv->fbo_b = priv->targets[priv->downsample][portrait].fbo_b;
 
   priv->current_blur_step = 0;
   priv->source_changed = TRUE;
 }
 
+/* Translate @priv->blur to the number of blur steps at the current
+ * downsampling factor.  A step spreads the image by a texel, so its
+ * variance grows with the square of the factor.  Blurless groups never
+ * downsample, so @priv->blur is already their number of steps. */
+static gint
+tidy_blur_group_blur_steps (TidyBlurGroupPrivate *priv)
+{
+  guint base, factor;
+  gint step;
+
+  base   = Downsamples[TIDY_BLUR_GROUP_DEFAULT_DOWNSAMPLE];
+  factor = priv->tweaks_blurless ? base : Downsamples[priv->downsample];
+  step = (gint)(priv->blur * (base*base) / (factor*factor) + 0.5f);
+
+  /* Don't set step to be 0 if blur isn't. This fixes the case where
+   * saturation!=0 but blur is, and blur is needlessly recalculated */
+  if (step==0 && priv->blur!=0)
+    step = 1;
+  return step;
+}
+
+/* Switch to @priv->next_downsample if it's different.  Only to be
+ * called while we're not blurred, because it throws away the blur. */
+static void
+tidy_blur_group_apply_downsample (TidyBlurGroup *self)
+{
+  TidyBlurGroupPrivate *priv = self->priv;
+
+  if (priv->downsample == priv->next_downsample)
+    return;
+
+  priv->downsample = priv->next_downsample;
+  if (priv->fbo_a)
+    tidy_blur_group_allocate_textures (self);
+}
+
 static gboolean
 tidy_blur_group_children_visible(ClutterGroup *group)
 {
@@ -849,20 +888,7 @@ tidy_blur_group_dispose (GObject *gobject)
   TidyBlurGroup *container = TIDY_BLUR_GROUP(gobject);
   TidyBlurGroupPrivate *priv = container->priv;
 
-  if (priv->fbo_a)
-    {
-      cogl_offscreen_unref(priv->fbo_a);
-      cogl_texture_unref(priv->tex_a);
-      priv->fbo_a = 0;
-      priv->tex_a = 0;
-    }
-  if (priv->fbo_b)
-    {
-      cogl_offscreen_unref(priv->fbo_b);
-      cogl_texture_unref(priv->tex_b);
-      priv->fbo_b = 0;
-      priv->tex_b = 0;
-    }
+  tidy_blur_group_free_textures(container);
   if (priv->tex_chequer)
     {
       cogl_texture_unref(priv->tex_chequer);
@@ -898,6 +924,7 @@ tidy_blur_group_init (TidyBlurGroup *self)
   priv = self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
                                                    TIDY_TYPE_BLUR_GROUP,
                                                    TidyBlurGroupPrivate);
+  priv->blur = 0;
   priv->blur_step = 0;
   priv->current_blur_step = 0;
   priv->max_blur_step = 0;
@@ -909,6 +936,10 @@ tidy_blur_group_init (TidyBlurGroup *self)
   priv->source_changed = TRUE;
   priv->tweaks_blurless = hd_transition_get_int("thp_tweaks", "blurless", 0);
   priv->blurless_saturation = hd_transition_get_double("thp_tweaks", "blurless_saturation", 0);
+  /* if we want blurless desaturation, don't downsample (downsampling
+   * makes the image look a bit blurry even with blurring disabled) */
+  priv->downsample = priv->next_downsample = priv->tweaks_blurless
+    ? 0 : TIDY_BLUR_GROUP_DEFAULT_DOWNSAMPLE;
 
 #if CLUTTER_COGL_HAS_GLES
   priv->use_shader = cogl_features_available(COGL_FEATURE_SHADERS_GLSL);
@@ -922,6 +953,7 @@ tidy_blur_group_init (TidyBlurGroup *self)
   priv->fbo_a = 0;
   priv->tex_b = 0;
   priv->fbo_b = 0;
+  memset (priv->targets, 0, sizeof (priv->targets));
   priv->current_is_a = TRUE;
   priv->current_is_rotated = FALSE;
   /* dimming for the vignette */
@@ -1017,17 +1049,19 @@ void tidy_blur_group_set_chequer(ClutterActor *blur_group, gboolean chequer)
 void tidy_blur_group_set_blur(ClutterActor *blur_group, float blur)
 {
   TidyBlurGroupPrivate *priv;
-  gint step = (int)blur;
-  /* Don't set step to be 0 if blur isn't. This fixes the case where
-   * saturation!=0 but blur is, and blur is needlessly recalculated */
-  if (step==0 && blur!=0)
-    step = 1;
+  gint step;
 
   if (!TIDY_IS_SANE_BLUR_GROUP(blur_group))
     return;
 
   priv = TIDY_BLUR_GROUP(blur_group)->priv;
 
+  /* If we're not blurred now it's the time to change the resolution. */
+  if (blur == 0)
+    tidy_blur_group_apply_downsample(TIDY_BLUR_GROUP(blur_group));
+  priv->blur = blur;
+  step = tidy_blur_group_blur_steps(priv);
+
   if (priv->blur_step != step)
     {
       priv->blur_step = step;
@@ -1140,7 +1174,42 @@ void tidy_blur_group_set_use_alpha(ClutterActor *blur_group, gboolean alpha)
 
   priv = TIDY_BLUR_GROUP(blur_group)->priv;
 
-  priv->use_alpha = alpha;
+  if (priv->use_alpha != alpha)
+    {
+      /* The textures need a different format. */
+      tidy_blur_group_free_textures(TIDY_BLUR_GROUP(blur_group));
+      priv->use_alpha = alpha;
+      tidy_blur_group_allocate_textures(TIDY_BLUR_GROUP(blur_group));
+    }
+}
+
+/**
+ * tidy_blur_group_set_target_blur:
+ *
+ * Tells the group how much it's going to be blurred in the current state,
+ * so it can choose the resolution to blur at.  A blur of at least
+ * [blur] quarter_res_radius is done at quarter resolution, anything less
+ * at half.  If the group is blurred at the moment the change only takes
+ * effect when it's next unblurred, not to throw away what it's showing.
+ */
+void tidy_blur_group_set_target_blur(ClutterActor *blur_group, float blur)
+{
+  TidyBlurGroupPrivate *priv;
+  gint quarter;
+
+  if (!TIDY_IS_SANE_BLUR_GROUP(blur_group))
+    return;
+
+  priv = TIDY_BLUR_GROUP(blur_group)->priv;
+  if (priv->tweaks_blurless)
+    return;
+
+  quarter = hd_transition_get_int("blur", "quarter_res_radius", 16);
+  priv->next_downsample = quarter > 0 && blur >= quarter
+    ? TIDY_BLUR_GROUP_DEFAULT_DOWNSAMPLE+1
+    : TIDY_BLUR_GROUP_DEFAULT_DOWNSAMPLE;
+  if (priv->blur_step == 0)
+    tidy_blur_group_apply_downsample(TIDY_BLUR_GROUP(blur_group));
 }
 
 /**
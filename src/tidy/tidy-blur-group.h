@@ -38,6 +38,7 @@ ClutterActor *tidy_blur_group_new (void);
 
 void tidy_blur_group_set_chequer(ClutterActor *blur_group, gboolean chequer);
 void tidy_blur_group_set_blur(ClutterActor *blur_group, float blur);
+void tidy_blur_group_set_target_blur(ClutterActor *blur_group, float blur);
 void tidy_blur_group_set_saturation(ClutterActor *blur_group, float saturation);
 void tidy_blur_group_set_brightness(ClutterActor *blur_group, float brightness);
 void tidy_blur_group_set_zoom(ClutterActor *blur_group, float zoom);
@@ -12,6 +12,7 @@
 #endif
 
 #include <clutter/clutter-container.h>
+#include <clutter/clutter-texture.h>
 
 #include <cogl/cogl.h>
 
@@ -36,12 +37,67 @@ struct _TidyCachedGroupPrivate
   gboolean source_changed;
   /* how much quality loss you can afford when rendering cached texture */
   float downsample;
+  /* whether a redraw of any of our children makes the cache stale,
+   * like in blur groups, or only tidy_cached_group_changed() does */
+  gboolean auto_update;
+
+  /* Number of times the cache was painted as it was and how many times
+   * it had to be rendered again, see tidy_cached_group_get_stats(). */
+  guint hits, misses;
 };
 
 G_DEFINE_TYPE (TidyCachedGroup,
                tidy_cached_group,
                CLUTTER_TYPE_GROUP);
 
+/* When the cached group's children are modified we need to
+   re-paint to the cache if we're asked to. When it is only us that
+   has been modified child==NULL */
+static gboolean
+tidy_cached_group_notify_modified_real(ClutterActor          *actor,
+                                       ClutterActor          *child)
+{
+  TidyCachedGroupPrivate *priv;
+
+  if (!TIDY_IS_CACHED_GROUP(actor))
+    return TRUE;
+
+  priv = TIDY_CACHED_GROUP(actor)->priv;
+  if (child != NULL && priv->auto_update)
+    priv->source_changed = TRUE;
+  return TRUE;
+}
+
+/* With an alpha channel the cache is kept premultiplied: the children
+ * accumulate coverage in its alpha channel rather than its square, and
+ * it is painted with GL_ONE.  glBlendFuncSeparate() is core in GLES 2
+ * but only in GL 1.4 on the desktop, so look it up there.  Without it
+ * alpha caches are not used at all. */
+typedef void (*TidyBlendFuncSeparate) (GLenum src_rgb, GLenum dst_rgb,
+                                       GLenum src_alpha, GLenum dst_alpha);
+
+static TidyBlendFuncSeparate
+tidy_cached_group_get_blend_func_separate (void)
+{
+#if CLUTTER_COGL_HAS_GLES
+  return glBlendFuncSeparate;
+#else
+  static gboolean looked_up;
+  static TidyBlendFuncSeparate func;
+
+  if (!looked_up)
+    {
+      looked_up = TRUE;
+      func = (TidyBlendFuncSeparate)
+        cogl_get_proc_address ("glBlendFuncSeparate");
+      if (!func)
+        func = (TidyBlendFuncSeparate)
+          cogl_get_proc_address ("glBlendFuncSeparateEXT");
+    }
+  return func;
+#endif
+}
+
 /* An implementation for the ClutterGroup::paint() vfunc,
    painting all the child actors: */
 static void
@@ -49,9 +105,11 @@ tidy_cached_group_paint (ClutterActor *actor)
 {
   ClutterColor    white = { 0xff, 0xff, 0xff, 0xff };
   ClutterColor    bgcol = { 0x00, 0x00, 0x00, 0xff };
+  ClutterColor    nocol = { 0x00, 0x00, 0x00, 0x00 };
   ClutterColor    col = { 0xff, 0xff, 0xff, 0xff };
   gint            x_1, y_1, x_2, y_2;
   gboolean        rotate_90;
+  TidyBlendFuncSeparate blend_func_separate;
 
   if (!TIDY_IS_CACHED_GROUP(actor))
     return;
@@ -75,6 +133,13 @@ tidy_cached_group_paint (ClutterActor *actor)
       return;
     }
 
+  blend_func_separate = tidy_cached_group_get_blend_func_separate ();
+  if (priv->use_alpha && !blend_func_separate)
+    { /* We couldn't keep the cache premultiplied. */
+      CLUTTER_ACTOR_CLASS (tidy_cached_group_parent_class)->paint(actor);
+      return;
+    }
+
 #ifdef __i386__
   if (!cogl_features_available(COGL_FEATURE_OFFSCREEN))
     { /* If we can't render offscreen properly, just render normally. */
@@ -132,8 +197,11 @@ tidy_cached_group_paint (ClutterActor *actor)
     }
 
   /* Draw children into an offscreen buffer */
-  if (priv->source_changed)
+  if (!priv->source_changed)
+    priv->hits++;
+  else
     {
+      priv->misses++;
       cogl_push_matrix();
       tidy_util_cogl_push_offscreen_buffer(priv->fbo);
       /* translate a bit to let bilinear filter smooth out intermediate pixels */
@@ -147,9 +215,16 @@ tidy_cached_group_paint (ClutterActor *actor)
         cogl_scale(CFX_ONE*tex_width/width, CFX_ONE*tex_height/height);
       }
 
-      cogl_paint_init(&bgcol);
+      cogl_paint_init(priv->use_alpha ? &nocol : &bgcol);
       cogl_color (&white);
+      /* Accumulate coverage in the alpha channel rather than its square,
+       * which leaves the colours premultiplied. */
+      if (priv->use_alpha)
+        blend_func_separate (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+                             GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
       CLUTTER_ACTOR_CLASS (tidy_cached_group_parent_class)->paint(actor);
+      if (priv->use_alpha)
+        glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
       tidy_util_cogl_pop_offscreen_buffer();
       cogl_pop_matrix();
@@ -174,6 +249,11 @@ tidy_cached_group_paint (ClutterActor *actor)
     }
 
   /* Now we render the image we have... */
+  if (priv->use_alpha)
+    { /* ...which is premultiplied, so the opacity goes to every channel. */
+      col.red = col.green = col.blue = col.alpha;
+      glBlendFunc (GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    }
   cogl_color (&col);
 
   if (rotate_90)
@@ -189,6 +269,8 @@ tidy_cached_group_paint (ClutterActor *actor)
                           CLUTTER_INT_TO_FIXED (width),
                           CLUTTER_INT_TO_FIXED (height),
                           0, 0, CFX_ONE, CFX_ONE);
+  if (priv->use_alpha)
+    glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   if (rotate_90)
     {
       cogl_pop_matrix();
@@ -198,16 +280,7 @@ tidy_cached_group_paint (ClutterActor *actor)
 static void
 tidy_cached_group_dispose (GObject *gobject)
 {
-  TidyCachedGroup *container = TIDY_CACHED_GROUP(gobject);
-  TidyCachedGroupPrivate *priv = container->priv;
-
-  if (priv->fbo)
-    {
-      cogl_offscreen_unref(priv->fbo);
-      cogl_texture_unref(priv->tex);
-      priv->fbo = 0;
-      priv->tex = 0;
-    }
+  tidy_cached_group_free_cache(CLUTTER_ACTOR(gobject));
 
   G_OBJECT_CLASS (tidy_cached_group_parent_class)->dispose (gobject);
 }
@@ -224,6 +297,7 @@ tidy_cached_group_class_init (TidyCachedGroupClass *klass)
 
   /* Provide implementations for ClutterActor vfuncs: */
   actor_class->paint = tidy_cached_group_paint;
+  actor_class->notify_modified = tidy_cached_group_notify_modified_real;
 }
 
 static void
@@ -238,6 +312,7 @@ tidy_cached_group_init (TidyCachedGroup *self)
   priv->downsample = TIDY_CACHED_GROUP_DEFAULT_DOWNSAMPLING;
   priv->use_alpha = FALSE;
   priv->source_changed = TRUE;
+  priv->auto_update = FALSE;
 
   priv->tex = 0;
   priv->fbo = 0;
@@ -310,4 +385,110 @@ void tidy_cached_group_changed(ClutterActor *cached_group)
   priv->source_changed = TRUE;
 }
 
+/**
+ * Sets whether to update the cache whenever one of the children is
+ * redrawn.  Otherwise it's only updated by tidy_cached_group_changed().
+ */
+void tidy_cached_group_set_auto_update(ClutterActor *cached_group,
+                                       gboolean auto_update)
+{
+  if (!TIDY_IS_CACHED_GROUP(cached_group))
+    return;
+
+  TIDY_CACHED_GROUP(cached_group)->priv->auto_update = auto_update;
+}
+
+/**
+ * Sets whether to use an alpha channel in the cache.  Only useful if
+ * we're caching something transparent.
+ */
+void tidy_cached_group_set_use_alpha(ClutterActor *cached_group,
+                                     gboolean alpha)
+{
+  TidyCachedGroupPrivate *priv;
+
+  if (!TIDY_IS_CACHED_GROUP(cached_group))
+    return;
+
+  priv = TIDY_CACHED_GROUP(cached_group)->priv;
+  if (priv->use_alpha != alpha)
+    {
+      /* The texture needs a different format. */
+      tidy_cached_group_free_cache(cached_group);
+      priv->use_alpha = alpha;
+    }
+}
+
+/**
+ * Returns how many times @cached_group was painted from its cache
+ * as it was (@hits) and how many times it had to render its children
+ * into the cache first (@misses).
+ */
+void tidy_cached_group_get_stats(ClutterActor *cached_group,
+                                 guint *hits, guint *misses)
+{
+  TidyCachedGroupPrivate *priv;
+
+  *hits = *misses = 0;
+  if (!TIDY_IS_CACHED_GROUP(cached_group))
+    return;
+
+  priv = TIDY_CACHED_GROUP(cached_group)->priv;
+  *hits   = priv->hits;
+  *misses = priv->misses;
+}
+
+/**
+ * Frees the texture the group is cached in.  It's recreated when the
+ * group is painted cached again.
+ */
+void tidy_cached_group_free_cache(ClutterActor *cached_group)
+{
+  TidyCachedGroupPrivate *priv;
+
+  if (!TIDY_IS_CACHED_GROUP(cached_group))
+    return;
+
+  priv = TIDY_CACHED_GROUP(cached_group)->priv;
+  if (priv->fbo)
+    {
+      cogl_offscreen_unref(priv->fbo);
+      cogl_texture_unref(priv->tex);
+      priv->fbo = 0;
+      priv->tex = 0;
+    }
+  priv->source_changed = TRUE;
+}
+
+
+
+/**
+ * Returns a new #ClutterTexture showing what @cached_group has cached,
+ * or %NULL if there's nothing usable.  The texture is handed over to
+ * the snapshot, so it stays the same whatever happens to the group,
+ * which makes itself a new one when it's painted cached again.
+ */
+ClutterActor *tidy_cached_group_get_snapshot(ClutterActor *cached_group)
+{
+  TidyCachedGroupPrivate *priv;
+  ClutterActor *snapshot;
+
+  if (!TIDY_IS_CACHED_GROUP(cached_group))
+    return NULL;
+
+  priv = TIDY_CACHED_GROUP(cached_group)->priv;
+  /* Don't bother with the aspect ratio if it was painted rotated. */
+  if (!priv->tex || priv->rotated)
+    return NULL;
+
+  snapshot = clutter_texture_new();
+  clutter_texture_set_cogl_texture(CLUTTER_TEXTURE(snapshot), priv->tex);
+
+  cogl_offscreen_unref(priv->fbo);
+  cogl_texture_unref(priv->tex);
+  priv->fbo = 0;
+  priv->tex = 0;
+  priv->source_changed = TRUE;
 
+  return snapshot;
+}
@@ -38,6 +38,14 @@ void tidy_cached_group_set_render_cache(ClutterActor *cached_group, float amount
 void tidy_cached_group_set_downsampling_factor(ClutterActor *cached_group,
                                                float downsample);
 void tidy_cached_group_changed(ClutterActor *cached_group);
+void tidy_cached_group_set_auto_update(ClutterActor *cached_group,
+                                       gboolean auto_update);
+void tidy_cached_group_set_use_alpha(ClutterActor *cached_group,
+                                     gboolean alpha);
+void tidy_cached_group_get_stats(ClutterActor *cached_group,
+                                 guint *hits, guint *misses);
+void tidy_cached_group_free_cache(ClutterActor *cached_group);
+ClutterActor *tidy_cached_group_get_snapshot(ClutterActor *cached_group);
 
 
 G_END_DECLS
@@ -2,13 +2,19 @@
  * Copyright (C) 2012 Tomasz Pieniążek <t.pieniazek@gazeta.pl>
  * Based on tidy-blur-group.c by Gordon Williams <gordon.williams@collabora.co.uk>
  *
- * This class desaturates all of its children. It renders its children into a 
- * half-size texture first, then desaturates this into  another texture, 
- * finally rendering that to the screen. 
+ * This class desaturates all of its children. It renders its children into a
+ * texture the size the group is shown at on the screen, then renders that to
+ * the screen with a desaturating shader.
+ *
+ * The texture is only held while the group is desaturated, and it comes
+ * from the pool of tidy-render-target.c, so an undesaturated group costs
+ * nothing more than a #ClutterGroup.
  */
 
 #include "tidy-desaturation-group.h"
 #include "tidy-util.h"
+#include "tidy-render-target.h"
+#include "tidy-shader-cache.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -19,19 +25,12 @@
 #include <cogl/cogl.h>
 
 #include <string.h>
-#include <locale.h>
 
 #include "util/hd-transition.h"
 
 /* #define it something sane */
 #define TIDY_IS_SANE_DESATURATION_GROUP(obj)    ((obj) != NULL)
 
-/* This fixes the bug where the SGX GLSL compiler uses the current locale for
- * numbers - so '1.0' in a shader will not work when the locale says that ','
- * is a decimal separator.
- */
-#define GLSL_LOCALE_FIX 1
-
 /* The OpenGL fragment shader used to do desaturation. */
 #if CLUTTER_COGL_HAS_GLES
 const char *DESATURATE_VERTEX_SHADER =
@@ -89,8 +88,11 @@ struct _TidyDesaturationGroupPrivate
 {
   /* Internal TidyDesaturationGroup stuff */
   ClutterShader *shader_saturate;
-  CoglHandle tex_a;
-  CoglHandle fbo_a;
+  /* What we render our children into, or %NULL if we're not
+   * desaturated or haven't painted since. */
+  TidyRenderTarget *target;
+  /* The size the children were rendered at into @target. */
+  guint render_width, render_height;
 
   gboolean use_shader;
   gboolean undo_desaturation;
@@ -144,69 +146,32 @@ static void tidy_desaturation_group_check_shader(TidyDesaturationGroup *group,
   TidyDesaturationGroupPrivate *priv = group->priv;
 
   if (priv->use_shader && !*shader)
-   {
-     GError *error = NULL;
-     char   *old_locale;
-
-#if GLSL_LOCALE_FIX
-      old_locale = g_strdup (setlocale (LC_ALL, NULL));
-      setlocale (LC_NUMERIC, "C");
-#endif
-
-      *shader = clutter_shader_new();
-      if (fragment_source)
-        clutter_shader_set_fragment_source (*shader, fragment_source, -1);
-      if (vertex_source)
-        clutter_shader_set_vertex_source (*shader, vertex_source, -1);
-      clutter_shader_compile (*shader, &error);
-
-      if (error)
-      {
-        g_warning ("unable to load shader: %s\n", error->message);
-        g_error_free (error);
+    {
+      *shader = tidy_shader_cache_get (fragment_source, vertex_source);
+      if (!*shader)
         priv->use_shader = FALSE;
-      }
-
-#if GLSL_LOCALE_FIX
-      setlocale (LC_ALL, old_locale);
-      g_free (old_locale);
-#endif
-   }
+    }
 }
 
 static void
-tidy_desaturation_group_allocate_textures (TidyDesaturationGroup *self)
+tidy_desaturation_group_release_target (TidyDesaturationGroup *self)
 {
   TidyDesaturationGroupPrivate *priv = self->priv;
-  guint tex_width, tex_height;
 
-#ifdef __i386__
-  if (!cogl_features_available(COGL_FEATURE_OFFSCREEN))
-    /* Don't try to allocate FBOs. */
-    return;
-#endif
-
-  /* Free the texture. */
-  if (priv->fbo_a)
+  if (priv->target)
     {
-      cogl_offscreen_unref(priv->fbo_a);
-      cogl_texture_unref(priv->tex_a);
-      priv->fbo_a = 0;
-      priv->tex_a = 0;
+      tidy_render_target_unref (priv->target);
+      priv->target = NULL;
     }
+}
 
-  /* (Re)create the texture and offscreen buffer.
-   * We can specify mipmapping here, but we don't need it. */
-  clutter_actor_get_size(CLUTTER_ACTOR(self), &tex_width, &tex_height);
-
-  priv->tex_a = cogl_texture_new_with_size(
-            tex_width, tex_height, 0, FALSE /* mipmap */,
-            COGL_PIXEL_FORMAT_RGBA_8888);
-  cogl_texture_set_filters(priv->tex_a, CGL_NEAREST, CGL_NEAREST);
-  priv->fbo_a = cogl_offscreen_new_to_texture(priv->tex_a);
-
-  priv->current_desaturation_step = 0;
-  priv->source_changed = TRUE;
+/* Our allocation changed, so whatever is in the target is stale.
+ * If the size changed the next paint will fetch another one. */
+static void
+tidy_desaturation_group_allocation_changed (TidyDesaturationGroup *self)
+{
+  self->priv->current_desaturation_step = 0;
+  self->priv->source_changed = TRUE;
 }
 
 static gboolean
@@ -280,6 +245,7 @@ tidy_desaturation_group_paint (ClutterActor *actor)
   TidyDesaturationGroupPrivate *priv  = container->priv;
   ClutterActorBox              box;
   gint                         width, height, tex_width, tex_height;
+  guint                        render_width, render_height;
   ClutterColor                 col;
   GArray                      *filters;
   const ClutterTextureQuality *filters_array;
@@ -303,21 +269,34 @@ tidy_desaturation_group_paint (ClutterActor *actor)
       return;
     }
 
-#ifdef __i386__
-  if (!cogl_features_available(COGL_FEATURE_OFFSCREEN))
-      return;
-#endif
+  /* Render at the size we're shown at on the screen, which is what's
+   * left of the window after the thumbnail has scaled it down.  Never
+   * more than our own size, it wouldn't show anything more. */
+  clutter_actor_get_transformed_size (actor, &render_width, &render_height);
+  render_width  = CLAMP (render_width,  1, MAX (width,  1));
+  render_height = CLAMP (render_height, 1, MAX (height, 1));
+  if (priv->target && !tidy_render_target_fits (priv->target, render_width,
+                                                render_height))
+    tidy_desaturation_group_release_target (container);
+  if (!priv->target)
+    {
+      if (!(priv->target = tidy_render_target_get (render_width,
+                                                   render_height)))
+        return;
+      priv->current_desaturation_step = 0;
+      priv->source_changed = TRUE;
+    }
 
-  tex_width  = cogl_texture_get_width(priv->tex_a);
-  tex_height = cogl_texture_get_height(priv->tex_a);
+  tex_width  = priv->target->width;
+  tex_height = priv->target->height;
 
   /* Draw children into an offscreen buffer */
   if (priv->source_changed && priv->current_desaturation_step==0)
     {
       cogl_push_matrix();
-      tidy_util_cogl_push_offscreen_buffer(priv->fbo_a);
-
-      cogl_scale(CFX_ONE*tex_width/width, CFX_ONE*tex_height/height);
+      tidy_util_cogl_push_offscreen_buffer(priv->target->fbo);
+      if (width && height)
+        cogl_scale(CFX_ONE*render_width/width, CFX_ONE*render_height/height);
 
       cogl_paint_init(&bgcol);
       cogl_color (&white);
@@ -333,6 +312,8 @@ tidy_desaturation_group_paint (ClutterActor *actor)
       tidy_util_cogl_pop_offscreen_buffer();
       cogl_pop_matrix();
 
+      priv->render_width  = render_width;
+      priv->render_height = render_height;
       priv->source_changed = FALSE;
       priv->current_desaturation_step = 0;
     }
@@ -367,15 +348,19 @@ tidy_desaturation_group_paint (ClutterActor *actor)
 
   /* Set the desaturation texture to linear interpolation - so we draw it smoothly
    * Onto the screen */
-  cogl_texture_set_filters(priv->tex_a, CGL_LINEAR, CGL_LINEAR);
+  cogl_texture_set_filters(priv->target->tex, CGL_LINEAR, CGL_LINEAR);
 
-  cogl_texture_rectangle (priv->tex_a,
+  /* Only the top-left @render_width x @render_height of the target
+   * is ours, stretch it back to our size. */
+  cogl_texture_rectangle (priv->target->tex,
                           mx-zx, my-zy,
                           mx+zx, my+zy,
-                          0, 0, CFX_ONE, CFX_ONE);
+                          0, 0,
+                          CFX_ONE*priv->render_width/tex_width,
+                          CFX_ONE*priv->render_height/tex_height);
 
-  /* Reset the filters on the tex_a texture ready for normal desaturating */
-  cogl_texture_set_filters(priv->tex_a, CGL_NEAREST, CGL_NEAREST);
+  /* Reset the filters on the texture ready for normal desaturating */
+  cogl_texture_set_filters(priv->target->tex, CGL_NEAREST, CGL_NEAREST);
 
   if (priv->use_shader && priv->shader_saturate && !priv->undo_desaturation)
     clutter_shader_set_is_enabled (priv->shader_saturate, FALSE);
@@ -385,16 +370,7 @@ tidy_desaturation_group_paint (ClutterActor *actor)
 static void
 tidy_desaturation_group_dispose (GObject *gobject)
 {
-  TidyDesaturationGroup *container = TIDY_DESATURATION_GROUP(gobject);
-  TidyDesaturationGroupPrivate *priv = container->priv;
-
-  if (priv->fbo_a)
-    {
-      cogl_offscreen_unref(priv->fbo_a);
-      cogl_texture_unref(priv->tex_a);
-      priv->fbo_a = 0;
-      priv->tex_a = 0;
-    }
+  tidy_desaturation_group_release_target (TIDY_DESATURATION_GROUP(gobject));
 
   G_OBJECT_CLASS (tidy_desaturation_group_parent_class)->dispose (gobject);
 }
@@ -433,14 +409,14 @@ tidy_desaturation_group_init (TidyDesaturationGroup *self)
 #endif
   priv->shader_saturate = 0;
 
-  priv->tex_a = 0;
-  priv->fbo_a = 0;
+  priv->target = NULL;
+  priv->render_width = priv->render_height = 0;
 
   tidy_desaturation_group_check_shader(self, &priv->shader_saturate,
                                DESATURATE_SATURATE_FRAGMENT_SHADER, 0);
 
   g_signal_connect(self, "notify::allocation",
-                   G_CALLBACK(tidy_desaturation_group_allocate_textures), NULL);
+                   G_CALLBACK(tidy_desaturation_group_allocation_changed), NULL);
 }
 
 /*
@@ -460,6 +436,21 @@ tidy_desaturation_group_new (void)
   return g_object_new (TIDY_TYPE_DESATURATION_GROUP, NULL);
 }
 
+/**
+ * tidy_desaturation_group_warm_up:
+ *
+ * Compiles the shader when the main loop is idle, so that the first
+ * group doesn't have to.
+ */
+void
+tidy_desaturation_group_warm_up (void)
+{
+#if CLUTTER_COGL_HAS_GLES
+  if (cogl_features_available (COGL_FEATURE_SHADERS_GLSL))
+    tidy_shader_cache_warm_up (DESATURATE_SATURATE_FRAGMENT_SHADER, NULL);
+#endif
+}
+
 /**
  * tidy_desaturation_group_desaturate:
  *
@@ -474,8 +465,9 @@ void tidy_desaturation_group_desaturate(ClutterActor *desaturation_group)
 
   priv = TIDY_DESATURATION_GROUP(desaturation_group)->priv;
 
-  tidy_desaturation_group_allocate_textures(TIDY_DESATURATION_GROUP(desaturation_group));
-
+  /* The target is fetched when we're painted next. */
+  priv->current_desaturation_step = 0;
+  priv->source_changed = TRUE;
   priv->undo_desaturation = FALSE;
   priv->desaturation_step = 1;
   clutter_actor_queue_redraw(desaturation_group);
@@ -499,6 +491,8 @@ void tidy_desaturation_group_undo_desaturate(ClutterActor *desaturation_group)
   priv->source_changed = TRUE;
   priv->current_desaturation_step = 0;
   priv->desaturation_step = 0;
+  tidy_desaturation_group_release_target (
+                              TIDY_DESATURATION_GROUP(desaturation_group));
   clutter_actor_queue_redraw(desaturation_group);
 }
 
@@ -35,6 +35,7 @@ struct _TidyDesaturationGroupClass
 
 GType tidy_desaturation_group_get_type (void) G_GNUC_CONST;
 ClutterActor *tidy_desaturation_group_new (void);
+void tidy_desaturation_group_warm_up (void);
 
 void tidy_desaturation_group_desaturate(ClutterActor *desaturation_group);
 gboolean tidy_desaturation_group_source_buffered(ClutterActor *desaturation_group);
@@ -32,11 +32,14 @@
 #include "tidy-scroll-view.h"
 
 #include "util/hd-transition.h"
+#include "util/hd-util.h"
 
 #define TIDY_FINGER_SCROLL_INITIAL_SCROLLBAR_DELAY (2000)
 #define TIDY_FINGER_SCROLL_FADE_SCROLLBAR_IN_TIME (250)
 #define TIDY_FINGER_SCROLL_FADE_SCROLLBAR_OUT_TIME (500)
 #define TIDY_FINGER_SCROLL_DRAG_TRASHOLD (25)
+/* The size of the motion ring buffer, the maximum of motion-buffer. */
+#define TIDY_FINGER_SCROLL_MAX_MOTIONS (32)
 
 G_DEFINE_TYPE (TidyFingerScroll, tidy_finger_scroll, TIDY_TYPE_SCROLL_VIEW)
 
@@ -48,7 +51,8 @@ typedef struct {
   /* Units to store the origin of a click when scrolling */
   ClutterUnit x;
   ClutterUnit y;
-  GTimeVal    time;
+  /* The event's timestamp in ms */
+  guint32     time;
 } TidyFingerScrollMotion;
 
 struct _TidyFingerScrollPrivate
@@ -61,9 +65,20 @@ struct _TidyFingerScrollPrivate
   gboolean               move;
   ClutterFixed           first_x, first_y;
 
-  GArray                *motion_buffer;
+  /*
+   * Ring buffer of the latest @n_motions motion samples, @last_motion
+   * being the newest.  At most @motion_buffer of them are kept.
+   */
+  TidyFingerScrollMotion motions[TIDY_FINGER_SCROLL_MAX_MOTIONS];
+  guint                  motion_buffer;
+  guint                  n_motions;
   guint                  last_motion;
 
+  /* How much to scroll by when we get to it; motion events are
+   * compressed so that @child is moved at most once a frame. */
+  ClutterFixed           pending_dx, pending_dy;
+  guint                  pending_motion_id;
+
   /* Variables for storing acceleration information for kinetic mode */
   ClutterTimeline       *deceleration_timeline;
   int                    deceleration_timeline_lastframe;
@@ -107,7 +122,7 @@ tidy_finger_scroll_get_property (GObject *object, guint property_id,
       g_value_set_enum (value, priv->mode);
       break;
     case PROP_BUFFER :
-      g_value_set_uint (value, priv->motion_buffer->len);
+      g_value_set_uint (value, priv->motion_buffer);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -127,7 +142,8 @@ tidy_finger_scroll_set_property (GObject *object, guint property_id,
       g_object_notify (object, "mode");
       break;
     case PROP_BUFFER :
-      g_array_set_size (priv->motion_buffer, g_value_get_uint (value));
+      priv->motion_buffer = g_value_get_uint (value);
+      priv->n_motions = priv->last_motion = 0;
       g_object_notify (object, "motion-buffer");
       break;
     default:
@@ -146,6 +162,12 @@ tidy_finger_scroll_dispose (GObject *object)
       priv->scrollbar_timeout = 0;
     }
 
+  if (priv->pending_motion_id)
+    {
+      g_source_remove (priv->pending_motion_id);
+      priv->pending_motion_id = 0;
+    }
+
   if (priv->deceleration_timeline)
     {
       clutter_timeline_stop (priv->deceleration_timeline);
@@ -208,8 +230,71 @@ tidy_finger_scroll_class_init (TidyFingerScrollClass *klass)
                                                       "Motion buffer",
                                                       "Amount of motion "
                                                       "events to buffer",
-                                                      1, G_MAXUINT, 3,
-                                                      G_PARAM_READWRITE));
+                                                      1,
+                                                      TIDY_FINGER_SCROLL_MAX_MOTIONS,
+                                                      8, G_PARAM_READWRITE));
+}
+
+/* Move @child, redrawing only what's inside the scroll view. */
+static void
+set_values (TidyFingerScroll *scroll,
+            TidyAdjustment *hadjust, ClutterFixed hvalue,
+            TidyAdjustment *vadjust, ClutterFixed vvalue)
+{
+  ClutterActor *actor = CLUTTER_ACTOR (scroll);
+
+  clutter_actor_set_allow_redraw (actor, FALSE);
+  tidy_adjustment_set_valuex (hadjust, hvalue);
+  tidy_adjustment_set_valuex (vadjust, vvalue);
+  clutter_actor_set_allow_redraw (actor, TRUE);
+  hd_util_partial_redraw_if_possible (actor, NULL);
+}
+
+/* Scroll by what the motion events since the last frame added up to. */
+static gboolean
+flush_pending_motion (TidyFingerScroll *scroll)
+{
+  TidyFingerScrollPrivate *priv = scroll->priv;
+  TidyAdjustment *hadjust, *vadjust;
+  ClutterActor *child;
+
+  priv->pending_motion_id = 0;
+  if (!priv->pending_dx && !priv->pending_dy)
+    return FALSE;
+
+  if ((child = tidy_scroll_view_get_child (TIDY_SCROLL_VIEW(scroll))))
+    {
+      tidy_scrollable_get_adjustments (TIDY_SCROLLABLE (child),
+                                       &hadjust, &vadjust);
+      set_values (scroll,
+                  hadjust, tidy_adjustment_get_valuex (hadjust)
+                           + priv->pending_dx,
+                  vadjust, tidy_adjustment_get_valuex (vadjust)
+                           + priv->pending_dy);
+    }
+  priv->pending_dx = priv->pending_dy = 0;
+
+  return FALSE;
+}
+
+/* Add a motion sample to the ring buffer. */
+static void
+push_motion (TidyFingerScrollPrivate *priv,
+             ClutterUnit x, ClutterUnit y, guint32 time)
+{
+  TidyFingerScrollMotion *motion;
+
+  if (priv->n_motions)
+    priv->last_motion = (priv->last_motion + 1) % priv->motion_buffer;
+  else
+    priv->last_motion = 0;
+  if (priv->n_motions < priv->motion_buffer)
+    priv->n_motions++;
+
+  motion = &priv->motions[priv->last_motion];
+  motion->x = x;
+  motion->y = y;
+  motion->time = time;
 }
 
 static gboolean
@@ -227,63 +312,91 @@ motion_event_cb (ClutterActor *actor,
                                            &x, &y))
     {
       TidyFingerScrollMotion *motion;
-      ClutterActor *child =
-        tidy_scroll_view_get_child (TIDY_SCROLL_VIEW(scroll));
 
-      if (child)
+      /* Has the drag treshold been reached? */
+      if (!priv->move)
         {
-          ClutterFixed dx, dy;
-          TidyAdjustment *hadjust, *vadjust;
-
-          tidy_scrollable_get_adjustments (TIDY_SCROLLABLE (child),
-                                           &hadjust,
-                                           &vadjust);
-
-          motion = &g_array_index (priv->motion_buffer,
-                                   TidyFingerScrollMotion, priv->last_motion);
-          dx = CLUTTER_UNITS_TO_FIXED(motion->x - x) +
-               tidy_adjustment_get_valuex (hadjust);
-          dy = CLUTTER_UNITS_TO_FIXED(motion->y - y) +
-               tidy_adjustment_get_valuex (vadjust);
-
-          /* Has the drag treshold been reached? */
-          if (!priv->move)
-            {
-                ClutterFixed d1 = x - priv->first_x;
-                ClutterFixed d2 = y - priv->first_y;
-                priv->move = clutter_qmulx (d1, d1) + clutter_qmulx (d2, d2)
-                  >= CLUTTER_INT_TO_FIXED (TIDY_FINGER_SCROLL_DRAG_TRASHOLD
-                                           * TIDY_FINGER_SCROLL_DRAG_TRASHOLD);
-            }
-
-          /* If not, do everything as if it had (we already did) except
-           * for adjusting @child's position. */
-          if (priv->move)
-            {
-              tidy_adjustment_set_valuex (hadjust, dx);
-              tidy_adjustment_set_valuex (vadjust, dy);
-              clutter_actor_queue_redraw( actor );
-            }
+            ClutterFixed d1 = x - priv->first_x;
+            ClutterFixed d2 = y - priv->first_y;
+            priv->move = clutter_qmulx (d1, d1) + clutter_qmulx (d2, d2)
+              >= CLUTTER_INT_TO_FIXED (TIDY_FINGER_SCROLL_DRAG_TRASHOLD
+                                       * TIDY_FINGER_SCROLL_DRAG_TRASHOLD);
         }
 
-      priv->last_motion ++;
-      if (priv->last_motion == priv->motion_buffer->len)
+      /* If not, do everything as if it had (we already did) except
+       * for adjusting @child's position.  Otherwise leave that until
+       * all the motion events queued up are processed. */
+      if (priv->move && tidy_scroll_view_get_child (TIDY_SCROLL_VIEW(scroll)))
         {
-          priv->motion_buffer = g_array_remove_index (priv->motion_buffer, 0);
-          g_array_set_size (priv->motion_buffer, priv->last_motion);
-          priv->last_motion --;
+          motion = &priv->motions[priv->last_motion];
+          priv->pending_dx += CLUTTER_UNITS_TO_FIXED(motion->x - x);
+          priv->pending_dy += CLUTTER_UNITS_TO_FIXED(motion->y - y);
+          if (!priv->pending_motion_id)
+            priv->pending_motion_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                        (GSourceFunc)flush_pending_motion,
+                                        scroll, NULL);
         }
 
-      motion = &g_array_index (priv->motion_buffer,
-                               TidyFingerScrollMotion, priv->last_motion);
-      motion->x = x;
-      motion->y = y;
-      g_get_current_time (&motion->time);
+      push_motion (priv, x, y, event->time);
     }
 
   return FALSE;
 }
 
+/*
+ * Estimate the speed of the finger at @time in units per 1/60th of
+ * a second from the motion samples of the last [launcher] velocity_window
+ * miliseconds by fitting a line on them with the method of least squares.
+ * The event timestamps are used, so it's not fooled by us processing
+ * the events late.
+ */
+static void
+estimate_speed (TidyFingerScrollPrivate *priv, guint32 time,
+                ClutterUnit *dx, ClutterUnit *dy)
+{
+  gdouble st, sx, sy, stt, stx, sty, n, t, x, y, denom;
+  TidyFingerScrollMotion *motion;
+  gint window;
+  guint i, idx;
+
+  window = hd_transition_get_int ("launcher", "velocity_window", 150);
+
+  n = st = sx = sy = stt = stx = sty = 0;
+  for (i = 0; i < priv->n_motions; i++)
+    {
+      idx = (priv->last_motion + priv->motion_buffer - i)
+        % priv->motion_buffer;
+      motion = &priv->motions[idx];
+
+      /* Relative to @time to keep the numbers small. */
+      t = -(gdouble)(gint32)(time - motion->time);
+      if (t < -window)
+        break;
+      x = CLUTTER_UNITS_TO_FLOAT (motion->x);
+      y = CLUTTER_UNITS_TO_FLOAT (motion->y);
+
+      n++;
+      st  += t;
+      sx  += x;
+      sy  += y;
+      stt += t*t;
+      stx += t*x;
+      sty += t*y;
+    }
+
+  denom = n*stt - st*st;
+  if (n < 2 || denom <= 0)
+    { /* All at the same time, no way to tell. */
+      *dx = *dy = 0;
+      return;
+    }
+
+  /* The slopes are in units per ms, and dragging to the left
+   * or upwards means scrolling forward. */
+  *dx = CLUTTER_UNITS_FROM_FLOAT (-(n*stx - st*sx) / denom * 1000.0 / 60.0);
+  *dy = CLUTTER_UNITS_FROM_FLOAT (-(n*sty - st*sy) / denom * 1000.0 / 60.0);
+}
+
 static void
 hfade_complete_cb (ClutterActor *scrollbar, TidyFingerScroll *scroll)
 {
@@ -492,8 +605,7 @@ deceleration_new_frame_cb (ClutterTimeline *timeline,
       priv->dy = get_next_delta (scroll,
                    vlowest, vlower, vvalue, priv->dy, vupper, vhighest);
     }
-  tidy_adjustment_set_valuex (hadjust, hvalue);
-  tidy_adjustment_set_valuex (vadjust, vvalue);
+  set_values (scroll, hadjust, hvalue, vadjust, vvalue);
 
   /* Stop the timeline if we don't move anymore,
    * or extend it if we're running out of frames. */
@@ -579,57 +691,18 @@ button_release_event_cb (ClutterActor *actor,
                                                CLUTTER_UNITS_FROM_DEVICE(event->y),
                                                &x, &y))
         {
-          ClutterUnit frac, x_origin, y_origin;
-          GTimeVal release_time, motion_time;
           TidyAdjustment *hadjust, *vadjust;
-          glong time_diff;
-          gint i;
 
-          /* Get time delta */
-          g_get_current_time (&release_time);
-
-          /* Get average position/time of last x mouse events */
-          priv->last_motion ++;
-          x_origin = y_origin = 0;
-          motion_time = (GTimeVal){ 0, 0 };
-          for (i = 0; i < priv->last_motion; i++)
+          /* Catch up with the finger. */
+          if (priv->pending_motion_id)
             {
-              TidyFingerScrollMotion *motion =
-                &g_array_index (priv->motion_buffer, TidyFingerScrollMotion, i);
-
-              /* FIXME: This doesn't guard against overflows - Should
-               *        either fix that, or calculate the correct maximum
-               *        value for the buffer size
-               */
-              x_origin += motion->x;
-              y_origin += motion->y;
-              motion_time.tv_sec += motion->time.tv_sec;
-              motion_time.tv_usec += motion->time.tv_usec;
+              g_source_remove (priv->pending_motion_id);
+              flush_pending_motion (scroll);
             }
-          x_origin = CLUTTER_UNITS_FROM_FIXED (
-            clutter_qdivx (CLUTTER_UNITS_TO_FIXED (x_origin),
-                           CLUTTER_INT_TO_FIXED (priv->last_motion)));
-          y_origin = CLUTTER_UNITS_FROM_FIXED (
-            clutter_qdivx (CLUTTER_UNITS_TO_FIXED (y_origin),
-                           CLUTTER_INT_TO_FIXED (priv->last_motion)));
-          motion_time.tv_sec /= priv->last_motion;
-          motion_time.tv_usec /= priv->last_motion;
-
-          if (motion_time.tv_sec == release_time.tv_sec)
-            time_diff = release_time.tv_usec - motion_time.tv_usec;
-          else
-            time_diff = release_time.tv_usec +
-                        (G_USEC_PER_SEC - motion_time.tv_usec);
-
-          /* Work out the fraction of 1/60th of a second that has elapsed */
-          frac = clutter_qdivx (CLUTTER_FLOAT_TO_FIXED (time_diff/1000.0),
-                                CLUTTER_FLOAT_TO_FIXED (1000.0/60.0));
 
           /* See how many units to move in 1/60th of a second */
-          priv->dx = CLUTTER_UNITS_FROM_FIXED(clutter_qdivx (
-                     CLUTTER_UNITS_TO_FIXED(x_origin - x), frac));
-          priv->dy = CLUTTER_UNITS_FROM_FIXED(clutter_qdivx (
-                     CLUTTER_UNITS_TO_FIXED(y_origin - y), frac));
+          push_motion (priv, x, y, event->time);
+          estimate_speed (priv, event->time, &priv->dx, &priv->dy);
 
           /* Get adjustments to do step-increment snapping */
           tidy_scrollable_get_adjustments (TIDY_SCROLLABLE (child),
@@ -741,7 +814,7 @@ button_release_event_cb (ClutterActor *actor,
     }
 
   /* Reset motion event buffer */
-  priv->last_motion = 0;
+  priv->n_motions = 0;
 
   if (!decelerating)
     _tidy_finger_scroll_hide_scrollbars_later (scroll);
@@ -786,27 +859,26 @@ captured_event_cb (ClutterActor     *actor,
 
   if (event->type == CLUTTER_BUTTON_PRESS)
     {
-      TidyFingerScrollMotion *motion;
       ClutterButtonEvent *bevent = (ClutterButtonEvent *)event;
-
-      /* Reset motion buffer */
-      priv->last_motion = 0;
-      motion = &g_array_index (priv->motion_buffer, TidyFingerScrollMotion, 0);
+      ClutterUnit x, y;
 
       if ((bevent->button == 1) &&
           (clutter_actor_transform_stage_point (actor,
                                            CLUTTER_UNITS_FROM_DEVICE(bevent->x),
                                            CLUTTER_UNITS_FROM_DEVICE(bevent->y),
-                                           &motion->x, &motion->y)))
+                                           &x, &y)))
         {
-          g_get_current_time (&motion->time);
+          /* Reset motion buffer */
+          priv->n_motions = 0;
+          push_motion (priv, x, y, bevent->time);
+          priv->pending_dx = priv->pending_dy = 0;
 
           /* Save the coordinates of the first touch to be able to determine
            * whether we've exceeded the drag treshold when processing motion
            * events.  Until then don't move @child. */
           priv->move = FALSE;
-          priv->first_x = motion->x;
-          priv->first_y = motion->y;
+          priv->first_x = x;
+          priv->first_y = y;
 
           if (priv->deceleration_timeline)
             {
@@ -897,9 +969,7 @@ tidy_finger_scroll_init (TidyFingerScroll *self)
   ClutterFixed qn;
   guint i;
 
-  priv->motion_buffer = g_array_sized_new (FALSE, TRUE,
-                                           sizeof (TidyFingerScrollMotion), 3);
-  g_array_set_size (priv->motion_buffer, 3);
+  priv->motion_buffer = 8;
   priv->decel_rate = CLUTTER_FLOAT_TO_FIXED (
        hd_transition_get_double("launcher", "deceleration_rate", 0.99));
   priv->bouncing_decel_rate = CLUTTER_FLOAT_TO_FIXED (
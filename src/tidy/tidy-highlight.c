@@ -7,6 +7,7 @@
 #endif
 
 #include "tidy-highlight.h"
+#include "tidy-shader-cache.h"
 #include <clutter/clutter-actor.h>
 
 #include "cogl/cogl.h"
@@ -269,7 +270,7 @@ tidy_highlight_dispose (GObject *object)
     g_object_unref (priv->parent_texture);
 
   priv->parent_texture = NULL;
-  /* TODO: handle disposal of cached shader? */
+  /* priv->shader belongs to the shader cache. */
 
   G_OBJECT_CLASS (tidy_highlight_parent_class)->dispose (object);
 }
@@ -369,30 +370,7 @@ tidy_highlight_init (TidyHighlight *self)
 #if CLUTTER_COGL_HAS_GLES
   /* We can't use shaders on x86/GL because they're different (and Xephyr
    * just returns blackness for them */
-  {
-    static ClutterShader *cached_shader = 0;
-    GError               *error = NULL;
-    if (cached_shader)
-      {
-        priv->shader = cached_shader;
-      }
-    else
-      {
-        priv->shader = clutter_shader_new();
-        clutter_shader_set_fragment_source (priv->shader, HIGHLIGHT_FRAGMENT_SHADER, -1);
-        clutter_shader_compile (priv->shader, &error);
-
-        if (error)
-        {
-          g_warning ("unable to load shader: %s\n", error->message);
-          g_error_free (error);
-          clutter_shader_release(priv->shader);
-          priv->shader = 0;
-        }
-
-        cached_shader = priv->shader;
-      }
-  }
+  priv->shader = tidy_shader_cache_get (HIGHLIGHT_FRAGMENT_SHADER, NULL);
 #endif
 }
 
@@ -437,3 +415,11 @@ void tidy_highlight_set_color (TidyHighlight *sub,
   clutter_actor_queue_redraw(CLUTTER_ACTOR(sub));
 }
 
+/* Compile the shader when the main loop is idle, so the first highlight
+ * doesn't have to. */
+void tidy_highlight_warm_up (void)
+{
+#if CLUTTER_COGL_HAS_GLES
+  tidy_shader_cache_warm_up (HIGHLIGHT_FRAGMENT_SHADER, NULL);
+#endif
+}
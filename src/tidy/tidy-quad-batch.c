@@ -0,0 +1,133 @@
+#include "tidy-quad-batch.h"
+
+typedef struct
+{
+  guint draws, quads;
+} Count;
+
+static struct
+{
+  /* What the pending vertices are drawn with.  Opaque quads are drawn
+   * without vertex colours, so blending isn't turned on for them unless
+   * the texture has an alpha channel.  Cogl decides whether to blend
+   * by the current colour, not the vertex colours, so for translucent
+   * ones it's set to the opacity of the last quad. */
+  CoglHandle  texture;
+  gboolean    translucent;
+  guint8      opacity;
+  GArray     *verts;
+
+  /* Draw calls and quads in the frame being painted and the last one,
+   * and all of them since the start. */
+  Count       frame, last_frame, total;
+  guint       nframes;
+  gulong      paint_handler;
+} Batch;
+
+static void
+tidy_quad_batch_frame_done (ClutterActor *stage, gpointer unused)
+{
+  Batch.last_frame = Batch.frame;
+  Batch.total.draws += Batch.frame.draws;
+  Batch.total.quads += Batch.frame.quads;
+  Batch.frame.draws = Batch.frame.quads = 0;
+  Batch.nframes++;
+}
+
+static void
+tidy_quad_batch_count (guint quads)
+{
+  if (G_UNLIKELY (!Batch.paint_handler))
+    Batch.paint_handler = g_signal_connect_after (
+                              clutter_stage_get_default (), "paint",
+                              G_CALLBACK (tidy_quad_batch_frame_done),
+                              NULL);
+  Batch.frame.draws++;
+  Batch.frame.quads += quads;
+}
+
+static void
+set_vertex (CoglTextureVertex *vert, guint8 opacity,
+            ClutterFixed x, ClutterFixed y,
+            ClutterFixed tx, ClutterFixed ty)
+{
+  vert->x = x;
+  vert->y = y;
+  vert->z = 0;
+  vert->tx = tx;
+  vert->ty = ty;
+  vert->color.red = vert->color.green = vert->color.blue = 0xff;
+  vert->color.alpha = opacity;
+}
+
+void
+tidy_quad_batch_add (CoglHandle texture, guint8 opacity,
+                     ClutterFixed x1, ClutterFixed y1,
+                     ClutterFixed x2, ClutterFixed y2,
+                     ClutterFixed tx1, ClutterFixed ty1,
+                     ClutterFixed tx2, ClutterFixed ty2)
+{
+  gboolean translucent = opacity < 0xff;
+  CoglTextureVertex *rect;
+
+  /* cogl_texture_triangles() can't draw sliced textures. */
+  if (cogl_texture_is_sliced (texture))
+    {
+      ClutterColor col = { 0xff, 0xff, 0xff, opacity };
+
+      tidy_quad_batch_flush ();
+      cogl_color (&col);
+      cogl_texture_rectangle (texture, x1, y1, x2, y2, tx1, ty1, tx2, ty2);
+      tidy_quad_batch_count (1);
+      return;
+    }
+
+  if (G_UNLIKELY (!Batch.verts))
+    Batch.verts = g_array_new (FALSE, FALSE, sizeof (CoglTextureVertex));
+  else if (Batch.verts->len > 0
+           && (texture != Batch.texture || translucent != Batch.translucent))
+    tidy_quad_batch_flush ();
+
+  Batch.texture = texture;
+  Batch.translucent = translucent;
+  Batch.opacity = opacity;
+
+  g_array_set_size (Batch.verts, Batch.verts->len + 6);
+  rect = &g_array_index (Batch.verts, CoglTextureVertex, Batch.verts->len-6);
+  set_vertex (&rect[0], opacity, x1, y1, tx1, ty1);
+  set_vertex (&rect[1], opacity, x2, y1, tx2, ty1);
+  set_vertex (&rect[2], opacity, x2, y2, tx2, ty2);
+  rect[3] = rect[0];
+  rect[4] = rect[2];
+  set_vertex (&rect[5], opacity, x1, y2, tx1, ty2);
+}
+
+void
+tidy_quad_batch_flush (void)
+{
+  ClutterColor col = { 0xff, 0xff, 0xff, 0xff };
+
+  if (!Batch.verts || !Batch.verts->len)
+    return;
+
+  col.alpha = Batch.opacity;
+  cogl_color (&col);
+  cogl_texture_triangles (Batch.texture, Batch.verts->len,
+                          (CoglTextureVertex *)Batch.verts->data,
+                          Batch.translucent);
+  tidy_quad_batch_count (Batch.verts->len / 6);
+
+  g_array_set_size (Batch.verts, 0);
+  Batch.texture = COGL_INVALID_HANDLE;
+}
+
+void
+tidy_quad_batch_dump_stats (void)
+{
+  g_debug ("quad batch: %u draws of %u quads in the last frame, "
+           "%.1f draws of %.1f quads per frame in %u frames",
+           Batch.last_frame.draws, Batch.last_frame.quads,
+           Batch.nframes ? Batch.total.draws / (gdouble)Batch.nframes : 0,
+           Batch.nframes ? Batch.total.quads / (gdouble)Batch.nframes : 0,
+           Batch.nframes);
+}
@@ -0,0 +1,28 @@
+#ifndef _TIDY_QUAD_BATCH
+#define _TIDY_QUAD_BATCH
+
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+
+/*
+ * Textured quads waiting to be drawn together.  tidy_quad_batch_add()
+ * appends a rectangle to the pending batch, which is drawn with a single
+ * cogl_texture_triangles() when tidy_quad_batch_flush() is called, or
+ * when a quad with a different texture or blending comes in.  The
+ * coordinates of all quads in a batch must be in the same space, so
+ * whoever starts adding quads must flush them before the modelview
+ * matrix changes or anything else is drawn.  #TidyBatchGroup does this
+ * for its #TidySubTexture children.
+ *
+ * The draw calls made through here are counted per frame, see
+ * tidy_quad_batch_dump_stats().
+ */
+void tidy_quad_batch_add        (CoglHandle texture, guint8 opacity,
+                                 ClutterFixed x1, ClutterFixed y1,
+                                 ClutterFixed x2, ClutterFixed y2,
+                                 ClutterFixed tx1, ClutterFixed ty1,
+                                 ClutterFixed tx2, ClutterFixed ty2);
+void tidy_quad_batch_flush      (void);
+void tidy_quad_batch_dump_stats (void);
+
+#endif
@@ -0,0 +1,104 @@
+#include "tidy-render-target.h"
+
+#include <cogl/cogl.h>
+
+/* Requested sizes are rounded up to multiples of this. */
+#define BUCKET_SIZE       32
+#define BUCKET(size)      (((size) + BUCKET_SIZE-1) / BUCKET_SIZE * BUCKET_SIZE)
+
+/* How many unreferenced targets to keep for reuse.  Each of them is
+ * a full RGBA texture, so don't go overboard. */
+#define MAX_SPARES        4
+
+/* Unreferenced targets, the most recently released first. */
+static GList *Spares;
+static guint Nspares;
+
+static void
+tidy_render_target_free (TidyRenderTarget *target)
+{
+  cogl_offscreen_unref (target->fbo);
+  cogl_texture_unref (target->tex);
+  g_slice_free (TidyRenderTarget, target);
+}
+
+/* Returns a target with a reference at least @width x @height large,
+ * or %NULL if offscreen rendering is not available. */
+TidyRenderTarget *
+tidy_render_target_get (guint width, guint height)
+{
+  TidyRenderTarget *target;
+  GList *li;
+
+#ifdef __i386__
+  if (!cogl_features_available (COGL_FEATURE_OFFSCREEN))
+    /* Don't try to allocate FBOs. */
+    return NULL;
+#endif
+
+  width  = BUCKET (MAX (width,  1));
+  height = BUCKET (MAX (height, 1));
+
+  for (li = Spares; li; li = li->next)
+    {
+      target = li->data;
+      if (target->width == width && target->height == height)
+        {
+          Spares = g_list_delete_link (Spares, li);
+          Nspares--;
+          target->refcount = 1;
+          return target;
+        }
+    }
+
+  /* We can specify mipmapping here, but we don't need it. */
+  target = g_slice_new (TidyRenderTarget);
+  target->width  = width;
+  target->height = height;
+  target->tex = cogl_texture_new_with_size (width, height, 0,
+                                            FALSE /* mipmap */,
+                                            COGL_PIXEL_FORMAT_RGBA_8888);
+  cogl_texture_set_filters (target->tex, CGL_NEAREST, CGL_NEAREST);
+  target->fbo = cogl_offscreen_new_to_texture (target->tex);
+  target->refcount = 1;
+
+  return target;
+}
+
+TidyRenderTarget *
+tidy_render_target_ref (TidyRenderTarget *target)
+{
+  g_assert (target->refcount > 0);
+  target->refcount++;
+  return target;
+}
+
+/* When the last reference is gone @target goes back to the pool,
+ * pushing out the least recently used spare if it's full. */
+void
+tidy_render_target_unref (TidyRenderTarget *target)
+{
+  g_assert (target->refcount > 0);
+  if (--target->refcount > 0)
+    return;
+
+  Spares = g_list_prepend (Spares, target);
+  if (++Nspares > MAX_SPARES)
+    {
+      GList *last = g_list_last (Spares);
+
+      tidy_render_target_free (last->data);
+      Spares = g_list_delete_link (Spares, last);
+      Nspares--;
+    }
+}
+
+/* Whether @target is what tidy_render_target_get() would return
+ * for @width x @height. */
+gboolean
+tidy_render_target_fits (const TidyRenderTarget *target,
+                         guint width, guint height)
+{
+  return target->width  == BUCKET (MAX (width,  1))
+      && target->height == BUCKET (MAX (height, 1));
+}
@@ -0,0 +1,31 @@
+#ifndef _TIDY_RENDER_TARGET
+#define _TIDY_RENDER_TARGET
+
+#include <clutter/clutter.h>
+
+/*
+ * A pool of offscreen render targets shared by the groups which only
+ * need one now and then.  Sizes are rounded up to buckets so that
+ * actors of roughly the same size can reuse each other's targets, and
+ * targets nobody holds a reference to are kept around for a while
+ * rather than deleted.  The contents of a target are only valid in the
+ * top-left @width x @height area the caller asked for.
+ */
+typedef struct
+{
+  CoglHandle tex, fbo;
+
+  /* The size of @tex, which is at least what was asked for. */
+  guint width, height;
+
+  /*< private >*/
+  guint refcount;
+} TidyRenderTarget;
+
+TidyRenderTarget *tidy_render_target_get   (guint width, guint height);
+TidyRenderTarget *tidy_render_target_ref   (TidyRenderTarget *target);
+void              tidy_render_target_unref (TidyRenderTarget *target);
+gboolean          tidy_render_target_fits  (const TidyRenderTarget *target,
+                                            guint width, guint height);
+
+#endif
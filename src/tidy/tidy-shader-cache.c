@@ -0,0 +1,156 @@
+#include "tidy-shader-cache.h"
+
+#include <string.h>
+#include <locale.h>
+
+/* This fixes the bug where the SGX GLSL compiler uses the current locale for
+ * numbers - so '1.0' in a shader will not work when the locale says that ','
+ * is a decimal separator.
+ */
+#define GLSL_LOCALE_FIX 1
+
+typedef struct
+{
+  /* The sources aren't copied, they're expected to be string literals. */
+  const gchar *fragment_source, *vertex_source;
+  guint hash;
+
+  /* %NULL if it failed to compile. */
+  ClutterShader *shader;
+} Program;
+
+/* Program:s by their sources, and the sources still to be warmed up. */
+static GHashTable *Programs;
+static GQueue Warm_up_queue;
+static guint Warm_up_id;
+
+/* How many times we could and couldn't reuse a shader. */
+static guint Nhits, Nmisses;
+
+static guint
+program_hash (gconstpointer key)
+{
+  return ((const Program *)key)->hash;
+}
+
+static gboolean
+program_equal (gconstpointer a, gconstpointer b)
+{
+  const Program *pa = a, *pb = b;
+
+  return pa->hash == pb->hash
+    && !g_strcmp0 (pa->fragment_source, pb->fragment_source)
+    && !g_strcmp0 (pa->vertex_source, pb->vertex_source);
+}
+
+static guint
+sources_hash (const gchar *fragment_source, const gchar *vertex_source)
+{
+  return (fragment_source ? g_str_hash (fragment_source) : 0) * 31
+    + (vertex_source ? g_str_hash (vertex_source) : 0);
+}
+
+static ClutterShader *
+compile (const gchar *fragment_source, const gchar *vertex_source)
+{
+  ClutterShader *shader;
+  GError *error = NULL;
+#if GLSL_LOCALE_FIX
+  gchar *old_locale;
+
+  old_locale = g_strdup (setlocale (LC_NUMERIC, NULL));
+  setlocale (LC_NUMERIC, "C");
+#endif
+
+  shader = clutter_shader_new ();
+  if (fragment_source)
+    clutter_shader_set_fragment_source (shader, fragment_source, -1);
+  if (vertex_source)
+    clutter_shader_set_vertex_source (shader, vertex_source, -1);
+  clutter_shader_compile (shader, &error);
+
+  if (error)
+    {
+      g_warning ("unable to load shader: %s\n", error->message);
+      g_error_free (error);
+      g_object_unref (shader);
+      shader = NULL;
+    }
+
+#if GLSL_LOCALE_FIX
+  setlocale (LC_NUMERIC, old_locale);
+  g_free (old_locale);
+#endif
+
+  return shader;
+}
+
+ClutterShader *
+tidy_shader_cache_get (const gchar *fragment_source,
+                       const gchar *vertex_source)
+{
+  Program key, *program;
+
+  if (!Programs)
+    Programs = g_hash_table_new (program_hash, program_equal);
+
+  key.fragment_source = fragment_source;
+  key.vertex_source   = vertex_source;
+  key.hash = sources_hash (fragment_source, vertex_source);
+  if ((program = g_hash_table_lookup (Programs, &key)) != NULL)
+    {
+      Nhits++;
+      return program->shader;
+    }
+
+  Nmisses++;
+  program = g_slice_dup (Program, &key);
+  program->shader = compile (fragment_source, vertex_source);
+  g_hash_table_insert (Programs, program, program);
+
+  return program->shader;
+}
+
+/* Compile one queued shader at a time, not to block the main loop
+ * for longer than necessary. */
+static gboolean
+tidy_shader_cache_warm_up_idle (gpointer unused)
+{
+  const gchar *fragment_source, *vertex_source;
+  guint hits, misses;
+
+  /* This is not a use of the shader, don't let it skew the stats. */
+  hits = Nhits;
+  misses = Nmisses;
+  fragment_source = g_queue_pop_head (&Warm_up_queue);
+  vertex_source   = g_queue_pop_head (&Warm_up_queue);
+  tidy_shader_cache_get (fragment_source, vertex_source);
+  Nhits = hits;
+  Nmisses = misses;
+
+  if (g_queue_is_empty (&Warm_up_queue))
+    {
+      Warm_up_id = 0;
+      return FALSE;
+    }
+  return TRUE;
+}
+
+void
+tidy_shader_cache_warm_up (const gchar *fragment_source,
+                           const gchar *vertex_source)
+{
+  g_queue_push_tail (&Warm_up_queue, (gpointer)fragment_source);
+  g_queue_push_tail (&Warm_up_queue, (gpointer)vertex_source);
+  if (!Warm_up_id)
+    Warm_up_id = g_idle_add_full (G_PRIORITY_LOW,
+                                  tidy_shader_cache_warm_up_idle,
+                                  NULL, NULL);
+}
+
+void
+tidy_shader_cache_dump_stats (void)
+{
+  g_debug ("shader cache: %u shaders, %u hits, %u misses",
+           Programs ? g_hash_table_size (Programs) : 0, Nhits, Nmisses);
+}
@@ -0,0 +1,24 @@
+#ifndef _TIDY_SHADER_CACHE
+#define _TIDY_SHADER_CACHE
+
+#include <clutter/clutter.h>
+
+/*
+ * Compiled shaders shared by all the tidy effects, keyed on their
+ * source.  The first tidy_shader_cache_get() of a source compiles it
+ * and the rest get the same #ClutterShader, which is owned by the cache,
+ * so don't unref it.  Shaders which failed to compile are remembered
+ * too, and are returned as %NULL without trying again.  Since all users
+ * share a shader, set its uniforms every time before enabling it.
+ *
+ * tidy_shader_cache_warm_up() compiles a shader when the main loop is
+ * idle, so that the first instance of an effect created later doesn't
+ * have to wait for the compiler.
+ */
+ClutterShader *tidy_shader_cache_get        (const gchar *fragment_source,
+                                             const gchar *vertex_source);
+void           tidy_shader_cache_warm_up    (const gchar *fragment_source,
+                                             const gchar *vertex_source);
+void           tidy_shader_cache_dump_stats (void);
+
+#endif
@@ -8,6 +8,7 @@
 #endif
 
 #include "tidy-sub-texture.h"
+#include "tidy-quad-batch.h"
 #include <clutter/clutter-actor.h>
 
 #include "cogl/cogl.h"
@@ -100,19 +101,21 @@ tidy_sub_texture_get_preferred_height (ClutterActor *self,
                                               natural_height_p);
 }
 
+/* Add the quads of @self to the pending batch, translated by @x and @y. */
 static void
-tidy_sub_texture_paint (ClutterActor *self)
+tidy_sub_texture_add_quads (TidySubTexture *self,
+                            ClutterFixed x, ClutterFixed y)
 {
   TidySubTexturePrivate  *priv;
   ClutterActor                *parent_texture;
   gint                         x_1, y_1, x_2, y_2, width, height;
-  ClutterColor                 col = { 0xff, 0xff, 0xff, 0xff };
+  guint8                       opacity;
   CoglHandle                   cogl_texture;
   ClutterFixed                 t_x, t_y, t_w, t_h;
   guint                        tex_width, tex_height;
   ClutterGeometry              region;
 
-  priv = TIDY_SUB_TEXTURE (self)->priv;
+  priv = self->priv;
 
   /* no need to paint stuff if we don't have a texture to sub */
   if (!priv->parent_texture)
@@ -125,10 +128,10 @@ tidy_sub_texture_paint (ClutterActor *self)
   if (!CLUTTER_ACTOR_IS_REALIZED (parent_texture))
     clutter_actor_realize (parent_texture);
 
-  col.alpha = clutter_actor_get_paint_opacity (self);
-  cogl_color (&col);
+  opacity = clutter_actor_get_paint_opacity (CLUTTER_ACTOR (self));
 
-  clutter_actor_get_allocation_coords (self, &x_1, &y_1, &x_2, &y_2);
+  clutter_actor_get_allocation_coords (CLUTTER_ACTOR (self),
+                                       &x_1, &y_1, &x_2, &y_2);
   width = x_2 - x_1;
   height = y_2 - y_1;
 
@@ -155,85 +158,53 @@ tidy_sub_texture_paint (ClutterActor *self)
   t_w = CLUTTER_FLOAT_TO_FIXED(region.width / (float)tex_width);
   t_h = CLUTTER_FLOAT_TO_FIXED(region.height / (float)tex_height);
 
-  /* Parent paint translated us into position, so we just
-   * paint at 0,0 */
   if (!priv->tiled)
     {
       // normal draw if not tiled...
-      cogl_texture_rectangle (cogl_texture, 0, 0,
-                              CLUTTER_INT_TO_FIXED (width),
-                              CLUTTER_INT_TO_FIXED (height),
-                              t_x, t_y, t_x+t_w, t_y+t_h);
+      tidy_quad_batch_add (cogl_texture, opacity,
+                           x, y,
+                           x + CLUTTER_INT_TO_FIXED (width),
+                           y + CLUTTER_INT_TO_FIXED (height),
+                           t_x, t_y, t_x+t_w, t_y+t_h);
     }
   else
     {
-      gint x,y,c,cx,cy;
-      CoglTextureVertex *verts, *rect;
-      /* For tiling, we draw a rectangles for each tile that we repeat.
-       * We do this using draw_triangles as it is way more efficient
-       * than calling texture_rectangle multiple times. Hence each rect
-       * has 6 elements = 2 triangles.  */
-
-      /* max number of items needed */
-      cx = ((width / region.width)+1);
-      cy = ((height / region.height)+1);
-      if (cx > 0 && cy > 0)
-        {
-          c = cx * cy;
-          verts = g_malloc(sizeof(CoglTextureVertex)*c*6);
-          c = 0;
-          rect = verts;
-
-
-          for (y=0;y<height;y+=region.height)
-            for (x=0;x<width;x+=region.width)
-              {
-                gint w,h;
-                /* Clip width and height to the edges of the image */
-                w = region.width;
-                if (x+w > width)
-                  w = width-x;
-                h = region.height;
-                if (y+h > height)
-                  h = height-y;
-
-                rect[0].x = CLUTTER_INT_TO_FIXED(x);
-                rect[0].y = CLUTTER_INT_TO_FIXED(y);
-                rect[0].z = 0;
-                rect[0].tx = t_x;
-                rect[0].ty = t_y;
-                rect[1].x = CLUTTER_INT_TO_FIXED(x+w);
-                rect[1].y = CLUTTER_INT_TO_FIXED(y);
-                rect[1].z = 0;
-                rect[1].tx = t_x+(t_w*w/region.width);
-                rect[1].ty = t_y;
-                rect[2].x = CLUTTER_INT_TO_FIXED(x+w);
-                rect[2].y = CLUTTER_INT_TO_FIXED(y+h);
-                rect[2].z = 0;
-                rect[2].tx = t_x+(t_w*w/region.width);
-                rect[2].ty = t_y+(t_h*h/region.height);
-                rect[3] = rect[0];
-                rect[4] = rect[2];
-                rect[5].x = CLUTTER_INT_TO_FIXED(x);
-                rect[5].y = CLUTTER_INT_TO_FIXED(y+h);
-                rect[5].z = 0;
-                rect[5].tx = t_x;
-                rect[5].ty = t_y+(t_h*h/region.height);
-
-                rect += 6;
-                c++;
-              }
-
-          /* render! */
-          cogl_texture_triangles (cogl_texture,
-                                  6*c,
-                                  verts,
-                                  FALSE);
-          g_free(verts);
-        }
+      gint tx,ty;
+      /* For tiling, we add a rectangle for each tile that we repeat,
+       * and they're drawn together. */
+      for (ty=0;ty<height;ty+=region.height)
+        for (tx=0;tx<width;tx+=region.width)
+          {
+            gint w,h;
+            /* Clip width and height to the edges of the image */
+            w = region.width;
+            if (tx+w > width)
+              w = width-tx;
+            h = region.height;
+            if (ty+h > height)
+              h = height-ty;
+
+            tidy_quad_batch_add (cogl_texture, opacity,
+                                 x + CLUTTER_INT_TO_FIXED (tx),
+                                 y + CLUTTER_INT_TO_FIXED (ty),
+                                 x + CLUTTER_INT_TO_FIXED (tx+w),
+                                 y + CLUTTER_INT_TO_FIXED (ty+h),
+                                 t_x, t_y,
+                                 t_x+(t_w*w/region.width),
+                                 t_y+(t_h*h/region.height));
+          }
     }
 }
 
+static void
+tidy_sub_texture_paint (ClutterActor *self)
+{
+  /* Parent paint translated us into position, so we just
+   * paint at 0,0 */
+  tidy_sub_texture_add_quads (TIDY_SUB_TEXTURE (self), 0, 0);
+  tidy_quad_batch_flush ();
+}
+
 static void
 set_parent_texture (TidySubTexture *ctexture,
 		    ClutterTexture      *texture)
@@ -442,6 +413,13 @@ void tidy_sub_texture_set_region (TidySubTexture *sub,
   sub->priv->region = *region;
 }
 
+void tidy_sub_texture_get_region (TidySubTexture *sub,
+                                  ClutterGeometry *region)
+{
+  g_return_if_fail (TIDY_IS_SUB_TEXTURE (sub));
+  *region = sub->priv->region;
+}
+
 /* Set whether to tile (rather than stretch) the image */
 void tidy_sub_texture_set_tiled (TidySubTexture *sub,
                                 gboolean tile)
@@ -450,3 +428,15 @@ void tidy_sub_texture_set_tiled (TidySubTexture *sub,
   sub->priv->tiled = tile;
 }
 
+/*
+ * Add the quads of @sub to the pending quad batch, at @x and @y in the
+ * coordinate space of the batch, without drawing them.  This is what
+ * painting @sub would draw, except that its transformation is not
+ * applied, so it's only correct for actors only translated.
+ */
+void tidy_sub_texture_paint_batched (TidySubTexture *sub,
+                                     ClutterFixed x, ClutterFixed y)
+{
+  g_return_if_fail (TIDY_IS_SUB_TEXTURE (sub));
+  tidy_sub_texture_add_quads (sub, x, y);
+}
@@ -0,0 +1,243 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "hd-arena.h"
+
+/* Everything handed out is aligned to this. */
+#define HD_ARENA_ALIGN          8
+#define HD_ARENA_ROUND(size)    (((size) + HD_ARENA_ALIGN-1) \
+                                 & ~(gsize)(HD_ARENA_ALIGN-1))
+
+typedef struct _HdArenaChunk HdArenaChunk;
+struct _HdArenaChunk
+{
+  HdArenaChunk *next;
+  gsize         size, used;
+};
+
+/* Where the data of a chunk starts. */
+#define HD_ARENA_CHUNK_DATA(chunk) \
+  ((guint8 *)(chunk) + HD_ARENA_ROUND (sizeof (HdArenaChunk)))
+
+struct _HdArena
+{
+  gchar        *name;
+  gsize         chunk_size;
+
+  /* @chunks up to and including @current are in use, the ones
+   * after @current are spares waiting to be reused. */
+  HdArenaChunk *chunks, *current;
+
+  /*
+   * -- @nallocs:      Number of allocations served.
+   * -- @nchunks:      Number of chunks malloc()ed, the heap churn.
+   * -- @nresets:      Number of hd_arena_reset()s.
+   * -- @cycle_bytes:  Bytes handed out since the last reset.
+   * -- @peak_bytes:   The most @cycle_bytes has ever been.
+   */
+  guint         nallocs, nchunks, nresets;
+  gsize         cycle_bytes, peak_bytes;
+};
+
+static HdArenaChunk *
+hd_arena_new_chunk (HdArena *arena, gsize size)
+{
+  HdArenaChunk *chunk;
+
+  if (size < arena->chunk_size)
+    size = arena->chunk_size;
+  chunk = g_malloc (HD_ARENA_ROUND (sizeof (*chunk)) + size);
+  chunk->next = NULL;
+  chunk->size = size;
+  chunk->used = 0;
+  arena->nchunks++;
+
+  return chunk;
+}
+
+HdArena *
+hd_arena_new (const gchar *name, gsize chunk_size)
+{
+  HdArena *arena = g_slice_new0 (HdArena);
+
+  arena->name = g_strdup (name);
+  arena->chunk_size = HD_ARENA_ROUND (chunk_size);
+  arena->chunks = arena->current = hd_arena_new_chunk (arena,
+                                                       arena->chunk_size);
+
+  return arena;
+}
+
+void
+hd_arena_free (HdArena *arena)
+{
+  HdArenaChunk *chunk, *next;
+
+  for (chunk = arena->chunks; chunk; chunk = next)
+    {
+      next = chunk->next;
+      g_free (chunk);
+    }
+  g_free (arena->name);
+  g_slice_free (HdArena, arena);
+}
+
+gpointer
+hd_arena_alloc (HdArena *arena, gsize size)
+{
+  HdArenaChunk *chunk;
+  gpointer mem;
+
+  size = HD_ARENA_ROUND (size ? size : 1);
+  chunk = arena->current;
+  if (chunk->size - chunk->used < size)
+    {
+      /* Go on with the next spare if it's large enough, otherwise
+       * put a new chunk in front of the spares. */
+      if (chunk->next && chunk->next->size >= size)
+        chunk = chunk->next;
+      else
+        {
+          HdArenaChunk *spares = chunk->next;
+
+          chunk->next = hd_arena_new_chunk (arena, size);
+          chunk = chunk->next;
+          chunk->next = spares;
+        }
+      chunk->used = 0;
+      arena->current = chunk;
+    }
+
+  mem = HD_ARENA_CHUNK_DATA (chunk) + chunk->used;
+  chunk->used += size;
+  arena->nallocs++;
+  arena->cycle_bytes += size;
+
+  return mem;
+}
+
+gpointer
+hd_arena_memdup (HdArena *arena, gconstpointer mem, gsize size)
+{
+  return memcpy (hd_arena_alloc (arena, size), mem, size);
+}
+
+gchar *
+hd_arena_strdup_printf (HdArena *arena, const gchar *format, ...)
+{
+  va_list args;
+  gchar buf[128], *str;
+  gint len;
+
+  /* Most strings fit in @buf, so they needn't be formatted twice. */
+  va_start (args, format);
+  len = vsnprintf (buf, sizeof (buf), format, args);
+  va_end (args);
+  g_assert (len >= 0);
+
+  str = hd_arena_alloc (arena, len + 1);
+  if ((gsize)len < sizeof (buf))
+    memcpy (str, buf, len + 1);
+  else
+    {
+      va_start (args, format);
+      vsnprintf (str, len + 1, format, args);
+      va_end (args);
+    }
+
+  return str;
+}
+
+GList *
+hd_arena_list_prepend (HdArena *arena, GList *list, gpointer data)
+{
+  GList *link = hd_arena_alloc (arena, sizeof (*link));
+
+  link->data = data;
+  link->next = list;
+  link->prev = NULL;
+  if (list)
+    list->prev = link;
+
+  return link;
+}
+
+void
+hd_arena_mark (HdArena *arena, HdArenaMark *mark)
+{
+  mark->chunk = arena->current;
+  mark->used  = arena->current->used;
+}
+
+/* Forget everything allocated since @mark was taken.  Marks must be
+ * released in the opposite order they were taken. */
+void
+hd_arena_release (HdArena *arena, const HdArenaMark *mark)
+{
+  arena->current = mark->chunk;
+  arena->current->used = mark->used;
+}
+
+void
+hd_arena_reset (HdArena *arena)
+{
+  HdArenaChunk *chunk, *next;
+
+  /* Don't hold on to chunks made for the odd oversized allocation. */
+  for (chunk = arena->chunks; chunk->next; )
+    {
+      next = chunk->next;
+      if (next->size > arena->chunk_size)
+        {
+          chunk->next = next->next;
+          g_free (next);
+        }
+      else
+        chunk = next;
+    }
+
+  arena->current = arena->chunks;
+  arena->current->used = 0;
+
+  arena->nresets++;
+  if (arena->peak_bytes < arena->cycle_bytes)
+    arena->peak_bytes = arena->cycle_bytes;
+  arena->cycle_bytes = 0;
+}
+
+void
+hd_arena_dump_stats (HdArena *arena)
+{
+  HdArenaChunk *chunk;
+  guint nchunks;
+
+  for (chunk = arena->chunks, nchunks = 0; chunk; chunk = chunk->next)
+    nchunks++;
+  g_debug ("%s: %u allocations, %u resets, %u chunks malloc()ed, "
+           "%u kept, peak %lu bytes", arena->name,
+           arena->nallocs, arena->nresets, arena->nchunks, nchunks,
+           (gulong)arena->peak_bytes);
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+
+/*
+ * HdArena is a bump allocator for short-lived scratch data.  Memory is
+ * handed out from large chunks and is never freed one by one: either
+ * everything goes at once with hd_arena_reset(), or everything allocated
+ * since an hd_arena_mark() goes with hd_arena_release().  Chunks are kept
+ * around for reuse, so in the steady state it doesn't touch the heap.
+ */
+
+#ifndef __HD_ARENA_H__
+#define __HD_ARENA_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _HdArena HdArena;
+
+/* Remembers how far the arena was filled; treat it as opaque. */
+typedef struct
+{
+  gpointer chunk;
+  gsize    used;
+} HdArenaMark;
+
+HdArena  *hd_arena_new           (const gchar *name, gsize chunk_size);
+void      hd_arena_free          (HdArena *arena);
+
+gpointer  hd_arena_alloc         (HdArena *arena, gsize size);
+gpointer  hd_arena_memdup        (HdArena *arena, gconstpointer mem,
+                                  gsize size);
+gchar    *hd_arena_strdup_printf (HdArena *arena, const gchar *format,
+                                  ...) G_GNUC_PRINTF (2, 3);
+
+/* The links are allocated from @arena, so don't g_list_free() them. */
+GList    *hd_arena_list_prepend  (HdArena *arena, GList *list,
+                                  gpointer data);
+
+void      hd_arena_mark          (HdArena *arena, HdArenaMark *mark);
+void      hd_arena_release       (HdArena *arena, const HdArenaMark *mark);
+void      hd_arena_reset         (HdArena *arena);
+
+void      hd_arena_dump_stats    (HdArena *arena);
+
+G_END_DECLS
+
+#endif /* __HD_ARENA_H__ */
@@ -6,6 +6,7 @@
 #include "hd-render-manager.h"
 #include "hd-volume-profile.h"
 #include "hd-task-navigator.h"
+#include "hd-frame-governor.h"
 
 #include <glib.h>
 #include <mce/dbus-names.h>
@@ -23,273 +24,523 @@
 #define DSME_SIGNAL_INTERFACE "com.nokia.dsme.signal"
 #define DSME_SHUTDOWN_SIGNAL_NAME "shutdown_ind"
 
+/*
+ * Incoming signals are looked up in a table by their interned interface
+ * and member.  The ones which only carry a new state (tklock, call
+ * state, render manager state) are not handled right away but
+ * coalesced until the end of the main loop iteration, so a burst of
+ * them from MCE only makes us change state (and redraw) once, with
+ * the last value.  Any other signal flushes the coalesced ones first,
+ * so the order the signals arrived in is kept.  The display status is
+ * not coalesced because "dimmed" depends on the "on" or "off" before.
+ */
+typedef struct
+{
+  GQuark interface, member;
+} HdDbusSignalKey;
+
+typedef struct
+{
+  /* Must be the first member, we look up entries by it. */
+  HdDbusSignalKey key;
+
+  const gchar *interface, *member;
+  void (*handler) (DBusMessage *msg, HdCompMgr *hmgr);
+  gboolean coalesce;
+
+  /* The last message we're waiting to handle if we @coalesce,
+   * when it arrived and the connection's filter's argument. */
+  DBusMessage *pending;
+  GTimeVal pending_since;
+  HdCompMgr *hmgr;
+
+  /* Statistics for hd_dbus_dump_stats(), latencies are in microseconds
+   * from arrival to the end of handling. */
+  guint received, handled, coalesced;
+  gulong total_latency, max_latency;
+} HdDbusSignal;
+
+/* What a connection's filter is given. */
+typedef struct
+{
+  HdDbusSignal *signals;
+  guint nsignals;
+  GHashTable *lookup;
+
+  /* Whether to return DBUS_HANDLER_RESULT_HANDLED for our signals. */
+  gboolean consume;
+  HdCompMgr *hmgr;
+} HdDbusSignalTable;
+
 gboolean hd_dbus_display_is_off = FALSE;
+gboolean hd_dbus_display_is_dimmed = FALSE;
 gboolean hd_dbus_tklock_on = FALSE;
 HDRMStateEnum hd_dbus_state_before_tklock = HDRM_STATE_UNDEFINED;
 gboolean hd_dbus_cunt = FALSE;
 
 static DBusConnection *connection, *sysbus_conn;
+static gboolean call_active;
 
-static DBusHandlerResult
-hd_dbus_signal_handler (DBusConnection *conn, DBusMessage *msg, void *data)
+/* The coalesced signals waiting to be handled in order of arrival
+ * of their last message, and the idle source which handles them. */
+static GQueue pending_signals = G_QUEUE_INIT;
+static guint pending_signals_idle;
+
+/* Signal handlers */
+static gboolean
+get_int_arg (DBusMessage *msg, int *value)
 {
-  HdCompMgr  * hmgr = data;
+  DBusMessageIter args;
 
-  if (dbus_message_is_signal(msg,
-			     APPKILLER_SIGNAL_INTERFACE,
-			     APPKILLER_SIGNAL_NAME))
-    {
-      /* kill -TERM all programs started from the launcher unconditionally,
-       * this signal is used by Backup application */
-      hd_comp_mgr_kill_all_apps (hmgr);
+  if (!dbus_message_iter_init (msg, &args)
+      || dbus_message_iter_get_arg_type (&args) != DBUS_TYPE_INT32)
+    return FALSE;
+  dbus_message_iter_get_basic (&args, value);
+  return TRUE;
+}
 
-      return DBUS_HANDLER_RESULT_HANDLED;
-    }
-  else if (dbus_message_is_signal(msg,
-                                  TASKNAV_SIGNAL_INTERFACE,
-                                  TASKNAV_SIGNAL_NAME))
+static void
+hd_dbus_appkiller_exit (DBusMessage *msg, HdCompMgr *hmgr)
+{
+  /* kill -TERM all programs started from the launcher unconditionally,
+   * this signal is used by Backup application */
+  hd_comp_mgr_kill_all_apps (hmgr);
+}
+
+static void
+hd_dbus_exit_app_view (DBusMessage *msg, HdCompMgr *hmgr)
+{
+  if (STATE_IS_APP (hd_render_manager_get_state ()))
+    hd_render_manager_set_state (HDRM_STATE_TASK_NAV);
+}
+
+static void
+hd_dbus_set_state (DBusMessage *msg, HdCompMgr *hmgr)
+{
+  int sigvalue;
+
+  if (!get_int_arg (msg, &sigvalue))
+    return;
+
+  switch (sigvalue)
     {
-      if (STATE_IS_APP (hd_render_manager_get_state ()))
-	hd_render_manager_set_state (HDRM_STATE_TASK_NAV);
-      return DBUS_HANDLER_RESULT_HANDLED;
+      case HDRM_STATE_HOME:
+      case HDRM_STATE_HOME_PORTRAIT:
+      case HDRM_STATE_APP:
+      case HDRM_STATE_APP_PORTRAIT:
+      case HDRM_STATE_TASK_NAV:
+      case HDRM_STATE_LAUNCHER:
+      case HDRM_STATE_NON_COMPOSITED:
+      case HDRM_STATE_NON_COMP_PORT:
+        hd_render_manager_set_state (sigvalue);
+        break;
     }
-  else if (dbus_message_is_signal(msg,
-                                  TASKNAV_SIGNAL_INTERFACE,
-                                  "set_state"))
+}
+
+static void
+hd_dbus_activate_window (DBusMessage *msg, HdCompMgr *hmgr)
+{
+  int sigvalue;
+
+  if (get_int_arg (msg, &sigvalue))
+    hd_task_navigator_activate (sigvalue, -1, 0);
+}
+
+static void
+hd_dbus_close_window (DBusMessage *msg, HdCompMgr *hmgr)
+{
+  int sigvalue;
+
+  if (get_int_arg (msg, &sigvalue))
+    hd_task_navigator_activate (sigvalue, -1, 1);
+}
+
+static void
+hd_dbus_activate_window_time (DBusMessage *msg, HdCompMgr *hmgr)
+{
+  int sigvalue;
+
+  if (get_int_arg (msg, &sigvalue))
+    hd_task_navigator_activate (sigvalue, -2, 0);
+}
+
+static void
+hd_dbus_close_window_time (DBusMessage *msg, HdCompMgr *hmgr)
+{
+  int sigvalue;
+
+  if (get_int_arg (msg, &sigvalue))
+    hd_task_navigator_activate (sigvalue, -2, 1);
+}
+
+static void
+hd_dbus_launcher_activate (DBusMessage *msg, HdCompMgr *hmgr)
+{
+  int sigvalue;
+
+  if (get_int_arg (msg, &sigvalue))
+    hd_launcher_activate (sigvalue);
+}
+
+static void
+hd_dbus_shutdown_ind (DBusMessage *msg, HdCompMgr *hmgr)
+{
+  extern MBWindowManager *hd_mb_wm;
+  Window overlay;
+
+  g_warning ("%s: " DSME_SHUTDOWN_SIGNAL_NAME " from DSME", __func__);
+  /* send TERM to applications and exit without cleanup */
+  hd_volume_profile_set_silent (TRUE);
+  hd_comp_mgr_kill_all_apps (hmgr);
+  overlay = mb_wm_comp_mgr_clutter_get_overlay_window (
+                    MB_WM_COMP_MGR_CLUTTER (hmgr));
+  if (overlay != None)
     {
-      DBusMessageIter args;
-      int sigvalue;
- 
-      if ((dbus_message_iter_init(msg, &args)) && 
-          (DBUS_TYPE_INT32 == dbus_message_iter_get_arg_type(&args))) {
-        dbus_message_iter_get_basic(&args, &sigvalue);
-	switch(sigvalue) {
-	  case HDRM_STATE_HOME :
-          case HDRM_STATE_HOME_PORTRAIT:
-          case HDRM_STATE_APP:
-          case HDRM_STATE_APP_PORTRAIT:
-          case HDRM_STATE_TASK_NAV:
-	  case HDRM_STATE_LAUNCHER:
-	  case HDRM_STATE_NON_COMPOSITED:
-          case HDRM_STATE_NON_COMP_PORT:
-            hd_render_manager_set_state (sigvalue);
-            break;
-        }
-        return DBUS_HANDLER_RESULT_HANDLED;
-      }
+      /* needed because of the non-composite optimisations in X,
+       * otherwise we could show garbage if the shutdown screen is
+       * a bit slow or missing */
+      XClearWindow (hd_mb_wm->xdpy, overlay);
+      XFlush (hd_mb_wm->xdpy);
     }
-  else if (dbus_message_is_signal(msg,
-                                  TASKNAV_SIGNAL_INTERFACE,
-                                  "activate_window"))
+  _exit (0);
+}
+
+static void
+hd_dbus_tklock_mode_ind (DBusMessage *msg, HdCompMgr *hmgr)
+{
+  extern MBWindowManager *hd_mb_wm;
+  const char *mode;
+
+  if (!dbus_message_get_args (msg, NULL, DBUS_TYPE_STRING, &mode,
+                              DBUS_TYPE_INVALID))
+    return;
+
+  if (strcmp(mode, MCE_TK_LOCKED))
     {
-      DBusMessageIter args;
-      int sigvalue;
- 
-      if ((dbus_message_iter_init(msg, &args)) && 
-          (DBUS_TYPE_INT32 == dbus_message_iter_get_arg_type(&args))) {
-        dbus_message_iter_get_basic(&args, &sigvalue);
-	hd_task_navigator_activate(sigvalue, -1, 0);
-        return DBUS_HANDLER_RESULT_HANDLED;
-      }
+      hd_dbus_cunt = FALSE;
+      if (hd_dbus_tklock_on)
+        {
+          hd_dbus_tklock_on = FALSE;
+          /* if we avoided focusing a window during tklock, do it now
+           * (this only has an effect if no window is currently
+           * focused) */
+          mb_wm_unfocus_client (hd_mb_wm, NULL);
+
+          if (hd_dbus_state_before_tklock != HDRM_STATE_UNDEFINED)
+            /* possibly go back to the state before tklock */
+            hd_render_manager_set_state (HDRM_STATE_AFTER_TKLOCK);
+          else
+            hd_app_mgr_mce_activate_accel_if_needed (FALSE);
+        }
     }
-  else if (dbus_message_is_signal(msg,
-                                  TASKNAV_SIGNAL_INTERFACE,
-                                  "close_window"))
+  else if (!hd_dbus_tklock_on)
     {
-      DBusMessageIter args;
-      int sigvalue;
- 
-      if ((dbus_message_iter_init(msg, &args)) && 
-          (DBUS_TYPE_INT32 == dbus_message_iter_get_arg_type(&args))) {
-        dbus_message_iter_get_basic(&args, &sigvalue);
-	hd_task_navigator_activate(sigvalue, -1, 1);
-        return DBUS_HANDLER_RESULT_HANDLED;
-      }
+      /*
+       * The order of the events is either
+       * call_state=ringing, tklock_ind=locked, call_state=active or
+       * call_state=ringing, call_state=active, tklock_ind=locked.
+       * Handle both cases.
+       */
+      hd_dbus_state_before_tklock = hd_render_manager_get_state ();
+      hd_dbus_tklock_on = TRUE;
+      hd_dbus_cunt = call_active
+        && (hd_render_manager_get_state()
+            & (HDRM_STATE_HOME|HDRM_STATE_HOME_PORTRAIT));
+      hd_app_mgr_mce_activate_accel_if_needed (FALSE);
     }
-  else if (dbus_message_is_signal(msg,
-                                  TASKNAV_SIGNAL_INTERFACE,
-                                  "activate_window_time"))
+}
+
+static void
+hd_dbus_display_status_ind (DBusMessage *msg, HdCompMgr *hmgr)
+{
+  DBusMessageIter iter;
+  char *str = NULL;
+
+  if (!dbus_message_iter_init(msg, &iter))
+    return;
+  dbus_message_iter_get_basic(&iter, &str);
+  if (!str)
+    return;
+
+  if (strcmp (str, "on") == 0)
     {
-      DBusMessageIter args;
-      int sigvalue;
- 
-      if ((dbus_message_iter_init(msg, &args)) && 
-          (DBUS_TYPE_INT32 == dbus_message_iter_get_arg_type(&args))) {
-        dbus_message_iter_get_basic(&args, &sigvalue);
-	hd_task_navigator_activate(sigvalue, -2, 0);
-        return DBUS_HANDLER_RESULT_HANDLED;
-      }
+      ClutterActor *stage = clutter_stage_get_default ();
+      /* Allow redraws again... */
+      clutter_actor_show(
+          CLUTTER_ACTOR(hd_render_manager_get()));
+      clutter_actor_set_allow_redraw(stage, TRUE);
+      /* make a blocking redraw to draw any new window (such as
+       * the "swipe to unlock") first, otherwise just a black
+       * screen will be visible (see below) */
+      hd_dbus_display_is_off = FALSE;
+      hd_dbus_display_is_dimmed = FALSE;
+      clutter_redraw (CLUTTER_STAGE (stage));
+      if (hd_task_navigator_has_notifications ())
+        { /* (Re)start pulsating if we have notifs. */
+          HdTitleBar *tb = HD_TITLE_BAR (hd_render_manager_get_title_bar ());
+          hd_title_bar_set_switcher_pulse (tb, FALSE);
+          hd_title_bar_set_switcher_pulse (tb, TRUE);
+        }
+      hd_app_mgr_check_show_callui ();
     }
-  else if (dbus_message_is_signal(msg,
-                                  TASKNAV_SIGNAL_INTERFACE,
-                                  "close_window_time"))
+  else if (strcmp (str, "off") == 0)
     {
-      DBusMessageIter args;
-      int sigvalue;
- 
-      if ((dbus_message_iter_init(msg, &args)) && 
-          (DBUS_TYPE_INT32 == dbus_message_iter_get_arg_type(&args))) {
-        dbus_message_iter_get_basic(&args, &sigvalue);
-	hd_task_navigator_activate(sigvalue, -2, 1);
-        return DBUS_HANDLER_RESULT_HANDLED;
-      }
+      ClutterActor *stage = clutter_stage_get_default ();
+      /* Stop redraws from anything. We do this on the stage
+       * because Rotation does it on HDRM, and we don't want to
+       * conflict. */
+      clutter_actor_hide(
+          CLUTTER_ACTOR(hd_render_manager_get()));
+      clutter_actor_set_allow_redraw(stage, FALSE);
+      hd_dbus_display_is_off = TRUE;
+      hd_dbus_display_is_dimmed = FALSE;
+      /* Hiding before set_allow_redraw will queue a redraw,
+       * which will draw a black screen (because hdrm is hidden).
+       * This is needed for bug 139928 so that there is
+       * absolutely no flicker of the previous screen
+       * contents before the lock window appears. */
+      clutter_redraw (CLUTTER_STAGE (stage));
     }
-  else if (dbus_message_is_signal(msg, TASKNAV_SIGNAL_INTERFACE, "launcher_activate"))
+  else if (strcmp (str, "dimmed") == 0)
+    hd_dbus_display_is_dimmed = TRUE;
+
+  hd_frame_governor_update ();
+  hd_comp_mgr_update_applets_on_current_desktop_property (hmgr);
+}
+
+static void
+hd_dbus_call_state_ind (DBusMessage *msg, HdCompMgr *hmgr)
+{
+  const char *state;
+
+  /* Watch the call state.  If we got an active call tell hdrm to
+   * try keeping the call-ui in the foreground after tklock is closed. */
+  if (!dbus_message_get_args (msg, NULL, DBUS_TYPE_STRING, &state,
+                              DBUS_TYPE_INVALID))
+    return;
+  call_active = !strcmp(state, "active");
+  hd_dbus_cunt = call_active && hd_dbus_tklock_on
+    && (hd_render_manager_get_state()
+        & (HDRM_STATE_HOME|HDRM_STATE_HOME_PORTRAIT));
+}
+
+static HdDbusSignal session_signals[] =
+{
+  { .interface = APPKILLER_SIGNAL_INTERFACE,
+    .member    = APPKILLER_SIGNAL_NAME,
+    .handler   = hd_dbus_appkiller_exit },
+  { .interface = TASKNAV_SIGNAL_INTERFACE,
+    .member    = TASKNAV_SIGNAL_NAME,
+    .handler   = hd_dbus_exit_app_view },
+  { .interface = TASKNAV_SIGNAL_INTERFACE,
+    .member    = "set_state",
+    .handler   = hd_dbus_set_state,
+    .coalesce  = TRUE },
+  { .interface = TASKNAV_SIGNAL_INTERFACE,
+    .member    = "activate_window",
+    .handler   = hd_dbus_activate_window },
+  { .interface = TASKNAV_SIGNAL_INTERFACE,
+    .member    = "close_window",
+    .handler   = hd_dbus_close_window },
+  { .interface = TASKNAV_SIGNAL_INTERFACE,
+    .member    = "activate_window_time",
+    .handler   = hd_dbus_activate_window_time },
+  { .interface = TASKNAV_SIGNAL_INTERFACE,
+    .member    = "close_window_time",
+    .handler   = hd_dbus_close_window_time },
+  { .interface = TASKNAV_SIGNAL_INTERFACE,
+    .member    = "launcher_activate",
+    .handler   = hd_dbus_launcher_activate },
+};
+
+static HdDbusSignal system_signals[] =
+{
+  { .interface = DSME_SIGNAL_INTERFACE,
+    .member    = DSME_SHUTDOWN_SIGNAL_NAME,
+    .handler   = hd_dbus_shutdown_ind },
+  { .interface = MCE_SIGNAL_IF,
+    .member    = "tklock_mode_ind",
+    .handler   = hd_dbus_tklock_mode_ind,
+    .coalesce  = TRUE },
+  { .interface = MCE_SIGNAL_IF,
+    .member    = MCE_DISPLAY_SIG,
+    .handler   = hd_dbus_display_status_ind },
+  { .interface = MCE_SIGNAL_IF,
+    .member    = MCE_CALL_STATE_SIG,
+    .handler   = hd_dbus_call_state_ind,
+    .coalesce  = TRUE },
+};
+
+static HdDbusSignalTable session_table =
+{
+  session_signals, G_N_ELEMENTS (session_signals), NULL, TRUE,
+};
+
+static HdDbusSignalTable system_table =
+{
+  system_signals, G_N_ELEMENTS (system_signals), NULL, FALSE,
+};
+
+/* Dispatching */
+static guint
+hd_dbus_signal_key_hash (gconstpointer key)
+{
+  const HdDbusSignalKey *k = key;
+  return (k->interface << 16) ^ k->member;
+}
+
+static gboolean
+hd_dbus_signal_key_equal (gconstpointer a, gconstpointer b)
+{
+  const HdDbusSignalKey *ka = a, *kb = b;
+  return ka->interface == kb->interface && ka->member == kb->member;
+}
+
+static void
+hd_dbus_signal_table_init (HdDbusSignalTable *table, HdCompMgr *hmgr)
+{
+  guint i;
+
+  table->hmgr = hmgr;
+  table->lookup = g_hash_table_new (hd_dbus_signal_key_hash,
+                                    hd_dbus_signal_key_equal);
+  for (i = 0; i < table->nsignals; i++)
     {
-	    DBusMessageIter args;
-	    int sigvalue;
-
-	    if ((dbus_message_iter_init(msg, &args)) && 
-			    (DBUS_TYPE_INT32 == dbus_message_iter_get_arg_type(&args))) {
-		    dbus_message_iter_get_basic(&args, &sigvalue);
-		    hd_launcher_activate(sigvalue);
-		    return DBUS_HANDLER_RESULT_HANDLED;
-	    }
+      HdDbusSignal *sig = &table->signals[i];
+
+      sig->key.interface = g_quark_from_static_string (sig->interface);
+      sig->key.member    = g_quark_from_static_string (sig->member);
+      g_hash_table_insert (table->lookup, &sig->key, sig);
     }
+}
 
+/* Returns the microseconds elapsed since @since. */
+static gulong
+usecs_since (const GTimeVal *since)
+{
+  GTimeVal now;
+
+  g_get_current_time (&now);
+  return (now.tv_sec - since->tv_sec) * G_USEC_PER_SEC
+    + now.tv_usec - since->tv_usec;
+}
 
+/* Call @sig's handler with @msg, which arrived at @arrived. */
+static void
+hd_dbus_handle_signal (HdDbusSignal *sig, HdCompMgr *hmgr,
+                       DBusMessage *msg, const GTimeVal *arrived)
+{
+  gulong latency;
 
+  sig->handler (msg, hmgr);
 
-  return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+  latency = usecs_since (arrived);
+  sig->handled++;
+  sig->total_latency += latency;
+  if (sig->max_latency < latency)
+    sig->max_latency = latency;
 }
 
-static DBusHandlerResult
-hd_dbus_system_bus_signal_handler (DBusConnection *conn,
-                                   DBusMessage *msg, void *data)
+/* Handle the coalesced signals in the order their last message arrived. */
+static void
+hd_dbus_flush_pending_signals (void)
 {
-  HdCompMgr  * hmgr = data;
-  extern MBWindowManager *hd_mb_wm;
-  static gboolean call_active;
+  HdDbusSignal *sig;
 
-  if (dbus_message_is_signal(msg, DSME_SIGNAL_INTERFACE,
-			     DSME_SHUTDOWN_SIGNAL_NAME))
+  while ((sig = g_queue_pop_head (&pending_signals)) != NULL)
     {
-      Window overlay;
-      g_warning ("%s: " DSME_SHUTDOWN_SIGNAL_NAME " from DSME", __func__);
-      /* send TERM to applications and exit without cleanup */
-      hd_volume_profile_set_silent (TRUE);
-      hd_comp_mgr_kill_all_apps (hmgr);
-      overlay = mb_wm_comp_mgr_clutter_get_overlay_window (
-                        MB_WM_COMP_MGR_CLUTTER (hmgr));
-      if (overlay != None)
-        {
-          /* needed because of the non-composite optimisations in X,
-           * otherwise we could show garbage if the shutdown screen is
-           * a bit slow or missing */
-          XClearWindow (hd_mb_wm->xdpy, overlay);
-          XFlush (hd_mb_wm->xdpy);
-        }
-      _exit (0);
+      DBusMessage *msg = sig->pending;
+
+      sig->pending = NULL;
+      hd_dbus_handle_signal (sig, sig->hmgr, msg, &sig->pending_since);
+      dbus_message_unref (msg);
     }
-  else if (dbus_message_is_signal (msg, MCE_SIGNAL_IF, "tklock_mode_ind"))
-    {
-      const char *mode;
+}
 
-      if (dbus_message_get_args (msg, NULL, DBUS_TYPE_STRING, &mode,
-                                 DBUS_TYPE_INVALID));
-        {
-          if (strcmp(mode, MCE_TK_LOCKED))
-            {
-              hd_dbus_cunt = FALSE;
-              if (hd_dbus_tklock_on)
-                {
-                  hd_dbus_tklock_on = FALSE;
-                  /* if we avoided focusing a window during tklock, do it now
-                   * (this only has an effect if no window is currently
-                   * focused) */
-                  mb_wm_unfocus_client (hd_mb_wm, NULL);
-
-                  if (hd_dbus_state_before_tklock != HDRM_STATE_UNDEFINED)
-                    /* possibly go back to the state before tklock */
-                    hd_render_manager_set_state (HDRM_STATE_AFTER_TKLOCK);
-                  else
-                    hd_app_mgr_mce_activate_accel_if_needed (FALSE);
-                }
-            }
-          else if (!hd_dbus_tklock_on)
-            {
-              /*
-               * The order of the events is either
-               * call_state=ringing, tklock_ind=locked, call_state=active or
-               * call_state=ringing, call_state=active, tklock_ind=locked.
-               * Handle both cases.
-               */
-              hd_dbus_state_before_tklock = hd_render_manager_get_state ();
-              hd_dbus_tklock_on = TRUE;
-              hd_dbus_cunt = call_active
-                && (hd_render_manager_get_state()
-                    & (HDRM_STATE_HOME|HDRM_STATE_HOME_PORTRAIT));
-              hd_app_mgr_mce_activate_accel_if_needed (FALSE);
-            }
+static gboolean
+hd_dbus_pending_signals_idle (gpointer unused)
+{
+  pending_signals_idle = 0;
+  hd_dbus_flush_pending_signals ();
+  return FALSE;
+}
+
+static DBusHandlerResult
+hd_dbus_signal_filter (DBusConnection *conn, DBusMessage *msg, void *data)
+{
+  HdDbusSignalTable *table = data;
+  HdDbusSignalKey key;
+  HdDbusSignal *sig;
+  GTimeVal now;
+
+  if (dbus_message_get_type (msg) != DBUS_MESSAGE_TYPE_SIGNAL)
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+  /* If the strings have never been interned they can't be ours. */
+  if (!(key.interface = g_quark_try_string (dbus_message_get_interface (msg)))
+      || !(key.member = g_quark_try_string (dbus_message_get_member (msg))))
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+  if (!(sig = g_hash_table_lookup (table->lookup, &key)))
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+  sig->received++;
+  g_get_current_time (&now);
+  if (sig->coalesce)
+    {
+      if (sig->pending)
+        { /* Supersede the previous value, but keep the order of arrival. */
+          sig->coalesced++;
+          dbus_message_unref (sig->pending);
+          g_queue_remove (&pending_signals, sig);
         }
+      sig->pending = dbus_message_ref (msg);
+      sig->pending_since = now;
+      sig->hmgr = table->hmgr;
+      g_queue_push_tail (&pending_signals, sig);
+
+      /* Run before the redraw of this main loop iteration. */
+      if (!pending_signals_idle)
+        pending_signals_idle = g_idle_add_full (G_PRIORITY_DEFAULT,
+                                       hd_dbus_pending_signals_idle,
+                                       NULL, NULL);
     }
-  else if (dbus_message_is_signal (msg, MCE_SIGNAL_IF, "display_status_ind"))
+  else
     {
-      DBusMessageIter iter;
-
-      if (dbus_message_iter_init(msg, &iter))
-        {
-          char *str = NULL;
-          dbus_message_iter_get_basic(&iter, &str);
-          if (str)
-            {
-              if (strcmp (str, "on") == 0)
-                {
-                  ClutterActor *stage = clutter_stage_get_default ();
-                  /* Allow redraws again... */
-                  clutter_actor_show(
-                      CLUTTER_ACTOR(hd_render_manager_get()));
-                  clutter_actor_set_allow_redraw(stage, TRUE);
-                  /* make a blocking redraw to draw any new window (such as
-                   * the "swipe to unlock") first, otherwise just a black
-                   * screen will be visible (see below) */
-                  hd_dbus_display_is_off = FALSE;
-                  clutter_redraw (CLUTTER_STAGE (stage));
-                  if (hd_task_navigator_has_notifications ())
-                    { /* (Re)start pulsating if we have notifs. */
-                      HdTitleBar *tb = HD_TITLE_BAR (hd_render_manager_get_title_bar ());
-                      hd_title_bar_set_switcher_pulse (tb, FALSE);
-                      hd_title_bar_set_switcher_pulse (tb, TRUE);
-                    }
-                  hd_app_mgr_check_show_callui ();
-                }
-              else if (strcmp (str, "off") == 0)
-                {
-                  ClutterActor *stage = clutter_stage_get_default ();
-                  /* Stop redraws from anything. We do this on the stage
-                   * because Rotation does it on HDRM, and we don't want to
-                   * conflict. */
-                  clutter_actor_hide(
-                      CLUTTER_ACTOR(hd_render_manager_get()));
-                  clutter_actor_set_allow_redraw(stage, FALSE);
-                  hd_dbus_display_is_off = TRUE;
-                  /* Hiding before set_allow_redraw will queue a redraw,
-                   * which will draw a black screen (because hdrm is hidden).
-                   * This is needed for bug 139928 so that there is
-                   * absolutely no flicker of the previous screen
-                   * contents before the lock window appears. */
-                  clutter_redraw (CLUTTER_STAGE (stage));
-                }
-
-              hd_comp_mgr_update_applets_on_current_desktop_property (hmgr);
-            }
-        }
+      hd_dbus_flush_pending_signals ();
+      hd_dbus_handle_signal (sig, table->hmgr, msg, &now);
     }
-  else if (dbus_message_is_signal (msg, MCE_SIGNAL_IF, "sig_call_state_ind"))
+
+  return table->consume
+    ? DBUS_HANDLER_RESULT_HANDLED
+    : DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+static void
+hd_dbus_dump_table_stats (const HdDbusSignalTable *table)
+{
+  guint i;
+
+  for (i = 0; i < table->nsignals; i++)
     {
-      const char *state;
-
-      /* Watch the call state.  If we got an active call tell hdrm to
-       * try keeping the call-ui in the foreground after tklock is closed. */
-      dbus_message_get_args (msg, NULL, DBUS_TYPE_STRING, &state,
-                             DBUS_TYPE_INVALID);
-      call_active = !strcmp(state, "active");
-      hd_dbus_cunt = call_active && hd_dbus_tklock_on
-        && (hd_render_manager_get_state()
-            & (HDRM_STATE_HOME|HDRM_STATE_HOME_PORTRAIT));
+      const HdDbusSignal *sig = &table->signals[i];
+
+      if (!sig->received)
+        continue;
+      g_debug ("  %s.%s: received=%u, handled=%u, coalesced=%u, "
+               "latency avg=%luus max=%luus", sig->interface, sig->member,
+               sig->received, sig->handled, sig->coalesced,
+               sig->handled ? sig->total_latency / sig->handled : 0,
+               sig->max_latency);
     }
+}
 
-  return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+/* Print how many of each signal we got and how long they took. */
+void
+hd_dbus_dump_stats (void)
+{
+  g_debug ("D-Bus signals:");
+  hd_dbus_dump_table_stats (&session_table);
+  hd_dbus_dump_table_stats (&system_table);
 }
 
 static void
@@ -437,8 +688,9 @@ hd_dbus_init (HdCompMgr * hmgr)
       dbus_bus_add_match (connection, "type='signal', interface='"
                           TASKNAV_SIGNAL_INTERFACE "'", NULL);
 
-      dbus_connection_add_filter (connection, hd_dbus_signal_handler,
-				  hmgr, NULL);
+      hd_dbus_signal_table_init (&session_table, hmgr);
+      dbus_connection_add_filter (connection, hd_dbus_signal_filter,
+				  &session_table, NULL);
 
       /* system bus */
       dbus_bus_add_match (sysbus_conn, "type='signal', interface='"
@@ -457,9 +709,9 @@ hd_dbus_init (HdCompMgr * hmgr)
                           "interface='" MCE_SIGNAL_IF "',"
                           "member='" MCE_CALL_STATE_SIG "'", NULL);
 
-      dbus_connection_add_filter (sysbus_conn,
-                                  hd_dbus_system_bus_signal_handler,
-                                  hmgr, NULL);
+      hd_dbus_signal_table_init (&system_table, hmgr);
+      dbus_connection_add_filter (sysbus_conn, hd_dbus_signal_filter,
+                                  &system_table, NULL);
     }
 
   return connection;
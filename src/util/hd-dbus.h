@@ -18,4 +18,5 @@ gboolean hd_dbus_launch_service (DBusConnection *connection,
 				 const gchar    *launch_param);
 void hd_dbus_send_event (char *value);
 void hd_dbus_send_desktop_orientation_changed (gboolean to_portrait);
+void hd_dbus_dump_stats (void);
 #endif
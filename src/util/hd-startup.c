@@ -0,0 +1,222 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+
+#include <stdio.h>
+#include <errno.h>
+
+#include "hd-startup.h"
+
+/* Where to write the timeline, if anywhere. */
+#define TIMELINE_ENV_VAR        "HD_STARTUP_TIMELINE"
+
+/* Run the deferred tasks even if the stage is never painted. */
+#define FIRST_FRAME_TIMEOUT     10
+
+typedef struct
+{
+  const gchar *phase;
+  gdouble      when; /* seconds since the first mark */
+} Mark;
+
+typedef struct
+{
+  const gchar   *name;
+  gint           priority;
+  HdStartupTask  func;
+  gpointer       data;
+} Task;
+
+static struct
+{
+  GTimer *timer;
+  GArray *marks;
+
+  /* Task:s waiting to be run, the most urgent first. */
+  GList  *tasks;
+
+  /* Set when the first frame has been painted or we gave up waiting
+   * for it, and the tasks can be run. */
+  gboolean ready;
+  guint    paint_handler, timeout_id, idle_id;
+  ClutterActor *stage;
+} Startup;
+
+void
+hd_startup_mark (const gchar *phase)
+{
+  Mark mark;
+
+  if (!Startup.timer)
+    {
+      Startup.timer = g_timer_new ();
+      Startup.marks = g_array_new (FALSE, FALSE, sizeof (Mark));
+    }
+
+  mark.phase = phase;
+  mark.when  = g_timer_elapsed (Startup.timer, NULL);
+  g_array_append_val (Startup.marks, mark);
+}
+
+static void
+hd_startup_write_timeline (void)
+{
+  const gchar *fname;
+  FILE *out;
+  guint i;
+
+  if (!(fname = g_getenv (TIMELINE_ENV_VAR)))
+    return;
+  if (!(out = fopen (fname, "w")))
+    {
+      g_warning ("%s: %s", fname, g_strerror (errno));
+      return;
+    }
+
+  for (i = 0; i < Startup.marks->len; i++)
+    {
+      const Mark *mark = &g_array_index (Startup.marks, Mark, i);
+      gdouble prev = i > 0
+        ? g_array_index (Startup.marks, Mark, i-1).when : 0;
+
+      fprintf (out, "%9.1f ms %+9.1f ms  %s\n", mark->when * 1000,
+               (mark->when - prev) * 1000, mark->phase);
+    }
+
+  fclose (out);
+}
+
+/* Never says equal, so tasks of the same priority are run in the order
+ * they were deferred. */
+static gint
+task_cmp (gconstpointer a, gconstpointer b)
+{
+  return ((const Task *)a)->priority < ((const Task *)b)->priority ? -1 : 1;
+}
+
+/* Run one task at a time, so input and redraws can come in between. */
+static gboolean
+hd_startup_run_next (gpointer unused)
+{
+  Task *task;
+
+  task = Startup.tasks->data;
+  Startup.tasks = g_list_delete_link (Startup.tasks, Startup.tasks);
+  task->func (task->data);
+  hd_startup_mark (task->name);
+  g_slice_free (Task, task);
+
+  if (Startup.tasks)
+    return TRUE;
+
+  Startup.idle_id = 0;
+  hd_startup_write_timeline ();
+  return FALSE;
+}
+
+static void
+hd_startup_schedule (void)
+{
+  if (Startup.ready && Startup.tasks && !Startup.idle_id)
+    Startup.idle_id = g_idle_add (hd_startup_run_next, NULL);
+}
+
+/*
+ * Call @func with @data after the first frame has been painted.  Tasks
+ * of lower @priority values go first, like the priorities of GLib.
+ * @name must be a string literal, it identifies the task in the timeline.
+ */
+void
+hd_startup_defer (const gchar *name, gint priority,
+                  HdStartupTask func, gpointer data)
+{
+  Task *task;
+
+  task = g_slice_new (Task);
+  task->name     = name;
+  task->priority = priority;
+  task->func     = func;
+  task->data     = data;
+  Startup.tasks = g_list_insert_sorted (Startup.tasks, task, task_cmp);
+  hd_startup_schedule ();
+}
+
+static void
+hd_startup_first_frame (const gchar *why)
+{
+  if (Startup.ready)
+    return;
+  Startup.ready = TRUE;
+
+  g_signal_handler_disconnect (Startup.stage, Startup.paint_handler);
+  if (Startup.timeout_id)
+    g_source_remove (Startup.timeout_id);
+  hd_startup_mark (why);
+
+  hd_startup_schedule ();
+  if (!Startup.tasks)
+    hd_startup_write_timeline ();
+}
+
+static void
+hd_startup_stage_painted (ClutterActor *stage)
+{
+  hd_startup_first_frame ("first frame");
+}
+
+static gboolean
+hd_startup_first_frame_timeout (gpointer unused)
+{
+  Startup.timeout_id = 0;
+  hd_startup_first_frame ("first frame timed out");
+  return FALSE;
+}
+
+/* Start running the deferred tasks after @stage is first painted. */
+void
+hd_startup_run_after_paint (ClutterActor *stage)
+{
+  Startup.stage = stage;
+  Startup.paint_handler = g_signal_connect_after (stage, "paint",
+                                  G_CALLBACK (hd_startup_stage_painted),
+                                  NULL);
+  Startup.timeout_id = g_timeout_add_seconds (FIRST_FRAME_TIMEOUT,
+                                  hd_startup_first_frame_timeout, NULL);
+}
+
+void
+hd_startup_dump (void)
+{
+  GList *li;
+  guint i;
+
+  if (!Startup.marks)
+    return;
+
+  g_debug ("startup:");
+  for (i = 0; i < Startup.marks->len; i++)
+    {
+      const Mark *mark = &g_array_index (Startup.marks, Mark, i);
+      g_debug ("  %9.1f ms  %s", mark->when * 1000, mark->phase);
+    }
+  for (li = Startup.tasks; li; li = li->next)
+    g_debug ("  deferred: %s", ((const Task *)li->data)->name);
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+
+/*
+ * Startup tracing and deferred initialisation.  hd_startup_mark() notes
+ * how long it took to get to a phase of the startup.  Work which is not
+ * needed for the first frame is hd_startup_defer()red until the stage
+ * has been painted, then run one task per main loop iteration in the
+ * order of their priority.  When all of them are done the timeline is
+ * written to $HD_STARTUP_TIMELINE if it's set.
+ */
+
+#ifndef __HD_STARTUP_H__
+#define __HD_STARTUP_H__
+
+#include <clutter/clutter.h>
+
+G_BEGIN_DECLS
+
+typedef void (*HdStartupTask) (gpointer data);
+
+void hd_startup_mark            (const gchar *phase);
+void hd_startup_defer           (const gchar *name, gint priority,
+                                 HdStartupTask func, gpointer data);
+void hd_startup_run_after_paint (ClutterActor *stage);
+void hd_startup_dump            (void);
+
+G_END_DECLS
+
+#endif /* __HD_STARTUP_H__ */
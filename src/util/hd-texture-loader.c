@@ -0,0 +1,539 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+#include <cogl/cogl.h>
+
+#include "hd-texture-loader.h"
+#include "hildon-desktop.h"
+
+/* GL enums of the compressed formats, in case the headers don't have them. */
+#ifndef GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG
+# define GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG   0x8C00
+# define GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG   0x8C01
+# define GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG  0x8C02
+# define GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG  0x8C03
+#endif
+#ifndef GL_ETC1_RGB8_OES
+# define GL_ETC1_RGB8_OES                     0x8D64
+#endif
+
+/* The legacy (v2) PVR header, which hd_pvr_texture_save() writes. */
+#define PVR_HEADER_SIZE         52
+#define PVR_MAGIC               0x21525650 /* "PVR!" */
+#define PVR_FLAG_ALPHA          0x8000
+enum
+{
+  PVR_RGBA_4444 = 0x10,
+  PVR_RGBA_5551 = 0x11,
+  PVR_RGBA_8888 = 0x12,
+  PVR_RGB_565   = 0x13,
+  PVR_RGB_888   = 0x15,
+  PVR_PVRTC2    = 0x18,
+  PVR_PVRTC4    = 0x19,
+};
+
+#define KTX_HEADER_SIZE         64
+#define KTX_ENDIANNESS          0x04030201
+static const guint8 Ktx_identifier[12] =
+  { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+/* A mapped texture file and what we found in its header. */
+typedef struct
+{
+  guint8 *map;
+  gsize   size;
+
+  guint   width, height;
+
+  /* Where the first mipmap level is in @map and how long it is. */
+  const guint8 *data;
+  gsize   data_size;
+
+  /* Either @compressed is the GL internal format or @format and
+   * @rowstride describe raw pixels. */
+  GLenum  compressed;
+  CoglPixelFormat format;
+  guint   rowstride;
+  gboolean has_alpha;
+} TextureFile;
+
+struct _HdTextureLoad
+{
+  gchar           *fname;
+  HdTextureLoaded  func;
+  gpointer         data;
+
+  /* Set by hd_texture_loader_cancel(), the load is dropped when
+   * it comes back to the main thread. */
+  gboolean         cancelled;
+
+  /* What the loading thread found: the mapped file, or %NULL and
+   * @error, which is %NULL too if it's not a PVR or KTX file. */
+  TextureFile     *file;
+  GError          *error;
+};
+
+GQuark
+hd_texture_loader_error_quark (void)
+{
+  return g_quark_from_static_string ("hd-texture-loader-error-quark");
+}
+
+/* Size of the top level of a PVRTC texture. */
+static gsize
+pvrtc_size (guint width, guint height, gboolean two_bpp)
+{
+  return two_bpp
+    ? (gsize)MAX (width, 16) * MAX (height, 8) * 2 / 8
+    : (gsize)MAX (width,  8) * MAX (height, 8) * 4 / 8;
+}
+
+static gboolean
+parse_pvr (TextureFile *file, GError **error)
+{
+  const guint32 *hdr = (const guint32 *)file->map;
+  guint bpp;
+
+  /* Everything we need is in the legacy header and the newer ones
+   * are not written by anybody we know. */
+  if (hdr[0] != PVR_HEADER_SIZE)
+    goto unsupported;
+
+  file->height    = hdr[1];
+  file->width     = hdr[2];
+  file->has_alpha = (hdr[4] & PVR_FLAG_ALPHA) != 0;
+  switch (hdr[4] & 0xff)
+    {
+      case PVR_PVRTC2:
+        file->compressed = file->has_alpha
+          ? GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG
+          : GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG;
+        file->data_size = pvrtc_size (file->width, file->height, TRUE);
+        break;
+      case PVR_PVRTC4:
+        file->compressed = file->has_alpha
+          ? GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG
+          : GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG;
+        file->data_size = pvrtc_size (file->width, file->height, FALSE);
+        break;
+      case PVR_RGBA_4444:
+        file->format = COGL_PIXEL_FORMAT_RGBA_4444;
+        bpp = 2;
+        goto raw;
+      case PVR_RGBA_5551:
+        file->format = COGL_PIXEL_FORMAT_RGBA_5551;
+        bpp = 2;
+        goto raw;
+      case PVR_RGBA_8888:
+        file->format = COGL_PIXEL_FORMAT_RGBA_8888;
+        bpp = 4;
+        goto raw;
+      case PVR_RGB_565:
+        file->format = COGL_PIXEL_FORMAT_RGB_565;
+        bpp = 2;
+        goto raw;
+      case PVR_RGB_888:
+        file->format = COGL_PIXEL_FORMAT_RGB_888;
+        bpp = 3;
+raw:
+        file->rowstride = file->width * bpp;
+        file->data_size = (gsize)file->rowstride * file->height;
+        break;
+      default:
+        goto unsupported;
+    }
+
+  file->data = file->map + PVR_HEADER_SIZE;
+  if (hdr[5] < file->data_size
+      || file->size - PVR_HEADER_SIZE < file->data_size)
+    {
+      g_set_error (error, HD_TEXTURE_LOADER_ERROR,
+                   HD_TEXTURE_LOADER_ERROR_CORRUPT, "truncated PVR file");
+      return FALSE;
+    }
+  return TRUE;
+
+unsupported:
+  g_set_error (error, HD_TEXTURE_LOADER_ERROR,
+               HD_TEXTURE_LOADER_ERROR_UNSUPPORTED,
+               "unsupported PVR header (size %u, flags 0x%x)",
+               hdr[0], hdr[4]);
+  return FALSE;
+}
+
+static gboolean
+parse_ktx (TextureFile *file, GError **error)
+{
+  const guint32 *hdr = (const guint32 *)(file->map + sizeof (Ktx_identifier));
+  guint32 gltype, glformat, glinternal, kvsize, bpp;
+  gsize offset;
+
+  /* endianness, glType, glTypeSize, glFormat, glInternalFormat,
+   * glBaseInternalFormat, pixelWidth, pixelHeight, pixelDepth,
+   * numberOfArrayElements, numberOfFaces, numberOfMipmapLevels,
+   * bytesOfKeyValueData */
+  if (hdr[0] != KTX_ENDIANNESS || hdr[8] != 0 || hdr[9] != 0 || hdr[10] != 1)
+    {
+      g_set_error (error, HD_TEXTURE_LOADER_ERROR,
+                   HD_TEXTURE_LOADER_ERROR_UNSUPPORTED,
+                   "only plain 2D KTX textures of our endianness "
+                   "are supported");
+      return FALSE;
+    }
+
+  gltype     = hdr[1];
+  glformat   = hdr[3];
+  glinternal = hdr[4];
+  file->width  = hdr[6];
+  file->height = hdr[7];
+  kvsize = hdr[12];
+
+  if (gltype == 0)
+    switch (glinternal)
+      {
+        case GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG:
+        case GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG:
+          file->has_alpha = TRUE;
+          /* fall through */
+        case GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG:
+        case GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG:
+        case GL_ETC1_RGB8_OES:
+          file->compressed = glinternal;
+          break;
+        default:
+          goto unsupported;
+      }
+  else if (gltype == GL_UNSIGNED_BYTE && glformat == GL_RGBA)
+    {
+      file->format = COGL_PIXEL_FORMAT_RGBA_8888;
+      file->has_alpha = TRUE;
+      bpp = 4;
+    }
+  else if (gltype == GL_UNSIGNED_BYTE && glformat == GL_RGB)
+    {
+      file->format = COGL_PIXEL_FORMAT_RGB_888;
+      bpp = 3;
+    }
+  else if (gltype == GL_UNSIGNED_SHORT_5_6_5 && glformat == GL_RGB)
+    {
+      file->format = COGL_PIXEL_FORMAT_RGB_565;
+      bpp = 2;
+    }
+  else
+    goto unsupported;
+
+  /* Rows of uncompressed images are padded to 4 bytes. */
+  if (!file->compressed)
+    file->rowstride = (file->width * bpp + 3) & ~3;
+
+  /* The key/value pairs are followed by the size of the first level. */
+  offset = (gsize)sizeof (Ktx_identifier) + KTX_HEADER_SIZE - 12 + kvsize;
+  if (kvsize > file->size || offset + 4 > file->size)
+    goto truncated;
+  file->data_size = *(const guint32 *)(file->map + offset);
+  file->data = file->map + offset + 4;
+  if (file->data_size > file->size - offset - 4
+      || (!file->compressed
+          && file->data_size < (gsize)file->rowstride * file->height))
+    goto truncated;
+  return TRUE;
+
+truncated:
+  g_set_error (error, HD_TEXTURE_LOADER_ERROR,
+               HD_TEXTURE_LOADER_ERROR_CORRUPT, "truncated KTX file");
+  return FALSE;
+
+unsupported:
+  g_set_error (error, HD_TEXTURE_LOADER_ERROR,
+               HD_TEXTURE_LOADER_ERROR_UNSUPPORTED,
+               "unsupported KTX format (type 0x%x, format 0x%x, "
+               "internal format 0x%x)", gltype, glformat, glinternal);
+  return FALSE;
+}
+
+static void
+texture_file_unmap (TextureFile *file)
+{
+  munmap (file->map, file->size);
+  g_slice_free (TextureFile, file);
+}
+
+/*
+ * Maps @fname and validates its header.  Returns %NULL and sets @error
+ * if it's broken, or returns %NULL without setting @error if it's not
+ * a PVR or KTX file at all.  Doesn't touch GL, so it's safe to call
+ * from any thread.
+ */
+static TextureFile *
+texture_file_map (const gchar *fname, GError **error)
+{
+  TextureFile *file;
+  struct stat sbuf;
+  void *map;
+  int fd;
+
+  if ((fd = open (fname, O_RDONLY)) < 0)
+    {
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                   "%s: %s", fname, g_strerror (errno));
+      return NULL;
+    }
+
+  if (fstat (fd, &sbuf) < 0)
+    {
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                   "%s: %s", fname, g_strerror (errno));
+      close (fd);
+      return NULL;
+    }
+  if (sbuf.st_size < MAX (PVR_HEADER_SIZE,
+                          sizeof (Ktx_identifier) + KTX_HEADER_SIZE - 12))
+    { /* Too small to be anything we know. */
+      close (fd);
+      return NULL;
+    }
+
+  map = mmap (NULL, sbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED)
+    {
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                   "%s: %s", fname, g_strerror (errno));
+      return NULL;
+    }
+
+  file = g_slice_new0 (TextureFile);
+  file->map  = map;
+  file->size = sbuf.st_size;
+
+  if (((const guint32 *)file->map)[11] == PVR_MAGIC)
+    {
+      if (parse_pvr (file, error))
+        return file;
+    }
+  else if (!memcmp (file->map, Ktx_identifier, sizeof (Ktx_identifier)))
+    {
+      if (parse_ktx (file, error))
+        return file;
+    }
+
+  texture_file_unmap (file);
+  return NULL;
+}
+
+static void
+delete_gl_texture (gpointer name, GObject *where_the_actor_was)
+{
+  GLuint tex = GPOINTER_TO_UINT (name);
+  glDeleteTextures (1, &tex);
+}
+
+/* Makes a #ClutterTexture of @file.  Must be called in the main thread. */
+static ClutterActor *
+texture_file_upload (TextureFile *file, const gchar *fname, GError **error)
+{
+  ClutterActor *actor;
+  CoglHandle tex;
+
+  if (!file->compressed)
+    { /* Don't slice it, the data is in the format we want to keep it in,
+       * so cogl can hand the mapping over to GL as it is. */
+      tex = cogl_texture_new_from_data (file->width, file->height, -1, FALSE,
+                                        file->format, file->format,
+                                        file->rowstride, file->data);
+      if (tex == COGL_INVALID_HANDLE)
+        goto upload_failed;
+
+      actor = clutter_texture_new ();
+      clutter_texture_set_cogl_texture (CLUTTER_TEXTURE (actor), tex);
+      cogl_texture_unref (tex);
+    }
+  else
+    {
+#if CLUTTER_COGL_HAS_GLES
+      GLuint name;
+
+      /* Cogl doesn't know about compressed formats, so make the texture
+       * ourselves and give it to cogl as a foreign one. */
+      glGenTextures (1, &name);
+      glBindTexture (GL_TEXTURE_2D, name);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glCompressedTexImage2D (GL_TEXTURE_2D, 0, file->compressed,
+                              file->width, file->height, 0,
+                              file->data_size, file->data);
+      if (glGetError () != GL_NO_ERROR)
+        {
+          glDeleteTextures (1, &name);
+          goto upload_failed;
+        }
+
+      tex = cogl_texture_new_from_foreign (name, GL_TEXTURE_2D,
+                                           file->width, file->height, 0, 0,
+                                           file->has_alpha
+                                             ? COGL_PIXEL_FORMAT_RGBA_8888
+                                             : COGL_PIXEL_FORMAT_RGB_888);
+      if (tex == COGL_INVALID_HANDLE)
+        {
+          glDeleteTextures (1, &name);
+          goto upload_failed;
+        }
+
+      actor = clutter_texture_new ();
+      clutter_texture_set_cogl_texture (CLUTTER_TEXTURE (actor), tex);
+      cogl_texture_unref (tex);
+
+      /* Cogl doesn't delete foreign textures.  Nobody takes the cogl
+       * texture from the actor, so it's safe to do it when it's gone. */
+      g_object_weak_ref (G_OBJECT (actor), delete_gl_texture,
+                         GUINT_TO_POINTER (name));
+#else
+      /* Let clutter decompress it if it can. */
+      return clutter_texture_new_from_file (fname, error);
+#endif
+    }
+
+  return actor;
+
+upload_failed:
+  g_set_error (error, HD_TEXTURE_LOADER_ERROR, HD_TEXTURE_LOADER_ERROR_UPLOAD,
+               "%s: couldn't upload %ux%u texture", fname,
+               file->width, file->height);
+  return NULL;
+}
+
+/* Returns a new #ClutterTexture of @fname or %NULL. */
+ClutterActor *
+hd_texture_loader_load (const gchar *fname, GError **error)
+{
+  TextureFile *file;
+  ClutterActor *actor;
+  GError *err = NULL;
+
+  if (!(file = texture_file_map (fname, &err)))
+    {
+      if (err)
+        {
+          g_propagate_error (error, err);
+          return NULL;
+        }
+      return clutter_texture_new_from_file (fname, error);
+    }
+
+  actor = texture_file_upload (file, fname, error);
+  texture_file_unmap (file);
+  return actor;
+}
+
+static void
+hd_texture_load_free (HdTextureLoad *load)
+{
+  if (load->file)
+    texture_file_unmap (load->file);
+  if (load->error)
+    g_error_free (load->error);
+  g_free (load->fname);
+  g_slice_free (HdTextureLoad, load);
+}
+
+/* Back in the main thread, upload what the loading thread mapped. */
+static gboolean
+hd_texture_load_done_idle (gpointer data)
+{
+  HdTextureLoad *load = data;
+  ClutterActor *actor = NULL;
+  GError *error = NULL;
+
+  if (!load->cancelled)
+    {
+      if (load->file)
+        actor = texture_file_upload (load->file, load->fname, &error);
+      else if (!load->error)
+        actor = clutter_texture_new_from_file (load->fname, &error);
+      load->func (actor, error ? error : load->error, load->data);
+      if (error)
+        g_error_free (error);
+    }
+
+  hd_texture_load_free (load);
+  return FALSE;
+}
+
+/* Map the file and fault it in, so the upload doesn't wait for the disk. */
+static gpointer
+hd_texture_load_thread (gpointer data)
+{
+  HdTextureLoad *load = data;
+
+  if ((load->file = texture_file_map (load->fname, &load->error)))
+    {
+      volatile guint8 sum = 0;
+      gsize page, i;
+
+      page = sysconf (_SC_PAGESIZE);
+      for (i = 0; i < load->file->size; i += page)
+        sum += load->file->map[i];
+    }
+
+  clutter_threads_add_idle (hd_texture_load_done_idle, load);
+  return NULL;
+}
+
+/*
+ * Loads @fname in the background and calls @func with the new texture
+ * from the main loop.  Returns a handle which can be given to
+ * hd_texture_loader_cancel() until @func is called.
+ */
+HdTextureLoad *
+hd_texture_loader_load_async (const gchar *fname, HdTextureLoaded func,
+                              gpointer data)
+{
+  HdTextureLoad *load;
+
+  load = g_slice_new0 (HdTextureLoad);
+  load->fname = g_strdup (fname);
+  load->func  = func;
+  load->data  = data;
+
+  if (hd_disable_threads ()
+      || !g_thread_create (hd_texture_load_thread, load, FALSE, NULL))
+    hd_texture_load_thread (load);
+
+  return load;
+}
+
+/* Makes sure the callback of @load is not called. */
+void
+hd_texture_loader_cancel (HdTextureLoad *load)
+{
+  load->cancelled = TRUE;
+}
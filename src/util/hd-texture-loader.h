@@ -0,0 +1,66 @@
+/*
+ * This file is part of hildon-desktop
+ *
+ * Copyright (C) 2008 Nokia Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+
+/*
+ * Loads PVR and KTX textures by mmap()ing the file and uploading the
+ * (compressed or raw) image straight from the mapping, rather than
+ * reading it into the heap first as clutter_texture_new_from_file()
+ * does.  Anything else is handed over to clutter_texture_new_from_file(),
+ * so these can be used for any image file.  Only the first mipmap level
+ * is loaded.
+ */
+
+#ifndef __HD_TEXTURE_LOADER_H__
+#define __HD_TEXTURE_LOADER_H__
+
+#include <clutter/clutter.h>
+
+G_BEGIN_DECLS
+
+#define HD_TEXTURE_LOADER_ERROR hd_texture_loader_error_quark ()
+
+typedef enum
+{
+  HD_TEXTURE_LOADER_ERROR_CORRUPT,
+  HD_TEXTURE_LOADER_ERROR_UNSUPPORTED,
+  HD_TEXTURE_LOADER_ERROR_UPLOAD,
+} HdTextureLoaderError;
+
+typedef struct _HdTextureLoad HdTextureLoad;
+
+/* Called with the new texture or %NULL and @error when the loading
+ * started by hd_texture_loader_load_async() is finished. */
+typedef void (*HdTextureLoaded) (ClutterActor *texture, const GError *error,
+                                 gpointer data);
+
+GQuark         hd_texture_loader_error_quark (void);
+
+ClutterActor  *hd_texture_loader_load        (const gchar *fname,
+                                              GError **error);
+HdTextureLoad *hd_texture_loader_load_async  (const gchar *fname,
+                                              HdTextureLoaded func,
+                                              gpointer data);
+void           hd_texture_loader_cancel      (HdTextureLoad *load);
+
+G_END_DECLS
+
+#endif /* __HD_TEXTURE_LOADER_H__ */
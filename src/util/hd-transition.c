@@ -93,6 +93,17 @@ typedef struct
   unsigned remaining, expiry;
 } HPTimer;
 
+/* A client we expect to redraw itself when the screen is rotated. */
+typedef struct
+{
+  Window   xwin;
+  /* Its size before the rotation and when we last saw it damaged. */
+  gint     width, height, last_width, last_height;
+  /* How many pixels it has damaged since it was last resized. */
+  gdouble  damaged;
+  gboolean ready;
+} RotatingClient;
+
 /* Describes the state of hd_transition_rotating_fsm(). */
 static struct
 {
@@ -175,6 +186,25 @@ static struct
    * necessary we stop waiting for damages immedeately.
    */
   guint patience_requests;
+
+  /*
+   * @snapshot:         The last frame before the rotation, shown instead
+   *                    of a blank screen while the clients are redrawing
+   *                    themselves, then cross-faded to the live contents.
+   * @snapshot_is_landscape: The orientation @snapshot was taken in.
+   * @clients:          The #RotatingClient:s visible when we started.
+   *                    We leave WAIT_FOR_DAMAGES when all of them are
+   *                    ready or the deadline is up.
+   */
+  ClutterActor *snapshot;
+  gboolean snapshot_is_landscape;
+  GSList *clients;
+
+  /* For the metrics: @duration counts from IDLE, @waited is how long
+   * we were in WAIT_FOR_DAMAGES, and whether we @timed_out there. */
+  GTimer *duration;
+  guint waited, last_duration;
+  gboolean timed_out;
 } Orientation_change;
 
 /* The number of transitions in progress requesting for @fixup_visibilities.
@@ -185,6 +215,7 @@ static guint Transitions_running;
 /* If %TRUE keep reloading transitions.ini until we can
  * and we can watch it. */
 static gboolean transitions_ini_is_dirty;
+static guint transitions_ini_generation;
 
 /* ------------------------------------------------------------------------- */
 /* ------------------------------------------------------------------------- */
@@ -807,6 +838,11 @@ on_rotate_screen_timeline_new_frame(ClutterTimeline *timeline,
       clutter_actor_raise_top(data->particles[0]);
       clutter_actor_set_opacity(data->particles[0], (int)(dim_amt*255));
     }
+
+  /* Cross-fade from the snapshot to the live contents. */
+  if (data->event == MBWMCompMgrClientEventUnmap
+      && Orientation_change.snapshot)
+    clutter_actor_set_opacity(Orientation_change.snapshot, (int)(amt*255));
 }
 
 /* ------------------------------------------------------------------------- */
@@ -1401,6 +1437,10 @@ hd_transition_fade_and_rotate(gboolean first_part,
    * go back to landscape as it looks better */
   if (first_part == goto_portrait)
     data->angle *= -1;
+  /* Don't tilt the live contents away from the flat snapshot
+   * we're cross-fading from. */
+  if (!first_part && Orientation_change.snapshot)
+    data->angle = 0;
 
   if (!use_zaxis)
     {
@@ -1439,6 +1479,171 @@ hd_transition_fade_and_rotate(gboolean first_part,
   clutter_timeline_start (data->timeline);
 }
 
+/* Take over what the render manager cached in IDLE and show it above
+ * everything until FADE_IN is finished. */
+static void
+rotation_take_snapshot (void)
+{
+  ClutterActor *hdrm, *snapshot;
+  guint width, height;
+
+  hdrm = CLUTTER_ACTOR(hd_render_manager_get());
+  if (!(snapshot = tidy_cached_group_get_snapshot(hdrm)))
+    return;
+
+  clutter_actor_get_size(hdrm, &width, &height);
+  clutter_actor_set_name(snapshot, "rotation snapshot");
+  clutter_actor_set_size(snapshot, width, height);
+  clutter_actor_set_anchor_point(snapshot, width/2, height/2);
+  /* Where FADE_OUT left the render manager. */
+  if (!hd_transition_get_int("thp_tweaks", "zaxisrotation", 0))
+    {
+      clutter_actor_set_depth(snapshot, -150);
+      clutter_actor_set_opacity(snapshot, 0x80);
+    }
+  clutter_container_add_actor(CLUTTER_CONTAINER(clutter_stage_get_default()),
+                              snapshot);
+  clutter_actor_show(snapshot);
+
+  Orientation_change.snapshot = snapshot;
+  Orientation_change.snapshot_is_landscape = width > height;
+}
+
+/* Center the snapshot on the screen and turn it so that it looks the same
+ * in whichever orientation the screen is now. */
+static void
+rotation_place_snapshot (void)
+{
+  guint scrw, scrh;
+  gboolean landscape;
+  gint angle;
+
+  if (!Orientation_change.snapshot)
+    return;
+
+  clutter_actor_get_size(clutter_stage_get_default(), &scrw, &scrh);
+  landscape = scrw > scrh;
+  if (landscape == Orientation_change.snapshot_is_landscape)
+    angle = 0;
+  else
+    /* Cf. hd_util_rotate_geometry(). */
+    angle = landscape ? -90 : 90;
+
+  clutter_actor_set_position(Orientation_change.snapshot, scrw/2, scrh/2);
+  clutter_actor_set_rotation(Orientation_change.snapshot, CLUTTER_Z_AXIS,
+                             angle, 0, 0, 0);
+}
+
+static void
+rotation_drop_snapshot (void)
+{
+  if (Orientation_change.snapshot)
+    {
+      clutter_actor_destroy(Orientation_change.snapshot);
+      Orientation_change.snapshot = NULL;
+    }
+}
+
+static void
+rotation_forget_clients (void)
+{
+  g_slist_foreach(Orientation_change.clients, (GFunc)g_free, NULL);
+  g_slist_free(Orientation_change.clients);
+  Orientation_change.clients = NULL;
+}
+
+/* Remember the clients visible now, which will have to redraw
+ * themselves when they're resized. */
+static void
+rotation_track_clients (void)
+{
+  MBWindowManagerClient *c;
+  ClutterActor *actor;
+  RotatingClient *rc;
+
+  rotation_forget_clients();
+  mb_wm_stack_enumerate (Orientation_change.wm, c)
+    {
+      if (!c->cm_client || !c->window
+          || MB_WM_CLIENT_CLIENT_TYPE (c) == MBWMClientTypeDesktop)
+        continue;
+      actor = mb_wm_comp_mgr_clutter_client_get_actor(
+                              MB_WM_COMP_MGR_CLUTTER_CLIENT(c->cm_client));
+      if (!actor || !CLUTTER_ACTOR_IS_VISIBLE(actor))
+        continue;
+
+      rc = g_new0(RotatingClient, 1);
+      rc->xwin = c->window->xwindow;
+      rc->width  = rc->last_width  = c->window->geometry.width;
+      rc->height = rc->last_height = c->window->geometry.height;
+      Orientation_change.clients = g_slist_prepend(Orientation_change.clients,
+                                                   rc);
+    }
+}
+
+/* Whether all the clients we track have redrawn themselves at their new
+ * size (or are gone) and nobody asked for patience. */
+static gboolean
+rotation_clients_ready (void)
+{
+  RotatingClient *rc;
+  GSList *li;
+
+  if (Orientation_change.patience_requests)
+    return FALSE;
+
+  for (li = Orientation_change.clients; li; li = li->next)
+    {
+      rc = li->data;
+      if (rc->ready)
+        continue;
+      if (!mb_wm_managed_client_from_xwindow(Orientation_change.wm,
+                                             rc->xwin))
+        { /* It's gone. */
+          rc->ready = TRUE;
+          continue;
+        }
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* The root window is configured and so are the clients.  Those which
+ * haven't been resized won't need to redraw. */
+static void
+rotation_prune_clients (void)
+{
+  MBWindowManagerClient *c;
+  RotatingClient *rc;
+  GSList *li;
+
+  for (li = Orientation_change.clients; li; li = li->next)
+    {
+      rc = li->data;
+      c = mb_wm_managed_client_from_xwindow(Orientation_change.wm, rc->xwin);
+      if (!c || !c->window
+          || (c->window->geometry.width == rc->width
+              && c->window->geometry.height == rc->height))
+        rc->ready = TRUE;
+    }
+}
+
+/* How many more miliseconds we may wait in WAIT_FOR_DAMAGES. */
+static gint
+rotation_deadline (void)
+{
+  gint max;
+
+  max = hd_transition_get_int("rotate", "damage_timeout_max", 1000);
+  if (Orientation_change.snapshot)
+    /* We aren't staring at a black screen, we can wait more. */
+    max = MAX(max, hd_transition_get_int("rotate", "ready_timeout_max",
+                                          1500));
+  max -= g_timer_elapsed(Orientation_change.timer, NULL) * 1000.0;
+  return MAX(max, 0);
+}
+
 /* Process %_MAEMO_ROTATION_PATIENCE requests. */
 static void
 patience (XClientMessageEvent *event, void *unused)
@@ -1455,10 +1660,8 @@ patience (XClientMessageEvent *event, void *unused)
 
       if (Orientation_change.timeout_id)
         {
-          /* remaining := max(damage_timeout_max-elapsed, 0) */
-          max  = hd_transition_get_int("rotate", "damage_timeout_max", 1000);
-          max -= g_timer_elapsed(Orientation_change.timer, NULL) * 1000.0;
-          if (max > 0)
+          /* remaining := max(deadline-elapsed, 0) */
+          if ((max = rotation_deadline()) > 0)
             Orientation_change.timeout_id->remaining = max;
         }
       if (Orientation_change.phase <= WAIT_FOR_DAMAGES)
@@ -1468,8 +1671,7 @@ patience (XClientMessageEvent *event, void *unused)
     { /* Get out of WAIT_FOR_DAMAGES as quickly as possible. */
       if (Orientation_change.patience_requests)
         Orientation_change.patience_requests--;
-      if (!Orientation_change.patience_requests
-          && Orientation_change.timeout_id)
+      if (Orientation_change.timeout_id && rotation_clients_ready())
         Orientation_change.timeout_id->remaining = 0;
     }
 }
@@ -1489,6 +1691,8 @@ hd_transition_rotating_fsm(void)
       case IDLE:
         Orientation_change.phase = TRANS_START;
         Orientation_change.direction = Orientation_change.new_direction;
+        g_timer_start(Orientation_change.duration);
+        rotation_track_clients();
         /* Take a screenshot of the screen as we currently are... */
         tidy_cached_group_changed(CLUTTER_ACTOR(hd_render_manager_get()));
         tidy_cached_group_set_render_cache(
@@ -1554,6 +1758,8 @@ hd_transition_rotating_fsm(void)
          * to states which don't support the orientation we're
          * going to.
          */
+        if (!Orientation_change.snapshot)
+          rotation_take_snapshot();
         if(!STATE_IS_TASK_NAV(hd_render_manager_get_state()))
           mb_wm_layout_update(Orientation_change.wm->layout);
         /* remove our flag to bodge layout - because we'll rotate properly
@@ -1579,12 +1785,14 @@ hd_transition_rotating_fsm(void)
         if (Orientation_change.direction == Orientation_change.new_direction)
           {
             /*
-             * Wait for the screen change. During this period, blank the
-             * screen by hiding %HdRenderManager. We wait here until
-             * until damage_timeout ms has passed since the last damage event,
-             * or until damage_timeout_max is reached. There is a lot of X
-             * traffic during this time, so g_timeout is often delayed past
-             * damage_timeout_max.
+             * Wait for the screen change. During this period, hide
+             * %HdRenderManager and show the snapshot (or blankness if we
+             * couldn't take one).  We wait here until all the clients have
+             * redrawn themselves at their new size, or if there was nothing
+             * to wait for until damage_timeout ms has passed since the last
+             * damage event, or until the deadline is reached. There is a
+             * lot of X traffic during this time, so g_timeout is often
+             * delayed past the deadline.
              */
             Orientation_change.phase = WAIT_FOR_ROOT_CONFIG;
 
@@ -1593,7 +1801,7 @@ hd_transition_rotating_fsm(void)
              * We now need to totally blank the screen before the rotation,
              * so we explicitly call clutter to redraw *right now*. Note that
              * we don't do this on the stage, because it might conflict with
-             * hd_dbus_system_bus_signal_handler */
+             * hd_dbus_display_status_ind() */
             clutter_actor_set_allow_redraw(
                 CLUTTER_ACTOR(hd_render_manager_get()), FALSE);
             clutter_actor_hide(CLUTTER_ACTOR(hd_render_manager_get()));
@@ -1635,20 +1843,28 @@ trans_start_error:
              * counterpart. */
             hd_util_root_window_configured(Orientation_change.wm);
 
+            rotation_place_snapshot();
+            rotation_prune_clients();
+
             g_assert(!Orientation_change.timeout_id);
+            g_timer_start(Orientation_change.timer);
             Orientation_change.timeout_id = hptimer_new(
-                  Orientation_change.patience_requests
-                    ? hd_transition_get_int("rotate", "damage_timeout_max",
-                                            1000)
+                  !rotation_clients_ready()
+                    ? rotation_deadline()
                     : hd_transition_get_int("rotate", "damage_timeout", 50),
                   (GSourceFunc)hd_transition_rotating_fsm,
                   &Orientation_change.timeout_id,
                   (GDestroyNotify)g_nullify_pointer);
-            g_timer_start(Orientation_change.timer);
             Orientation_change.phase = WAIT_FOR_DAMAGES;
           }
         else /* WAIT_FOR_DAMAGES || FADE_OUT error path || TRANS_START error */
           {
+            if (Orientation_change.phase == WAIT_FOR_DAMAGES)
+              {
+                Orientation_change.waited = g_timer_elapsed(
+                                  Orientation_change.timer, NULL) * 1000.0;
+                Orientation_change.timed_out = !rotation_clients_ready();
+              }
             /* We must update the layout again so the window sizes
              * return to normal relative to the screen. flags is probably
              * already correct. But just for safety. */
@@ -1704,6 +1920,9 @@ trans_start_error:
           clutter_actor_set_rotation(actor, CLUTTER_Y_AXIS, 0, 0, 0, 0);
           clutter_actor_set_depthu(actor, 0);
 
+          rotation_drop_snapshot();
+          rotation_forget_clients();
+
           Orientation_change.phase = IDLE;
           if (Orientation_change.direction != Orientation_change.new_direction)
             /* No sense resetting the rotating property. */
@@ -1714,6 +1933,15 @@ trans_start_error:
                             Orientation_change.wm->comp_mgr);
               hd_util_set_rotating_property (Orientation_change.wm, FALSE);
               Orientation_change.patience_requests = 0;
+
+              Orientation_change.last_duration = g_timer_elapsed(
+                                  Orientation_change.duration, NULL) * 1000.0;
+              g_debug ("%s: rotation took %u ms, waited %u ms for redraws%s",
+                       __FUNCTION__, Orientation_change.last_duration,
+                       Orientation_change.waited,
+                       Orientation_change.timed_out ? " (timed out)" : "");
+              Orientation_change.waited = 0;
+              Orientation_change.timed_out = FALSE;
             }
           break;
         }
@@ -1734,6 +1962,8 @@ hd_transition_rotate_screen (MBWindowManager *wm, gboolean goto_portrait)
   Orientation_change.wm = wm;
   if (!Orientation_change.timer)
     Orientation_change.timer = g_timer_new();
+  if (!Orientation_change.duration)
+    Orientation_change.duration = g_timer_new();
   if (!cmsg_id)
     cmsg_id = mb_wm_main_context_x_event_handler_add (wm->main_ctx,
                                                wm->root_win->xwindow,
@@ -1827,34 +2057,81 @@ hd_transition_rotate_ignore_damage()
       gint max;
 
       /*
-       * Only postpone the timeout if we haven't postponed
+       * Until everybody is ready wait for them until the deadline.
+       * Then only postpone the timeout if we haven't postponed
        * it too long already. This stops us getting stuck
        * in the WAITING state if an app keeps redrawing.
        *
        * remaining := min(max(remaining, damage_timeout_plus),
-       *                  max(damage_timeout_max-elapsed, 0))
+       *                  max(deadline-elapsed, 0))
        */
-      max  = hd_transition_get_int("rotate", "damage_timeout_max", 1000);
-      max -= g_timer_elapsed(Orientation_change.timer, NULL) * 1000.0;
-      if (max > 0)
+      if ((max = rotation_deadline()) <= 0)
+        Orientation_change.timeout_id->remaining = 0;
+      else if (!rotation_clients_ready())
+        Orientation_change.timeout_id->remaining = max;
+      else
         {
           gint remaining;
 
           remaining = hd_transition_get_int("rotate", "damage_timeout_plus",
                                             50);
-          if (Orientation_change.timeout_id->remaining < remaining)
+          /* If we were waiting for the clients only settle a little. */
+          if (Orientation_change.clients
+              || Orientation_change.timeout_id->remaining < remaining)
             Orientation_change.timeout_id->remaining = remaining;
           if (Orientation_change.timeout_id->remaining > max)
             Orientation_change.timeout_id->remaining = max;
         }
-      else
-        Orientation_change.timeout_id->remaining = 0;
 
       return TRUE;
     }
   return FALSE;
 }
 
+/* Called with the damage of @c while rotating to find out when it's
+ * redrawn itself at its new size.  We consider it has when the damage
+ * since it was last resized covers most of it. */
+void
+hd_transition_rotate_client_damaged (MBWindowManagerClient *c,
+                                     gint width, gint height)
+{
+  RotatingClient *rc;
+  GSList *li;
+  gint w, h;
+
+  if (Orientation_change.phase == IDLE || !c->window)
+    return;
+
+  for (li = Orientation_change.clients; li; li = li->next)
+    if (((RotatingClient *)li->data)->xwin == c->window->xwindow)
+      break;
+  if (!li || (rc = li->data)->ready)
+    return;
+
+  w = c->window->geometry.width;
+  h = c->window->geometry.height;
+  if (w != rc->last_width || h != rc->last_height)
+    { /* It's been reconfigured, what it's drawn so far doesn't count. */
+      rc->last_width  = w;
+      rc->last_height = h;
+      rc->damaged = 0;
+    }
+  if (w == rc->width && h == rc->height)
+    /* Not resized yet. */
+    return;
+
+  rc->damaged += (gdouble)width * height;
+  rc->ready = rc->damaged >= (gdouble)w * h
+    * hd_transition_get_double("rotate", "ready_coverage", 0.9);
+}
+
+/* How many miliseconds the last rotation took from start to finish. */
+guint
+hd_transition_get_last_rotation_time (void)
+{
+  return Orientation_change.last_duration;
+}
+
 /* Returns whether @actor will last only as long as the effect
  * (if it has any) takes.  Currently only subview transitions
  * are considered. */
@@ -1998,6 +2275,7 @@ hd_transition_get_keyfile(void)
   if (transitions_ini)
     g_key_file_free(transitions_ini);
   transitions_ini = ini;
+  transitions_ini_generation++;
 
   if (!transitions_ini_watcher || transitions_ini_is_dirty > TRUE)
     {
@@ -2041,6 +2319,15 @@ out:
   return transitions_ini;
 }
 
+/* Returns a number which changes whenever transitions.ini is (re)loaded,
+ * so callers can cache what they derive from it until it does. */
+guint
+hd_transition_get_generation(void)
+{
+  hd_transition_get_keyfile();
+  return transitions_ini_generation;
+}
+
 gint
 hd_transition_get_int(const gchar *transition, const char *key,
                       gint default_val)
@@ -95,6 +95,11 @@ gboolean
 hd_transition_is_rotating_to_portrait (void);
 gboolean
 hd_transition_rotate_ignore_damage(void);
+void
+hd_transition_rotate_client_damaged (MBWindowManagerClient *c,
+                                     gint width, gint height);
+guint
+hd_transition_get_last_rotation_time (void);
 
 gboolean
 hd_transition_actor_will_go_away (ClutterActor *actor);
@@ -102,6 +107,9 @@ hd_transition_actor_will_go_away (ClutterActor *actor);
 void
 hd_transition_play_sound(const gchar           *fname);
 
+guint
+hd_transition_get_generation(void);
+
 gint
 hd_transition_get_int(const gchar *transition,
                       const char *key,
@@ -665,37 +665,108 @@ hd_util_partial_redraw_if_possible(ClutterActor *actor, ClutterGeometry *bounds)
     }
 }
 
+/* Prepends to @pieces what remains of @rect outside @hole,
+ * allocating the pieces from @arena. */
+static GList *
+hd_util_subtract_rect(HdArena *arena, GList *pieces,
+                      const MBGeometry *rect, const MBGeometry *hole)
+{
+  MBGeometry piece;
+  gint top, bottom;
+
+  if (hole->x >= rect->x + (gint)rect->width
+      || rect->x >= hole->x + (gint)hole->width
+      || hole->y >= rect->y + (gint)rect->height
+      || rect->y >= hole->y + (gint)hole->height)
+    /* They don't overlap. */
+    return hd_arena_list_prepend(arena, pieces,
+                                 hd_arena_memdup(arena, rect, sizeof(*rect)));
+
+  /* Above and below @hole, full width. */
+  top    = MAX(rect->y, hole->y);
+  bottom = MIN(rect->y + (gint)rect->height, hole->y + (gint)hole->height);
+  if (rect->y < top)
+    {
+      piece = *rect;
+      piece.height = top - rect->y;
+      pieces = hd_arena_list_prepend(arena, pieces,
+                             hd_arena_memdup(arena, &piece, sizeof(piece)));
+    }
+  if (bottom < rect->y + (gint)rect->height)
+    {
+      piece = *rect;
+      piece.y = bottom;
+      piece.height = rect->y + (gint)rect->height - bottom;
+      pieces = hd_arena_list_prepend(arena, pieces,
+                             hd_arena_memdup(arena, &piece, sizeof(piece)));
+    }
+
+  /* Left and right of @hole, between @top and @bottom. */
+  piece.y = top;
+  piece.height = bottom - top;
+  if (rect->x < hole->x)
+    {
+      piece.x = rect->x;
+      piece.width = hole->x - rect->x;
+      pieces = hd_arena_list_prepend(arena, pieces,
+                             hd_arena_memdup(arena, &piece, sizeof(piece)));
+    }
+  if (hole->x + (gint)hole->width < rect->x + (gint)rect->width)
+    {
+      piece.x = hole->x + (gint)hole->width;
+      piece.width = rect->x + (gint)rect->width - piece.x;
+      pieces = hd_arena_list_prepend(arena, pieces,
+                             hd_arena_memdup(arena, &piece, sizeof(piece)));
+    }
+
+  return pieces;
+}
+
 /* Check to see whether clients above this one totally obscure it */
 gboolean hd_util_client_obscured(MBWindowManagerClient *client)
 {
-  GdkRegion *region;
+  HdArena *arena;
+  HdArenaMark mark;
+  GList *visible, *remains, *li;
   MBWindowManagerClient *obscurer;
   gboolean empty;
 
   if (!client->window)
     return FALSE; /* be safe */
+  if (!client->window->geometry.width || !client->window->geometry.height)
+    return TRUE;
+
+  /* The visible parts of the client are kept as a list of rectangles
+   * in the render manager's scratch arena rather than in a GdkRegion,
+   * not to go to the heap for each window above. */
+  arena = hd_render_manager_get_scratch();
+  hd_arena_mark(arena, &mark);
 
-  /* Get region representing the current client */
-  region = gdk_region_rectangle((GdkRectangle*)(void*)&client->window->geometry);
+  /* Start with the current client */
+  visible = hd_arena_list_prepend(arena, NULL,
+                                  &client->window->geometry);
 
-  /* Subtract the region of all clients above */
+  /* Subtract the geometry of all clients above */
   for (obscurer = client->stacked_above;
-       obscurer && !gdk_region_empty(region);
+       obscurer && visible;
        obscurer = obscurer->stacked_above)
     {
-      GdkRegion *obscure_region;
       if (!obscurer->window)
         continue; /* be safe */
-      obscure_region =
-          gdk_region_rectangle((GdkRectangle*)(void*)&obscurer->window->geometry);
-      gdk_region_subtract(region, obscure_region);
-      gdk_region_destroy(obscure_region);
+      if (!obscurer->window->geometry.width
+          || !obscurer->window->geometry.height)
+        continue;
+      remains = NULL;
+      for (li = visible; li; li = li->next)
+        remains = hd_util_subtract_rect(arena, remains, li->data,
+                                        &obscurer->window->geometry);
+      visible = remains;
     }
 
   /* If there is nothing left, then this can't
    * be visible */
-  empty = gdk_region_empty(region);
-  gdk_region_destroy(region);
+  empty = visible == NULL;
+  hd_arena_release(arena, &mark);
   return empty;
 }
 
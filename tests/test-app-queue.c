@@ -0,0 +1,257 @@
+/*
+ * Stress test of HdAppQueue, the priority queues of HdAppMgr.
+ *
+ * Cycles 500 prestartable and hibernatable apps through the states
+ * HdAppMgr would take them through and checks after each round that
+ * the queues are ordered and contain exactly the apps they should.
+ * Prestarted apps are killed the way HdAppMgr does it, and are checked
+ * to stay in the prestarted queue until their exit is seen.
+ * Usage: test-app-queue [rounds]
+ */
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <glib.h>
+
+#include "hd-app-queue.h"
+
+#define NAPPS   500
+
+enum
+{
+  PRESTARTABLE,
+  PRESTARTED,
+  HIBERNATABLE,
+  HIBERNATED,
+
+  NQUEUES,
+  INACTIVE = NQUEUES
+};
+
+/* Each app is in one queue at most here, so it needs only one link. */
+typedef struct
+{
+  guint id, state;
+  gint priority;
+  guint stamp;
+  HdAppQueueLink link;
+
+  /* Killed but not seen exiting yet, and in which round it was
+   * last killed in one go. */
+  gboolean exiting;
+  guint killed;
+} App;
+
+static App Apps[NAPPS];
+static HdAppQueue *Queues[NQUEUES];
+static guint Lengths[NQUEUES];
+static guint Stamp, Round;
+
+/* Take @app from the queue of its current state to that of @state. */
+static void
+change_state (App *app, guint state)
+{
+  gboolean was_queued;
+
+  if (state != INACTIVE)
+    {
+      was_queued = hd_app_queue_move (Queues[state], &app->link,
+                                      app->priority);
+      if (hd_app_queue_insert (Queues[state], &app->link, app->priority))
+        g_error ("app %u queued twice", app->id);
+      app->stamp = Stamp++;
+      Lengths[state]++;
+    }
+  else
+    was_queued = hd_app_queue_remove (&app->link);
+
+  if (was_queued != (app->state != INACTIVE))
+    g_error ("app %u was %squeued", app->id, was_queued ? "" : "not ");
+  if (app->state != INACTIVE)
+    Lengths[app->state]--;
+  app->state = state;
+}
+
+/* Like hd_app_mgr_prestart() and hd_app_mgr_hibernate(), which take
+ * the app to its new queue themselves. */
+static gboolean
+move_app (gpointer data, gpointer to)
+{
+  change_state (data, GPOINTER_TO_UINT (to));
+  return TRUE;
+}
+
+/* Service the top (or bottom) of @from like HdAppMgr does. */
+static guint
+service_top (guint from, gboolean lowest, guint max, guint to)
+{
+  return hd_app_queue_service (Queues[from], lowest, max, move_app,
+                               GUINT_TO_POINTER (to));
+}
+
+/* Like hd_app_mgr_kill(): the app stays where it is until its exit is
+ * seen.  @once is set when every app may only be visited once. */
+static gboolean
+kill_app (gpointer data, gpointer once)
+{
+  App *app = data;
+
+  if (app->state != PRESTARTED)
+    g_error ("app %u killed in state %u", app->id, app->state);
+  if (once)
+    {
+      if (app->killed == Round + 1)
+        g_error ("app %u killed twice in one go", app->id);
+      app->killed = Round + 1;
+    }
+  app->exiting = TRUE;
+  return TRUE;
+}
+
+/* See the killed apps exit, like hd_app_mgr_app_closed(). */
+static void
+reap (void)
+{
+  guint i;
+
+  for (i = 0; i < NAPPS; i++)
+    if (Apps[i].exiting)
+      {
+        Apps[i].exiting = FALSE;
+        change_state (&Apps[i], INACTIVE);
+      }
+}
+
+static void
+check (void)
+{
+  guint i, q, n, last_stamp;
+  gint last_priority;
+  GList *apps, *li;
+
+  for (i = 0; i < NAPPS; i++)
+    if (Apps[i].exiting
+        && !hd_app_queue_contains (Queues[PRESTARTED], &Apps[i].link))
+      g_error ("app %u left the prestarted queue before it exited", i);
+
+  for (q = 0; q < NQUEUES; q++)
+    {
+      if (hd_app_queue_get_length (Queues[q]) != Lengths[q])
+        g_error ("queue %u: length %u instead of %u", q,
+                 hd_app_queue_get_length (Queues[q]), Lengths[q]);
+      if (hd_app_queue_is_empty (Queues[q]) != !Lengths[q])
+        g_error ("queue %u: bad emptiness", q);
+
+      n = 0;
+      last_priority = G_MAXINT;
+      last_stamp = 0;
+      apps = hd_app_queue_to_list (Queues[q]);
+      for (li = apps; li; li = li->next)
+        {
+          App *app = li->data;
+
+          if (app->state != q)
+            g_error ("queue %u: app %u is in state %u", q, app->id,
+                     app->state);
+          if (!hd_app_queue_contains (Queues[q], &app->link))
+            g_error ("queue %u: app %u isn't linked", q, app->id);
+          if (app->priority > last_priority)
+            g_error ("queue %u: priority order broken at app %u", q,
+                     app->id);
+          if (app->priority == last_priority
+              && app->stamp < last_stamp)
+            g_error ("queue %u: FIFO order broken at app %u", q, app->id);
+          last_priority = app->priority;
+          last_stamp = app->stamp;
+          n++;
+        }
+      if (n != Lengths[q])
+        g_error ("queue %u: %u apps listed instead of %u", q, n, Lengths[q]);
+      if (apps && (hd_app_queue_peek_head (Queues[q]) != apps->data
+                   || hd_app_queue_peek_tail (Queues[q])
+                        != g_list_last (apps)->data))
+        g_error ("queue %u: bad head or tail", q);
+      g_list_free (apps);
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  guint i, n, rounds;
+  GTimer *timer;
+
+  rounds = argc > 1 ? atoi (argv[1]) : 1000;
+  for (i = 0; i < NQUEUES; i++)
+    Queues[i] = hd_app_queue_new ();
+  for (i = 0; i < NAPPS; i++)
+    {
+      Apps[i].id = i;
+      Apps[i].state = INACTIVE;
+      Apps[i].priority = g_random_int_range (0, 10);
+      hd_app_queue_link_init (&Apps[i].link, &Apps[i]);
+      change_state (&Apps[i], PRESTARTABLE);
+    }
+  check ();
+
+  timer = g_timer_new ();
+  for (Round = 0; Round < rounds; Round++)
+    {
+      /* Some random state changes, like the user would cause. */
+      for (i = 0; i < NAPPS / 5; i++)
+        {
+          App *app = &Apps[g_random_int_range (0, NAPPS)];
+
+          if (app->exiting)
+            continue;
+          switch (app->state)
+            {
+              case INACTIVE:
+                change_state (app, PRESTARTABLE);
+                break;
+              case PRESTARTABLE:
+              case PRESTARTED:
+              case HIBERNATED:
+                /* Launched or relaunched. */
+                change_state (app, HIBERNATABLE);
+                break;
+              case HIBERNATABLE:
+                /* Closed. */
+                change_state (app, g_random_boolean ()
+                              ? INACTIVE : PRESTARTABLE);
+                break;
+            }
+        }
+
+      /* Prestart the most important, hibernate and kill the least. */
+      service_top (PRESTARTABLE, FALSE, NAPPS / 10, PRESTARTED);
+      service_top (HIBERNATABLE, TRUE, NAPPS / 20, HIBERNATED);
+
+      /* Kill one under low memory, the same one every time until it's
+       * seen exiting, then a batch like hd_app_mgr_kill_all_prestarted(). */
+      for (i = 0; i < 3; i++)
+        hd_app_queue_service (Queues[PRESTARTED], TRUE, 1, kill_app, NULL);
+      if (!hd_app_queue_is_empty (Queues[PRESTARTED])
+          && !((App *)hd_app_queue_peek_tail (Queues[PRESTARTED]))->exiting)
+        g_error ("the killed app left the prestarted queue");
+      n = MIN (NAPPS / 20, Lengths[PRESTARTED]);
+      if (hd_app_queue_service (Queues[PRESTARTED], TRUE, NAPPS / 20,
+                                kill_app, GINT_TO_POINTER (TRUE)) != n)
+        g_error ("didn't kill %u apps", n);
+      if (!(Round % 100))
+        check ();
+      reap ();
+    }
+  check ();
+
+  printf ("%u rounds of %u apps in %.3fs; queue lengths %u %u %u %u\n",
+          rounds, NAPPS, g_timer_elapsed (timer, NULL),
+          Lengths[PRESTARTABLE], Lengths[PRESTARTED],
+          Lengths[HIBERNATABLE], Lengths[HIBERNATED]);
+
+  for (i = 0; i < NQUEUES; i++)
+    hd_app_queue_free (Queues[i]);
+  g_timer_destroy (timer);
+
+  return 0;
+}
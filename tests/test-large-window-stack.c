@@ -1,3 +1,9 @@
+/*
+ * Grows and shrinks a stack of stackable windows, a new one every 250ms,
+ * to see how restacking copes with many windows.  Tap to switch between
+ * adding and removing windows.  Send hildon-desktop SIGUSR1 afterwards
+ * to have it log how many actors its restacks moved.
+ */
 #include <stdlib.h>
 #include <hildon/hildon.h>
 
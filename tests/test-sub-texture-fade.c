@@ -0,0 +1,127 @@
+/*
+ * Checks that faded TidySubTextures of a texture without an alpha channel
+ * are blended, both painted alone and batched in a TidyBatchGroup.
+ *
+ * A red RGB texture is shown at half opacity over a black stage, so the
+ * red channel of the result should be about half.  Prints the pixels
+ * read back and exits with 1 if any of them is off.
+ * Usage: test-sub-texture-fade
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <clutter/clutter.h>
+
+#include "tidy/tidy-sub-texture.h"
+#include "tidy/tidy-batch-group.h"
+
+#define SIZE      32
+#define OPACITY   0x80
+#define SLACK     0x10
+
+static ClutterActor *Stage;
+static int Status;
+
+static ClutterActor *
+new_sub_texture (ClutterActor *texture, gint x, gint y, gboolean tiled)
+{
+  ClutterGeometry region = { 0, 0, SIZE / 2, SIZE / 2 };
+  TidySubTexture *sub;
+
+  sub = tidy_sub_texture_new (CLUTTER_TEXTURE (texture));
+  tidy_sub_texture_set_region (sub, &region);
+  tidy_sub_texture_set_tiled (sub, tiled);
+  clutter_actor_set_position (CLUTTER_ACTOR (sub), x, y);
+  clutter_actor_set_size (CLUTTER_ACTOR (sub), SIZE, SIZE);
+  return CLUTTER_ACTOR (sub);
+}
+
+static void
+check_pixel (const gchar *what, gint x, gint y)
+{
+  guchar *pixel;
+
+  pixel = clutter_stage_read_pixels (CLUTTER_STAGE (Stage),
+                                     x + SIZE / 2, y + SIZE / 2, 1, 1);
+  printf ("%-24s %02x %02x %02x\n", what, pixel[0], pixel[1], pixel[2]);
+  if (ABS (pixel[0] - OPACITY) > SLACK || pixel[1] > SLACK
+      || pixel[2] > SLACK)
+    {
+      printf ("  should be about %02x 00 00\n", OPACITY);
+      Status = 1;
+    }
+  g_free (pixel);
+}
+
+static gboolean
+check (gpointer unused)
+{
+  check_pixel ("alone", 0, 0);
+  check_pixel ("alone, tiled", SIZE, 0);
+  check_pixel ("batched", 0, SIZE);
+  check_pixel ("batched, tiled", SIZE, SIZE);
+  clutter_main_quit ();
+  return FALSE;
+}
+
+static void
+painted (ClutterActor *stage, gpointer unused)
+{
+  static gboolean done;
+
+  if (!done)
+    {
+      done = TRUE;
+      g_idle_add (check, NULL);
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  static const ClutterColor black = { 0x00, 0x00, 0x00, 0xff };
+  guchar data[SIZE * SIZE * 3];
+  ClutterActor *texture, *actor, *group;
+  GError *error = NULL;
+  guint i;
+
+  clutter_init (&argc, &argv);
+  Stage = clutter_stage_get_default ();
+  clutter_stage_set_color (CLUTTER_STAGE (Stage), &black);
+  clutter_actor_set_size (Stage, 2 * SIZE, 2 * SIZE);
+
+  for (i = 0; i < sizeof (data); i += 3)
+    {
+      data[i+0] = 0xff;
+      data[i+1] = 0x00;
+      data[i+2] = 0x00;
+    }
+  texture = clutter_texture_new ();
+  if (!clutter_texture_set_from_rgb_data (CLUTTER_TEXTURE (texture), data,
+                                          FALSE, SIZE, SIZE, SIZE * 3, 3,
+                                          0, &error))
+    g_error ("%s", error->message);
+  clutter_actor_hide (texture);
+  clutter_container_add_actor (CLUTTER_CONTAINER (Stage), texture);
+
+  actor = new_sub_texture (texture, 0, 0, FALSE);
+  clutter_actor_set_opacity (actor, OPACITY);
+  clutter_container_add_actor (CLUTTER_CONTAINER (Stage), actor);
+  actor = new_sub_texture (texture, SIZE, 0, TRUE);
+  clutter_actor_set_opacity (actor, OPACITY);
+  clutter_container_add_actor (CLUTTER_CONTAINER (Stage), actor);
+
+  group = tidy_batch_group_new ();
+  clutter_actor_set_opacity (group, OPACITY);
+  clutter_container_add_actor (CLUTTER_CONTAINER (group),
+                               new_sub_texture (texture, 0, SIZE, FALSE));
+  clutter_container_add_actor (CLUTTER_CONTAINER (group),
+                               new_sub_texture (texture, SIZE, SIZE, TRUE));
+  clutter_container_add_actor (CLUTTER_CONTAINER (Stage), group);
+
+  g_signal_connect_after (Stage, "paint", G_CALLBACK (painted), NULL);
+  clutter_actor_show (Stage);
+  clutter_main ();
+
+  return Status;
+}